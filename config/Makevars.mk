@@ -43,6 +43,11 @@ ifdef FIND_DEAD_CODE
   OPTFLAGS += -Wunreachable-code
 endif
 
+ifdef MFM_MAX_LOG_LEVEL
+  COMMON_CFLAGS += -DMFM_MAX_LOG_LEVEL=$(MFM_MAX_LOG_LEVEL)
+  COMMON_CPPFLAGS += -DMFM_MAX_LOG_LEVEL=$(MFM_MAX_LOG_LEVEL)
+endif
+
 ifdef MAKE_GUI
   COMMON_CFLAGS += -DMFM_GUI_DRIVER
   COMMON_CPPFLAGS += -DMFM_GUI_DRIVER
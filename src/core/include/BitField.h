@@ -72,7 +72,7 @@ namespace MFM {
      */
     static u32 Read(const BV & bv)
     {
-      return bv.Read(START,LENGTH);
+      return bv.template Read<START,LENGTH>();
     }
 
     /**
@@ -83,7 +83,7 @@ namespace MFM {
      */
     static void Write(BV & bv, u32 val)
     {
-      bv.Write(START,LENGTH,val);
+      bv.template Write<START,LENGTH>(val);
     }
 
     /**
@@ -97,7 +97,7 @@ namespace MFM {
      */
     static u64 ReadLong(const BV & bv)
     {
-      return bv.ReadLong(START,LENGTH);
+      return bv.template ReadLong<START,LENGTH>();
     }
 
     /**
@@ -108,7 +108,7 @@ namespace MFM {
      */
     static void WriteLong(BV & bv, u64 val)
     {
-      bv.WriteLong(START,LENGTH,val);
+      bv.template WriteLong<START,LENGTH>(val);
     }
 
     /**
@@ -30,7 +30,7 @@
 #include "itype.h"
 #include "ByteSink.h"
 #include "ByteSource.h"
-#include "Util.h"   /* for MakeMaskClip */
+#include "Util.h"   /* for COMPILATION_REQUIREMENT */
 #include <climits>  /* for CHAR_BIT */
 #include <stdlib.h> /* for abort */
 
@@ -39,11 +39,17 @@ namespace MFM {
   /**
    * A bit vector with reasonably fast operations
    *
-   * BITS should be a multiple of BITS_PER_UNIT (currently
-   * 32). Otherwise there will, at least, be some wasted space -- and
-   * may be other issues.
+   * BITS should be a multiple of BITS_PER_UNIT (32 by default, or 64
+   * when UNIT is u64). Otherwise there will, at least, be some wasted
+   * space -- and may be other issues.
+   *
+   * The UNIT storage type affects only the internal layout: bit
+   * indexing (MSB is index 0), the u32-based accessors, and the byte
+   * serialization formats are identical for either choice.  u64 units
+   * let more spans fit within a single unit, at the cost of rounding
+   * the storage size up to a multiple of 8 bytes.
    */
-  template <u32 B>
+  template <u32 B, class UNIT = u32>
   class BitVector
   {
   public:
@@ -64,24 +70,41 @@ namespace MFM {
       return BITS;
     }
 
-    typedef u32 BitUnitType;
+    typedef UNIT BitUnitType;
     static const u32 BITS_PER_UNIT = sizeof(BitUnitType) * CHAR_BIT;
 
     static const u32 ARRAY_LENGTH = (BITS + BITS_PER_UNIT - 1) / BITS_PER_UNIT;
 
+    /**
+     * The number of u32s needed to hold this BitVector when it is
+     * converted to or from a u32 array, regardless of BitUnitType.
+     */
+    static const u32 U32_LENGTH = ARRAY_LENGTH * (BITS_PER_UNIT / 32);
+
   private:
     BitUnitType m_bits[ARRAY_LENGTH];
 
+    /**
+     * Right-aligned mask of \c length ones in a BitUnitType.  Returns
+     * all ones if \c length >= BITS_PER_UNIT.  Folds to a constant
+     * when \c length is a compile-time constant.
+     */
+    static inline BitUnitType MakeUnitMask(const u32 length)
+    {
+      if (length < BITS_PER_UNIT) return (((BitUnitType) 1) << length) - 1;
+      return (BitUnitType) -1;
+    }
+
     /**
      * Low-level raw bitvector writing to a single array element.
      * startIdx==0 means the leftmost bit (MSB).  No checking is done:
      * Caller guarantees (1) idx is valid and (2) startIdx + length <=
-     * 32
+     * BITS_PER_UNIT
      */
-    inline void WriteToUnit(const u32 idx, const u32 startIdx, const u32 length, const u32 value) {
+    inline void WriteToUnit(const u32 idx, const u32 startIdx, const u32 length, const BitUnitType value) {
       if (length == 0) return;
       const u32 shift = BITS_PER_UNIT - (startIdx + length);
-      u32 mask = MakeMaskClip(length) << shift;
+      BitUnitType mask = MakeUnitMask(length) << shift;
       m_bits[idx] = (m_bits[idx] & ~mask) | ((value << shift) & mask);
     }
 
@@ -89,13 +112,101 @@ namespace MFM {
      * Low-level raw bitvector reading from a single array element.
      * startIdx==0 means the leftmost bit (MSB).  No checking is done:
      * Caller guarantees (1) idx is valid and (2) startIdx + length <=
-     * 32
+     * BITS_PER_UNIT
      */
-    inline u32 ReadFromUnit(const u32 idx, const u32 startIdx, const u32 length) const {
+    inline BitUnitType ReadFromUnit(const u32 idx, const u32 startIdx, const u32 length) const {
       if (length==0) { return 0; }
       if(idx >= ARRAY_LENGTH) abort();
       const u32 shift = BITS_PER_UNIT - (startIdx + length);
-      return (m_bits[idx] >> shift) & MakeMaskClip(length);
+      return (m_bits[idx] >> shift) & MakeUnitMask(length);
+    }
+
+    /**
+     * Read the \c idx'th u32 of this BitVector (counting from the
+     * MSB end), without range checking against B.
+     */
+    inline u32 GetWord32(const u32 idx) const
+    {
+      const u32 wordsPerUnit = BITS_PER_UNIT / 32;
+      const u32 shift = BITS_PER_UNIT - 32 * (idx % wordsPerUnit + 1);
+      return (u32) (m_bits[idx / wordsPerUnit] >> shift);
+    }
+
+    /**
+     * Write the \c idx'th u32 of this BitVector (counting from the
+     * MSB end), without range checking against B.
+     */
+    inline void SetWord32(const u32 idx, const u32 value)
+    {
+      WriteToUnit(idx / (BITS_PER_UNIT / 32), 32 * (idx % (BITS_PER_UNIT / 32)), 32, value);
+    }
+
+    /**
+     * Compile-time dispatch tag for the fixed-span accessors, so that
+     * only the code for the span's actual shape gets instantiated.
+     */
+    enum SpanKind { SPAN_EMPTY, SPAN_SINGLE, SPAN_SPLIT };
+    template <u32 KIND> struct SpanTag { };
+
+    template <u32 START, u32 LENGTH>
+    struct SpanKindOf
+    {
+      enum { KIND =
+             (LENGTH == 0) ? SPAN_EMPTY :
+             ((START % BITS_PER_UNIT + LENGTH > BITS_PER_UNIT) ? SPAN_SPLIT : SPAN_SINGLE) };
+    };
+
+    template <u32 START, u32 LENGTH>
+    inline u32 ReadSpan(SpanTag<SPAN_EMPTY>) const
+    {
+      return 0;
+    }
+
+    template <u32 START, u32 LENGTH>
+    inline void WriteSpan(SpanTag<SPAN_EMPTY>, const u32 value)
+    { }
+
+    template <u32 START, u32 LENGTH>
+    inline u32 ReadSpan(SpanTag<SPAN_SINGLE>) const
+    {
+      enum { UNIT_IDX = START / BITS_PER_UNIT,
+             SHIFT = BITS_PER_UNIT - (START % BITS_PER_UNIT + LENGTH) };
+      return (u32) ((m_bits[UNIT_IDX] >> SHIFT) & MakeUnitMask(LENGTH));
+    }
+
+    template <u32 START, u32 LENGTH>
+    inline u32 ReadSpan(SpanTag<SPAN_SPLIT>) const
+    {
+      enum { UNIT_IDX = START / BITS_PER_UNIT,
+             FIRST_LEN = BITS_PER_UNIT - START % BITS_PER_UNIT,
+             SECOND_LEN = LENGTH - FIRST_LEN };
+      const BitUnitType hi = m_bits[UNIT_IDX] & MakeUnitMask(FIRST_LEN);
+      const BitUnitType lo = m_bits[UNIT_IDX + 1] >> (BITS_PER_UNIT - SECOND_LEN);
+      return (u32) ((hi << SECOND_LEN) | lo);
+    }
+
+    template <u32 START, u32 LENGTH>
+    inline void WriteSpan(SpanTag<SPAN_SINGLE>, const u32 value)
+    {
+      enum { UNIT_IDX = START / BITS_PER_UNIT,
+             SHIFT = BITS_PER_UNIT - (START % BITS_PER_UNIT + LENGTH) };
+      const BitUnitType mask = MakeUnitMask(LENGTH) << SHIFT;
+      m_bits[UNIT_IDX] = (m_bits[UNIT_IDX] & ~mask) | ((((BitUnitType) value) << SHIFT) & mask);
+    }
+
+    template <u32 START, u32 LENGTH>
+    inline void WriteSpan(SpanTag<SPAN_SPLIT>, const u32 value)
+    {
+      enum { UNIT_IDX = START / BITS_PER_UNIT,
+             FIRST_LEN = BITS_PER_UNIT - START % BITS_PER_UNIT,
+             SECOND_LEN = LENGTH - FIRST_LEN,
+             SECOND_SHIFT = BITS_PER_UNIT - SECOND_LEN };
+      const BitUnitType firstMask = MakeUnitMask(FIRST_LEN);
+      const BitUnitType secondMask = MakeUnitMask(SECOND_LEN) << SECOND_SHIFT;
+      m_bits[UNIT_IDX] =
+        (m_bits[UNIT_IDX] & ~firstMask) | (((BitUnitType) (value >> SECOND_LEN)) & firstMask);
+      m_bits[UNIT_IDX + 1] =
+        (m_bits[UNIT_IDX + 1] & ~secondMask) | ((((BitUnitType) value) << SECOND_SHIFT) & secondMask);
     }
 
   public:
@@ -181,6 +292,39 @@ namespace MFM {
      */
     void Write(const u32 startIdx, const u32 length, const u32 value);
 
+    /**
+     * Reads up to 32 bits of a section of this BitVector whose
+     * position and size are known at compile time.  Equivalent to
+     * Read(START,LENGTH), but resolves at compile time to either a
+     * single-unit mask and shift or a fixed two-unit splice.
+     *
+     * @tparam START The index of the first bit to read, where the MSB
+     *               is indexed at \c 0 .
+     *
+     * @tparam LENGTH The number of bits to read, in the range \c [0,32] .
+     *
+     * @returns The bits read from the particular section of this
+     *          BitVector.
+     */
+    template <u32 START, u32 LENGTH>
+    inline u32 Read() const;
+
+    /**
+     * Writes up to 32 bits of a specified u32 to a section of this
+     * BitVector whose position and size are known at compile time.
+     * Equivalent to Write(START,LENGTH,value); \sa Read<START,LENGTH>()
+     *
+     * @tparam START The index of the first bit to write, where the
+     *               MSB is indexed at \c 0 .
+     *
+     * @tparam LENGTH The number of bits to write, in the range \c [0,32] .
+     *
+     * @param value The bits to write to the specified section of this
+     *              BitVector.
+     */
+    template <u32 START, u32 LENGTH>
+    inline void Write(const u32 value);
+
     /**
      * Reads up to 64 bits of a particular section of this BitVector.
      *
@@ -209,6 +353,22 @@ namespace MFM {
      */
     void WriteLong(const u32 startIdx, const u32 length, const u64 value);
 
+    /**
+     * Reads up to 64 bits of a section of this BitVector whose
+     * position and size are known at compile time.  \sa
+     * Read<START,LENGTH>()
+     */
+    template <u32 START, u32 LENGTH>
+    inline u64 ReadLong() const;
+
+    /**
+     * Writes up to 64 bits to a section of this BitVector whose
+     * position and size are known at compile time.  \sa
+     * Write<START,LENGTH>(u32)
+     */
+    template <u32 START, u32 LENGTH>
+    inline void WriteLong(const u64 value);
+
     /**
      * Sets the bit at a specified index in this BitVector.
      *
@@ -376,9 +536,9 @@ namespace MFM {
 
     bool operator==(const BitVector & rhs) const;
 
-    void ToArray(u32 array[ARRAY_LENGTH]) const;
+    void ToArray(u32 array[U32_LENGTH]) const;
 
-    void FromArray(const u32 array[ARRAY_LENGTH]);
+    void FromArray(const u32 array[U32_LENGTH]);
 
   };
 } /* namespace MFM */
@@ -4,29 +4,30 @@
 #include <string.h> /* For memset, memcpy */
 
 namespace MFM {
-  template <u32 B>
-  BitVector<B>::BitVector()
+  template <u32 B, class UNIT>
+  BitVector<B,UNIT>::BitVector()
   {
     Clear();
   }
 
-  template <u32 B>
-  BitVector<B>::BitVector(const u32 * const values)
+  template <u32 B, class UNIT>
+  BitVector<B,UNIT>::BitVector(const u32 * const values)
   {
-    memcpy(m_bits,values,sizeof(m_bits));
+    Clear();  // FromArray merges into whole units; start them defined
+    FromArray(values);
   }
 
 #if 0 // Fri Mar 13 16:04:59 2015 XXX TESTING GCC CODE GEN IMPACTS
-  template <u32 B>
-  BitVector<B>::BitVector(const BitVector & other)
+  template <u32 B, class UNIT>
+  BitVector<B,UNIT>::BitVector(const BitVector & other)
   {
     memcpy(m_bits,other.m_bits,sizeof(m_bits));
   }
 #endif // Fri Mar 13 16:04:59 2015 XXX TESTING GCC CODE GEN IMPACTS
 
   // This is the general case..
-  template <u32 B>
-  BitVector<B>::BitVector(const u32 value)
+  template <u32 B, class UNIT>
+  BitVector<B,UNIT>::BitVector(const u32 value)
   {
     Clear();
     u32 startIdx = (u32) MAX(0, ((s32) B) - 32);
@@ -36,7 +37,7 @@ namespace MFM {
 
   // ..but this one special case helps g++ codegen tremendously!
   template <>
-  inline BitVector<32>::BitVector(const u32 value)
+  inline BitVector<32,u32>::BitVector(const u32 value)
   {
     m_bits[0] = value;
   }
@@ -61,8 +62,8 @@ namespace MFM {
   }
 #endif
 
-  template <u32 B>
-  void BitVector<B>::Clear()
+  template <u32 B, class UNIT>
+  void BitVector<B,UNIT>::Clear()
   {
     memset(m_bits, 0, sizeof(m_bits));
   }
@@ -76,12 +77,12 @@ namespace MFM {
    * and Write(), to avoid going per-bit)
    */
 
-  template <u32 B>
-  void BitVector<B>::WriteBit(u32 idx, bool bit)
+  template <u32 B, class UNIT>
+  void BitVector<B,UNIT>::WriteBit(u32 idx, bool bit)
   {
     u32 arrIdx = idx / BITS_PER_UNIT;
     u32 inIdx = idx % BITS_PER_UNIT;
-    u32 newWord = 0x80000000 >> inIdx;
+    BitUnitType newWord = ((BitUnitType) 1) << (BITS_PER_UNIT - 1 - inIdx);
 
     if(!bit)
       m_bits[arrIdx] &= ~newWord;
@@ -89,28 +90,28 @@ namespace MFM {
       m_bits[arrIdx] |= newWord;
   }
 
-  template <u32 B>
-  bool BitVector<B>::ToggleBit(const u32 idx)
+  template <u32 B, class UNIT>
+  bool BitVector<B,UNIT>::ToggleBit(const u32 idx)
   {
     u32 arrIdx = idx / BITS_PER_UNIT;
     u32 inIdx = idx % BITS_PER_UNIT;
-    u32 newWord = 0x80000000 >> inIdx;
+    BitUnitType newWord = ((BitUnitType) 1) << (BITS_PER_UNIT - 1 - inIdx);
 
     m_bits[arrIdx] ^= newWord;
     return m_bits[arrIdx] & newWord;
   }
 
-  template <u32 B>
-  bool BitVector<B>::ReadBit(u32 idx)
+  template <u32 B, class UNIT>
+  bool BitVector<B,UNIT>::ReadBit(u32 idx)
   {
     u32 arrIdx = idx / BITS_PER_UNIT;
     u32 intIdx = idx % BITS_PER_UNIT;
 
-    return m_bits[arrIdx] & (0x80000000 >> intIdx);
+    return m_bits[arrIdx] & (((BitUnitType) 1) << (BITS_PER_UNIT - 1 - intIdx));
   }
 
-  template <u32 B>
-  u64 BitVector<B>::ReadLong(const u32 startIdx, const u32 length) const
+  template <u32 B, class UNIT>
+  u64 BitVector<B,UNIT>::ReadLong(const u32 startIdx, const u32 length) const
   {
     const u32 firstLen = MIN((const u32) 32,length);
     const u32 secondLen = length - firstLen;
@@ -122,8 +123,8 @@ namespace MFM {
     return ret;
   }
 
-  template <u32 B>
-  void BitVector<B>::WriteLong(const u32 startIdx, const u32 length, const u64 value)
+  template <u32 B, class UNIT>
+  void BitVector<B,UNIT>::WriteLong(const u32 startIdx, const u32 length, const u64 value)
   {
     const u32 firstLen = MIN((const u32) 32,length);
     const u32 secondLen = length - firstLen;
@@ -134,8 +135,8 @@ namespace MFM {
     }
   }
 
-  template <u32 B>
-  void BitVector<B>::Write(u32 startIdx,
+  template <u32 B, class UNIT>
+  void BitVector<B,UNIT>::Write(u32 startIdx,
                               u32 length,
                               u32 value)
   {
@@ -161,8 +162,8 @@ namespace MFM {
       WriteToUnit(firstUnitIdx + 1, 0, length - firstUnitLength, value);
   }
 
-  template <u32 B>
-  u32 BitVector<B>::Read(const u32 startIdx, const u32 length) const
+  template <u32 B, class UNIT>
+  u32 BitVector<B,UNIT>::Read(const u32 startIdx, const u32 length) const
   {
     if (length == 0)
       return 0;
@@ -177,11 +178,11 @@ namespace MFM {
     const bool hasSecondUnit = (firstUnitFirstBit + length) > BITS_PER_UNIT;
     const u32 firstUnitLength = hasSecondUnit ? BITS_PER_UNIT-firstUnitFirstBit : length;
 
-    u32 ret = ReadFromUnit(firstUnitIdx, firstUnitFirstBit, firstUnitLength);
+    u32 ret = (u32) ReadFromUnit(firstUnitIdx, firstUnitFirstBit, firstUnitLength);
 
     if (hasSecondUnit) {
       const u32 secondUnitLength = length - firstUnitLength;
-      ret = (ret << secondUnitLength) | ReadFromUnit(firstUnitIdx + 1, 0, secondUnitLength);
+      ret = (ret << secondUnitLength) | (u32) ReadFromUnit(firstUnitIdx + 1, 0, secondUnitLength);
     }
 
     return ret;
@@ -189,11 +190,61 @@ namespace MFM {
 
 
 
-  template <u32 B>
-  void BitVector<B>::StoreBits(const u32 bits, const u32 startIdx, const u32 length)
+  template <u32 B, class UNIT>
+  template <u32 START, u32 LENGTH>
+  u32 BitVector<B,UNIT>::Read() const
+  {
+    COMPILATION_REQUIREMENT< START + LENGTH <= B >();
+    COMPILATION_REQUIREMENT< LENGTH <= 32 >();
+
+    return ReadSpan<START,LENGTH>(SpanTag<SpanKindOf<START,LENGTH>::KIND>());
+  }
+
+  template <u32 B, class UNIT>
+  template <u32 START, u32 LENGTH>
+  void BitVector<B,UNIT>::Write(const u32 value)
+  {
+    COMPILATION_REQUIREMENT< START + LENGTH <= B >();
+    COMPILATION_REQUIREMENT< LENGTH <= 32 >();
+
+    WriteSpan<START,LENGTH>(SpanTag<SpanKindOf<START,LENGTH>::KIND>(), value);
+  }
+
+  template <u32 B, class UNIT>
+  template <u32 START, u32 LENGTH>
+  u64 BitVector<B,UNIT>::ReadLong() const
+  {
+    enum { FIRST_LEN = (LENGTH < 32) ? LENGTH : 32, SECOND_LEN = LENGTH - FIRST_LEN };
+    u64 ret = Read<START + SECOND_LEN, FIRST_LEN>();
+    if (SECOND_LEN > 0)
+    {
+      ret |= ((u64) Read<START, SECOND_LEN>()) << FIRST_LEN;
+    }
+    return ret;
+  }
+
+  template <u32 B, class UNIT>
+  template <u32 START, u32 LENGTH>
+  void BitVector<B,UNIT>::WriteLong(const u64 value)
+  {
+    enum { FIRST_LEN = (LENGTH < 32) ? LENGTH : 32, SECOND_LEN = LENGTH - FIRST_LEN };
+    Write<START + SECOND_LEN, FIRST_LEN>((u32) value);
+    if (SECOND_LEN > 0)
+    {
+      Write<START, SECOND_LEN>((u32) (value >> FIRST_LEN));
+    }
+  }
+
+  template <u32 B, class UNIT>
+  void BitVector<B,UNIT>::StoreBits(const u32 bits, const u32 startIdx, const u32 length)
   {
     if (!length) return;
 
+    // Tile the u32 pattern across a whole storage unit
+    BitUnitType unitBits = bits;
+    for (u32 i = 32; i < BITS_PER_UNIT; i *= 2)
+      unitBits |= unitBits << i;
+
     const u32 stopIdx = MIN((u32) B, startIdx + length) - 1;
 
     const u32 firstUnitIdx = startIdx / BITS_PER_UNIT;
@@ -208,7 +259,7 @@ namespace MFM {
 
     if (!hasMultipleUnits) {
       WriteToUnit(firstUnitIdx, firstUnitFirstBit, length,
-                  bits >> (BITS_PER_UNIT - (firstUnitFirstBit + length)));
+                  unitBits >> (BITS_PER_UNIT - (firstUnitFirstBit + length)));
       return;
     }
 
@@ -218,28 +269,28 @@ namespace MFM {
 
     if (!firstUnitFull) {
       const u32 firstUnitLength = BITS_PER_UNIT - firstUnitFirstBit;
-      WriteToUnit(firstUnitIdx, firstUnitFirstBit, firstUnitLength, bits);
+      WriteToUnit(firstUnitIdx, firstUnitFirstBit, firstUnitLength, unitBits);
     }
 
     for (s32 idx = firstFullUnitIdx; idx <= lastFullUnitIdx; ++idx)
-      m_bits[idx] = bits;
+      m_bits[idx] = unitBits;
 
     if (!lastUnitFull) {
       const u32 lastUnitLength = lastUnitLastBit + 1;
       WriteToUnit(lastUnitIdx, 0, lastUnitLength,
-                  bits >> (BITS_PER_UNIT - lastUnitLength));
+                  unitBits >> (BITS_PER_UNIT - lastUnitLength));
     }
   }
 
-  template <u32 B>
-  void BitVector<B>::Print(ByteSink & ostream) const
+  template <u32 B, class UNIT>
+  void BitVector<B,UNIT>::Print(ByteSink & ostream) const
   {
     for (u32 i = 0; i < B; i += 4)
       ostream.Printf("%x",Read(i,4));
   }
 
-  template <u32 B>
-  void BitVector<B>::PrintBase2(ByteSink& ostream) const
+  template <u32 B, class UNIT>
+  void BitVector<B,UNIT>::PrintBase2(ByteSink& ostream) const
   {
     for(u32 i = 0; i < B; i++)
     {
@@ -247,21 +298,21 @@ namespace MFM {
     }
   }
 
-  template <u32 B>
-  void BitVector<B>::PrintBytes(ByteSink& ostream) const
+  template <u32 B, class UNIT>
+  void BitVector<B,UNIT>::PrintBytes(ByteSink& ostream) const
   {
-    for(u32 w = 0; w < ARRAY_LENGTH; w++)
+    for(u32 w = 0; w < U32_LENGTH; w++)
     {
-      ostream.Print(m_bits[w], Format::BEU32);
+      ostream.Print(GetWord32(w), Format::BEU32);
     }
   }
 
-  template <u32 B>
-  bool BitVector<B>::Read(ByteSource & istream)
+  template <u32 B, class UNIT>
+  bool BitVector<B,UNIT>::Read(ByteSource & istream)
   {
     istream.SkipWhitespace();
 
-    BitVector<B> temp;
+    BitVector<B,UNIT> temp;
     for (u32 i = 0; i < B; i += 4)
     {
       s32 hex;
@@ -277,27 +328,29 @@ namespace MFM {
     return true;
   }
 
-  template <u32 B>
-  bool BitVector<B>::ReadBytes(ByteSource& istream)
+  template <u32 B, class UNIT>
+  bool BitVector<B,UNIT>::ReadBytes(ByteSource& istream)
   {
-    BitVector<B> temp;
-    for(u32 w = 0; w < ARRAY_LENGTH; w++)
+    BitVector<B,UNIT> temp;
+    for(u32 w = 0; w < U32_LENGTH; w++)
     {
-      if (!istream.Scan(temp.m_bits[w], Format::BEU32))
+      u32 word;
+      if (!istream.Scan(word, Format::BEU32))
       {
         return false;
       }
+      temp.SetWord32(w, word);
     }
     *this = temp;
     return true;
   }
 
-  template <u32 B>
-  bool BitVector<B>::ReadBase2(ByteSource& istream)
+  template <u32 B, class UNIT>
+  bool BitVector<B,UNIT>::ReadBase2(ByteSource& istream)
   {
     istream.SkipWhitespace();
 
-    BitVector<B> temp;
+    BitVector<B,UNIT> temp;
     for(u32 i = 0; i < B; i++)
     {
       s32 bit;
@@ -313,25 +366,25 @@ namespace MFM {
     return true;
   }
 
-  template <u32 B>
-  bool BitVector<B>::operator==(const BitVector & rhs) const
+  template <u32 B, class UNIT>
+  bool BitVector<B,UNIT>::operator==(const BitVector & rhs) const
   {
     return 0 == memcmp(m_bits, rhs.m_bits, sizeof(m_bits));
 
   }
 
-  template <u32 B>
-  void BitVector<B>::FromArray(const u32 array[ARRAY_LENGTH])
+  template <u32 B, class UNIT>
+  void BitVector<B,UNIT>::FromArray(const u32 array[U32_LENGTH])
   {
-    for(u32 i = 0; i < ARRAY_LENGTH; i++)
-      m_bits[i] = array[i];
+    for(u32 i = 0; i < U32_LENGTH; i++)
+      SetWord32(i, array[i]);
   }
 
-  template <u32 B>
-  void BitVector<B>::ToArray(u32 array[ARRAY_LENGTH]) const
+  template <u32 B, class UNIT>
+  void BitVector<B,UNIT>::ToArray(u32 array[U32_LENGTH]) const
   {
-    for(u32 i = 0; i < ARRAY_LENGTH; i++)
-      array[i] = m_bits[i];
+    for(u32 i = 0; i < U32_LENGTH; i++)
+      array[i] = GetWord32(i);
   }
 
 
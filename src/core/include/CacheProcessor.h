@@ -32,8 +32,13 @@
 #include "Point.h"
 #include "Packet.h"
 #include "ChannelEnd.h"
+#include "Rect.h"
 #include "MDist.h"  /* for EVENT_WINDOW_SITES */
 #include "Logger.h"
+#include "TraceBuffer.h"
+#include "TileCounters.h"
+#include "PhaseHistograms.h"
+#include "Util.h"     /* For GetMonotonicNanos */
 
 namespace MFM {
 
@@ -68,6 +73,31 @@ namespace MFM {
      */
     LonglivedLock * m_longlivedLock;
 
+    /**
+       In direct intertile mode, our peer on the far side of the
+       channel, whose Tile we write our changes into while we hold
+       m_longlivedLock, instead of shipping them as packets.  Null in
+       the usual packet mode.
+     */
+    CacheProcessor * m_directPeer;
+
+    /**
+       If our peer is in another process, the CacheProcessor -- us, or
+       a sibling sharing our corner lock -- that carries the
+       LOCK_REQUEST and LOCK_GRANT traffic for it.  m_longlivedLock is
+       then only this process's stand-in for the lock, held on the far
+       side's behalf by the address of the agent's m_remoteLockOwner
+       (see SetRemoteLock).  Null if our peer is in this process.
+     */
+    CacheProcessor * m_lockAgent;
+
+    // Also set and read from siblings' threads; staleness only delays
+    volatile bool m_lockWanted;     // A TryLock failed for want of the token
+    volatile bool m_peerWantsLock;  // Peer sent LOCK_REQUEST we haven't granted
+
+    bool m_lockRequested;  // We sent LOCK_REQUEST and await LOCK_GRANT
+    u8 m_remoteLockOwner;  // Only its address matters
+
     /**
        Our cache direction, used as an owner index for the long lived
        lock, since any given lock can't be claimed from the same
@@ -169,6 +199,77 @@ namespace MFM {
       }
     }
 
+    /**
+       The sites, in full untransformed local coordinates, that only
+       we and our peer hold: the shared and cache strips along our
+       edge, minus the ends that the tiles beside us can also see.
+       Empty for corner cache processors.  Anything writing these
+       sites holds our lock, so when we ship an update, the peer's
+       copy of the strip should match ours once it has applied it.
+     */
+    Rect m_digestStrip;
+
+    /**
+       The half of m_digestStrip that we own.  A resync sends only
+       these sites, so it never overwrites the peer's own half with
+       our possibly stale cache of it; the peer resyncs that half
+       itself.
+     */
+    Rect m_ownedStrip;
+
+    /**
+       If nonzero, verify the peer's copy of m_digestStrip by sending
+       a digest of it with every this many updates, instead of by
+       sending CHECK packets for its unchanged sites.  Sites outside
+       the strip are still spot-checked at m_checkOdds.
+     */
+    u32 m_digestPeriod;
+
+    u32 m_updatesSinceDigest; // Updates shipped without a digest
+    bool m_resyncPending;     // A digest mismatch was found, by us or the peer
+    bool m_shipDigest;        // End the current update with a digest
+    u32 m_digest;             // Our strip digest for the current update
+    u32 m_resyncCount;        // Strip sites to resync in the current update
+    u32 m_resyncSentCount;    // Next strip site to resync
+
+    void InitDigestStrip() ;
+
+    bool IsInDigestStrip(const SPoint & local) const
+    {
+      const s32 dx = local.GetX() - m_digestStrip.GetX();
+      const s32 dy = local.GetY() - m_digestStrip.GetY();
+      return
+        dx >= 0 && dx < (s32) m_digestStrip.GetWidth() &&
+        dy >= 0 && dy < (s32) m_digestStrip.GetHeight();
+    }
+
+    /**
+       Return the local coordinate of the index'th site of
+       m_digestStrip, scanning rows top to bottom and each row left to
+       right.  Since the peer's strip is the same sites translated,
+       the peer scans them in the same order.
+     */
+    SPoint GetDigestStripSite(u32 index) const
+    {
+      return GetStripSite(m_digestStrip, index);
+    }
+
+    SPoint GetOwnedStripSite(u32 index) const
+    {
+      return GetStripSite(m_ownedStrip, index);
+    }
+
+    static SPoint GetStripSite(const Rect & strip, u32 index)
+    {
+      const u32 width = strip.GetWidth();
+      return strip.GetPosition() + SPoint(index % width, index / width);
+    }
+
+    /**
+       Compute a digest of the atoms now in m_digestStrip.
+     */
+    u32 ComputeStripDigest() const ;
+
     /**
        Return true if the site at the given siteNumber, relative to
        our m_eventCenter (which is measured in full untransformed Tile
@@ -193,6 +294,69 @@ namespace MFM {
     u32 m_toSendCount;    // Used length of m_toSend
     u32 m_sentCount;      // Next index to send in m_toSend
 
+    enum {
+      /**
+         MAX_PIPELINE_DEPTH is the largest number of updates that may
+         be awaiting their replies at once.  \sa SetPipelineDepth
+       */
+      MAX_PIPELINE_DEPTH = 8,
+
+      /**
+         The bytes needed on m_channelEnd to ship a
+         SEQUENCED_UPDATE_BEGIN packet, including its length byte.
+       */
+      SEQUENCED_UPDATE_BEGIN_BYTES = 1 + 1 + 2 + 2 + 1
+    };
+
+    /**
+       An update we have shipped and whose reply has not yet arrived.
+     */
+    struct OutstandingUpdate {
+      SPoint m_center;     // Event center, in full untransformed local coords
+      u32 m_toSendCount;   // Atoms shipped, to check against the reply
+      u8 m_sequence;       // As sent in SEQUENCED_UPDATE_BEGIN
+    };
+
+    /**
+       The updates awaiting replies, oldest at m_outstandingFirst.
+       Replies arrive in the order the updates were shipped.
+     */
+    OutstandingUpdate m_outstanding[MAX_PIPELINE_DEPTH];
+    u32 m_outstandingFirst;
+    u32 m_outstandingCount;
+
+    /**
+       The most updates we will ship while holding the lock once, and
+       hence the most that may await replies.  1 selects the classic
+       protocol, which waits for each reply before the next event.
+     */
+    u32 m_pipelineDepth;
+
+    u32 m_tenureUpdates;  // Updates shipped since we took the lock
+    u8 m_nextSequence;    // For our next SEQUENCED_UPDATE_BEGIN
+
+    /**
+       When passive, the sequence number to echo in our reply, or -1
+       if the update was begun by a classic UPDATE_BEGIN.
+     */
+    s32 m_replySequence;
+
+    u64 m_packetsShipped; // Total packets written to m_channelEnd
+    u64 m_bytesShipped;   // Total bytes, including length bytes, written
+    u64 m_packetsReceived;     // Total packets read from m_channelEnd
+    u64 m_bytesReceived;       // Total bytes, including length bytes, read
+    u64 m_updatePacketsShipped; // Atom packets queued as PACKET_UPDATE
+    u64 m_checkPacketsShipped;  // Atom packets queued as PACKET_CHECK
+    u64 m_consistencyFailures; // Replies with too few consistent atoms
+    u64 m_digestsShipped;      // Updates ended with UPDATE_END_DIGEST
+    u64 m_digestMismatches;    // DIGEST_MISMATCH replies received
+    u64 m_resyncPacketsShipped; // RESYNC packets written
+    u64 m_directUpdates;       // Atoms written straight into m_directPeer
+    u64 m_lockGrants;          // LOCK_GRANT packets written
+    u64 m_blockingNanos;       // Total time spent in BLOCKING
+    u64 m_blockingSince;       // When we last entered BLOCKING
+    u64 m_phaseStamp;          // End of last timed phase; 0 if untimed
+
     enum State
     {
       IDLE,         // Unlocked, not in use
@@ -254,17 +418,25 @@ namespace MFM {
 
     void SetStateInternal(State state)
     {
-      MFM_LOG_DBG6(("CP %s %s [%s] (%d,%d): %s->%s",
-                    m_tile->GetLabel(),
-                    Dirs::GetName(m_cacheDir),
-                    Dirs::GetName(m_centerRegion),
-                    m_farSideOrigin.GetX(),
-                    m_farSideOrigin.GetY(),
-                    GetStateName(m_cpState),
-                    GetStateName(state)));
+      MFM_TRACE_DBG6(*m_tile, TRACE_CP_STATE, m_cacheDir, m_cpState, state,
+                     ("CP %s %s [%s] (%d,%d): %s->%s",
+                      m_tile->GetLabel(),
+                      Dirs::GetName(m_cacheDir),
+                      Dirs::GetName(m_centerRegion),
+                      m_farSideOrigin.GetX(),
+                      m_farSideOrigin.GetY(),
+                      GetStateName(m_cpState),
+                      GetStateName(state)));
       m_cpState = state;
     }
 
+    /**
+     * If the current event is being timed, records the time since
+     * its last phase ended as the duration of \c phase (a
+     * PhaseHistograms::Phase).
+     */
+    void EndPhase(u32 phase) ;
+
   public:
 
     enum RedundancyOdds {
@@ -303,10 +475,70 @@ namespace MFM {
     void ReportCacheProcessorStatus(Logger::Level level) ;
 
     /**
-       Shift this cache processor from IDLE to ACTIVE.
+       Shift this cache processor from IDLE to ACTIVE, or from
+       RECEIVING to ACTIVE if CanPipelineEvent just said it could.
      */
     void Activate() ;
 
+    /**
+       Set how many updates we may ship while holding our lock once,
+       without waiting for their replies.  1 (the default) gives the
+       classic protocol; larger values let non-overlapping events in
+       our edge region proceed while earlier replies are in flight,
+       which pays off when the channel has high latency.
+     */
+    void SetPipelineDepth(u32 depth)
+    {
+      MFM_API_ASSERT_ARG(depth >= 1 && depth <= MAX_PIPELINE_DEPTH);
+      m_pipelineDepth = depth;
+    }
+
+    u32 GetPipelineDepth() const
+    {
+      return m_pipelineDepth;
+    }
+
+    /**
+       Set how often to verify our peer's copy of the strip of sites
+       only we two hold: with a digest every period updates, or, if
+       period is 0 (the default), by CHECK packets as for all other
+       sites.  \sa m_digestPeriod
+     */
+    void SetDigestPeriod(u32 period)
+    {
+      m_digestPeriod = period;
+      m_updatesSinceDigest = 0;
+    }
+
+    u32 GetDigestPeriod() const
+    {
+      return m_digestPeriod;
+    }
+
+    static u32 GetMaxPipelineDepth()
+    {
+      return MAX_PIPELINE_DEPTH;
+    }
+
+    /**
+       Return how many of our updates are still awaiting replies.
+     */
+    u32 GetOutstandingUpdates() const
+    {
+      return m_outstandingCount;
+    }
+
+    /**
+       Return true if an event at eventCenter, needing only the lock
+       for lockRegion, can reuse this cache processor while it is
+       still RECEIVING replies to earlier updates.  That requires a
+       pipeline depth above 1, an edge event in our own direction
+       like the ones in flight, room in this lock tenure and on the
+       channel, and no overlap between the new event window and those
+       of the updates still outstanding.
+     */
+    bool CanPipelineEvent(Dir lockRegion, const SPoint & eventCenter) ;
+
     /**
        Shift this cache processor back to IDLE.
      */
@@ -320,9 +552,11 @@ namespace MFM {
 
     /**
        Notify the CacheProcessor that m_toSend is now fully loaded and
-       no more MaybeSendAtoms will occur for this event.
+       no more MaybeSendAtoms will occur for this event.  If
+       timePhases, record the durations of the shipping, receiving,
+       and blocking that follow in the Tile's PhaseHistograms.
      */
-    void StartShipping() ;
+    void StartShipping(bool timePhases) ;
 
     /**
        Advance the CacheProcessor state however it can be advanced.
@@ -351,6 +585,16 @@ namespace MFM {
       return m_cpState == BLOCKING;
     }
 
+    /**
+       Return true if we can make no progress until our peer sends us
+       something: the reply to an update we shipped, or the grant of
+       a lock we requested from it.
+     */
+    bool IsWaitingForPeer() const
+    {
+      return m_cpState == RECEIVING || m_lockRequested;
+    }
+
     CacheProcessor & GetSibling(Dir inDirection) ;
 
     /**
@@ -372,28 +616,80 @@ namespace MFM {
     void ReceiveUpdateEnd() ;
 
     /**
-       Handle the ACK that our neighbor cache processor sent us
-       in reply to our update end.
+       Compare the digest our neighbor cache processor sent with its
+       update end against our copy of the strip, and tell it if they
+       differ.  Called just before ReceiveUpdateEnd.
+     */
+    void CheckDigest(u32 digest) ;
+
+    /**
+       Handle our neighbor's report that its copy of our strip did not
+       match the digest we sent, by resending the whole strip with our
+       next update.
+     */
+    void ReceiveDigestMismatch() ;
+
+    /**
+       Handle a strip site that our neighbor cache processor resent
+       after a digest mismatch.
+     */
+    void ReceiveResync(const SPoint & site, const T & inboundAtom) ;
+
+    /**
+       Handle our neighbor's request, from another process, for the
+       lock we share, by granting it once nobody here is using it.
      */
-    void ReceiveReply(u32 consistentCount) ;
+    void ReceiveLockRequest() ;
 
     /**
-       Record that we are (about to be) receiving an update from a window at onCenter
+       Take over the lock we share with our neighbor in another
+       process, which has just granted it to us.
      */
-    void BeginUpdate(SPoint onCenter) ;
+    void ReceiveLockGrant() ;
+
+    /**
+       Handle the ACK that our neighbor cache processor sent us in
+       reply to our oldest outstanding update end.  sequence is the
+       echoed sequence number of a SEQUENCED_UPDATE_ACK, or -1 for a
+       classic UPDATE_ACK.
+     */
+    void ReceiveReply(u32 consistentCount, s32 sequence = -1) ;
+
+    /**
+       Record that we are (about to be) receiving an update from a
+       window at onCenter, with sequence number to echo in our reply,
+       or -1 if the update was not sequenced.
+     */
+    void BeginUpdate(SPoint onCenter, s32 sequence = -1) ;
 
     bool ShipBufferAsPacket(PacketBuffer & pb) ;
 
     bool TryLock(Dir centerRegion)
     {
+      if (m_lockAgent && m_lockAgent->m_peerWantsLock)
+      {
+        return false;  // Let the far side have its turn first
+      }
+
       bool ret = GetLonglivedLock().TryLock(this);
       if (ret)
       {
         m_centerRegion = centerRegion;
       }
+      else if (m_lockAgent)
+      {
+        m_lockAgent->m_lockWanted = true;
+      }
       return ret;
     }
 
+    /**
+       As the lock agent, ask the far side for the lock if one of our
+       TryLocks wanted it, or hand it over if the far side wants it
+       and nobody here is using it.  Return true if we did either.
+     */
+    bool AdvanceRemoteLock() ;
+
     void Unlock()
     {
       bool ret = GetLonglivedLock().Unlock(this);
@@ -406,6 +702,27 @@ namespace MFM {
       return m_channelEnd.IsConnected();
     }
 
+    /**
+     * Adds this CacheProcessor's packet, consistency, and blocking
+     * counters into \c counters .
+     */
+    void AddCounters(TileCounters & counters) const
+    {
+      counters.m_packetsShipped += m_packetsShipped;
+      counters.m_bytesShipped += m_bytesShipped;
+      counters.m_packetsReceived += m_packetsReceived;
+      counters.m_bytesReceived += m_bytesReceived;
+      counters.m_updatePacketsShipped += m_updatePacketsShipped;
+      counters.m_checkPacketsShipped += m_checkPacketsShipped;
+      counters.m_consistencyFailures += m_consistencyFailures;
+      counters.m_digestsShipped += m_digestsShipped;
+      counters.m_digestMismatches += m_digestMismatches;
+      counters.m_resyncPacketsShipped += m_resyncPacketsShipped;
+      counters.m_directUpdates += m_directUpdates;
+      counters.m_lockGrants += m_lockGrants;
+      counters.m_blockingNanos += m_blockingNanos;
+    }
+
     void ClaimCacheProcessor(Tile<EC>& tile, AbstractChannel& channel, LonglivedLock & lock, Dir toCache)
     {
       MFM_API_ASSERT_STATE(!m_tile && !m_longlivedLock);
@@ -417,11 +734,86 @@ namespace MFM {
       // Map their full untransformed origin to our full untransformed frame
       SPoint remoteOrigin = Dirs::GetOffset(m_cacheDir) * m_tile->OWNED_SIDE;
       m_farSideOrigin = remoteOrigin;
+      InitDigestStrip();
 
       bool onSideA = (m_cacheDir >= Dirs::NORTHEAST && m_cacheDir <= Dirs::SOUTH);
       m_channelEnd.ClaimChannelEnd(channel, onSideA);
     }
 
+    /**
+     * Switches this CacheProcessor to direct intertile mode, in which
+     * each changed atom visible to \c peer is written straight into
+     * \c peer's Tile during StoreToTile, and the lock is released
+     * as soon as the event is stored, without any packets, replies,
+     * or BLOCKING.  Both ends of a channel must be switched together,
+     * after both are claimed and before either Tile runs (see
+     * Grid::Init).
+     *
+     * The writes are safe without packets because they happen only
+     * while we hold the LonglivedLock we share with \c peer, and any
+     * event of \c peer's that could read those cache sites must take
+     * that same lock first; its mutex orders our writes before such
+     * reads.
+     */
+    void SetDirectPeer(CacheProcessor & peer)
+    {
+      MFM_API_ASSERT_STATE(m_tile && peer.m_tile && &peer != this);
+      MFM_API_ASSERT_STATE(m_cpState == IDLE);
+      m_directPeer = &peer;
+      peer.m_tile->AllowDirectWriters();
+    }
+
+    bool IsDirect() const
+    {
+      return m_directPeer != 0;
+    }
+
+    /**
+     * Declares that our peer is in another process, reached over a
+     * channel such as a SocketChannel, so that the LonglivedLock we
+     * were claimed with is only this process's stand-in for the one
+     * shared with the far side.  That lock is a token held by one
+     * process at a time: there, the stand-in is used as usual, while
+     * in the other process it stays locked on the holder's behalf.
+     * A TryLock failing for want of the token has \c agent send a
+     * LOCK_REQUEST, and the holder's agent answers with a LOCK_GRANT
+     * as soon as its stand-in is free -- so once every update made
+     * under it has been acknowledged -- locking the stand-in as it
+     * does.
+     *
+     * \c agent is us, except where two crossing diagonal links share
+     * a corner lock: then both ends of one of them are agents for the
+     * other's as well.  Call on every CacheProcessor whose peer is in
+     * another process, after they are claimed and before their Tiles
+     * run, with \c holdToken true in exactly one of the processes.
+     */
+    void SetRemoteLock(bool holdToken, CacheProcessor & agent)
+    {
+      MFM_API_ASSERT_STATE(m_tile && !m_lockAgent && !m_directPeer);
+      MFM_API_ASSERT_STATE(m_cpState == IDLE);
+      m_lockAgent = &agent;
+      if (&agent == this && !holdToken)
+      {
+        MFM_API_ASSERT(GetLonglivedLock().TryLock(&m_remoteLockOwner), LOCK_FAILURE);
+      }
+    }
+
+    bool IsRemoteLock() const
+    {
+      return m_lockAgent != 0;
+    }
+
+    /**
+     * Returns true if we may use the lock we share with our peer
+     * right now: always, unless the peer is in another process and
+     * the far side currently holds it.
+     */
+    bool HoldsRemoteLockToken()
+    {
+      return !m_lockAgent ||
+        GetLonglivedLock().GetOwnerIndex() != &m_lockAgent->m_remoteLockOwner;
+    }
+
     void AssertConnected() const
     {
       MFM_API_ASSERT_STATE(m_tile && m_longlivedLock);
@@ -477,11 +869,45 @@ namespace MFM {
     CacheProcessor()
       : m_tile(0)
       , m_longlivedLock(0)
+      , m_directPeer(0)
+      , m_lockAgent(0)
+      , m_lockWanted(false)
+      , m_peerWantsLock(false)
+      , m_lockRequested(false)
+      , m_remoteLockOwner(0)
       , m_cacheDir(0)
       , m_centerRegion((Dir) -1)
       , m_checkOdds(INITIAL_CHECK_ODDS)
       , m_remoteConsistentAtomCount(0)
       , m_useAdaptiveRedundancy(true)
+      , m_digestPeriod(0)
+      , m_updatesSinceDigest(0)
+      , m_resyncPending(false)
+      , m_shipDigest(false)
+      , m_digest(0)
+      , m_resyncCount(0)
+      , m_resyncSentCount(0)
+      , m_outstandingFirst(0)
+      , m_outstandingCount(0)
+      , m_pipelineDepth(1)
+      , m_tenureUpdates(0)
+      , m_nextSequence(0)
+      , m_replySequence(-1)
+      , m_packetsShipped(0)
+      , m_bytesShipped(0)
+      , m_packetsReceived(0)
+      , m_bytesReceived(0)
+      , m_updatePacketsShipped(0)
+      , m_checkPacketsShipped(0)
+      , m_consistencyFailures(0)
+      , m_digestsShipped(0)
+      , m_digestMismatches(0)
+      , m_resyncPacketsShipped(0)
+      , m_directUpdates(0)
+      , m_lockGrants(0)
+      , m_blockingNanos(0)
+      , m_blockingSince(0)
+      , m_phaseStamp(0)
       , m_cpState(IDLE)
       , m_eventCenter(0,0)
       , m_farSideOrigin(0,0)
@@ -25,10 +25,63 @@ namespace MFM
     LOG.Log(level,"    CheckOdds: %d", m_checkOdds);
     LOG.Log(level,"    ToSendCount: %d", m_toSendCount);
     LOG.Log(level,"    SentCount:   %d", m_sentCount);
+    LOG.Log(level,"    Outstanding: %d of %d", m_outstandingCount, m_pipelineDepth);
 
     m_channelEnd.ReportChannelEndStatus(level);
   }
 
+  template <class EC>
+  void CacheProcessor<EC>::InitDigestStrip()
+  {
+    const u32 W = m_tile->TILE_SIDE;
+    m_digestStrip = Rect();
+    m_ownedStrip = Rect();
+    if (Dirs::IsCorner(m_cacheDir) || W <= 4 * R)
+    {
+      return;  // Everything we share with a corner peer, others see too
+    }
+
+    // Start with everything both tiles hold
+    Rect strip(SPoint(0, 0), UPoint(W, W));
+    strip.IntersectWith(Rect(m_farSideOrigin, UPoint(W, W)));
+
+    // And drop the ends, which the tiles beside us also hold
+    if (strip.GetWidth() == W)
+    {
+      strip.SetX(2 * R);
+      strip.SetWidth(W - 4 * R);
+    }
+    else
+    {
+      strip.SetY(2 * R);
+      strip.SetHeight(W - 4 * R);
+    }
+    m_digestStrip = strip;
+
+    // Of which we own the sites outside our cache
+    m_ownedStrip = strip;
+    m_ownedStrip.IntersectWith(Rect(SPoint(R, R), UPoint(W - 2 * R, W - 2 * R)));
+  }
+
+  template <class EC>
+  u32 CacheProcessor<EC>::ComputeStripDigest() const
+  {
+    // FNV-1a over the words of each atom, in strip order
+    u32 digest = 2166136261u;
+    const u32 count = m_digestStrip.GetWidth() * m_digestStrip.GetHeight();
+    for (u32 i = 0; i < count; ++i)
+    {
+      typedef BitVector<AC::BITS_PER_ATOM> BV;
+      u32 words[BV::U32_LENGTH];
+      Element<EC>::GetBits(*m_tile->GetAtom(GetDigestStripSite(i))).ToArray(words);
+      for (u32 w = 0; w < BV::U32_LENGTH; ++w)
+      {
+        digest = (digest ^ words[w]) * 16777619u;
+      }
+    }
+    return digest;
+  }
+
   template <class EC>
   bool CacheProcessor<EC>::IsSiteNumberVisible(u16 siteNumber)
   {
@@ -58,20 +111,121 @@ namespace MFM
   }
 
   template <class EC>
-  void CacheProcessor<EC>::StartShipping()
+  void CacheProcessor<EC>::StartShipping(bool timePhases)
   {
     MFM_API_ASSERT_STATE(m_cpState == LOADING);
 
+    // In direct mode our peer already holds every change, so we're done
+    if (m_directPeer)
+    {
+      SetIdle();
+      Unlock();
+      return;
+    }
+
     // Now it's about shipping
+    m_phaseStamp = timePhases ? ReadCycleCounter() : 0;
     SetStateInternal(SHIPPING);
 
+    MFM_API_ASSERT_STATE(m_outstandingCount < MAX_PIPELINE_DEPTH);
+    OutstandingUpdate & ou =
+      m_outstanding[(m_outstandingFirst + m_outstandingCount) % MAX_PIPELINE_DEPTH];
+    ou.m_center = m_eventCenter;
+    ou.m_toSendCount = m_toSendCount;
+    ou.m_sequence = m_nextSequence++;
+    ++m_outstandingCount;
+    ++m_tenureUpdates;
+
+    // Digest the strip only we and the peer hold, and maybe resync
+    // our half of it
+    m_shipDigest = false;
+    m_resyncCount = 0;
+    m_resyncSentCount = 0;
+    if (m_digestPeriod > 0 && m_digestStrip.GetWidth() > 0)
+    {
+      if (m_resyncPending)
+      {
+        m_resyncCount = m_ownedStrip.GetWidth() * m_ownedStrip.GetHeight();
+        m_resyncPending = false;
+      }
+      if (m_resyncCount > 0 || ++m_updatesSinceDigest >= m_digestPeriod)
+      {
+        m_shipDigest = true;
+        m_updatesSinceDigest = 0;
+        m_digest = ComputeStripDigest();
+      }
+    }
+
     PacketIO pbuffer;
-    if (!pbuffer.SendUpdateBegin(*this, m_eventCenter))
+    bool sent;
+    if (m_pipelineDepth > 1)
+    {
+      sent = pbuffer.SendSequencedUpdateBegin(*this, m_eventCenter, ou.m_sequence);
+    }
+    else
+    {
+      sent = pbuffer.SendUpdateBegin(*this, m_eventCenter);
+    }
+    if (!sent)
     {
       FAIL(ILLEGAL_STATE);
     }
   }
 
+  template <class EC>
+  bool CacheProcessor<EC>::CanPipelineEvent(Dir lockRegion, const SPoint & eventCenter)
+  {
+    if (m_pipelineDepth <= 1 || m_cpState != RECEIVING)
+    {
+      return false;
+    }
+
+    // Let the far side of a remote lock have its turn
+    if (m_lockAgent && m_lockAgent->m_peerWantsLock)
+    {
+      return false;
+    }
+
+    // Corner events need our siblings too, and unlock all together
+    if (Dirs::IsCorner(m_cacheDir) || lockRegion != m_cacheDir || m_centerRegion != m_cacheDir)
+    {
+      return false;
+    }
+
+    // Bound our tenure so the peer gets its turn at the lock
+    if (m_tenureUpdates >= m_pipelineDepth)
+    {
+      return false;
+    }
+
+    if (m_channelEnd.CanWrite() <= SEQUENCED_UPDATE_BEGIN_BYTES)
+    {
+      return false;
+    }
+
+    // Overlapping windows wait for the earlier update to be acked
+    for (u32 i = 0; i < m_outstandingCount; ++i)
+    {
+      const OutstandingUpdate & ou = m_outstanding[(m_outstandingFirst + i) % MAX_PIPELINE_DEPTH];
+      if ((eventCenter - ou.m_center).GetManhattanLength() <= 2 * R)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  template <class EC>
+  void CacheProcessor<EC>::EndPhase(u32 phase)
+  {
+    if (m_phaseStamp)
+    {
+      const u64 now = ReadCycleCounter();
+      GetTile().GetPhaseHistograms().Record(phase, now - m_phaseStamp);
+      m_phaseStamp = now;
+    }
+  }
+
   template <class EC>
   void CacheProcessor<EC>::StartLoading(const SPoint & eventCenter)
   {
@@ -88,7 +242,26 @@ namespace MFM
     MFM_API_ASSERT_STATE(m_cpState == LOADING);
 
     // If far side can't see it, done
-    if (!IsSiteNumberVisible(siteNumber))
+    const MDist<R> & md = MDist<R>::get();
+    const SPoint local = md.GetPoint(siteNumber) + m_eventCenter;
+    if (!IsCoordVisibleToPeer(local))
+    {
+      return;
+    }
+
+    // In direct mode, write changes straight into the peer's cache
+    if (m_directPeer)
+    {
+      if (changed)
+      {
+        m_directPeer->GetTile().ApplyDirectCacheUpdate(atom, LocalToRemote(local));
+        ++m_directUpdates;
+      }
+      return;
+    }
+
+    // If unchanged and covered by our strip digest, done
+    if (!changed && m_digestPeriod > 0 && IsInDigestStrip(local))
     {
       return;
     }
@@ -106,15 +279,16 @@ namespace MFM
     // Time to pack this puppy up for travel
     MFM_API_ASSERT_STATE(m_toSendCount < SITE_COUNT);  // You say ship a whole window or more?
 
-    MFM_LOG_DBG7(("CP %s %s [%s] (%d,%d) send #%d (%d,%d)",
-                  m_tile->GetLabel(),
-                  Dirs::GetName(m_cacheDir),
-                  Dirs::GetName(m_centerRegion),
-                  m_farSideOrigin.GetX(),
-                  m_farSideOrigin.GetY(),
-                  siteNumber,
-                  99,
-                  99));
+    MFM_TRACE_DBG7(*m_tile, TRACE_CP_SEND, m_cacheDir, siteNumber, 0,
+                   ("CP %s %s [%s] (%d,%d) send #%d (%d,%d)",
+                    m_tile->GetLabel(),
+                    Dirs::GetName(m_cacheDir),
+                    Dirs::GetName(m_centerRegion),
+                    m_farSideOrigin.GetX(),
+                    m_farSideOrigin.GetY(),
+                    siteNumber,
+                    99,
+                    99));
 
     // Allocate next struct
     CachePacketInfo & cpi = m_toSend[m_toSendCount++];
@@ -138,16 +312,19 @@ namespace MFM
     u8 byte = (u8) plen;  // plen<128 since OString128..
     m_channelEnd.Write(&byte, 1);  // Packet length, then data
     m_channelEnd.Write((const u8 *) pb.GetBuffer(), plen);
+    ++m_packetsShipped;
+    m_bytesShipped += plen + 1;
     return true;
   }
 
   template <class EC>
-  void CacheProcessor<EC>::BeginUpdate(SPoint onCenter)
+  void CacheProcessor<EC>::BeginUpdate(SPoint onCenter, s32 sequence)
   {
     MFM_API_ASSERT_STATE(m_cpState == IDLE);
 
     SetStateInternal(PASSIVE);
     m_eventCenter = onCenter;
+    m_replySequence = sequence;
     m_consistentAtomCount = 0;  // Ready for my update..
   }
 
@@ -220,33 +397,150 @@ namespace MFM
   void CacheProcessor<EC>::ReceiveUpdateEnd()
   {
     MFM_API_ASSERT_STATE(m_cpState == PASSIVE);
-    MFM_LOG_DBG7(("Replying to UE, %d consistent",
-                  m_consistentAtomCount));
+    MFM_TRACE_DBG7(GetTile(), TRACE_CP_REPLY_UPDATE_END, m_consistentAtomCount, 0, 0,
+                   ("Replying to UE, %d consistent",
+                    m_consistentAtomCount));
     PacketIO pbuffer;
-    pbuffer.SendReply(m_consistentAtomCount, *this);
+    if (m_replySequence >= 0)
+    {
+      pbuffer.SendSequencedReply((u8) m_replySequence, m_consistentAtomCount, *this);
+    }
+    else
+    {
+      pbuffer.SendReply(m_consistentAtomCount, *this);
+    }
     SetIdle();
   }
 
   template <class EC>
-  void CacheProcessor<EC>::ReceiveReply(u32 consistentCount)
+  void CacheProcessor<EC>::CheckDigest(u32 digest)
+  {
+    MFM_API_ASSERT_STATE(m_cpState == PASSIVE);
+    if (digest != ComputeStripDigest())
+    {
+      PacketIO pbuffer;
+      pbuffer.SendDigestMismatch(*this);
+
+      // The peer will resync its half; we resync ours on our next update
+      m_resyncPending = true;
+    }
+  }
+
+  template <class EC>
+  void CacheProcessor<EC>::ReceiveDigestMismatch()
   {
-    MFM_API_ASSERT_STATE(m_cpState == RECEIVING);
+    MFM_API_ASSERT_STATE(m_cpState == RECEIVING && m_outstandingCount > 0);
+    ++m_digestMismatches;
+    m_resyncPending = true;
+  }
+
+  template <class EC>
+  bool CacheProcessor<EC>::AdvanceRemoteLock()
+  {
+    MFM_API_ASSERT_STATE(m_lockAgent == this);
+
+    LonglivedLock & lock = GetLonglivedLock();
+    PacketIO pbuffer;
+    if (m_peerWantsLock)
+    {
+      // LOCK_GRANT and its length byte must fit before we commit
+      if (m_channelEnd.CanWrite() <= 1 || !lock.TryLock(&m_remoteLockOwner))
+      {
+        return false;
+      }
+
+      if (!pbuffer.SendLockGrant(*this))
+      {
+        FAIL(ILLEGAL_STATE);
+      }
+      m_peerWantsLock = false;
+      m_lockWanted = false;  // Anyone still wanting it will say so
+      ++m_lockGrants;
+      return true;
+    }
+
+    if (!m_lockWanted || m_lockRequested)
+    {
+      return false;
+    }
 
-    if (consistentCount != m_toSendCount)
+    if (lock.GetOwnerIndex() != &m_remoteLockOwner)
     {
+      m_lockWanted = false;  // We have the token; a sibling had the lock
+      return false;
+    }
+
+    if (!pbuffer.SendLockRequest(*this))
+    {
+      return false;
+    }
+    m_lockRequested = true;
+    m_lockWanted = false;
+    return true;
+  }
+
+  template <class EC>
+  void CacheProcessor<EC>::ReceiveLockRequest()
+  {
+    MFM_API_ASSERT_STATE(m_lockAgent == this);
+    m_peerWantsLock = true;
+  }
+
+  template <class EC>
+  void CacheProcessor<EC>::ReceiveLockGrant()
+  {
+    MFM_API_ASSERT_STATE(m_lockAgent == this && m_lockRequested);
+    MFM_API_ASSERT(GetLonglivedLock().Unlock(&m_remoteLockOwner), LOCK_FAILURE);
+    m_lockRequested = false;
+  }
+
+  template <class EC>
+  void CacheProcessor<EC>::ReceiveResync(const SPoint & site, const T & inboundAtom)
+  {
+    MFM_API_ASSERT_STATE(m_cpState == PASSIVE);
+    MFM_API_ASSERT_ARG(IsInDigestStrip(site) && !m_tile->IsOwnedSite(site));
+
+    if (inboundAtom != *m_tile->GetAtom(site))
+    {
+      m_tile->PlaceAtom(inboundAtom, site);
+    }
+  }
+
+  template <class EC>
+  void CacheProcessor<EC>::ReceiveReply(u32 consistentCount, s32 sequence)
+  {
+    MFM_API_ASSERT_STATE(m_cpState == RECEIVING && m_outstandingCount > 0);
+
+    const OutstandingUpdate & ou = m_outstanding[m_outstandingFirst];
+    MFM_API_ASSERT_STATE(sequence < 0 || (u8) sequence == ou.m_sequence);
+    const u32 toSendCount = ou.m_toSendCount;
+    m_outstandingFirst = (m_outstandingFirst + 1) % MAX_PIPELINE_DEPTH;
+    --m_outstandingCount;
+
+    if (consistentCount != toSendCount)
+    {
+      ++m_consistencyFailures;
       ReportCheckFailure();
     }
     else
     {
-      ReportCleanUpdate(m_toSendCount);
+      ReportCleanUpdate(toSendCount);
     }
-    MFM_LOG_DBG7(("CP %s %s [%s] reply %d<->%d : %d",
-                  GetTile().GetLabel(),
-                  Dirs::GetName(m_cacheDir),
-                  Dirs::GetName(m_centerRegion),
-                  consistentCount,
-                  m_toSendCount,
-                  m_checkOdds));
+    MFM_TRACE_DBG7(GetTile(), TRACE_CP_RECEIVE_REPLY, m_cacheDir, consistentCount, toSendCount,
+                   ("CP %s %s [%s] reply %d<->%d : %d",
+                    GetTile().GetLabel(),
+                    Dirs::GetName(m_cacheDir),
+                    Dirs::GetName(m_centerRegion),
+                    consistentCount,
+                    toSendCount,
+                    m_checkOdds));
+
+    if (m_outstandingCount > 0)
+    {
+      return;  // Still awaiting replies to later updates
+    }
+    m_blockingSince = GetMonotonicNanos();
+    EndPhase(PhaseHistograms::RECEIVE);
     SetStateInternal(BLOCKING);
   }
 
@@ -261,28 +555,38 @@ namespace MFM
 
     if (m_cpState != IDLE)
     {
-      MFM_LOG_DBG7(("CP %s %s Advance in state %s",
-                    GetTile().GetLabel(),
-                    Dirs::GetName(m_cacheDir),
-                    GetStateName(m_cpState)));
+      MFM_TRACE_DBG7(GetTile(), TRACE_CP_ADVANCE, m_cacheDir, m_cpState, 0,
+                     ("CP %s %s Advance in state %s",
+                      GetTile().GetLabel(),
+                      Dirs::GetName(m_cacheDir),
+                      GetStateName(m_cpState)));
     }
 
+    bool didWork;
     switch (m_cpState)
     {
-    case SHIPPING: return AdvanceShipping();
+    case SHIPPING: didWork = AdvanceShipping(); break;
     case IDLE:    // During idle we just receive
     case PASSIVE: // During passive we receive
-    case RECEIVING: return AdvanceReceiving();
-    case BLOCKING: return AdvanceBlocking();
+    case RECEIVING: didWork = AdvanceReceiving(); break;
+    case BLOCKING: didWork = AdvanceBlocking(); break;
     default:
       FAIL(ILLEGAL_STATE);
     }
+
+    // Ask for, or hand over, a lock shared with another process
+    if (m_lockAgent == this)
+    {
+      didWork |= AdvanceRemoteLock();
+    }
+    return didWork;
   }
 
   template <class EC>
   void CacheProcessor<EC>::Activate()
   {
-    MFM_API_ASSERT_STATE(m_cpState == IDLE);
+    MFM_API_ASSERT_STATE(m_cpState == IDLE ||
+                         (m_cpState == RECEIVING && m_outstandingCount > 0 && m_pipelineDepth > 1));
     SetStateInternal(ACTIVE);
   }
 
@@ -296,11 +600,12 @@ namespace MFM
   template <class EC>
   bool CacheProcessor<EC>::AdvanceShipping()
   {
-    MFM_LOG_DBG7(("CP %s %s (%d,%d): Advance shipping",
-                  GetTile().GetLabel(),
-                  Dirs::GetName(m_cacheDir),
-                  m_farSideOrigin.GetX(),
-                  m_farSideOrigin.GetY()));
+    MFM_TRACE_DBG7(GetTile(), TRACE_CP_ADVANCE_SHIPPING, m_cacheDir, 0, 0,
+                   ("CP %s %s (%d,%d): Advance shipping",
+                    GetTile().GetLabel(),
+                    Dirs::GetName(m_cacheDir),
+                    m_farSideOrigin.GetX(),
+                    m_farSideOrigin.GetY()));
     bool didWork = false;
     PacketIO pbuffer;
 
@@ -314,23 +619,53 @@ namespace MFM
       }
       didWork = true;
       ++m_sentCount;
-      MFM_LOG_DBG7(("CP %s %s: Ship %d (site #%d)",
-                    GetTile().GetLabel(),
-                    Dirs::GetName(m_cacheDir),
-                    m_sentCount,
-                    cpi.m_siteNumber));
+      if (cpi.m_type == PacketType::UPDATE)
+      {
+        ++m_updatePacketsShipped;
+      }
+      else
+      {
+        ++m_checkPacketsShipped;
+      }
+      MFM_TRACE_DBG7(GetTile(), TRACE_CP_SHIP, m_cacheDir, m_sentCount, cpi.m_siteNumber,
+                     ("CP %s %s: Ship %d (site #%d)",
+                      GetTile().GetLabel(),
+                      Dirs::GetName(m_cacheDir),
+                      m_sentCount,
+                      cpi.m_siteNumber));
+    }
+
+    // Then any owned strip sites being resynced
+    while (m_resyncSentCount < m_resyncCount)
+    {
+      const SPoint site = GetOwnedStripSite(m_resyncSentCount);
+      if (!pbuffer.SendResync(*this, site, *GetTile().GetAtom(site)))
+      {
+        return didWork;
+      }
+      didWork = true;
+      ++m_resyncSentCount;
+      ++m_resyncPacketsShipped;
     }
 
     // Try to send the update end packet if not yet sent
     if (m_sentCount == m_toSendCount)
     {
-      if (!pbuffer.SendUpdateEnd(*this))
+      const bool sent = m_shipDigest ?
+        pbuffer.SendUpdateEndDigest(*this, m_digest) :
+        pbuffer.SendUpdateEnd(*this);
+      if (!sent)
       {
         return didWork;
       }
+      if (m_shipDigest)
+      {
+        ++m_digestsShipped;
+      }
       didWork = true;
     }
 
+    EndPhase(PhaseHistograms::SHIP);
     SetStateInternal(RECEIVING);
     return didWork;
   }
@@ -353,6 +688,8 @@ namespace MFM
         return didWork;
       }
       didWork = true;
+      ++m_packetsReceived;
+      m_bytesReceived += pb->GetLength() + 1;
       if (!pio.HandlePacket(*this, *pb))
       {
         FAIL(INCOMPLETE_CODE);
@@ -365,6 +702,10 @@ namespace MFM
   {
     MFM_API_ASSERT_STATE(m_cpState == BLOCKING);
 
+    m_blockingNanos += GetMonotonicNanos() - m_blockingSince;
+    EndPhase(PhaseHistograms::BLOCK);
+    m_phaseStamp = 0;
+    m_tenureUpdates = 0;
     SetIdle();
     m_centerRegion = (Dir) -1;
     Unlock();  // FINALLY
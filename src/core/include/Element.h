@@ -98,6 +98,12 @@ namespace MFM
      */
     bool m_renderLowlight;
 
+    /**
+     * Counts changes to any Element's rendering colors, so renderers
+     * caching atom colors can tell when to redraw.
+     */
+    static u32 m_physicsColorChanges;
+
     /**
      * The basic, most generic Atom of this Element to be used when
      * placing a new Atom.
@@ -115,6 +121,29 @@ namespace MFM
      */
     const char* m_name;
 
+   public:
+
+    /**
+     * A plain function equivalent to an Element's Behavior method,
+     * which an Element may supply so that ElementTable can dispatch
+     * to it without a virtual call.  \sa SetBehaviorFunction
+     */
+    typedef void (*BehaviorFunction)(const Element<EC> & elt, EventWindow<EC>& window);
+
+   private:
+
+    /**
+     * The optional direct-dispatch equivalent of Behavior, or 0 if
+     * this Element is dispatched virtually.
+     */
+    BehaviorFunction m_behaviorFunction;
+
+    /**
+     * A flag declaring that Atoms of this Element have no behavior
+     * and are never changed by their own events.  \sa SetInert
+     */
+    bool m_isInert;
+
    public:
 
     /**
@@ -219,6 +248,36 @@ namespace MFM
       m_name = name;
     }
 
+    /**
+     * Supplies a plain function that ElementTable will call instead
+     * of the virtual Behavior method when an Atom of this Element is
+     * the center of an event.  \a fn must have exactly the effect of
+     * Behavior, which remains in use by any caller that does not go
+     * through ElementTable.  This must be set before the Element is
+     * registered in any Tile, normally in the constructor.
+     *
+     * @param fn The behavior function, or 0 to use virtual dispatch.
+     */
+    void SetBehaviorFunction(BehaviorFunction fn)
+    {
+      m_behaviorFunction = fn;
+    }
+
+    /**
+     * Declares that an event centered on an Atom of this Element does
+     * nothing at all: Behavior is empty and no site in the event
+     * window ever changes.  Events on inert Atoms are still counted,
+     * but skip locking, window loading, behavior dispatch and
+     * write-back entirely.  Like SetBehaviorFunction, this must be
+     * set before the Element is registered in any Tile.
+     *
+     * @param inert \c true if this Element is inert.
+     */
+    void SetInert(bool inert)
+    {
+      m_isInert = inert;
+    }
+
    public:
 
     /**
@@ -232,7 +291,9 @@ namespace MFM
                                  m_hasType(false),
                                  m_renderLowlight(false),
                                  m_atomicSymbol("!!"),
-                                 m_name("UNNAMED")
+                                 m_name("UNNAMED"),
+                                 m_behaviorFunction(0),
+                                 m_isInert(false)
     {
       LOG.Debug("Constructed %@ at %p", &m_UUID, this);
     }
@@ -363,6 +424,30 @@ namespace MFM
      */
     virtual void Behavior(EventWindow<EC>& window) const = 0;
 
+    /**
+     * Gets the direct-dispatch equivalent of Behavior for this
+     * Element, if it has supplied one.
+     *
+     * @returns The BehaviorFunction of this Element, or 0 if it must
+     *          be dispatched through Behavior.
+     */
+    BehaviorFunction GetBehaviorFunction() const
+    {
+      return m_behaviorFunction;
+    }
+
+    /**
+     * Checks whether this Element has declared itself inert.
+     *
+     * @returns \c true if events on Atoms of this Element do nothing.
+     *
+     * \sa SetInert
+     */
+    bool IsInert() const
+    {
+      return m_isInert;
+    }
+
     /**
        Downcast an Element pointer to an UlamElement pointer, if
        possible.
@@ -464,6 +549,16 @@ namespace MFM
     void ToggleLowlightPhysicsColor()
     {
       m_renderLowlight = !m_renderLowlight;
+      ++m_physicsColorChanges;
+    }
+
+    /**
+     * Gets a count that changes whenever the rendering colors of any
+     * Element may have changed.
+     */
+    static u32 GetPhysicsColorChanges()
+    {
+      return m_physicsColorChanges;
     }
 
     /**
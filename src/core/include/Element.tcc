@@ -4,4 +4,6 @@
 
 namespace MFM
 {
+  template <class EC>
+  u32 Element<EC>::m_physicsColorChanges = 0;
 }
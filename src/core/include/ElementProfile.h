@@ -0,0 +1,80 @@
+/*                                              -*- mode:C++ -*-
+  ElementProfile.h Behavior costs of one Element in one or more Tiles
+  Copyright (C) 2014 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file ElementProfile.h Behavior costs of one Element in one or more Tiles
+  \author David H. Ackley.
+  \date (C) 2014 All rights reserved.
+  \lgpl
+ */
+#ifndef ELEMENTPROFILE_H
+#define ELEMENTPROFILE_H
+
+#include "itype.h"
+#include "Util.h"  /* For MAX */
+
+namespace MFM
+{
+
+  /**
+   * What the behavior of one Element has cost, as recorded by an
+   * ElementTable while profiling, or the sum of such records over
+   * several Tiles.  Cycles are ReadCycleCounter ticks.
+   */
+  struct ElementProfile
+  {
+    u64 m_calls;         ///< Behaviors run
+    u64 m_cycles;        ///< Total ticks spent in those behaviors
+    u64 m_maxCycles;     ///< Ticks spent in the longest one
+    u64 m_sitesWritten;  ///< Sites their events changed
+
+    ElementProfile()
+    {
+      Clear();
+    }
+
+    void Clear()
+    {
+      m_calls = m_cycles = m_maxCycles = m_sitesWritten = 0;
+    }
+
+    void RecordCall(u64 cycles)
+    {
+      ++m_calls;
+      m_cycles += cycles;
+      m_maxCycles = MAX(m_maxCycles, cycles);
+    }
+
+    /**
+     * Adds \c other into this ElementProfile, keeping the larger
+     * maximum.
+     */
+    void Add(const ElementProfile & other)
+    {
+      m_calls += other.m_calls;
+      m_cycles += other.m_cycles;
+      m_maxCycles = MAX(m_maxCycles, other.m_maxCycles);
+      m_sitesWritten += other.m_sitesWritten;
+    }
+  };
+
+} /* namespace MFM */
+
+#endif /*ELEMENTPROFILE_H*/
@@ -33,6 +33,7 @@
 #include "itype.h"
 #include "Element.h"
 #include "Element_Empty.h"
+#include "ElementProfile.h"
 
 namespace MFM
 {
@@ -48,7 +49,12 @@ namespace MFM
     typedef typename AC::ATOM_TYPE T;
     enum { B = AC::ATOM_TYPE_BITS};
     enum { R = EC::EVENT_WINDOW_RADIUS};
-    //XXX currently deprecated    enum { ELEMENT_DATA_SLOTS = P::ELEMENT_DATA_SLOTS};
+
+    /**
+     * The u64's of element-specific data available to all the
+     * Elements in one ElementTable.
+     */
+    enum { ELEMENT_DATA_SLOTS = 16 };
 
   public:
     // -3 to avoid 2**k and 2**k-1 sizes; they seem to beat against type assignments
@@ -121,12 +127,67 @@ namespace MFM
     /**
      * Executes the behavior method of the Element in the center of a
      * specified EventWindow. This method finds the central Element by
-     * the type of the Atom located there, then executes its behavior.
+     * the type of the Atom located there, then executes its behavior,
+     * directly through the Element's BehaviorFunction if it supplied
+     * one, or else through its virtual Behavior method.
      *
      * @param window The EventWindow to execute an event upon.
      */
     void Execute(EventWindow<EC>& window) ;
 
+    /**
+     * Checks whether an event on an Atom of a given type would do
+     * nothing, because its type is registered here and its Element
+     * has declared itself inert.
+     *
+     * @param elementType The type of the Atom at an event center.
+     *
+     * @returns \c true if \c elementType is a registered, inert type.
+     *
+     * \sa Element::SetInert
+     */
+    bool IsInertType(u32 elementType) const
+    {
+      return m_hash[SlotFor(elementType)].m_inert;
+    }
+
+    /**
+     * Starts or stops recording, in each Element's ElementProfile,
+     * what its behaviors cost as Execute runs them.  Profiles are
+     * kept until Reinit, whether or not profiling is on.
+     */
+    void SetProfiling(bool on)
+    {
+      m_profiling = on;
+    }
+
+    bool IsProfiling() const
+    {
+      return m_profiling;
+    }
+
+    /**
+     * Gets the ElementProfile of the Element of type \c elementType,
+     * or null if no such Element is registered here.
+     */
+    const ElementProfile * GetProfile(u32 elementType) const
+    {
+      const ElementEntry & entry = m_hash[SlotFor(elementType)];
+      return entry.m_element ? &entry.m_profile : 0;
+    }
+
+    /**
+     * While profiling, charges \c count written sites to the Element
+     * whose behavior Execute last ran, if any.
+     */
+    void NoteSitesWritten(u32 count)
+    {
+      if (m_lastProfile)
+      {
+        m_lastProfile->m_sitesWritten += count;
+      }
+    }
+
     /**
      * Inserts an Element into this ElementTable.
      *
@@ -160,8 +221,8 @@ namespace MFM
      *   element-specific data but now has SLOTS of element-specific
      *   data allocated for it, as a result of this call.
      *
-     * In the case of a true return, note that the resulting slots
-     * have no particular values.
+     * In the case of a true return, slots newly allocated by this
+     * call are zeroed before any other thread can see them.
      */
     bool AllocateElementDataSlots(const Element<EC>& e, u32 slots) ;
 
@@ -186,6 +247,18 @@ namespace MFM
 
     u64 * GetElementDataSlotsFromType(const u32 elementType, const u32 slots) ;
 
+    /**
+     * Access the SLOTS u64's of element-specific data associated with
+     * elementType, allocating them first if need be.  FAILs with
+     * ILLEGAL_STATE if they cannot be allocated.
+     *
+     * Element-specific data is written without locks, so it must
+     * only be written by the thread driving the Tile that owns this
+     * ElementTable -- as by an Element's behavior -- and other
+     * threads may only read it.  To count something per epoch,
+     * readers should remember the values they last saw rather than
+     * resetting the slots (see StatsRenderer::ElementDataSlotSum).
+     */
     u64 * GetDataAndRegister(const u32 elementType, u32 slots) ;
 
     u64 * GetDataIfRegistered(const u32 elementType, u32 slots) ;
@@ -207,17 +280,39 @@ namespace MFM
     struct ElementEntry {
       void Clear() {
         m_element = 0;
+        m_behavior = 0;
+        m_inert = false;
         m_elementDataStart = 0;
         m_elementDataLength = 0;
+        m_profile.Clear();
       }
       const Element<EC>* m_element;
+      typename Element<EC>::BehaviorFunction m_behavior; // 0 means use m_element->Behavior
+      bool m_inert;
       u16 m_elementDataStart;
       u16 m_elementDataLength;
+      ElementProfile m_profile;
     } m_hash[SIZE];
     u32 m_hashSlotsInUse;
 
-    //XXX    u64 m_elementData[ELEMENT_DATA_SLOTS];
-    //XXX    u32 m_nextFreeElementDataIndex;
+    bool m_profiling;
+
+    /**
+     * While profiling, the profile of the Element Execute last ran,
+     * else null.
+     */
+    ElementProfile * m_lastProfile;
+
+    static void RunBehavior(const ElementEntry & entry, EventWindow<EC>& window)
+    {
+      if (entry.m_behavior)
+        entry.m_behavior(*entry.m_element, window);
+      else
+        entry.m_element->Behavior(window);
+    }
+
+    u64 m_elementData[ELEMENT_DATA_SLOTS];
+    u32 m_nextFreeElementDataIndex;
 
   };
 
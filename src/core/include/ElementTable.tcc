@@ -47,6 +47,8 @@ namespace MFM {
       if (++m_hashSlotsInUse > SIZE/2)
         FAIL(OUT_OF_ROOM);
       m_hash[slotFor].m_element = &theElement;
+      m_hash[slotFor].m_behavior = theElement.GetBehaviorFunction();
+      m_hash[slotFor].m_inert = theElement.IsInert();
 
     }
   }
@@ -60,6 +62,8 @@ namespace MFM {
   template <class EC>
   void ElementTable<EC>::Execute(EventWindow<EC>& window)
   {
+    m_lastProfile = 0;
+
     T atom = window.GetCenterAtomDirect();
     if (!atom.IsSane())
     {
@@ -75,9 +79,19 @@ namespace MFM {
     u32 type = atom.GetType();
     if(type != Element_Empty<EC>::THE_INSTANCE.GetType())
     {
-      const Element<EC> * elt = Lookup(type);
-      if (elt == 0) FAIL(UNKNOWN_ELEMENT);
-      elt->Behavior(window);
+      ElementEntry & entry = m_hash[SlotFor(type)];
+      if (entry.m_element == 0) FAIL(UNKNOWN_ELEMENT);
+      if (m_profiling)
+      {
+        const u64 start = ReadCycleCounter();
+        RunBehavior(entry, window);
+        entry.m_profile.RecordCall(ReadCycleCounter() - start);
+        m_lastProfile = &entry.m_profile;
+      }
+      else
+      {
+        RunBehavior(entry, window);
+      }
     }
   }
 
@@ -90,11 +104,11 @@ namespace MFM {
 
   template <class EC>
   ElementTable<EC>::ElementTable()
+    : m_profiling(false)
   {
     Reinit();
   }
 
-#if 0
   template <class EC>
   bool ElementTable<EC>::AllocateElementDataSlots(const Element<EC>& e, u32 slots)
   {
@@ -115,9 +129,14 @@ namespace MFM {
       if (m_nextFreeElementDataIndex+slots > ELEMENT_DATA_SLOTS)
         return false;
 
-      m_hash[index].m_elementDataLength = slots;
       m_hash[index].m_elementDataStart = m_nextFreeElementDataIndex;
+      for (u32 i = 0; i < slots; ++i)
+        m_elementData[m_nextFreeElementDataIndex + i] = 0;
       m_nextFreeElementDataIndex += slots;
+
+      // Readers on other threads check the length first
+      __sync_synchronize();
+      m_hash[index].m_elementDataLength = slots;
     }
 
     return true;
@@ -153,7 +172,7 @@ namespace MFM {
     {
 
       // Not yet registered.  If this fails, you probably need to up
-      // the EDS in your ParamConfig.
+      // ELEMENT_DATA_SLOTS.
       if (!AllocateElementDataSlotsFromType(elementType, slots))
         FAIL(ILLEGAL_STATE);
 
@@ -161,10 +180,6 @@ namespace MFM {
       datap = GetElementDataSlotsFromType(elementType, slots);
       if (!datap)
         FAIL(ILLEGAL_STATE);
-
-      // Init newly registered slots
-      for (u32 i = 0; i < slots; ++i)
-        datap[i] = 0;
     }
     return datap;
   }
@@ -174,15 +189,15 @@ namespace MFM {
   {
     return GetElementDataSlotsFromType(elementType, slots);
   }
-#endif
 
   template <class EC>
   void ElementTable<EC>::Reinit()
   {
     m_hashSlotsInUse = 0;
+    m_lastProfile = 0;
     for (u32 i = 0; i < SIZE; ++i)
       m_hash[i].Clear();
-    //XXX    m_nextFreeElementDataIndex = 0;
+    m_nextFreeElementDataIndex = 0;
   }
 
 } /* namespace MFM */
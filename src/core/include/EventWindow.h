@@ -52,7 +52,10 @@ namespace MFM
        (one and only) EventWindow.
 
      - TryEventAt first does filtering for the desired degree of
-       spatial flatness (RejectOnRecency).  Then it goes to
+       spatial flatness (RejectOnRecency).  If the center atom is of
+       an inert Element (such as Empty), the event is recorded as
+       executed and TryEventAt returns immediately, since such an
+       event could not change anything.  Otherwise it goes to
        InitForEvent, which attempts to acquire all necessary locks.
        If either filtering or locking fails, the event attempt fails.
        (If Tile::AdvanceComputation sees a false return from
@@ -100,6 +103,22 @@ namespace MFM
 
     u64 m_eventWindowsAttempted;
     u64 m_eventWindowsExecuted;
+    u64 m_eventWindowsLockFailed;
+    u64 m_eventWindowsRecencyRejected;
+    u64 m_lockFailuresByDir[Dirs::DIR_COUNT];
+
+    /**
+     * The ReadCycleCounter at the end of the last phase timed in the
+     * current event, or 0 if the current event is not being timed.
+     */
+    u64 m_phaseStamp;
+
+    /**
+     * If the current event is being timed, records the time since
+     * the last phase ended as the duration of \c phase (a
+     * PhaseHistograms::Phase).
+     */
+    void EndPhase(u32 phase) ;
 
     void RecordEventAtTileCoord(const SPoint tcoord) ;
 
@@ -112,6 +131,10 @@ namespace MFM
     T m_atomBuffer[SITE_COUNT];
     bool m_isLiveSite[SITE_COUNT];
 
+    /**
+     * The center site's Base, for the event.  Scratch, fresh for each
+     * event, if our Sites have no Base (see SiteFeatures).
+     */
     Base<AC> m_centerBase;
 
     SPoint m_center;
@@ -126,7 +149,7 @@ namespace MFM
 
     bool AcquireAllLocks(const SPoint& centerSite) ;
 
-    bool AcquireRegionLocks() ;
+    bool AcquireRegionLocks(const SPoint& centerSite) ;
 
     enum LockStatus {
       LOCK_UNNEEDED,
@@ -134,7 +157,7 @@ namespace MFM
       LOCK_ACQUIRED
     };
 
-    LockStatus AcquireDirLock(Dir dir) ;
+    LockStatus AcquireDirLock(Dir dir, const SPoint& centerSite) ;
 
     /**
        EventWindow states
@@ -178,6 +201,15 @@ namespace MFM
 
     bool RejectOnRecency(const SPoint tcoord) ;
 
+    /**
+     * Checks whether the atom at tile coordinate \c tcoord is a sane
+     * atom of an inert Element, so that an event there may be
+     * counted without being performed.  Only centers in Hidden
+     * memory qualify: no other thread writes those, so their atoms
+     * may be read without taking the locks an event would.
+     */
+    bool IsInertCenter(const SPoint tcoord) ;
+
     void ExecuteEvent() ;
 
     void ExecuteBehavior() ;
@@ -254,6 +286,22 @@ namespace MFM
       return m_eventWindowsExecuted;
     }
 
+    /**
+     * Adds this EventWindow's event and lock counters into \c
+     * counters .
+     */
+    void AddCounters(TileCounters & counters) const
+    {
+      counters.m_eventsAttempted += m_eventWindowsAttempted;
+      counters.m_eventsExecuted += m_eventWindowsExecuted;
+      counters.m_recencyRejections += m_eventWindowsRecencyRejected;
+      counters.m_lockFailures += m_eventWindowsLockFailed;
+      for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+      {
+        counters.m_lockFailuresByDir[d] += m_lockFailuresByDir[d];
+      }
+    }
+
     void Diffuse() ;
 
     bool IsFree() const
@@ -11,16 +11,26 @@ namespace MFM {
   template <class EC>
   bool EventWindow<EC>::TryEventAt(const SPoint & tcenter)
   {
-    MFM_LOG_DBG6(("EW::TryEventAt(%d,%d)",
-                  tcenter.GetX(),
-                  tcenter.GetY()));
+    MFM_TRACE_DBG6(GetTile(), TRACE_EW_TRY_EVENT, tcenter.GetX(), tcenter.GetY(), 0,
+                   ("EW::TryEventAt(%d,%d)",
+                    tcenter.GetX(),
+                    tcenter.GetY()));
     ++m_eventWindowsAttempted;
 
     if (RejectOnRecency(tcenter))
     {
+      ++m_eventWindowsRecencyRejected;
       return false;
     }
 
+    if (IsInertCenter(tcenter))
+    {
+      RecordEventAtTileCoord(tcenter);
+      return true;
+    }
+
+    m_phaseStamp = GetTile().ChoosePhaseSample() ? ReadCycleCounter() : 0;
+
     if (!InitForEvent(tcenter))
     {
       return false;
@@ -32,6 +42,17 @@ namespace MFM {
     return true;
   }
 
+  template <class EC>
+  void EventWindow<EC>::EndPhase(u32 phase)
+  {
+    if (m_phaseStamp)
+    {
+      const u64 now = ReadCycleCounter();
+      GetTile().GetPhaseHistograms().Record(phase, now - m_phaseStamp);
+      m_phaseStamp = now;
+    }
+  }
+
   template <class EC>
   void EventWindow<EC>::RecordEventAtTileCoord(const SPoint tcoord)
   {
@@ -52,13 +73,27 @@ namespace MFM {
     return !GetRandom().OddsOf(eventAge + warpFactor*t.GetSites(), 10*t.GetSites());
   }
 
+  template <class EC>
+  bool EventWindow<EC>::IsInertCenter(const SPoint tcoord)
+  {
+    Tile<EC> & t = GetTile();
+    if (!t.IsInHidden(tcoord))
+    {
+      return false;
+    }
+    const T & atom = *t.GetAtom(tcoord);
+    return atom.IsSane() && t.GetElementTable().IsInertType(atom.GetType());
+  }
+
   template <class EC>
   void EventWindow<EC>::ExecuteEvent()
   {
-    MFM_LOG_DBG6(("EW::ExecuteEvent"));
+    MFM_TRACE_DBG6(GetTile(), TRACE_EW_EXECUTE_EVENT, 0, 0, 0,
+                   ("EW::ExecuteEvent"));
     MFM_API_ASSERT_STATE(m_ewState == COMPUTE);
 
     ExecuteBehavior();
+    EndPhase(PhaseHistograms::BEHAVIOR);
 
     InitiateCommunications();
   }
@@ -66,7 +101,8 @@ namespace MFM {
   template <class EC>
   void EventWindow<EC>::InitiateCommunications()
   {
-    MFM_LOG_DBG6(("EW::InitiateCommunications"));
+    MFM_TRACE_DBG6(GetTile(), TRACE_EW_INITIATE_COMMUNICATIONS, 0, 0, 0,
+                   ("EW::InitiateCommunications"));
     MFM_API_ASSERT_STATE(m_ewState == COMPUTE);
 
     // Step 1: Write back the event window and set up the CacheProcessors
@@ -79,8 +115,9 @@ namespace MFM {
   template <class EC>
   void EventWindow<EC>::ExecuteBehavior()
   {
-    MFM_LOG_DBG6(("EW::ExecuteBehavior"));
     Tile<EC> & t = GetTile();
+    MFM_TRACE_DBG6(t, TRACE_EW_EXECUTE_BEHAVIOR, 0, 0, 0,
+                   ("EW::ExecuteBehavior"));
     unwind_protect(
     {
       if(!GetCenterAtomDirect().IsSane())
@@ -95,7 +132,8 @@ namespace MFM {
       SetCenterAtomDirect(t.GetEmptyAtom());
     },
     {
-      MFM_LOG_DBG6(("ET::Execute"));
+      MFM_TRACE_DBG6(t, TRACE_ET_EXECUTE, 0, 0, 0,
+                     ("ET::Execute"));
       t.GetElementTable().Execute(*this);
     });
   }
@@ -136,13 +174,19 @@ namespace MFM {
   template <class EC>
   bool EventWindow<EC>::InitForEvent(const SPoint & center)
   {
-    MFM_LOG_DBG6(("EW::InitForEvent(%d,%d)",center.GetX(),center.GetY()));
+    MFM_TRACE_DBG6(GetTile(), TRACE_EW_INIT_FOR_EVENT, center.GetX(), center.GetY(), 0,
+                   ("EW::InitForEvent(%d,%d)",center.GetX(),center.GetY()));
 
     MFM_API_ASSERT_STATE(IsFree());  // Don't be callin' when I'm not free
 
-    if (!AcquireAllLocks(center))
+    const bool locked = AcquireAllLocks(center);
+    EndPhase(PhaseHistograms::LOCK);
+
+    if (!locked)
     {
-      MFM_LOG_DBG6(("EW::InitForEvent - abandoned"));
+      ++m_eventWindowsLockFailed;
+      MFM_TRACE_DBG6(GetTile(), TRACE_EW_INIT_ABANDONED, 0, 0, 0,
+                     ("EW::InitForEvent - abandoned"));
       return false;
     }
 
@@ -151,11 +195,12 @@ namespace MFM {
     m_sym = PSYM_NORMAL;
 
     LoadFromTile();
+    EndPhase(PhaseHistograms::LOAD);
     return true;
   }
 
   template <class EC>
-  typename EventWindow<EC>::LockStatus EventWindow<EC>::AcquireDirLock(Dir dir)
+  typename EventWindow<EC>::LockStatus EventWindow<EC>::AcquireDirLock(Dir dir, const SPoint& centerSite)
   {
     CacheProcessor<EC> & cp = GetTile().GetCacheProcessor(dir);
 
@@ -163,36 +208,50 @@ namespace MFM {
     {
       // Whups, didn't really need that one.  Leave it null, since
       // the other loops check all MAX_CACHES_TO_UPDATE slots anyway
-      MFM_LOG_DBG6(("EW::AcquireRegionLocks - skip: %s unconnected",
-                    Dirs::GetName(dir)));
+      MFM_TRACE_DBG6(GetTile(), TRACE_EW_LOCK_UNCONNECTED, dir, 0, 0,
+                     ("EW::AcquireRegionLocks - skip: %s unconnected",
+                      Dirs::GetName(dir)));
       return LOCK_UNNEEDED;
     }
 
+    // Already ours, with earlier updates still awaiting replies?
+    if (cp.CanPipelineEvent(m_lockRegion, centerSite))
+    {
+      MFM_TRACE_DBG6(GetTile(), TRACE_EW_LOCK_ACQUIRED, dir, 0, 0,
+                     ("EW::AcquireRegionLocks, %s pipelined",
+                      Dirs::GetName(dir)));
+      return LOCK_ACQUIRED;
+    }
+
     if (!cp.IsIdle())
     {
-      MFM_LOG_DBG6(("EW::AcquireRegionLocks - fail: %s cp not idle",
-                    Dirs::GetName(dir)));
+      MFM_TRACE_DBG6(GetTile(), TRACE_EW_LOCK_NOT_IDLE, dir, 0, 0,
+                     ("EW::AcquireRegionLocks - fail: %s cp not idle",
+                      Dirs::GetName(dir)));
       return LOCK_UNAVAILABLE;
     }
 
     bool locked = cp.TryLock(m_lockRegion);
     if (!locked)
     {
-      MFM_LOG_DBG6(("EW::AcquireRegionLocks - fail: didn't get %s lock",
-                    Dirs::GetName(dir)));
+      MFM_TRACE_DBG6(GetTile(), TRACE_EW_LOCK_TAKEN, dir, 0, 0,
+                     ("EW::AcquireRegionLocks - fail: didn't get %s lock",
+                      Dirs::GetName(dir)));
       return LOCK_UNAVAILABLE;
     }
-    MFM_LOG_DBG6(("EW::AcquireRegionLocks, %s locked",
-                  Dirs::GetName(dir)));
+    MFM_TRACE_DBG6(GetTile(), TRACE_EW_LOCK_ACQUIRED, dir, 0, 0,
+                   ("EW::AcquireRegionLocks, %s locked",
+                    Dirs::GetName(dir)));
     return LOCK_ACQUIRED;
   }
 
   template <class EC>
-  bool EventWindow<EC>::AcquireRegionLocks()
+  bool EventWindow<EC>::AcquireRegionLocks(const SPoint& centerSite)
   {
     Random & random = GetRandom();
 
-    MFM_LOG_DBG6(("EW::AcquireRegionLocks"));
+    MFM_TRACE_DBG6(GetTile(), TRACE_EW_ACQUIRE_LOCKS, 0, 0, 0,
+                   ("EW::AcquireRegionLocks"));
     // We cannot still have any cacheprocessors in use
     for (u32 i = 0; i < MAX_CACHES_TO_UPDATE; ++i)
     {
@@ -201,7 +260,8 @@ namespace MFM {
 
     if (((s32) m_lockRegion) == -1)
     {
-      MFM_LOG_DBG6(("EW::AcquireRegionLocks - none needed"));
+      MFM_TRACE_DBG6(GetTile(), TRACE_EW_NO_LOCKS_NEEDED, 0, 0, 0,
+                     ("EW::AcquireRegionLocks - none needed"));
       return true;  // Nobody is needed
     }
 
@@ -220,13 +280,14 @@ namespace MFM {
       Shuffle<Dir,3>(GetRandom(),lockDirs);
     }
 
-    MFM_LOG_DBG6(("EW::AcquireRegionLocks - checking %d", needed));
+    MFM_TRACE_DBG6(tile, TRACE_EW_LOCKS_CHECKING, needed, 0, 0,
+                   ("EW::AcquireRegionLocks - checking %d", needed));
 
     u32 got = 0;
     for (s32 i = needed; --i >= 0; )
     {
       Dir dir = lockDirs[i];
-      LockStatus ls = AcquireDirLock(dir);
+      LockStatus ls = AcquireDirLock(dir, centerSite);
 
       if (ls == LOCK_UNNEEDED)
       {
@@ -238,6 +299,7 @@ namespace MFM {
 
       if (ls == LOCK_UNAVAILABLE)
       {
+        ++m_lockFailuresByDir[dir];
         break;  // Not idle or we didn't get it
       }
 
@@ -250,7 +312,8 @@ namespace MFM {
 
     if (got < needed)
     {
-      MFM_LOG_DBG6(("EW::AcquireRegionLocks - got %d but needed %d", got, needed));
+      MFM_TRACE_DBG6(tile, TRACE_EW_LOCKS_SHORT, got, needed, 0,
+                     ("EW::AcquireRegionLocks - got %d but needed %d", got, needed));
       // Opps, didn't get all, free any we got
 
       for (m_cpli.ShuffleOrReset(random); m_cpli.HasNext(); )
@@ -261,7 +324,8 @@ namespace MFM {
         {
           CacheProcessor<EC> & cp = *m_cacheProcessorsLocked[i];
           cp.Unlock();
-          MFM_LOG_DBG6(("EW::AcquireRegionLocks #%d freed", i));
+          MFM_TRACE_DBG6(tile, TRACE_EW_LOCK_FREED, i, 0, 0,
+                         ("EW::AcquireRegionLocks #%d freed", i));
           m_cacheProcessorsLocked[i] = 0;
         }
       }
@@ -276,7 +340,8 @@ namespace MFM {
 
       if (m_cacheProcessorsLocked[i])
       {
-        MFM_LOG_DBG6(("EW::AcquireRegionLocks activate #%d", i));
+        MFM_TRACE_DBG6(tile, TRACE_EW_LOCK_ACTIVATED, i, 0, 0,
+                       ("EW::AcquireRegionLocks activate #%d", i));
         m_cacheProcessorsLocked[i]->Activate();
       }
     }
@@ -289,7 +354,7 @@ namespace MFM {
   {
     Tile<EC> & t = GetTile();
     m_lockRegion = t.GetLockDirection(tileCenter);
-    return AcquireRegionLocks();
+    return AcquireRegionLocks(tileCenter);
   }
 
   template <class EC>
@@ -297,6 +362,9 @@ namespace MFM {
     : m_tile(tile)
     , m_eventWindowsAttempted(0)
     , m_eventWindowsExecuted(0)
+    , m_eventWindowsLockFailed(0)
+    , m_eventWindowsRecencyRejected(0)
+    , m_phaseStamp(0)
     , m_center(0,0)
     , m_lockRegion(-1)
     , m_sym(PSYM_NORMAL)
@@ -304,6 +372,11 @@ namespace MFM {
   {
     m_cpli.Shuffle(GetRandom());
 
+    for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+    {
+      m_lockFailuresByDir[d] = 0;
+    }
+
     for (u32 i = 0; i < SITE_COUNT; ++i)
     {
       m_isLiveSite[i] = false;
@@ -344,7 +417,7 @@ namespace MFM {
     const MDist<R> & md = MDist<R>::get();
     Tile<EC> & tile = GetTile();
 
-    m_centerBase = tile.GetSite(SPoint(0,0)).GetBase();
+    tile.GetSite(SPoint(0,0)).LoadBase(m_centerBase);
 
     for (u32 i = 0; i < SITE_COUNT; ++i)
     {
@@ -359,7 +432,8 @@ namespace MFM {
   {
     Random & random = GetRandom();
 
-    MFM_LOG_DBG6(("EW::StoreToTile"));
+    MFM_TRACE_DBG6(GetTile(), TRACE_EW_STORE_TO_TILE, 0, 0, 0,
+                   ("EW::StoreToTile"));
 
     // First initialize the cache processors
     for (m_cpli.ShuffleOrReset(random); m_cpli.HasNext(); )
@@ -376,9 +450,10 @@ namespace MFM {
     const MDist<R> & md = MDist<R>::get();
     Tile<EC> & tile = GetTile();
 
-    // Write back base changes if any
-    tile.GetSite(SPoint(0,0)).GetBase() = m_centerBase;
+    // Write back base changes if any, and if the site keeps them
+    tile.GetSite(SPoint(0,0)).StoreBase(m_centerBase);
 
+    u32 sitesWritten = 0;
     for (u32 i = 0; i < SITE_COUNT; ++i)
     {
       const SPoint & pt = md.GetPoint(i) + m_center;
@@ -389,6 +464,7 @@ namespace MFM {
         {
           tile.PlaceAtom(m_atomBuffer[i], pt);
           dirty = true;
+          ++sitesWritten;
         }
 
         // Let the CPs see even some unchanged atoms, for spot checks
@@ -402,14 +478,18 @@ namespace MFM {
       }
     }
 
-    MFM_LOG_DBG6(("EW::StoreToTile releasing"));
+    tile.GetElementTable().NoteSitesWritten(sitesWritten);
+    EndPhase(PhaseHistograms::STORE);
+
+    MFM_TRACE_DBG6(tile, TRACE_EW_STORE_RELEASING, 0, 0, 0,
+                   ("EW::StoreToTile releasing"));
     // Finally, release the cache processors to take it from here
     for (m_cpli.ShuffleOrReset(random); m_cpli.HasNext(); )
     {
       u32 i = m_cpli.Next();
       if (m_cacheProcessorsLocked[i])
       {
-        m_cacheProcessorsLocked[i]->StartShipping();
+        m_cacheProcessorsLocked[i]->StartShipping(m_phaseStamp != 0);
         m_cacheProcessorsLocked[i] = 0;
       }
     }
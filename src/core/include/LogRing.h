@@ -0,0 +1,177 @@
+/*                                              -*- mode:C++ -*-
+  LogRing.h Lock-free multiple-producer ring of log records
+  Copyright (C) 2014 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file LogRing.h Lock-free multiple-producer ring of log records
+  \author David H. Ackley.
+  \date (C) 2014 All rights reserved.
+  \lgpl
+ */
+#ifndef LOGRING_H
+#define LOGRING_H
+
+#include "itype.h"
+#include "Util.h"
+#include <string.h>  /* for memcpy */
+
+namespace MFM
+{
+
+  /**
+   * A bounded ring of fixed-size text records that any number of
+   * threads may push into without locking, and that a single thread
+   * drains.  Each slot carries a sequence number that tells
+   * producers when it is free and the consumer when it is full, so
+   * a push costs one compare-and-swap plus a copy, and never waits:
+   * if the ring is full, Push simply returns false.
+   *
+   * SLOTS must be a power of two.  Records longer than BYTES - 1
+   * bytes are truncated.
+   */
+  template <u32 SLOTS, u32 BYTES>
+  class LogRing
+  {
+  public:
+
+    LogRing() :
+      m_enqueuePos(0),
+      m_dequeuePos(0)
+    {
+      COMPILATION_REQUIREMENT<(SLOTS >= 2) && ((SLOTS & (SLOTS - 1)) == 0)>();
+      COMPILATION_REQUIREMENT<(BYTES >= 2)>();
+
+      for (u32 i = 0; i < SLOTS; ++i)
+      {
+        m_records[i].m_sequence = i;
+        m_records[i].m_tag = 0;
+        m_records[i].m_length = 0;
+        m_records[i].m_text[0] = '\0';
+      }
+    }
+
+    /**
+     * Copies a record into this LogRing.  Safe to call from any
+     * number of threads at once.
+     *
+     * @param tag An arbitrary value to store with the record.
+     *
+     * @param text The record bytes.
+     *
+     * @param length The number of bytes in \c text .
+     *
+     * @returns \c true if the record was stored, \c false if this
+     *          LogRing was full.
+     */
+    bool Push(u32 tag, const char * text, u32 length)
+    {
+      Record * rec;
+      u32 pos = m_enqueuePos;
+      while (true)
+      {
+        rec = &m_records[pos & (SLOTS - 1)];
+        u32 seq = rec->m_sequence;
+        __sync_synchronize();
+        s32 diff = (s32) (seq - pos);
+        if (diff == 0)
+        {
+          if (__sync_bool_compare_and_swap(&m_enqueuePos, pos, pos + 1))
+          {
+            break;
+          }
+          pos = m_enqueuePos;
+        }
+        else if (diff < 0)
+        {
+          return false;   // Full
+        }
+        else
+        {
+          pos = m_enqueuePos;
+        }
+      }
+
+      if (length > BYTES - 1)
+      {
+        length = BYTES - 1;
+      }
+      rec->m_tag = tag;
+      rec->m_length = length;
+      memcpy(rec->m_text, text, length);
+      rec->m_text[length] = '\0';
+
+      __sync_synchronize();
+      rec->m_sequence = pos + 1;
+      return true;
+    }
+
+    /**
+     * Removes the oldest complete record from this LogRing.  Must
+     * only be called by one thread at a time.
+     *
+     * @param tag Set to the tag passed to Push.
+     *
+     * @param buffer Receives the null-terminated record text; must
+     *               hold at least BYTES bytes.
+     *
+     * @returns The length of the record, or -1 if there was none.
+     */
+    s32 Pop(u32 & tag, char * buffer)
+    {
+      u32 pos = m_dequeuePos;
+      Record & rec = m_records[pos & (SLOTS - 1)];
+      if (rec.m_sequence != pos + 1)
+      {
+        return -1;        // Empty, or producer still copying
+      }
+      __sync_synchronize();
+
+      tag = rec.m_tag;
+      u32 length = rec.m_length;
+      memcpy(buffer, rec.m_text, length + 1);
+
+      __sync_synchronize();
+      rec.m_sequence = pos + SLOTS;
+      m_dequeuePos = pos + 1;
+      return (s32) length;
+    }
+
+  private:
+
+    struct Record
+    {
+      volatile u32 m_sequence;
+      u32 m_tag;
+      u32 m_length;
+      char m_text[BYTES];
+    };
+
+    Record m_records[SLOTS];
+
+    volatile u32 m_enqueuePos;
+
+    u32 m_dequeuePos;
+
+    LogRing(const LogRing &) ; // Declare away
+    LogRing & operator=(const LogRing &) ; // Declare away
+  };
+
+} /* namespace MFM */
+
+#endif /*LOGRING_H*/
@@ -33,15 +33,29 @@
 #include "ByteSerializable.h"
 #include "Util.h"
 #include "Mutex.h"
+#include "LogRing.h"
+#include "OverflowableCharBufferByteSink.h"
 #include <stdarg.h>
 #include <strings.h> /* for strcasecmp */
 #include <stdlib.h>  /* for abort(), strtol() */
 
-#define MFM_LOG_DBG3(args) do {if (__builtin_expect(LOG.IfLog((Logger::Level) 3),0)) {LOG.Message args ;}} while (0)
-#define MFM_LOG_DBG4(args) do {if (__builtin_expect(LOG.IfLog((Logger::Level) 4),0)) {LOG.Debug args ;}} while (0)
-#define MFM_LOG_DBG5(args) do {if (__builtin_expect(LOG.IfLog((Logger::Level) 5),0)) {LOG.Debug args ;}} while (0)
-#define MFM_LOG_DBG6(args) do {if (__builtin_expect(LOG.IfLog((Logger::Level) 6),0)) {LOG.Debug args ;}} while (0)
-#define MFM_LOG_DBG7(args) do {if (__builtin_expect(LOG.IfLog((Logger::Level) 7),0)) {LOG.Debug args ;}} while (0)
+/**
+ * The highest Logger::Level whose MFM_LOG_DBG\c n statements are
+ * compiled in.  Statements above it cost nothing at run time, no
+ * matter what level the Logger is set to.  Defaults to all levels;
+ * set at build time with e.g. 'make MFM_MAX_LOG_LEVEL=5'.
+ */
+#ifndef MFM_MAX_LOG_LEVEL
+#define MFM_MAX_LOG_LEVEL 8
+#endif
+
+#define MFM_LOG_LEVEL_KEPT(n) ((n) <= MFM_MAX_LOG_LEVEL)
+
+#define MFM_LOG_DBG3(args) do {if (MFM_LOG_LEVEL_KEPT(3) && __builtin_expect(LOG.IfLog((Logger::Level) 3),0)) {LOG.Message args ;}} while (0)
+#define MFM_LOG_DBG4(args) do {if (MFM_LOG_LEVEL_KEPT(4) && __builtin_expect(LOG.IfLog((Logger::Level) 4),0)) {LOG.Debug args ;}} while (0)
+#define MFM_LOG_DBG5(args) do {if (MFM_LOG_LEVEL_KEPT(5) && __builtin_expect(LOG.IfLog((Logger::Level) 5),0)) {LOG.Debug args ;}} while (0)
+#define MFM_LOG_DBG6(args) do {if (MFM_LOG_LEVEL_KEPT(6) && __builtin_expect(LOG.IfLog((Logger::Level) 6),0)) {LOG.Debug args ;}} while (0)
+#define MFM_LOG_DBG7(args) do {if (MFM_LOG_LEVEL_KEPT(7) && __builtin_expect(LOG.IfLog((Logger::Level) 7),0)) {LOG.Debug args ;}} while (0)
 
 namespace MFM
 {
@@ -74,6 +88,25 @@ namespace MFM
       MAX_LEVEL = ALL
     };
 
+    enum
+    {
+      /**
+       * The largest formatted message, time stamp and level included,
+       * in bytes, that asynchronous logging will pass to the writer
+       * thread.  Longer messages are truncated and marked with a
+       * trailing 'X'.
+       */
+      ASYNC_RECORD_BYTES = 256,
+
+      /**
+       * The number of formatted messages that may be waiting for the
+       * writer thread before further messages are dropped.
+       */
+      ASYNC_RECORD_SLOTS = 1024
+    };
+
+    typedef LogRing<ASYNC_RECORD_SLOTS, ASYNC_RECORD_BYTES> AsyncRing;
+
     /**
      * Translates a Level to an immutable string .
      *
@@ -250,12 +283,103 @@ namespace MFM
     Logger(ByteSink & sink, Level initialLevel) :
       m_sink(&sink),
       m_logLevel(initialLevel),
-      m_timeStamper(&m_defaultTimeStamper)
+      m_timeStamper(&m_defaultTimeStamper),
+      m_ring(0),
+      m_async(false),
+      m_asyncStop(false),
+      m_writerActive(false),
+      m_asyncPushers(0),
+      m_droppedRecords(0),
+      m_reportedDrops(0)
     {
     }
 
     ~Logger()
     {
+      StopAsync();
+      delete m_ring;
+    }
+
+    /**
+     * Switches this Logger to asynchronous operation.  From now
+     * until StopAsync, each logged message is formatted by the
+     * calling thread into a stack buffer, after its time stamp and
+     * level, and pushed onto a lock-free ring, and a background
+     * writer thread takes messages off the ring and writes them to
+     * the ByteSink.  Logging threads never wait on the lock or on the
+     * ByteSink; if the ring is full the message is dropped and
+     * counted instead (see GetDroppedRecords).  Does nothing if
+     * this Logger is already asynchronous.
+     *
+     * FAILs with ILLEGAL_STATE if the writer thread cannot be started.
+     */
+    void StartAsync()
+    {
+      Mutex::ScopeLock lock(m_mutex);
+      if (m_async)
+      {
+        return;
+      }
+      if (!m_ring)
+      {
+        m_ring = new AsyncRing();
+      }
+      m_asyncStop = false;
+      MFM_API_ASSERT_STATE(!pthread_create(&m_writerThread, NULL, WriterRunner, this));
+      m_writerActive = true;
+      m_async = true;
+    }
+
+    /**
+     * Returns this Logger to synchronous operation, after the writer
+     * thread has written out every message already on the ring, or
+     * being pushed onto it by a thread that saw us asynchronous.
+     * Does nothing if this Logger is not asynchronous.
+     */
+    void StopAsync()
+    {
+      {
+        Mutex::ScopeLock lock(m_mutex);
+        if (!m_async)
+        {
+          return;
+        }
+        m_async = false;
+      }
+
+      // Pushers recheck m_async after counting themselves in, so
+      // once the count is zero, no more pushes can start
+      __sync_synchronize();
+      while (m_asyncPushers != 0)
+      {
+        SleepMsec(1);
+      }
+
+      m_asyncStop = true;
+      pthread_join(m_writerThread, NULL);
+      m_writerActive = false;
+    }
+
+    /**
+     * Checks whether this Logger is currently asynchronous.
+     *
+     * @returns \c true if messages are being written by a background
+     *          thread.  \sa StartAsync
+     */
+    bool IsAsync() const
+    {
+      return m_async;
+    }
+
+    /**
+     * Gets the number of messages that have been dropped because the
+     * asynchronous ring was full.
+     *
+     * @returns The total number of messages dropped by this Logger .
+     */
+    u32 GetDroppedRecords() const
+    {
+      return m_droppedRecords;
     }
 
     /**
@@ -306,13 +430,50 @@ namespace MFM
     {
       if (IfLog(level))
       {
+        if (m_async)
+        {
+          // Format on this thread's stack, stamped now rather than
+          // when the writer gets to it.  ByteSink::Vprintf can only
+          // FAIL on a malformed format, which reaches the caller's
+          // unwind_protect, if any.  Keep ap for the fallback below.
+          OverflowableCharBufferByteSink<ASYNC_RECORD_BYTES> buf;
+          {
+            Mutex::ScopeLock lock(m_stampMutex);
+            buf.Printf("%@%s: ", m_timeStamper, StrLevel(level));
+          }
+          va_list recordAp;
+          __builtin_va_copy(recordAp, ap);
+          buf.Vprintf(format, recordAp);
+          va_end(recordAp);
+
+          // Count ourselves in, so StopAsync can't finish while we
+          // push, then make sure it hadn't already begun
+          __sync_fetch_and_add(&m_asyncPushers, 1);
+          if (m_async)
+          {
+            if (!m_ring->Push((u32) level, buf.GetBuffer(), buf.GetLength()))
+            {
+              __sync_fetch_and_add(&m_droppedRecords, 1);
+            }
+            __sync_fetch_and_sub(&m_asyncPushers, 1);
+            return;
+          }
+          __sync_fetch_and_sub(&m_asyncPushers, 1);
+
+          // Too late for the ring; write it ourselves, in full, below
+        }
+
+        WaitForWriter();
         Mutex::ScopeLock lock(m_mutex); // Hold lock for this block
         unwind_protect(
         {
           abort(); // Logger is not prepared to handle failures during printing!
         },
         {
-          m_sink->Printf("%@%s: ",m_timeStamper, StrLevel(level));
+          {
+            Mutex::ScopeLock stampLock(m_stampMutex);
+            m_sink->Printf("%@%s: ",m_timeStamper, StrLevel(level));
+          }
           m_sink->Vprintf(format, ap);
           m_sink->Println();
         });
@@ -420,12 +581,92 @@ namespace MFM
     ByteSink * m_sink;
     Level m_logLevel;
 
+    static void * WriterRunner(void * arg)
+    {
+      ((Logger *) arg)->WriterLoop();
+      return NULL;
+    }
+
+    /**
+     * Waits out the end of a StopAsync, so that a message written
+     * synchronously can't get ahead of messages still on the ring.
+     */
+    void WaitForWriter()
+    {
+      while (m_writerActive)
+      {
+        SleepMsec(1);
+      }
+    }
+
+    void WriterLoop()
+    {
+      while (!m_asyncStop)
+      {
+        if (!Drain())
+        {
+          SleepMsec(1);
+        }
+      }
+      Drain();
+    }
+
+    /**
+     * Writes out everything currently on the ring, followed by a
+     * note if any messages have been dropped since the last note.
+     * Runs only on the writer thread.
+     *
+     * @returns \c true if anything was written.
+     */
+    bool Drain()
+    {
+      char text[ASYNC_RECORD_BYTES];
+      u32 level;
+      bool any = false;
+      s32 len;
+
+      while ((len = m_ring->Pop(level, text)) >= 0)
+      {
+        Mutex::ScopeLock lock(m_mutex);
+        unwind_protect(
+        {
+          abort(); // Logger is not prepared to handle failures during printing!
+        },
+        {
+          m_sink->WriteBytes((const u8 *) text, (u32) len);  // Stamped already
+          m_sink->Println();
+        });
+        any = true;
+      }
+
+      u32 dropped = m_droppedRecords;
+      if (dropped != m_reportedDrops)
+      {
+        Mutex::ScopeLock lock(m_mutex);
+        {
+          Mutex::ScopeLock stampLock(m_stampMutex);
+          m_sink->Printf("%@%s: ", m_timeStamper, StrLevel(WARNING));
+        }
+        m_sink->Printf("[%d log messages dropped]", dropped - m_reportedDrops);
+        m_sink->Println();
+        m_reportedDrops = dropped;
+        any = true;
+      }
+      return any;
+    }
+
     /**
      * A lock to ensure only one thread does logging at a time; the
      * underlying ByteSink routines are not thread-safe.
      */
     Mutex m_mutex;
 
+    /**
+     * Serializes calls to m_timeStamper, which asynchronous loggers
+     * make on their own threads without holding m_mutex.
+     */
+    Mutex m_stampMutex;
+
     class DefaultTimeStamper : public ByteSerializable
     {
       u32 m_calls;
@@ -445,6 +686,30 @@ namespace MFM
     } m_defaultTimeStamper;
     ByteSerializable * m_timeStamper;
 
+    /**
+     * The ring of formatted messages awaiting the writer thread,
+     * allocated on the first StartAsync and kept thereafter.
+     */
+    AsyncRing * m_ring;
+
+    volatile bool m_async;
+
+    volatile bool m_asyncStop;
+
+    volatile bool m_writerActive;  // From StartAsync until StopAsync joins
+
+    /**
+     * The number of threads between checking m_async and finishing
+     * their Push (see Vreport and StopAsync).
+     */
+    volatile u32 m_asyncPushers;
+
+    pthread_t m_writerThread;
+
+    volatile u32 m_droppedRecords;
+
+    u32 m_reportedDrops;
+
   };
 
   extern Logger LOG;
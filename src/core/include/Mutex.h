@@ -66,6 +66,11 @@ namespace MFM
 
     void CondWait(pthread_cond_t & condvar)
     {
+      // The wait releases the lock without going through
+      // Mutex::Unlock; simulate its effects
+      m_locked = false;
+      m_threadId = 0;
+
       MFM_API_ASSERT(!pthread_cond_wait(&condvar, &m_lock), LOCK_FAILURE);
 
       // The signal gave us back the lock without going through
@@ -205,6 +205,29 @@ namespace MFM {
       return this->m_bits.Write(P3_STATE_BITS_POS + stateIndex, stateWidth, value);
     }
 
+    /**
+     * Read LEN state bits starting at IDX, as GetStateField(IDX,LEN),
+     * but with the field position fixed at compile time.
+     */
+    template <u32 IDX, u32 LEN>
+    u32 GetStateField() const
+    {
+      COMPILATION_REQUIREMENT< IDX + LEN <= P3_STATE_BITS_LEN >();
+      return this->m_bits.template Read<P3_STATE_BITS_POS + IDX, LEN>();
+    }
+
+    /**
+     * Store value into LEN state bits starting at IDX, as
+     * SetStateField(IDX,LEN,value), but with the field position
+     * fixed at compile time.
+     */
+    template <u32 IDX, u32 LEN>
+    void SetStateField(u32 value)
+    {
+      COMPILATION_REQUIREMENT< IDX + LEN <= P3_STATE_BITS_LEN >();
+      this->m_bits.template Write<P3_STATE_BITS_POS + IDX, LEN>(value);
+    }
+
     void PrintBits(ByteSink & ostream) const
     { this->m_bits.Print(ostream); }
 
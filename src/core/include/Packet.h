@@ -84,6 +84,61 @@ namespace MFM
      */
     static const u8 UPDATE_ACK = 'a';
 
+    /**
+     * The PacketType when an updater using the pipelined protocol is
+     * initiating a new cache update, which may be sent before the
+     * replies to its earlier updates have arrived.  Format:
+     * SEQUENCED_UPDATE_BEGIN + s16:CX + s16:CY + u8:SEQUENCE
+     */
+    static const u8 SEQUENCED_UPDATE_BEGIN = 'B';
+
+    /**
+     * The PacketType when an updatee has received the UPDATE_END of
+     * an update begun by SEQUENCED_UPDATE_BEGIN, echoing its
+     * sequence number.  Format: SEQUENCED_UPDATE_ACK + u8:SEQUENCE +
+     * u8:CONSISTENT_ATOM_COUNT
+     */
+    static const u8 SEQUENCED_UPDATE_ACK = 'A';
+
+    /**
+     * The PacketType when an updater has sent all packets it intends
+     * to for this cache update, and supplies a digest of the strip of
+     * sites that only it and the updatee hold, for the updatee to
+     * compare against its own.  Format: UPDATE_END_DIGEST + u32:DIGEST
+     */
+    static const u8 UPDATE_END_DIGEST = 'd';
+
+    /**
+     * The PacketType when an updatee found its strip digest differed
+     * from the one in an UPDATE_END_DIGEST.  Precedes the reply to
+     * that update.  Format: DIGEST_MISMATCH
+     */
+    static const u8 DIGEST_MISMATCH = 'm';
+
+    /**
+     * The PacketType when an updater is resending a site of its own
+     * half of the digest strip after a digest mismatch found by
+     * either side, with its coordinate
+     * mapped into the updatee's full untransformed coordinate space.
+     * Format: RESYNC + s16:X + s16:Y + T:ATOM
+     */
+    static const u8 RESYNC = 'r';
+
+    /**
+     * The PacketType when a cache processor whose peer is in another
+     * process wants the intertile lock they share, which the peer
+     * currently holds on its side.  Format: LOCK_REQUEST
+     */
+    static const u8 LOCK_REQUEST = 'q';
+
+    /**
+     * The PacketType when a cache processor hands the intertile lock
+     * it shares with a peer in another process over to that peer,
+     * after all of its own updates have been acknowledged.  Format:
+     * LOCK_GRANT
+     */
+    static const u8 LOCK_GRANT = 'g';
+
   } /* namespace PacketType */
 
 } /* namespace MFM */
@@ -43,15 +43,37 @@ namespace MFM
     template <class EC>
     bool SendUpdateBegin(CacheProcessor<EC> & cxn, const SPoint & localCenter) ;
 
+    template <class EC>
+    bool SendSequencedUpdateBegin(CacheProcessor<EC> & cxn, const SPoint & localCenter, u8 sequence) ;
+
     template <class EC>
     bool SendUpdateEnd(CacheProcessor<EC> & cxn) ;
 
+    template <class EC>
+    bool SendUpdateEndDigest(CacheProcessor<EC> & cxn, u32 digest) ;
+
+    template <class EC>
+    bool SendDigestMismatch(CacheProcessor<EC> & cxn) ;
+
+    template <class EC>
+    bool SendResync(CacheProcessor<EC> & cxn, const SPoint & localSite,
+                    const typename EC::ATOM_CONFIG::ATOM_TYPE & atom) ;
+
+    template <class EC>
+    bool SendLockRequest(CacheProcessor<EC> & cxn) ;
+
+    template <class EC>
+    bool SendLockGrant(CacheProcessor<EC> & cxn) ;
+
     template <class EC>
     bool SendAtom(PacketTypeCode ptype, CacheProcessor<EC> & cxn,
                   u16 siteNumber, const typename EC::ATOM_CONFIG::ATOM_TYPE & atom) ;
 
     template <class EC>
-    bool SendReply(PacketTypeCode ptype, CacheProcessor<EC> & cxn) ;
+    bool SendReply(u8 consistentCount, CacheProcessor<EC> & cxn) ;
+
+    template <class EC>
+    bool SendSequencedReply(u8 sequence, u8 consistentCount, CacheProcessor<EC> & cxn) ;
 
     /**
        Parse (and dispatch to ReceiveXXX methods herein) to deal with
@@ -64,15 +86,36 @@ namespace MFM
     template <class EC>
     bool ReceiveUpdateBegin(CacheProcessor<EC> & cxn, ByteSource & buf) ;
 
+    template <class EC>
+    bool ReceiveSequencedUpdateBegin(CacheProcessor<EC> & cxn, ByteSource & buf) ;
+
     template <class EC>
     bool ReceiveAtom(CacheProcessor<EC> & cxn, ByteSource & buf) ;
 
     template <class EC>
     bool ReceiveUpdateEnd(CacheProcessor<EC> & cxn, ByteSource & buf) ;
 
+    template <class EC>
+    bool ReceiveUpdateEndDigest(CacheProcessor<EC> & cxn, ByteSource & buf) ;
+
+    template <class EC>
+    bool ReceiveDigestMismatch(CacheProcessor<EC> & cxn, ByteSource & buf) ;
+
+    template <class EC>
+    bool ReceiveResync(CacheProcessor<EC> & cxn, ByteSource & buf) ;
+
+    template <class EC>
+    bool ReceiveLockRequest(CacheProcessor<EC> & cxn, ByteSource & buf) ;
+
+    template <class EC>
+    bool ReceiveLockGrant(CacheProcessor<EC> & cxn, ByteSource & buf) ;
+
     template <class EC>
     bool ReceiveReply(CacheProcessor<EC> & cxn, ByteSource & buf) ;
 
+    template <class EC>
+    bool ReceiveSequencedReply(CacheProcessor<EC> & cxn, ByteSource & buf) ;
+
   };
 
 } /* namespace MFM */
@@ -28,6 +28,31 @@ namespace MFM
     return true;
   }
 
+  template <class EC>
+  bool PacketIO::SendSequencedUpdateBegin(CacheProcessor<EC> & cxn, const SPoint & localCenter, u8 sequence)
+  {
+    SPoint center = cxn.LocalToRemote(localCenter);
+    m_buffer.Reset();
+    m_buffer.Printf("%c%h%h%c", PacketType::SEQUENCED_UPDATE_BEGIN, center.GetX(), center.GetY(), sequence);
+    return cxn.ShipBufferAsPacket(m_buffer);
+  }
+
+  template <class EC>
+  bool PacketIO::ReceiveSequencedUpdateBegin(CacheProcessor<EC> & cxn, ByteSource & bs)
+  {
+    u8 ptype;
+    s16 cx, cy;
+    u8 sequence;
+    if (bs.Scanf("%c%h%h%c", &ptype, &cx, &cy, &sequence) != 4 ||
+        ptype != PacketType::SEQUENCED_UPDATE_BEGIN)
+    {
+      return false;
+    }
+
+    cxn.BeginUpdate(SPoint(cx, cy), sequence);
+    return true;
+  }
+
   template <class EC>
   bool PacketIO::SendUpdateEnd(CacheProcessor<EC> & cxn)
   {
@@ -44,6 +69,111 @@ namespace MFM
   }
 
 
+  template <class EC>
+  bool PacketIO::SendUpdateEndDigest(CacheProcessor<EC> & cxn, u32 digest)
+  {
+    m_buffer.Reset();
+    m_buffer.Printf("%c%l", PacketType::UPDATE_END_DIGEST, digest);
+    return cxn.ShipBufferAsPacket(m_buffer);
+  }
+
+  template <class EC>
+  bool PacketIO::ReceiveUpdateEndDigest(CacheProcessor<EC> & cxn, ByteSource & bs)
+  {
+    u8 ptype;
+    u32 digest;
+    if (bs.Scanf("%c%l", &ptype, &digest) != 2 || ptype != PacketType::UPDATE_END_DIGEST)
+    {
+      return false;
+    }
+
+    cxn.CheckDigest(digest);
+    cxn.ReceiveUpdateEnd();
+    return true;
+  }
+
+  template <class EC>
+  bool PacketIO::SendDigestMismatch(CacheProcessor<EC> & cxn)
+  {
+    m_buffer.Reset();
+    m_buffer.Printf("%c", PacketType::DIGEST_MISMATCH);
+    return cxn.ShipBufferAsPacket(m_buffer);
+  }
+
+  template <class EC>
+  bool PacketIO::ReceiveDigestMismatch(CacheProcessor<EC> & cxn, ByteSource & bs)
+  {
+    cxn.ReceiveDigestMismatch();
+    return true;
+  }
+
+  template <class EC>
+  bool PacketIO::SendLockRequest(CacheProcessor<EC> & cxn)
+  {
+    m_buffer.Reset();
+    m_buffer.Printf("%c", PacketType::LOCK_REQUEST);
+    return cxn.ShipBufferAsPacket(m_buffer);
+  }
+
+  template <class EC>
+  bool PacketIO::ReceiveLockRequest(CacheProcessor<EC> & cxn, ByteSource & bs)
+  {
+    cxn.ReceiveLockRequest();
+    return true;
+  }
+
+  template <class EC>
+  bool PacketIO::SendLockGrant(CacheProcessor<EC> & cxn)
+  {
+    m_buffer.Reset();
+    m_buffer.Printf("%c", PacketType::LOCK_GRANT);
+    return cxn.ShipBufferAsPacket(m_buffer);
+  }
+
+  template <class EC>
+  bool PacketIO::ReceiveLockGrant(CacheProcessor<EC> & cxn, ByteSource & bs)
+  {
+    cxn.ReceiveLockGrant();
+    return true;
+  }
+
+  template <class EC>
+  bool PacketIO::SendResync(CacheProcessor<EC> & cxn, const SPoint & localSite,
+                            const typename EC::ATOM_CONFIG::ATOM_TYPE & atom)
+  {
+    SPoint site = cxn.LocalToRemote(localSite);
+    m_buffer.Reset();
+    m_buffer.Printf("%c%h%h", PacketType::RESYNC, site.GetX(), site.GetY());
+    Element<EC>::GetBits(atom).PrintBytes(m_buffer);
+    return cxn.ShipBufferAsPacket(m_buffer);
+  }
+
+  template <class EC>
+  bool PacketIO::ReceiveResync(CacheProcessor<EC> & cxn, ByteSource & bs)
+  {
+    u8 ptype;
+    s16 x, y;
+    if (bs.Scanf("%c%h%h", &ptype, &x, &y) != 3 || ptype != PacketType::RESYNC)
+    {
+      return false;
+    }
+
+    typename EC::ATOM_CONFIG::ATOM_TYPE atom;
+    if (!Element<EC>::GetBits(atom).ReadBytes(bs))
+    {
+      return false;
+    }
+
+    // OK, need EOF now
+    if (bs.Read() >= 0)
+    {
+      return false;
+    }
+
+    cxn.ReceiveResync(SPoint(x, y), atom);
+    return true;
+  }
+
   template <class EC>
   bool PacketIO::SendAtom(PacketTypeCode ptype,
                           CacheProcessor<EC> & cxn,
@@ -108,6 +238,30 @@ namespace MFM
     return true;
   }
 
+  template <class EC>
+  bool PacketIO::SendSequencedReply(u8 sequence, u8 consistentCount, CacheProcessor<EC> & cxn)
+  {
+    m_buffer.Reset();
+    m_buffer.Printf("%c%c%c", PacketType::SEQUENCED_UPDATE_ACK, sequence, consistentCount);
+    return cxn.ShipBufferAsPacket(m_buffer);
+  }
+
+  template <class EC>
+  bool PacketIO::ReceiveSequencedReply(CacheProcessor<EC> & cxn, ByteSource & bs)
+  {
+    u8 ptype;
+    u8 sequence;
+    u8 consistentCount;
+    if (bs.Scanf("%c%c%c", &ptype, &sequence, &consistentCount) != 3 ||
+        ptype != PacketType::SEQUENCED_UPDATE_ACK)
+    {
+      return false;
+    }
+
+    cxn.ReceiveReply(consistentCount, sequence);
+    return true;
+  }
+
   template <class EC>
   bool PacketIO::HandlePacket(CacheProcessor<EC> & cxn, PacketBuffer & buf)
   {
@@ -117,6 +271,9 @@ namespace MFM
     case PacketType::UPDATE_BEGIN:
       return ReceiveUpdateBegin(cxn, cbs);
 
+    case PacketType::SEQUENCED_UPDATE_BEGIN:
+      return ReceiveSequencedUpdateBegin(cxn, cbs);
+
     case PacketType::UPDATE:
     case PacketType::CHECK:
       return ReceiveAtom(cxn, cbs);
@@ -124,9 +281,27 @@ namespace MFM
     case PacketType::UPDATE_END:
       return ReceiveUpdateEnd(cxn, cbs);
 
+    case PacketType::UPDATE_END_DIGEST:
+      return ReceiveUpdateEndDigest(cxn, cbs);
+
+    case PacketType::DIGEST_MISMATCH:
+      return ReceiveDigestMismatch(cxn, cbs);
+
+    case PacketType::RESYNC:
+      return ReceiveResync(cxn, cbs);
+
+    case PacketType::LOCK_REQUEST:
+      return ReceiveLockRequest(cxn, cbs);
+
+    case PacketType::LOCK_GRANT:
+      return ReceiveLockGrant(cxn, cbs);
+
     case PacketType::UPDATE_ACK:
       return ReceiveReply(cxn, cbs);
 
+    case PacketType::SEQUENCED_UPDATE_ACK:
+      return ReceiveSequencedReply(cxn, cbs);
+
     default:
       FAIL(ILLEGAL_STATE);
     }
@@ -0,0 +1,139 @@
+/*                                              -*- mode:C++ -*-
+  PhaseHistograms.h Sampled event phase latencies for one or more Tiles
+  Copyright (C) 2014 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file PhaseHistograms.h Sampled event phase latencies for one or more Tiles
+  \author David H. Ackley.
+  \date (C) 2014 All rights reserved.
+  \lgpl
+ */
+#ifndef PHASEHISTOGRAMS_H
+#define PHASEHISTOGRAMS_H
+
+#include "itype.h"
+#include "ByteSink.h"
+
+namespace MFM
+{
+
+  /**
+   * Counts of durations, in ReadCycleCounter ticks, by power of two.
+   * Bucket 0 counts durations of 0 or 1 tick, bucket \c b > 0 counts
+   * durations of 2^b up to 2^(b+1) ticks, and the last bucket also
+   * counts everything longer.
+   */
+  struct LatencyHistogram
+  {
+    enum { BUCKET_COUNT = 32 };
+
+    u64 m_buckets[BUCKET_COUNT];
+
+    static u32 GetBucket(u64 ticks)
+    {
+      if (ticks <= 1)
+      {
+        return 0;
+      }
+      const u32 log2 = 63 - __builtin_clzll(ticks);
+      return log2 < BUCKET_COUNT ? log2 : BUCKET_COUNT - 1;
+    }
+
+    void Record(u64 ticks)
+    {
+      ++m_buckets[GetBucket(ticks)];
+    }
+
+    u64 GetSamples() const ;
+
+    void Clear() ;
+
+    void Add(const LatencyHistogram & other) ;
+  };
+
+  /**
+   * One LatencyHistogram for each timed phase of an event, from
+   * acquiring the event window locks through the cache processors
+   * returning to IDLE.  The histograms live in each Tile and are
+   * written only by the thread driving it; sums of them over Tiles,
+   * or differences over time, remain histograms of the same phases.
+   */
+  struct PhaseHistograms
+  {
+    enum Phase
+    {
+      LOCK,      ///< Acquiring cache processor locks, successfully or not
+      LOAD,      ///< EventWindow::LoadFromTile
+      BEHAVIOR,  ///< EventWindow::ExecuteBehavior
+      STORE,     ///< EventWindow::StoreToTile, up to shipping
+      SHIP,      ///< A cache processor in SHIPPING
+      RECEIVE,   ///< A cache processor in RECEIVING, until its reply
+      BLOCK,     ///< A cache processor in BLOCKING, until IDLE
+      PHASE_COUNT
+    };
+
+    static const char * GetPhaseName(u32 phase) ;
+
+    /**
+     * Gets the name of the ticks the histograms count: "cycles" where
+     * ReadCycleCounter reads the time-stamp counter, else "nanos".
+     */
+    static const char * GetTickName() ;
+
+    LatencyHistogram m_phases[PHASE_COUNT];
+
+    PhaseHistograms()
+    {
+      Clear();
+    }
+
+    void Record(u32 phase, u64 ticks)
+    {
+      m_phases[phase].Record(ticks);
+    }
+
+    void Clear() ;
+
+    /**
+     * Adds every bucket of \c other into this PhaseHistograms .
+     */
+    void Add(const PhaseHistograms & other) ;
+
+    /**
+     * Prints the comma-separated column names matching each line of
+     * PrintCSV, less its \c prefix .
+     */
+    static void PrintCSVHeader(ByteSink & sink) ;
+
+    /**
+     * Prints one line per phase: \c prefix, then the phase name, its
+     * sample count, and its buckets, all comma-separated.
+     */
+    void PrintCSV(ByteSink & sink, const char * prefix) const ;
+
+    /**
+     * Prints the histograms as one JSON object holding the tick name
+     * and, for each phase by name, an array of its buckets.
+     */
+    void PrintJSON(ByteSink & sink) const ;
+  };
+
+} /* namespace MFM */
+
+#endif /*PHASEHISTOGRAMS_H*/
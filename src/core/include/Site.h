@@ -33,14 +33,111 @@
 
 namespace MFM
 {
+  /**
+     The optional parts of a Site, as bits of its FEATURES template
+     parameter.  Leaving out parts a configuration never uses keeps
+     each Site -- and so each Tile -- smaller.
+   */
+  enum SiteFeatures
+  {
+    SITE_BASE    = 0x1,  ///< A Base, with its atoms and touch sensors
+    SITE_HISTORY = 0x2,  ///< Event counts and last-changed times, for display
+    SITE_LEAN    = 0x0,  ///< Just the atom and its last event time
+    SITE_ALL     = SITE_BASE | SITE_HISTORY
+  };
 
   /**
-     A Site holds a Base and an Atom, and all information associated
-     with that Atom, such as access times, ages, and so forth.  It is
-     a template depending only on an AtomConfig (AC).
+     Where a Site keeps its Base, if it has one.  Without one, the
+     Base loaded for an event is always fresh, and any changes made
+     to it are dropped when the event is stored.
    */
+  template <class AC, bool HAS_BASE> struct SiteBaseStorage;
+
+  template <class AC>
+  struct SiteBaseStorage<AC, true>
+  {
+    Base<AC> m_base;
+
+    Base<AC> & GetBase() { return m_base; }
+    const Base<AC> & GetBase() const { return m_base; }
+
+    void LoadBase(Base<AC> & base) const { base = m_base; }
+    void StoreBase(const Base<AC> & base) { m_base = base; }
+
+    void Sense(SiteTouchType stt, s64 lastEvent)
+    {
+      m_base.GetSensory().Touch(stt, lastEvent);
+    }
+
+    SiteTouchType RecentTouch(s64 lastEvent)
+    {
+      return m_base.GetSensory().RecentTouch(lastEvent);
+    }
+
+    void NoteEvent(u64 eventNumber)
+    {
+      m_base.SetLastEventEventNumber(eventNumber);
+    }
+  };
+
   template <class AC>
+  struct SiteBaseStorage<AC, false>
+  {
+    void LoadBase(Base<AC> & base) const { base = Base<AC>(); }
+    void StoreBase(const Base<AC> &) { }
+    void Sense(SiteTouchType, s64) { }
+    SiteTouchType RecentTouch(s64) { return TOUCH_TYPE_NONE; }
+    void NoteEvent(u64) { }
+  };
+
+  /**
+     Where a Site keeps its history for display, if it does.  Without
+     it, every Site reads as never having changed.
+   */
+  template <bool HAS_HISTORY> struct SiteHistoryStorage;
+
+  template <>
+  struct SiteHistoryStorage<true>
+  {
+    u64 m_eventCount;
+    u64 m_lastChangedEventNumber;
+
+    SiteHistoryStorage()
+      : m_eventCount(0)
+      , m_lastChangedEventNumber(0)
+    { }
+
+    void ClearHistory()
+    {
+      m_eventCount = 0;
+      m_lastChangedEventNumber = 0;
+    }
+
+    u64 GetEventCount() const { return m_eventCount; }
+    u64 GetLastChangedEventNumber() const { return m_lastChangedEventNumber; }
+    void SetLastChangedEventNumber(u64 eventNumber) { m_lastChangedEventNumber = eventNumber; }
+  };
+
+  template <>
+  struct SiteHistoryStorage<false>
+  {
+    void ClearHistory() { }
+    u64 GetEventCount() const { return 0; }
+    u64 GetLastChangedEventNumber() const { return 0; }
+    void SetLastChangedEventNumber(u64) { }
+  };
+
+  /**
+     A Site holds an Atom, and, depending on FEATURES (see
+     SiteFeatures), a Base and other information associated with that
+     Atom, such as access times, ages, and so forth.  It is a template
+     depending on an AtomConfig (AC) and those features.  The parts
+     left out cost no space.
+   */
+  template <class AC, u32 FEATURES = SITE_ALL>
   class Site
+    : public SiteBaseStorage<AC, (FEATURES & SITE_BASE) != 0>
+    , public SiteHistoryStorage<(FEATURES & SITE_HISTORY) != 0>
   {
   public:
     /**
@@ -51,75 +148,80 @@ namespace MFM
     // Extract short names for parameter types
     typedef typename ATOM_CONFIG::ATOM_TYPE T;
 
+    enum {
+      HAS_BASE = (FEATURES & SITE_BASE) != 0,
+      HAS_HISTORY = (FEATURES & SITE_HISTORY) != 0
+    };
+
   private:
+    typedef SiteBaseStorage<AC, HAS_BASE> BaseStorage;
+    typedef SiteHistoryStorage<HAS_HISTORY> HistoryStorage;
+
     T m_atom;
-    Base<AC> m_base;
-    u64 m_eventCount;
-    u64 m_lastChangedEventNumber;
     s64 m_lastEventEventNumber;
-    bool m_isLiveSite;
 
   public:
     Site()
-      : m_eventCount(0)
-      , m_lastChangedEventNumber(0)
-      , m_lastEventEventNumber(S32_MIN) // init deep in past
-      , m_isLiveSite(true)
+      : m_lastEventEventNumber(S32_MIN) // init deep in past
     { }
 
     void Sense(SiteTouchType stt)
     {
-      m_base.GetSensory().Touch(stt, m_lastEventEventNumber);
+      BaseStorage::Sense(stt, m_lastEventEventNumber);
     }
 
     bool InRecentProximity()
     {
-      return TOUCH_TYPE_PROXIMITY == m_base.GetSensory().RecentTouch(m_lastEventEventNumber);
+      return TOUCH_TYPE_PROXIMITY == BaseStorage::RecentTouch(m_lastEventEventNumber);
     }
 
     bool HasRecentLightTouch()
     {
-      return TOUCH_TYPE_LIGHT == m_base.GetSensory().RecentTouch(m_lastEventEventNumber);
+      return TOUCH_TYPE_LIGHT == BaseStorage::RecentTouch(m_lastEventEventNumber);
     }
 
     void PutAtom(const T & newAtom) { m_atom = newAtom; }
     T & GetAtom() { return m_atom; }
     const T & GetAtom() const { return m_atom; }
 
-    Base<AC> & GetBase() { return m_base; }
-    const Base<AC> & GetBase() const { return m_base; }
-
     void Clear() {
       m_atom.SetEmpty();
-      m_eventCount = 0;
-      m_lastChangedEventNumber = 0;
+      HistoryStorage::ClearHistory();
 
       // Set last event deep in the past to avoid initial color
       m_lastEventEventNumber = S32_MIN; // (stored into s64..)
     }
 
-    u64 GetEventCount() const {
-      return m_eventCount;
-    }
-
-    u64 GetLastChangedEventNumber() const {
-      return m_lastChangedEventNumber;
-    }
-
-    void SetLastChangedEventNumber(u64 eventNumber) {
-      m_lastChangedEventNumber = eventNumber;
-    }
-
     s64 GetLastEventEventNumber() const {
       return m_lastEventEventNumber;
     }
 
     void SetLastEventEventNumber(u64 eventNumber) {
       m_lastEventEventNumber = (s64) eventNumber;
-      m_base.SetLastEventEventNumber(eventNumber);
+      BaseStorage::NoteEvent(eventNumber);
     }
 
   };
+
+  /**
+     Returns \c site as a Site with all features, for interfaces such
+     as Element::LocalPhysicsColor that take one: \c site itself if it
+     is one, or else \c scratch, holding a copy of its atom and last
+     event time.
+   */
+  template <class AC>
+  const Site<AC> & AsFullSite(const Site<AC> & site, Site<AC> &)
+  {
+    return site;
+  }
+
+  template <class AC, u32 FEATURES>
+  const Site<AC> & AsFullSite(const Site<AC, FEATURES> & site, Site<AC> & scratch)
+  {
+    scratch.PutAtom(site.GetAtom());
+    scratch.SetLastEventEventNumber(site.GetLastEventEventNumber());
+    return scratch;
+  }
 } /* namespace MFM */
 
 #endif /*SITE_H*/
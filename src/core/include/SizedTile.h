@@ -28,13 +28,14 @@
 #define SIZEDTILE_H
 
 #include "Tile.h"
+#include <new>  /* For placement new */
 
 namespace MFM
 {
 
   /**
      A SizedTile provides a completed Tile, possessing a size and site
-     storage, and offering a default constructor so that arrays of
+     and change-tracking storage, and offering a default constructor so that arrays of
      SizedTiles can be formed.
    */
   template <class EC, u32 SIDE>
@@ -46,10 +47,97 @@ namespace MFM
     enum { TILE_SIDE = SIDE };
     enum { TILE_SITES = TILE_SIDE * TILE_SIDE };
 
-    SizedTile() : Tile<EC>(TILE_SIDE, m_sites) { }
+    enum { CHANGE_BLOCKS_PER_SIDE =
+           (TILE_SIDE + Tile<EC>::CHANGE_BLOCK_SIDE - 1) / Tile<EC>::CHANGE_BLOCK_SIDE };
+
+    SizedTile() : Tile<EC>(TILE_SIDE, m_sites, m_blockChanges) { }
+
+    /**
+       Constructs a SizedTile as SizedTile<EC,0> would, for code that
+       handles both.  \c side must be TILE_SIDE, and \c storage is
+       unused.
+     */
+    SizedTile(u32 side, void * storage)
+      : Tile<EC>(CheckSide(side), m_sites, m_blockChanges)
+    { }
+
+    /**
+       A SizedTile holds all its own storage.
+     */
+    static u64 StorageBytes(u32 side)
+    {
+      return 0;
+    }
 
   private:
     SITE m_sites[TILE_SITES];
+    u32 m_blockChanges[CHANGE_BLOCKS_PER_SIDE * CHANGE_BLOCKS_PER_SIDE];
+
+    static u32 CheckSide(u32 side)
+    {
+      MFM_API_ASSERT_ARG(side == TILE_SIDE);
+      return side;
+    }
+  };
+
+  /**
+     A SizedTile<EC,0> is a Tile whose size is chosen at runtime, and
+     whose site and change-tracking storage -- StorageBytes(side)
+     bytes, aligned for a SITE, that outlive the Tile -- is provided
+     by its creator.  It runs the same code as any Tile; what a
+     compile-time SIDE adds is only the storage inside the object.
+   */
+  template <class EC>
+  class SizedTile<EC,0> : public Tile<EC>
+  {
+  public:
+    typedef typename EC::SITE SITE;
+
+    SizedTile(u32 side, void * storage)
+      : Tile<EC>(side, NewSites(side, storage), GetBlockChanges(side, storage))
+    { }
+
+    ~SizedTile()
+    {
+      SITE * sites = &this->GetSite(SPoint(0, 0));
+      const u32 count = this->TILE_SIDE * this->TILE_SIDE;
+      for (u32 i = 0; i < count; ++i)
+      {
+        sites[i].~SITE();
+      }
+    }
+
+    static u64 StorageBytes(u32 side)
+    {
+      const u32 blocks = Tile<EC>::GetChangeBlocksPerSide(side);
+      return SitesBytes(side) + ((u64) blocks) * blocks * sizeof(u32);
+    }
+
+  private:
+    static u64 SitesBytes(u32 side)
+    {
+      return ((u64) side) * side * sizeof(SITE);
+    }
+
+    static SITE * NewSites(u32 side, void * storage)
+    {
+      MFM_API_ASSERT_NONNULL(storage);
+      SITE * sites = (SITE *) storage;
+      for (u32 i = 0; i < side * side; ++i)
+      {
+        new (&sites[i]) SITE();
+      }
+      return sites;
+    }
+
+    static u32 * GetBlockChanges(u32 side, void * storage)
+    {
+      return (u32 *) (((u8 *) storage) + SitesBytes(side));
+    }
+
+    // Not copyable
+    SizedTile(const SizedTile &) ;
+    SizedTile & operator=(const SizedTile &) ;
   };
 } /* namespace MFM */
 
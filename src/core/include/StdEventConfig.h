@@ -36,6 +36,13 @@ namespace MFM {
   typedef P3Atom StdAtom;
   typedef Site<P3AtomConfig> StdSite;
   typedef EventConfig<StdSite, 4> StdEventConfig;
+
+  /**
+     For element sets that use neither Bases nor touch sensing, and
+     runs that don't display site history.
+   */
+  typedef Site<P3AtomConfig, SITE_LEAN> StdLeanSite;
+  typedef EventConfig<StdLeanSite, 4> StdLeanEventConfig;
 }
 
 #endif /* STDEVENTCONFIG_H */
@@ -41,6 +41,8 @@
 #include "CacheProcessor.h"
 #include "UlamClass.h"
 #include "LonglivedLock.h"
+#include "TraceBuffer.h"
+#include "TileSnapshot.h"
 #include "OverflowableCharBufferByteSink.h"  /* for OString16 */
 
 namespace MFM
@@ -109,7 +111,33 @@ namespace MFM
      */
     const u32 OWNED_SIDE;
 
-    Tile(const u32 tileSide, S * sites) ;
+    /**
+     * The side length, in sites, of the square blocks for which this
+     * Tile tracks changes.
+     */
+    enum { CHANGE_BLOCK_SIDE = 8 };
+
+    /**
+     * Gets the number of change blocks along each side of a Tile with
+     * \c tileSide sites along each side.
+     */
+    static u32 GetChangeBlocksPerSide(u32 tileSide)
+    {
+      return (tileSide + CHANGE_BLOCK_SIDE - 1) / CHANGE_BLOCK_SIDE;
+    }
+
+    /**
+     * Constructs a Tile over externally-provided storage.
+     *
+     * @param tileSide The length of a side of this Tile, in sites.
+     *
+     * @param sites Storage for tileSide * tileSide sites.
+     *
+     * @param blockChanges Storage for the square of
+     *                     GetChangeBlocksPerSide(tileSide) change
+     *                     generations.
+     */
+    Tile(const u32 tileSide, S * sites, u32 * blockChanges) ;
 
     /**
        Get a const reference to the Site at position \c index of the
@@ -163,11 +191,36 @@ namespace MFM
       return OwnedCoordToTile(SPoint(GetRandom(), OWNED_SIDE, OWNED_SIDE));
     }
 
+    /**
+     * Counts the atoms of type \c atomType among this Tile's owned
+     * sites, recounting them if they may have changed.  Call only
+     * from the thread driving this Tile, or while it is paused.
+     */
     u32 GetAtomCount(ElementType atomType) const
     {
       return m_cdata.GetAtomCount(atomType);
     }
 
+    /**
+     * Gets the count of atoms of type \c atomType as of the last
+     * PublishAtomCounts, without touching the sites.  Safe to call
+     * from any thread while this Tile runs.
+     */
+    u32 GetPublishedAtomCount(ElementType atomType) const
+    {
+      return m_cdata.GetPublishedAtomCount(atomType);
+    }
+
+    /**
+     * Recounts this Tile's atoms if they may have changed, and
+     * publishes the counts for GetPublishedAtomCount.  Call only from
+     * the thread driving this Tile, and only between events.
+     */
+    void PublishAtomCounts()
+    {
+      m_cdata.RecountIfNeeded();
+    }
+
     /**
      * The maximum number of tile parameters
      */
@@ -330,7 +383,10 @@ namespace MFM
     struct CountData {
       CountData(const Tile& t)
         : m_tile(t)
-      { }
+        , m_needRecount(true)
+      {
+        for (u32 i = 0; i < ELEMENT_TABLE_SIZE; i++) m_publishedCount[i] = 0;
+      }
 
       const Tile & m_tile;
 
@@ -338,10 +394,15 @@ namespace MFM
           within this Tile.  */
       u32 m_atomCount[ELEMENT_TABLE_SIZE];
 
+      /** m_atomCount as of the last recount, for other threads to
+          read while the Tile runs.  */
+      volatile u32 m_publishedCount[ELEMENT_TABLE_SIZE];
+
       u32 m_illegalAtomCount;
 
-      /** false when the m_atomCount counts are known valid.*/
-      bool m_needRecount;
+      /** false when the m_atomCount counts are known valid.  Set by
+          whoever changes a site, possibly from another thread. */
+      volatile bool m_needRecount;
 
       void RecountAtoms() ;
 
@@ -349,9 +410,9 @@ namespace MFM
       {
         if (m_needRecount)
         {
+          m_needRecount = false;  // First, so a change mid-count isn't lost
           RecountAtoms();
         }
-        m_needRecount = false;
       }
 
       u32 GetIllegalAtomCount()
@@ -362,6 +423,8 @@ namespace MFM
 
       s32 GetAtomCount(u32 type) ;
 
+      s32 GetPublishedAtomCount(u32 type) const ;
+
       void NeedAtomRecount()
       {
         m_needRecount = true;
@@ -373,11 +436,17 @@ namespace MFM
      */
     mutable CountData m_cdata;
 
-    /** Total times we tried to acquire a lock in this Tile */
-    u64 m_lockAttempts;
+    /** Total calls to Advance that accomplished nothing */
+    u64 m_idleAdvances;
 
-    /** Total times we successfully acquired a lock in this Tile */
-    u64 m_lockAttemptsSucceeded;
+    /** Time the phases of one in this many events; 0 for none */
+    u32 m_phaseSampleOdds;
+
+    /** Events, including this one, until the next one to time */
+    u32 m_phaseSampleCountdown;
+
+    /** Durations of the phases of the timed events */
+    PhaseHistograms m_phaseHistograms;
 
     /**
      * The event number (GetEventsExecuted()) as of the last time the
@@ -409,6 +478,70 @@ namespace MFM
     CacheProcessor<EC> m_cacheProcessors[Dirs::DIR_COUNT];
     RandomDirIterator m_dirIterator;
 
+    /**
+     * Binary trace records from this Tile's MFM_TRACE_DBG trace
+     * points, written only by the thread driving this Tile.
+     */
+    TraceBuffer m_traceBuffer;
+
+    /**
+     * Published copies of m_sites, for readers on other threads.
+     */
+    TileSnapshot<S> m_snapshot;
+
+    /**
+     * Incremented whenever an atom in this Tile may have changed.
+     * Once m_directWriters is set, neighboring Tiles' threads
+     * increment it too, so from then on it is incremented atomically.
+     */
+    u32 m_changeGeneration;
+
+    /**
+     * True if neighboring Tiles may write our caches directly (see
+     * CacheProcessor::SetDirectPeer).
+     */
+    bool m_directWriters;
+
+    u32 NextChangeGeneration()
+    {
+      if (m_directWriters)
+      {
+        return __sync_add_and_fetch(&m_changeGeneration, 1);
+      }
+      return ++m_changeGeneration;
+    }
+
+    /**
+     * For each change block, the m_changeGeneration of its most
+     * recent possible change.
+     */
+    u32 * const m_blockChanges;
+
+    const u32 CHANGE_BLOCKS_PER_SIDE;
+
+    /**
+     * Records that the atom at \c pt (including caches) may have
+     * changed.
+     */
+    void NoteSiteChanged(const SPoint & pt)
+    {
+      const u32 generation = NextChangeGeneration();
+      m_blockChanges[(pt.GetY() / CHANGE_BLOCK_SIDE) * CHANGE_BLOCKS_PER_SIDE +
+                     pt.GetX() / CHANGE_BLOCK_SIDE] = generation;
+    }
+
+    /**
+     * Records that any atom in this Tile may have changed.
+     */
+    void NoteAllSitesChanged()
+    {
+      const u32 generation = NextChangeGeneration();
+      for (u32 i = 0; i < CHANGE_BLOCKS_PER_SIDE * CHANGE_BLOCKS_PER_SIDE; ++i)
+      {
+        m_blockChanges[i] = generation;
+      }
+    }
+
     bool AllCacheProcessorsIdle();
 
     /**
@@ -555,6 +688,44 @@ namespace MFM
       }
     }
 
+    /**
+     * Sets the pipeline depth of all this Tile's CacheProcessors (see
+     * CacheProcessor::SetPipelineDepth).  Call only while this Tile's
+     * thread is paused.
+     */
+    void SetCachePipelineDepth(u32 depth)
+    {
+      for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+      {
+        m_cacheProcessors[d].SetPipelineDepth(depth);
+      }
+    }
+
+    u32 GetCachePipelineDepth() const
+    {
+      return m_cacheProcessors[0].GetPipelineDepth();
+    }
+
+    /**
+     * Has all this Tile's CacheProcessors verify their peers' copies
+     * of the strips only they share by a digest every \c period
+     * updates, or by CHECK packets if \c period is 0 (see
+     * CacheProcessor::SetDigestPeriod).  Call only while this Tile's
+     * thread is paused.
+     */
+    void SetCacheDigestPeriod(u32 period)
+    {
+      for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+      {
+        m_cacheProcessors[d].SetDigestPeriod(period);
+      }
+    }
+
+    u32 GetCacheDigestPeriod() const
+    {
+      return m_cacheProcessors[0].GetDigestPeriod();
+    }
+
     double GetAverageCacheRedundancy() const
     {
       u32 count = 0;
@@ -647,10 +818,184 @@ namespace MFM
       return m_window.GetEventWindowsExecuted();
     }
 
+    /**
+     * Adds this Tile's hot-path counters, including those of its
+     * EventWindow and CacheProcessors, into \c counters .  Counters
+     * gathered while this Tile's thread is running are approximate.
+     */
+    void AddCounters(TileCounters & counters) const
+    {
+      m_window.AddCounters(counters);
+      for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+      {
+        m_cacheProcessors[d].AddCounters(counters);
+      }
+      counters.m_idleAdvances += m_idleAdvances;
+    }
+
+    /**
+     * Has this Tile time the phases of one in every \c oneIn events
+     * that get as far as trying for their locks, or of none if \c
+     * oneIn is 0.  Sampling is by count, not by Random, so turning
+     * it on does not change the course of the simulation.  Call only
+     * while this Tile's thread is paused.
+     */
+    void SetPhaseSampleOdds(u32 oneIn)
+    {
+      m_phaseSampleOdds = oneIn;
+      m_phaseSampleCountdown = oneIn;
+    }
+
+    u32 GetPhaseSampleOdds() const
+    {
+      return m_phaseSampleOdds;
+    }
+
+    /**
+     * Returns true if the phases of the event about to try for its
+     * locks should be timed.
+     */
+    bool ChoosePhaseSample()
+    {
+      if (m_phaseSampleOdds == 0 || --m_phaseSampleCountdown > 0)
+      {
+        return false;
+      }
+      m_phaseSampleCountdown = m_phaseSampleOdds;
+      return true;
+    }
+
+    /**
+     * Starts or stops profiling the behaviors of this Tile's
+     * Elements (see ElementTable::SetProfiling).  Call only while
+     * this Tile's thread is paused.
+     */
+    void SetElementProfiling(bool on)
+    {
+      m_elementTable.SetProfiling(on);
+    }
+
+    bool IsElementProfiling() const
+    {
+      return m_elementTable.IsProfiling();
+    }
+
+    PhaseHistograms & GetPhaseHistograms()
+    {
+      return m_phaseHistograms;
+    }
+
+    const PhaseHistograms & GetPhaseHistograms() const
+    {
+      return m_phaseHistograms;
+    }
+
     EventWindow<EC> & GetEventWindow() {
       return m_window;
     }
 
+    /**
+     * Gets this Tile's TraceBuffer.  Start or stop tracing only while
+     * this Tile's thread is paused.
+     */
+    TraceBuffer & GetTraceBuffer()
+    {
+      return m_traceBuffer;
+    }
+
+    /**
+     * Allocates this Tile's snapshot buffers, so that PublishSnapshot
+     * will take effect.  Call only while this Tile's thread is
+     * paused.
+     */
+    void InitSnapshots()
+    {
+      m_snapshot.Init(TILE_SIDE * TILE_SIDE,
+                      CHANGE_BLOCKS_PER_SIDE * CHANGE_BLOCKS_PER_SIDE);
+    }
+
+    /**
+     * Publishes a copy of all of this Tile's sites, including caches,
+     * and of its block change generations, if InitSnapshots has been called and GetChangeGeneration() has
+     * moved since the last publish.  Call only from the thread
+     * driving this Tile, and only between events.
+     */
+    void PublishSnapshot()
+    {
+      if (m_snapshot.IsEnabled())
+      {
+        m_snapshot.Publish(m_sites, m_changeGeneration, m_blockChanges);
+      }
+    }
+
+    /**
+     * Gets the most recently published copy of this Tile's sites,
+     * indexed like m_sites, without waiting on the thread driving
+     * this Tile.  Call from at most one other thread.
+     *
+     * @returns The snapshot sites, or null if none has been published.
+     */
+    const S * AcquireSnapshot()
+    {
+      return m_snapshot.Acquire();
+    }
+
+    /**
+     * Gets the GetChangeGeneration() of this Tile as of the snapshot
+     * last returned by AcquireSnapshot.
+     */
+    u32 GetSnapshotGeneration() const
+    {
+      return m_snapshot.GetGeneration();
+    }
+
+    /**
+     * Gets the GetBlockChangeGeneration(blockX, blockY) of this Tile
+     * as of the snapshot last returned by AcquireSnapshot.
+     */
+    u32 GetSnapshotBlockChangeGeneration(u32 blockX, u32 blockY) const
+    {
+      MFM_API_ASSERT_ARG(blockX < CHANGE_BLOCKS_PER_SIDE && blockY < CHANGE_BLOCKS_PER_SIDE);
+      return m_snapshot.GetBlockGeneration(blockY * CHANGE_BLOCKS_PER_SIDE + blockX);
+    }
+
+    /**
+     * Gets a count that increases whenever any atom in this Tile may
+     * have changed, so a renderer may skip redrawing a Tile whose
+     * generation is unchanged since it was last drawn.
+     */
+    u32 GetChangeGeneration() const
+    {
+      return m_changeGeneration;
+    }
+
+    /**
+     * Notes that neighboring Tiles' threads may now write this Tile's
+     * caches directly, so that its change generation must be kept
+     * atomically.  Call before this Tile runs.
+     */
+    void AllowDirectWriters()
+    {
+      m_directWriters = true;
+    }
+
+    u32 GetChangeBlocksPerSide() const
+    {
+      return CHANGE_BLOCKS_PER_SIDE;
+    }
+
+    /**
+     * Gets the GetChangeGeneration() as of the most recent possible
+     * change to any atom in the CHANGE_BLOCK_SIDE square block of
+     * sites (including caches) at block position \c blockX, \c
+     * blockY .
+     */
+    u32 GetBlockChangeGeneration(u32 blockX, u32 blockY) const
+    {
+      MFM_API_ASSERT_ARG(blockX < CHANGE_BLOCKS_PER_SIDE && blockY < CHANGE_BLOCKS_PER_SIDE);
+      return m_blockChanges[blockY * CHANGE_BLOCKS_PER_SIDE + blockX];
+    }
+
     /**
      * Returns this Tile's label, if any.  May return an empty string,
      * never returns null.
@@ -678,6 +1023,10 @@ namespace MFM
     {
       CopyTileParameters(heroTile);
       SetWarpFactor(heroTile.GetWarpFactor());
+      SetPhaseSampleOdds(heroTile.GetPhaseSampleOdds());
+      SetElementProfiling(heroTile.IsElementProfiling());
+      SetCachePipelineDepth(heroTile.GetCachePipelineDepth());
+      SetCacheDigestPeriod(heroTile.GetCacheDigestPeriod());
       m_ucr = heroTile.m_ucr;
     }
 
@@ -1018,6 +1367,7 @@ namespace MFM
      */
     T* GetWritableAtom(const SPoint & pt)
     {
+      NoteSiteChanged(pt);   // Assume the caller will write it
       S & site = GetSite(pt);
       return &site.GetAtom();
     }
@@ -1181,6 +1531,19 @@ namespace MFM
      */
     bool ApplyCacheUpdate(bool isDifferent, const T& atom, const SPoint& site);
 
+    /**
+     * Store atom at site, a cache or shared location in full-Tile
+     * coordinates, on behalf of a neighboring Tile in direct
+     * intertile mode (see CacheProcessor::SetDirectPeer).  Called by
+     * that neighbor's thread while it holds the lock covering site,
+     * so unlike PlaceAtom this touches nothing but the site and the
+     * change bookkeeping: no background radiation, since our Random
+     * is not the caller's to use.
+     *
+     * @fails ILLEGAL_ARGUMENT if site is in the hidden region
+     */
+    void ApplyDirectCacheUpdate(const T& atom, const SPoint& site);
+
 
     /**
      * Store an atom in the 'locally-owned' portion of a Tile, using the
@@ -8,14 +8,19 @@
 namespace MFM
 {
   template <class EC>
-  Tile<EC>::Tile(const u32 tileSide, S * sites)
+  Tile<EC>::Tile(const u32 tileSide, S * sites, u32 * blockChanges)
     : TILE_SIDE(tileSide)
     , OWNED_SIDE(TILE_SIDE - 2 * EVENT_WINDOW_RADIUS)  // This OWNED_SIDE computation is duplicated in Grid.h!
     , m_sites(sites)
     , m_cdata(*this)
-    , m_lockAttempts(0)
-    , m_lockAttemptsSucceeded(0)
+    , m_idleAdvances(0)
+    , m_phaseSampleOdds(0)
+    , m_phaseSampleCountdown(0)
     , m_window(*this)
+    , m_changeGeneration(0)
+    , m_directWriters(false)
+    , m_blockChanges(blockChanges)
+    , CHANGE_BLOCKS_PER_SIDE(GetChangeBlocksPerSide(TILE_SIDE))
     , m_state(OFF)
     , m_enabled(true)
     , m_backgroundRadiation(false)
@@ -23,7 +28,7 @@ namespace MFM
     , m_warpFactor(3)
   {
     // TILE_SIDE can't be too small, and we must apparently have sites..
-    MFM_API_ASSERT_ARG(TILE_SIDE >= 3*EVENT_WINDOW_RADIUS && m_sites != 0);
+    MFM_API_ASSERT_ARG(TILE_SIDE >= 3*EVENT_WINDOW_RADIUS && m_sites != 0 && m_blockChanges != 0);
 
     // Require even TILE_SIDE.  (The 'GetSquareDistanceFromCenter'
     // computation would be cheaper if TILE_SIDE was guaranteed odd,
@@ -78,6 +83,7 @@ namespace MFM
       i->Clear();
     }
     NeedAtomRecount();
+    NoteAllSitesChanged();
   }
 
   template <class EC>
@@ -121,6 +127,16 @@ namespace MFM
     return m_atomCount[idx];
   }
 
+  template <class EC>
+  s32 Tile<EC>::CountData::GetPublishedAtomCount(u32 type) const
+  {
+    s32 idx = m_tile.m_elementTable.GetIndex(type);
+    if (idx < 0)
+      return -1;
+
+    return m_publishedCount[idx];
+  }
+
   template <class EC>
   void Tile<EC>::CountData::RecountAtoms()
   {
@@ -137,6 +153,8 @@ namespace MFM
       if (idx < 0) ++m_illegalAtomCount;
       else ++m_atomCount[idx];
     }
+
+    for(u32 i = 0; i < ELEMENT_TABLE_SIZE; i++) m_publishedCount[i] = m_atomCount[i];
   }
 
   template <class EC>
@@ -262,6 +280,28 @@ namespace MFM
     return consistent;
   }
 
+  template <class EC>
+  void Tile<EC>::ApplyDirectCacheUpdate(const T& atom, const SPoint& site)
+  {
+    MFM_API_ASSERT_ARG(!IsInHidden(site));  // That would make no sense
+    if (!IsLiveSite(site))
+    {
+      return;  // As PlaceAtom would
+    }
+
+    S & s = GetSite(site);
+    if (s.GetAtom() != atom)
+    {
+      NeedAtomRecount();
+      NoteSiteChanged(site);
+      if (IsOwnedSite(site))
+      {
+        s.SetLastChangedEventNumber(GetEventsExecuted());
+      }
+      s.PutAtom(atom);
+    }
+  }
+
   template <class EC>
   void Tile<EC>::PlaceAtom(const T& atom, const SPoint& pt)
   {
@@ -275,7 +315,7 @@ namespace MFM
       return;
     }
 
-    Site<AC> & site = GetSite(pt);
+    S & site = GetSite(pt);
     T newAtom = atom;
     unwind_protect(
     {
@@ -296,6 +336,7 @@ namespace MFM
 
       if (oldAtom != newAtom) {
         NeedAtomRecount();
+        NoteSiteChanged(pt);
         if (owned)
           site.SetLastChangedEventNumber(GetEventsExecuted());
 
@@ -432,6 +473,7 @@ namespace MFM
   {
     if (!ConsiderStateChange())
     {
+      ++m_idleAdvances;
       return false;
     }
 
@@ -448,9 +490,10 @@ namespace MFM
       break;
     case ACTIVE:
       didWork |= AdvanceComputation();
-      MFM_LOG_DBG6(("Tile %s: AdvanceComputation->%d",
-                    this->GetLabel(),
-                    didWork));
+      MFM_TRACE_DBG6(*this, TRACE_TILE_ADVANCE_COMPUTATION, didWork, 0, 0,
+                     ("Tile %s: AdvanceComputation->%d",
+                      this->GetLabel(),
+                      didWork));
       // FALL THROUGH
     case PASSIVE:
       didWork |= AdvanceCommunication();
@@ -458,6 +501,10 @@ namespace MFM
     default:
       FAIL(ILLEGAL_STATE);
     }
+    if (!didWork)
+    {
+      ++m_idleAdvances;
+    }
     return didWork;
   }
 
@@ -471,8 +518,9 @@ namespace MFM
         return false;
       }
     }
-    MFM_LOG_DBG6(("Tile %s All CPs idle",
-                  this->GetLabel()));
+    MFM_TRACE_DBG6(*this, TRACE_TILE_ALL_CPS_IDLE, 0, 0, 0,
+                   ("Tile %s All CPs idle",
+                    this->GetLabel()));
     return true;
   }
 
@@ -0,0 +1,101 @@
+/*                                              -*- mode:C++ -*-
+  TileCounters.h Hot-path counters for one or more Tiles
+  Copyright (C) 2014 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file TileCounters.h Hot-path counters for one or more Tiles
+  \author David H. Ackley.
+  \date (C) 2014 All rights reserved.
+  \lgpl
+ */
+#ifndef TILECOUNTERS_H
+#define TILECOUNTERS_H
+
+#include "itype.h"
+#include "Dirs.h"
+#include "ByteSink.h"
+
+namespace MFM
+{
+
+  /**
+   * A snapshot of the counters a Tile keeps on its event and cache
+   * hot paths, or the sum of such snapshots over several Tiles.  The
+   * counters themselves live where they are incremented, and are
+   * written only by the thread driving their Tile; a TileCounters
+   * gathered while that thread runs is approximate.
+   */
+  struct TileCounters
+  {
+    u64 m_eventsAttempted;        ///< Event window centers chosen
+    u64 m_eventsExecuted;         ///< Events that ran (or were inert)
+    u64 m_recencyRejections;      ///< Events skipped by RejectOnRecency
+    u64 m_lockFailures;           ///< Events abandoned for lack of locks
+    u64 m_lockFailuresByDir[Dirs::DIR_COUNT]; ///< Unavailable locks, by Dir
+
+    u64 m_packetsShipped;         ///< Cache packets shipped
+    u64 m_bytesShipped;           ///< Cache bytes shipped, with framing
+    u64 m_packetsReceived;        ///< Cache packets received
+    u64 m_bytesReceived;          ///< Cache bytes received, with framing
+    u64 m_updatePacketsShipped;   ///< Atom packets for changed sites
+    u64 m_checkPacketsShipped;    ///< Atom packets for unchanged sites
+    u64 m_consistencyFailures;    ///< Replies reporting inconsistent caches
+    u64 m_digestsShipped;         ///< Updates ending with a strip digest
+    u64 m_digestMismatches;       ///< Strip digests the peer disagreed with
+    u64 m_resyncPacketsShipped;   ///< Strip sites resent after mismatches
+    u64 m_directUpdates;          ///< Atoms written into neighbors directly
+    u64 m_lockGrants;             ///< Intertile locks handed to other processes
+
+    u64 m_blockingNanos;          ///< Time cache processors spent BLOCKING
+    u64 m_idleAdvances;           ///< Tile::Advance calls that did nothing
+
+    TileCounters()
+    {
+      Clear();
+    }
+
+    void Clear() ;
+
+    /**
+     * Adds every counter in \c other into this TileCounters .
+     */
+    void Add(const TileCounters & other) ;
+
+    /**
+     * Prints the comma-separated column names matching PrintCSV .
+     */
+    static void PrintCSVHeader(ByteSink & sink) ;
+
+    /**
+     * Prints the counters as comma-separated values, without a
+     * leading or trailing comma or newline.
+     */
+    void PrintCSV(ByteSink & sink) const ;
+
+    /**
+     * Prints the counters as one JSON object, named as by
+     * PrintCSVHeader except that lock failures by direction form a
+     * nested object.
+     */
+    void PrintJSON(ByteSink & sink) const ;
+  };
+
+} /* namespace MFM */
+
+#endif /*TILECOUNTERS_H*/
@@ -0,0 +1,212 @@
+/*                                              -*- mode:C++ -*-
+  TileSnapshot.h Triple-buffered copies of a Tile's sites
+  Copyright (C) 2014 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file TileSnapshot.h Triple-buffered copies of a Tile's sites
+  \author David H. Ackley.
+  \date (C) 2014 All rights reserved.
+  \lgpl
+ */
+#ifndef TILESNAPSHOT_H
+#define TILESNAPSHOT_H
+
+#include "itype.h"
+#include "Fail.h"
+
+namespace MFM
+{
+
+  /**
+   * Consistent copies of a Tile's site array, published by the
+   * thread running the Tile and read by one other thread (such as a
+   * renderer) without either side ever waiting on the other.
+   *
+   * Three buffers rotate among a back buffer the publisher fills, a
+   * front buffer the reader holds, and a middle buffer holding the
+   * most recently published copy.  Publish and Acquire each swap
+   * their buffer with the middle one atomically, so the reader always
+   * sees a complete copy, and at worst sees the same copy twice.
+   */
+  template <class S>
+  class TileSnapshot
+  {
+  public:
+
+    TileSnapshot() :
+      m_sites(0),
+      m_blocks(0),
+      m_publishedGeneration(0),
+      m_published(false),
+      m_back(0),
+      m_front(2),
+      m_middle(1),
+      m_frontValid(false)
+    {
+      for (u32 i = 0; i < BUFFERS; ++i)
+      {
+        m_buffers[i] = 0;
+        m_blockGenerations[i] = 0;
+        m_generations[i] = 0;
+      }
+    }
+
+    ~TileSnapshot()
+    {
+      for (u32 i = 0; i < BUFFERS; ++i)
+      {
+        delete [] m_buffers[i];
+        delete [] m_blockGenerations[i];
+      }
+    }
+
+    /**
+     * Allocates snapshot buffers for \c sites sites and \c blocks
+     * block generations.  Must be called before any Publish or
+     * Acquire, while neither thread is using this TileSnapshot.
+     * FAILs with ILLEGAL_STATE if already initialized to a different
+     * size.
+     */
+    void Init(u32 sites, u32 blocks)
+    {
+      if (m_sites == sites && m_blocks == blocks)
+      {
+        return;
+      }
+      MFM_API_ASSERT_STATE(m_sites == 0);
+      MFM_API_ASSERT_ARG(sites > 0);
+      for (u32 i = 0; i < BUFFERS; ++i)
+      {
+        m_buffers[i] = new S[sites];
+        m_blockGenerations[i] = new u32[blocks];
+        for (u32 b = 0; b < blocks; ++b)
+        {
+          m_blockGenerations[i][b] = 0;
+        }
+      }
+      m_sites = sites;
+      m_blocks = blocks;
+    }
+
+    bool IsEnabled() const
+    {
+      return m_sites != 0;
+    }
+
+    /**
+     * Copies \c sites and \c blockGenerations into the back buffer
+     * and makes it the most recently published snapshot.  Called only
+     * by the publishing thread.
+     *
+     * @param generation A value that changes whenever \c sites may
+     *                   have, available to the reader via
+     *                   GetGeneration.  If it is the same as in the
+     *                   previous Publish, the sites are taken to be
+     *                   unchanged, and nothing is copied.
+     *
+     * @param blockGenerations Per-block values to publish with the
+     *                   sites, available to the reader via
+     *                   GetBlockGeneration.
+     */
+    void Publish(const S * sites, u32 generation, const u32 * blockGenerations)
+    {
+      if (m_published && generation == m_publishedGeneration)
+      {
+        return;
+      }
+      m_published = true;
+      m_publishedGeneration = generation;
+
+      u32 * backBlocks = m_blockGenerations[m_back];
+      for (u32 i = 0; i < m_blocks; ++i)
+      {
+        backBlocks[i] = blockGenerations[i];
+      }
+      S * back = m_buffers[m_back];
+      for (u32 i = 0; i < m_sites; ++i)
+      {
+        back[i] = sites[i];
+      }
+      m_generations[m_back] = generation;
+      __sync_synchronize();
+      u32 old = __sync_lock_test_and_set(&m_middle, m_back | FRESH);
+      m_back = old & INDEX_MASK;
+    }
+
+    /**
+     * Gets the most recently published snapshot.  Called only by the
+     * reading thread; the returned sites remain unchanged until its
+     * next call to Acquire.
+     *
+     * @returns The snapshot sites, or null if nothing has been
+     *          published yet.
+     */
+    const S * Acquire()
+    {
+      if (m_middle & FRESH)
+      {
+        u32 old = __sync_lock_test_and_set(&m_middle, m_front);
+        m_front = old & INDEX_MASK;
+        m_frontValid = true;
+      }
+      return m_frontValid ? m_buffers[m_front] : 0;
+    }
+
+    /**
+     * Gets the generation published with the snapshot last returned
+     * by Acquire.  Called only by the reading thread.
+     */
+    u32 GetGeneration() const
+    {
+      return m_generations[m_front];
+    }
+
+    /**
+     * Gets block generation \c block as published with the snapshot
+     * last returned by Acquire.  Called only by the reading thread.
+     */
+    u32 GetBlockGeneration(u32 block) const
+    {
+      MFM_API_ASSERT_ARG(block < m_blocks);
+      return m_blockGenerations[m_front][block];
+    }
+
+  private:
+    enum { BUFFERS = 3, INDEX_MASK = 3, FRESH = 4 };
+
+    S * m_buffers[BUFFERS];
+    u32 * m_blockGenerations[BUFFERS];
+    u32 m_generations[BUFFERS];
+    u32 m_sites;
+    u32 m_blocks;
+
+    u32 m_publishedGeneration; // Owned by the publisher
+    bool m_published;          // Owned by the publisher
+    u32 m_back;            // Owned by the publisher
+    u32 m_front;           // Owned by the reader
+    volatile u32 m_middle; // Index, plus FRESH if not yet acquired
+    bool m_frontValid;     // Owned by the reader
+
+    TileSnapshot(const TileSnapshot &) ; // Declare away
+    TileSnapshot & operator=(const TileSnapshot &) ; // Declare away
+  };
+
+} /* namespace MFM */
+
+#endif /*TILESNAPSHOT_H*/
@@ -0,0 +1,207 @@
+/*                                              -*- mode:C++ -*-
+  TraceBuffer.h Binary trace records for hot-path debugging
+  Copyright (C) 2014 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file TraceBuffer.h Binary trace records for hot-path debugging
+  \author David H. Ackley.
+  \date (C) 2014 All rights reserved.
+  \lgpl
+ */
+#ifndef TRACEBUFFER_H
+#define TRACEBUFFER_H
+
+#include "itype.h"
+#include "ByteSink.h"
+#include "Logger.h"
+
+/**
+ * Records a level \c n trace point with code \c code and integer
+ * arguments \c a0 , \c a1 , and \c a2 , in the TraceBuffer of Tile
+ * \c tile , if that buffer is recording level \c n .  Otherwise,
+ * logs \c args as text exactly as MFM_LOG_DBG\c n would.  Like those
+ * macros, compiles to nothing if \c n exceeds MFM_MAX_LOG_LEVEL .
+ */
+#define MFM_TRACE_DBG(n, tile, code, a0, a1, a2, args)                  \
+  do {                                                                  \
+    if (MFM_LOG_LEVEL_KEPT(n)) {                                        \
+      TraceBuffer & _mfmTB = (tile).GetTraceBuffer();                   \
+      if (__builtin_expect(_mfmTB.IsRecording(n),0)) {                  \
+        _mfmTB.Record(n, code, (u32) (tile).GetEventsExecuted(),        \
+                      (s32) (a0), (s32) (a1), (s32) (a2));              \
+      } else if (__builtin_expect(LOG.IfLog((Logger::Level) (n)),0)) {  \
+        LOG.Debug args ;                                                \
+      }                                                                 \
+    }                                                                   \
+  } while (0)
+
+#define MFM_TRACE_DBG6(tile, code, a0, a1, a2, args) MFM_TRACE_DBG(6, tile, code, a0, a1, a2, args)
+#define MFM_TRACE_DBG7(tile, code, a0, a1, a2, args) MFM_TRACE_DBG(7, tile, code, a0, a1, a2, args)
+
+namespace MFM
+{
+
+  /**
+   * The trace points that may appear in a TraceRecord .  Codes are
+   * written to trace files, so new codes must be added at the end.
+   */
+  enum TraceCode
+  {
+    TRACE_NONE = 0,
+
+    TRACE_EW_TRY_EVENT,          // x, y
+    TRACE_EW_EXECUTE_EVENT,
+    TRACE_EW_INITIATE_COMMUNICATIONS,
+    TRACE_EW_EXECUTE_BEHAVIOR,
+    TRACE_ET_EXECUTE,
+    TRACE_EW_INIT_FOR_EVENT,     // x, y
+    TRACE_EW_INIT_ABANDONED,
+    TRACE_EW_LOCK_UNCONNECTED,   // dir
+    TRACE_EW_LOCK_NOT_IDLE,      // dir
+    TRACE_EW_LOCK_TAKEN,         // dir
+    TRACE_EW_LOCK_ACQUIRED,      // dir
+    TRACE_EW_ACQUIRE_LOCKS,
+    TRACE_EW_NO_LOCKS_NEEDED,
+    TRACE_EW_LOCKS_CHECKING,     // needed
+    TRACE_EW_LOCKS_SHORT,        // got, needed
+    TRACE_EW_LOCK_FREED,         // slot
+    TRACE_EW_LOCK_ACTIVATED,     // slot
+    TRACE_EW_STORE_TO_TILE,
+    TRACE_EW_STORE_RELEASING,
+
+    TRACE_TILE_ADVANCE_COMPUTATION, // didWork
+    TRACE_TILE_ALL_CPS_IDLE,
+
+    TRACE_CP_STATE,              // dir, old state, new state
+    TRACE_CP_SEND,               // dir, site number
+    TRACE_CP_REPLY_UPDATE_END,   // consistent count
+    TRACE_CP_RECEIVE_REPLY,      // dir, consistent count, sent count
+    TRACE_CP_ADVANCE,            // dir, state
+    TRACE_CP_ADVANCE_SHIPPING,   // dir
+    TRACE_CP_SHIP,               // dir, sent count, site number
+
+    TRACE_CODE_COUNT
+  };
+
+  /**
+   * One fixed-size binary trace record, as written to trace files in
+   * host byte order.
+   */
+  struct TraceRecord
+  {
+    enum { ARG_COUNT = 3 };
+
+    u64 m_timestamp;   ///< CLOCK_MONOTONIC nanoseconds
+    u32 m_tileId;      ///< As given to TraceBuffer::Start
+    u32 m_eventId;     ///< Low 32 bits of the tile's events executed
+    u16 m_code;        ///< A TraceCode
+    u16 m_level;       ///< The Logger::Level of the trace point
+    s32 m_args[ARG_COUNT];
+
+    /**
+     * Prints this TraceRecord as one line of text.
+     */
+    void PrintTo(ByteSink & sink) const ;
+  };
+
+  /**
+   * A buffer of TraceRecords belonging to one Tile, and so written
+   * only by the one thread driving that Tile.  While recording,
+   * trace points at or below the recording level are stored here
+   * with no formatting and no locking, and the buffer is written to
+   * its ByteSink in binary whenever it fills, and on Stop.
+   */
+  class TraceBuffer
+  {
+  public:
+
+    enum { RECORDS = 4096 };
+
+    TraceBuffer() ;
+
+    ~TraceBuffer() ;
+
+    /**
+     * Begins recording trace points at or below \c maxLevel .
+     *
+     * @param tileId A number identifying the owning Tile in the
+     *               records written.
+     *
+     * @param sink Where to write records.  It is written only by the
+     *             thread driving the owning Tile, and only during
+     *             Record and Stop.
+     *
+     * @param maxLevel The highest Logger::Level to record.
+     */
+    void Start(u32 tileId, ByteSink & sink, u32 maxLevel) ;
+
+    /**
+     * Writes out any buffered records and stops recording.  Does
+     * nothing if not recording.
+     */
+    void Stop() ;
+
+    /**
+     * Writes out any buffered records.
+     */
+    void Flush() ;
+
+    bool IsRecording(u32 level) const
+    {
+      return level <= m_maxLevel;
+    }
+
+    void Record(u32 level, u32 code, u32 eventId, s32 a0, s32 a1, s32 a2)
+    {
+      if (m_used == RECORDS)
+      {
+        Flush();
+      }
+      TraceRecord & r = m_records[m_used++];
+      r.m_timestamp = GetTimestamp();
+      r.m_tileId = m_tileId;
+      r.m_eventId = eventId;
+      r.m_code = (u16) code;
+      r.m_level = (u16) level;
+      r.m_args[0] = a0;
+      r.m_args[1] = a1;
+      r.m_args[2] = a2;
+    }
+
+    /**
+     * Gets the printable name of a TraceCode .
+     */
+    static const char * GetCodeName(u32 code) ;
+
+  private:
+    static u64 GetTimestamp() ;
+
+    TraceRecord * m_records;
+    u32 m_used;
+    u32 m_maxLevel;   // 0 when not recording
+    u32 m_tileId;
+    ByteSink * m_sink;
+
+    TraceBuffer(const TraceBuffer &) ; // Declare away
+    TraceBuffer & operator=(const TraceBuffer &) ; // Declare away
+  };
+
+} /* namespace MFM */
+
+#endif /*TRACEBUFFER_H*/
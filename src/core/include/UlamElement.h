@@ -107,10 +107,32 @@ namespace MFM
     typedef typename AC::ATOM_TYPE T;
     const UlamElementInfo<EC> * m_info;
 
+    /**
+       The BehaviorFunction for all UlamElements, equivalent to
+       Behavior.
+     */
+    static void BehaviorDirect(const Element<EC> & elt, EventWindow<EC>& window) ;
+
+  protected:
+
+    /**
+       For subclasses that override Behavior: has ElementTable call
+       it virtually, instead of through BehaviorDirect, which would
+       bypass the override.  Call from the subclass constructor.
+     */
+    void UseVirtualBehavior()
+    {
+      this->SetBehaviorFunction(0);
+    }
+
   public:
 
-    UlamElement(const UUID & uuid) : Element<EC>(uuid)
-    { }
+    UlamElement(const UUID & uuid)
+      : Element<EC>(uuid)
+      , m_info(0)
+    {
+      this->SetBehaviorFunction(&BehaviorDirect);
+    }
 
     /**
        Print the contents of atom to the given ByteSink, including
@@ -131,6 +153,13 @@ namespace MFM
     virtual ~UlamElement()
     { }
 
+    /**
+       Runs Uf_6behave on the center atom, after setting the event
+       window symmetry.  Note that ElementTable dispatches
+       UlamElements through BehaviorDirect instead, so subclasses
+       should override Uf_6behave rather than this method, or else
+       call UseVirtualBehavior.
+     */
     virtual void Behavior(EventWindow<EC>& window) const ;
 
     /**
@@ -9,15 +9,22 @@ namespace MFM {
   template <class EC>
   void UlamElement<EC>::Behavior(EventWindow<EC>& window) const
   {
+    BehaviorDirect(*this, window);
+  }
+
+  template <class EC>
+  void UlamElement<EC>::BehaviorDirect(const Element<EC> & elt, EventWindow<EC>& window)
+  {
+    const UlamElement<EC> & uelt = static_cast<const UlamElement<EC> &>(elt);
     Tile<EC> & tile = window.GetTile();
     UlamContext<EC> uc;
     uc.SetTile(tile);
 
-    u32 sym = m_info ? m_info->GetSymmetry(uc) : PSYM_DEG000L;
+    u32 sym = uelt.m_info ? uelt.m_info->GetSymmetry(uc) : PSYM_DEG000L;
     window.SetSymmetry((PointSymmetry) sym);
 
     T & me = window.GetCenterAtomSym();
-    Uf_6behave(uc, me);
+    uelt.Uf_6behave(uc, me);
   }
 
   template <class EC>
@@ -400,6 +400,29 @@ namespace MFM {
    */
   extern void Sleep(u32 seconds, u64 nanos) ;
 
+  /**
+   * Gets the current time, in nanoseconds, from a clock that never
+   * jumps backwards.  Only differences between values are meaningful.
+   */
+  extern u64 GetMonotonicNanos() ;
+
+  /**
+   * Gets a cheap, fine-grained, non-serializing timestamp: the CPU
+   * time-stamp counter on x86, else GetMonotonicNanos().  Only
+   * differences between values read on the same thread are
+   * meaningful, and their units vary between machines.
+   */
+  inline u64 ReadCycleCounter()
+  {
+#if defined(__i386__) || defined(__x86_64__)
+    u32 lo, hi;
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+    return (((u64) hi) << 32) | lo;
+#else
+    return GetMonotonicNanos();
+#endif
+  }
+
   /**
    * Pauses the calling thread for more or less a specified number of
    * milliseconds.
@@ -0,0 +1,114 @@
+#include "PhaseHistograms.h"
+#include "Fail.h"
+
+namespace MFM {
+
+  u64 LatencyHistogram::GetSamples() const
+  {
+    u64 total = 0;
+    for (u32 b = 0; b < BUCKET_COUNT; ++b)
+    {
+      total += m_buckets[b];
+    }
+    return total;
+  }
+
+  void LatencyHistogram::Clear()
+  {
+    for (u32 b = 0; b < BUCKET_COUNT; ++b)
+    {
+      m_buckets[b] = 0;
+    }
+  }
+
+  void LatencyHistogram::Add(const LatencyHistogram & other)
+  {
+    for (u32 b = 0; b < BUCKET_COUNT; ++b)
+    {
+      m_buckets[b] += other.m_buckets[b];
+    }
+  }
+
+  const char * PhaseHistograms::GetPhaseName(u32 phase)
+  {
+    switch (phase)
+    {
+    case LOCK: return "lock";
+    case LOAD: return "load";
+    case BEHAVIOR: return "behavior";
+    case STORE: return "store";
+    case SHIP: return "ship";
+    case RECEIVE: return "receive";
+    case BLOCK: return "block";
+    default:
+      FAIL(ILLEGAL_ARGUMENT);
+    }
+  }
+
+  const char * PhaseHistograms::GetTickName()
+  {
+#if defined(__i386__) || defined(__x86_64__)
+    return "cycles";
+#else
+    return "nanos";
+#endif
+  }
+
+  void PhaseHistograms::Clear()
+  {
+    for (u32 p = 0; p < PHASE_COUNT; ++p)
+    {
+      m_phases[p].Clear();
+    }
+  }
+
+  void PhaseHistograms::Add(const PhaseHistograms & other)
+  {
+    for (u32 p = 0; p < PHASE_COUNT; ++p)
+    {
+      m_phases[p].Add(other.m_phases[p]);
+    }
+  }
+
+  void PhaseHistograms::PrintCSVHeader(ByteSink & sink)
+  {
+    sink.Printf("phase,samples");
+    for (u32 b = 0; b < LatencyHistogram::BUCKET_COUNT; ++b)
+    {
+      sink.Printf(",b%d", b);
+    }
+  }
+
+  void PhaseHistograms::PrintCSV(ByteSink & sink, const char * prefix) const
+  {
+    for (u32 p = 0; p < PHASE_COUNT; ++p)
+    {
+      const LatencyHistogram & h = m_phases[p];
+      sink.Printf("%s%s,", prefix, GetPhaseName(p));
+      sink.Print(h.GetSamples());
+      for (u32 b = 0; b < LatencyHistogram::BUCKET_COUNT; ++b)
+      {
+        sink.WriteByte(',');
+        sink.Print(h.m_buckets[b]);
+      }
+      sink.Println();
+    }
+  }
+
+  void PhaseHistograms::PrintJSON(ByteSink & sink) const
+  {
+    sink.Printf("{\"ticks\":\"%s\"", GetTickName());
+    for (u32 p = 0; p < PHASE_COUNT; ++p)
+    {
+      const LatencyHistogram & h = m_phases[p];
+      sink.Printf(",\"%s\":[", GetPhaseName(p));
+      for (u32 b = 0; b < LatencyHistogram::BUCKET_COUNT; ++b)
+      {
+        if (b > 0) sink.WriteByte(',');
+        sink.Print(h.m_buckets[b]);
+      }
+      sink.WriteByte(']');
+    }
+    sink.WriteByte('}');
+  }
+}
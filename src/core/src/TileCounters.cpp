@@ -0,0 +1,133 @@
+#include "TileCounters.h"
+
+namespace MFM {
+
+  typedef u64 TileCounters::* CounterPtr;
+
+  struct CounterColumn
+  {
+    const char * m_name;
+    CounterPtr m_counter;
+  };
+
+  /* Columns before the lock failures by direction */
+  static const CounterColumn EVENT_COLUMNS[] =
+  {
+    { "eventsAttempted", &TileCounters::m_eventsAttempted },
+    { "eventsExecuted", &TileCounters::m_eventsExecuted },
+    { "recencyRejections", &TileCounters::m_recencyRejections },
+    { "lockFailures", &TileCounters::m_lockFailures }
+  };
+
+  /* Columns after the lock failures by direction */
+  static const CounterColumn CACHE_COLUMNS[] =
+  {
+    { "packetsShipped", &TileCounters::m_packetsShipped },
+    { "bytesShipped", &TileCounters::m_bytesShipped },
+    { "packetsReceived", &TileCounters::m_packetsReceived },
+    { "bytesReceived", &TileCounters::m_bytesReceived },
+    { "updatePacketsShipped", &TileCounters::m_updatePacketsShipped },
+    { "checkPacketsShipped", &TileCounters::m_checkPacketsShipped },
+    { "consistencyFailures", &TileCounters::m_consistencyFailures },
+    { "digestsShipped", &TileCounters::m_digestsShipped },
+    { "digestMismatches", &TileCounters::m_digestMismatches },
+    { "resyncPacketsShipped", &TileCounters::m_resyncPacketsShipped },
+    { "directUpdates", &TileCounters::m_directUpdates },
+    { "lockGrants", &TileCounters::m_lockGrants },
+    { "blockingNanos", &TileCounters::m_blockingNanos },
+    { "idleAdvances", &TileCounters::m_idleAdvances }
+  };
+
+  static const u32 EVENT_COLUMN_COUNT = sizeof(EVENT_COLUMNS) / sizeof(EVENT_COLUMNS[0]);
+  static const u32 CACHE_COLUMN_COUNT = sizeof(CACHE_COLUMNS) / sizeof(CACHE_COLUMNS[0]);
+
+  void TileCounters::Clear()
+  {
+    for (u32 i = 0; i < EVENT_COLUMN_COUNT; ++i)
+    {
+      this->*EVENT_COLUMNS[i].m_counter = 0;
+    }
+    for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+    {
+      m_lockFailuresByDir[d] = 0;
+    }
+    for (u32 i = 0; i < CACHE_COLUMN_COUNT; ++i)
+    {
+      this->*CACHE_COLUMNS[i].m_counter = 0;
+    }
+  }
+
+  void TileCounters::Add(const TileCounters & other)
+  {
+    for (u32 i = 0; i < EVENT_COLUMN_COUNT; ++i)
+    {
+      this->*EVENT_COLUMNS[i].m_counter += other.*EVENT_COLUMNS[i].m_counter;
+    }
+    for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+    {
+      m_lockFailuresByDir[d] += other.m_lockFailuresByDir[d];
+    }
+    for (u32 i = 0; i < CACHE_COLUMN_COUNT; ++i)
+    {
+      this->*CACHE_COLUMNS[i].m_counter += other.*CACHE_COLUMNS[i].m_counter;
+    }
+  }
+
+  void TileCounters::PrintCSVHeader(ByteSink & sink)
+  {
+    for (u32 i = 0; i < EVENT_COLUMN_COUNT; ++i)
+    {
+      sink.Printf("%s%s", i ? "," : "", EVENT_COLUMNS[i].m_name);
+    }
+    for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+    {
+      sink.Printf(",lockFailures%s", Dirs::GetName(d));
+    }
+    for (u32 i = 0; i < CACHE_COLUMN_COUNT; ++i)
+    {
+      sink.Printf(",%s", CACHE_COLUMNS[i].m_name);
+    }
+  }
+
+  void TileCounters::PrintCSV(ByteSink & sink) const
+  {
+    for (u32 i = 0; i < EVENT_COLUMN_COUNT; ++i)
+    {
+      if (i > 0) sink.WriteByte(',');
+      sink.Print(this->*EVENT_COLUMNS[i].m_counter);
+    }
+    for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+    {
+      sink.WriteByte(',');
+      sink.Print(m_lockFailuresByDir[d]);
+    }
+    for (u32 i = 0; i < CACHE_COLUMN_COUNT; ++i)
+    {
+      sink.WriteByte(',');
+      sink.Print(this->*CACHE_COLUMNS[i].m_counter);
+    }
+  }
+
+  void TileCounters::PrintJSON(ByteSink & sink) const
+  {
+    sink.WriteByte('{');
+    for (u32 i = 0; i < EVENT_COLUMN_COUNT; ++i)
+    {
+      sink.Printf("%s\"%s\":", i ? "," : "", EVENT_COLUMNS[i].m_name);
+      sink.Print(this->*EVENT_COLUMNS[i].m_counter);
+    }
+    sink.Printf(",\"lockFailuresByDir\":{");
+    for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+    {
+      sink.Printf("%s\"%s\":", d ? "," : "", Dirs::GetName(d));
+      sink.Print(m_lockFailuresByDir[d]);
+    }
+    sink.WriteByte('}');
+    for (u32 i = 0; i < CACHE_COLUMN_COUNT; ++i)
+    {
+      sink.Printf(",\"%s\":", CACHE_COLUMNS[i].m_name);
+      sink.Print(this->*CACHE_COLUMNS[i].m_counter);
+    }
+    sink.WriteByte('}');
+  }
+}
@@ -0,0 +1,110 @@
+#include "TraceBuffer.h"
+#include "Fail.h"
+#include <time.h>  /* For clock_gettime */
+
+namespace MFM {
+
+  void TraceRecord::PrintTo(ByteSink & sink) const
+  {
+    sink.Printf("%u.%09u %u %u %s",
+                (u32) (m_timestamp / 1000000000),
+                (u32) (m_timestamp % 1000000000),
+                m_tileId,
+                m_eventId,
+                TraceBuffer::GetCodeName(m_code));
+    for (u32 i = 0; i < ARG_COUNT; ++i)
+    {
+      sink.Printf(" %d", m_args[i]);
+    }
+    sink.Println();
+  }
+
+  TraceBuffer::TraceBuffer()
+    : m_records(0)
+    , m_used(0)
+    , m_maxLevel(0)
+    , m_tileId(0)
+    , m_sink(0)
+  { }
+
+  TraceBuffer::~TraceBuffer()
+  {
+    Stop();
+    delete [] m_records;
+  }
+
+  void TraceBuffer::Start(u32 tileId, ByteSink & sink, u32 maxLevel)
+  {
+    Stop();
+    if (!m_records)
+    {
+      m_records = new TraceRecord[RECORDS];
+    }
+    m_used = 0;
+    m_tileId = tileId;
+    m_sink = &sink;
+    m_maxLevel = maxLevel;
+  }
+
+  void TraceBuffer::Stop()
+  {
+    if (!m_sink)
+    {
+      return;
+    }
+    Flush();
+    m_maxLevel = 0;
+    m_sink = 0;
+  }
+
+  void TraceBuffer::Flush()
+  {
+    MFM_API_ASSERT_STATE(m_sink);
+    m_sink->WriteBytes((const u8 *) m_records, m_used * sizeof(TraceRecord));
+    m_used = 0;
+  }
+
+  u64 TraceBuffer::GetTimestamp()
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((u64) ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  }
+
+  const char * TraceBuffer::GetCodeName(u32 code)
+  {
+    switch (code)
+    {
+    case TRACE_NONE: return "NONE";
+    case TRACE_EW_TRY_EVENT: return "EW_TRY_EVENT";
+    case TRACE_EW_EXECUTE_EVENT: return "EW_EXECUTE_EVENT";
+    case TRACE_EW_INITIATE_COMMUNICATIONS: return "EW_INITIATE_COMMUNICATIONS";
+    case TRACE_EW_EXECUTE_BEHAVIOR: return "EW_EXECUTE_BEHAVIOR";
+    case TRACE_ET_EXECUTE: return "ET_EXECUTE";
+    case TRACE_EW_INIT_FOR_EVENT: return "EW_INIT_FOR_EVENT";
+    case TRACE_EW_INIT_ABANDONED: return "EW_INIT_ABANDONED";
+    case TRACE_EW_LOCK_UNCONNECTED: return "EW_LOCK_UNCONNECTED";
+    case TRACE_EW_LOCK_NOT_IDLE: return "EW_LOCK_NOT_IDLE";
+    case TRACE_EW_LOCK_TAKEN: return "EW_LOCK_TAKEN";
+    case TRACE_EW_LOCK_ACQUIRED: return "EW_LOCK_ACQUIRED";
+    case TRACE_EW_ACQUIRE_LOCKS: return "EW_ACQUIRE_LOCKS";
+    case TRACE_EW_NO_LOCKS_NEEDED: return "EW_NO_LOCKS_NEEDED";
+    case TRACE_EW_LOCKS_CHECKING: return "EW_LOCKS_CHECKING";
+    case TRACE_EW_LOCKS_SHORT: return "EW_LOCKS_SHORT";
+    case TRACE_EW_LOCK_FREED: return "EW_LOCK_FREED";
+    case TRACE_EW_LOCK_ACTIVATED: return "EW_LOCK_ACTIVATED";
+    case TRACE_EW_STORE_TO_TILE: return "EW_STORE_TO_TILE";
+    case TRACE_EW_STORE_RELEASING: return "EW_STORE_RELEASING";
+    case TRACE_TILE_ADVANCE_COMPUTATION: return "TILE_ADVANCE_COMPUTATION";
+    case TRACE_TILE_ALL_CPS_IDLE: return "TILE_ALL_CPS_IDLE";
+    case TRACE_CP_STATE: return "CP_STATE";
+    case TRACE_CP_SEND: return "CP_SEND";
+    case TRACE_CP_REPLY_UPDATE_END: return "CP_REPLY_UPDATE_END";
+    case TRACE_CP_RECEIVE_REPLY: return "CP_RECEIVE_REPLY";
+    case TRACE_CP_ADVANCE: return "CP_ADVANCE";
+    case TRACE_CP_ADVANCE_SHIPPING: return "CP_ADVANCE_SHIPPING";
+    case TRACE_CP_SHIP: return "CP_SHIP";
+    default: return "UNKNOWN";
+    }
+  }
+}
@@ -1,5 +1,5 @@
 #include "Util.h"
-#include <time.h>  /* For nanosleep */
+#include <time.h>  /* For nanosleep, clock_gettime */
 
 namespace MFM
 {
@@ -44,4 +44,11 @@ namespace MFM
 
     nanosleep(&tspec, NULL);
   }
+
+  u64 GetMonotonicNanos()
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((u64) ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  }
 }
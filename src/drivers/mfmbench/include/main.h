@@ -0,0 +1,19 @@
+/* -*- C++ -*- */
+#ifndef MAIN_H
+#define MAIN_H
+
+#include "itype.h"
+#include "AbstractHeadlessDriver.h"
+#include "P3Atom.h"
+#include "GridConfig.h"
+#include "Element_Dreg.h"
+#include "Element_Res.h"
+
+#include "Element_City_Building.h"
+#include "Element_City_Car.h"
+#include "Element_City_Intersection.h"
+#include "Element_City_Park.h"
+#include "Element_City_Sidewalk.h"
+#include "Element_City_Street.h"
+
+#endif /* MAIN_H */
@@ -0,0 +1,723 @@
+#include "main.h"
+
+#include <stdio.h>     /* For printf, popen */
+#include <string.h>    /* For strcmp, strchr */
+#include <errno.h>     /* For errno */
+#include <sys/stat.h>  /* For mkdir */
+#include <sys/resource.h>  /* For getrlimit / setrlimit */
+#include <signal.h>    /* For signal */
+#include <unistd.h>    /* For alarm, write, _exit */
+
+/*
+ * mfmbench: Reproducible headless benchmarks.
+ *
+ * Run with a geometry code, mfmbench runs one seeded scenario on one
+ * grid for a fixed number of AEPS, and prints one JSON object
+ * describing its performance to stdout:
+ *
+ *   mfmbench {3C2} --scenario dreg --benchaeps 100 [--benchstall 60]
+ *            [driver switches]
+ *
+ * If the grid makes no AEPS progress for --benchstall seconds, the run
+ * gives up, reports "stalled":true, and exits with status 2; if it
+ * hangs outright, an alarm ends it with status 3.
+ *
+ * With the driver switch --processes N, the grid's tiles are split
+ * among N processes (see Grid::ForkPartitions), and each prints its
+ * own JSON object, for its own tiles, tagged with its partition.
+ *
+ * Run without one, mfmbench runs a suite of scenarios over tile sizes
+ * and grid shapes, each in a child mfmbench so that no run inherits
+ * another's heap or threads, and prints one JSON object holding every
+ * run's results:
+ *
+ *   mfmbench [--aeps N] [--tiles ABC] [--shapes 1x1,3x2]
+ *            [--scenarios dreg,city] [--seed N] [--dir DIR] [--continuous]
+ *            [--phasetiming N] [--cachepipeline N] [--cachedigest N]
+ *            [--directcaches]
+ *
+ * With --phasetiming N, each run also reports its event phase latency
+ * histograms (see PhaseHistograms) from timing 1 in N events.  With
+ * --cachepipeline N, each run uses the pipelined cache protocol with
+ * up to N updates awaiting replies, and with --cachedigest N, verifies
+ * tile edge caches by a digest every N updates (see CacheProcessor).
+ * With --directcaches, tiles write edge changes straight into their
+ * neighbors' caches instead (see Grid::Init).
+ */
+
+namespace MFM
+{
+  /**
+   * The scenarios mfmbench knows how to seed.  Each seeds every tile
+   * alike, so that work is spread over the whole grid.
+   */
+  static const char * SCENARIO_NAMES[] =
+  {
+    "dreg",     // Dreg and Res filling the grid
+    "forkbomb", // ForkBomb storm, with AntiForkBomb cleanup
+    "sorter",   // Emitters feeding Sorters feeding Consumers
+    "city",     // City elements growing from Intersections
+    "xtal"      // Xtal_Sq1 growing from Dreg-made Res
+  };
+
+  enum Scenario
+  {
+    SCENARIO_DREG,
+    SCENARIO_FORKBOMB,
+    SCENARIO_SORTER,
+    SCENARIO_CITY,
+    SCENARIO_XTAL,
+    SCENARIO_COUNT
+  };
+
+  static s32 FindScenario(const char * name, u32 length)
+  {
+    for (u32 i = 0; i < SCENARIO_COUNT; ++i)
+    {
+      if (strlen(SCENARIO_NAMES[i]) == length &&
+          !strncmp(SCENARIO_NAMES[i], name, length))
+      {
+        return (s32) i;
+      }
+    }
+    return -1;
+  }
+
+  // Build with e.g. -DMFMBENCH_SITE_FEATURES=SITE_LEAN to bench lean sites
+#ifndef MFMBENCH_SITE_FEATURES
+#define MFMBENCH_SITE_FEATURES SITE_ALL
+#endif
+
+  typedef Site<P3AtomConfig, MFMBENCH_SITE_FEATURES> OurSiteAll;
+  typedef EventConfig<OurSiteAll,4> OurEventConfigAll;
+
+  template <class GC>
+  struct MFMBenchDriver : public AbstractHeadlessDriver<GC>
+  {
+  private:
+
+    typedef AbstractHeadlessDriver<GC> Super;
+    typedef typename GC::EVENT_CONFIG EC;
+    typedef typename EC::ATOM_CONFIG AC;
+    typedef typename AC::ATOM_TYPE T;
+
+    enum { R = EC::EVENT_WINDOW_RADIUS };
+    enum { OWNED_SIDE = Grid<GC>::OWNED_SIDE };
+
+    const char m_tileCode;
+    Scenario m_scenario;
+    u32 m_benchAEPS;
+    u32 m_seed;
+    u32 m_stallSeconds;
+    bool m_stalled;
+
+    virtual void DefineNeededElements()
+    {
+      this->NeedElement(&Element_Empty<EC>::THE_INSTANCE);
+      this->NeedElement(&Element_Res<EC>::THE_INSTANCE);
+      this->NeedElement(&Element_Dreg<EC>::THE_INSTANCE);
+      this->NeedElement(&Element_Sorter<EC>::THE_INSTANCE);
+      this->NeedElement(&Element_Data<EC>::THE_INSTANCE);
+      this->NeedElement(&Element_Emitter<EC>::THE_INSTANCE);
+      this->NeedElement(&Element_Consumer<EC>::THE_INSTANCE);
+      this->NeedElement(&Element_ForkBomb1<EC>::THE_INSTANCE);
+      this->NeedElement(&Element_AntiForkBomb<EC>::THE_INSTANCE);
+      this->NeedElement(&Element_Xtal_Sq1<EC>::THE_INSTANCE);
+
+      this->NeedElement(&Element_City_Building<EC>::THE_INSTANCE);
+      this->NeedElement(&Element_City_Car<EC>::THE_INSTANCE);
+      this->NeedElement(&Element_City_Intersection<EC>::THE_INSTANCE);
+      this->NeedElement(&Element_City_Park<EC>::THE_INSTANCE);
+      this->NeedElement(&Element_City_Sidewalk<EC>::THE_INSTANCE);
+      this->NeedElement(&Element_City_Street<EC>::THE_INSTANCE);
+    }
+
+    static void SetScenarioFromArgs(const char* name, void* driverptr)
+    {
+      MFMBenchDriver & driver = *((MFMBenchDriver*) driverptr);
+      s32 scenario = FindScenario(name, strlen(name));
+      if (scenario < 0)
+      {
+        driver.GetVArguments().Die("Unknown scenario '%s'", name);
+      }
+      driver.m_scenario = (Scenario) scenario;
+    }
+
+    static void SetBenchAEPSFromArgs(const char* aeps, void* driverptr)
+    {
+      MFMBenchDriver & driver = *((MFMBenchDriver*) driverptr);
+      s32 out;
+      const char * errmsg = AbstractDriver<GC>::GetNumberFromString(aeps, out, 1, S32_MAX);
+      if (errmsg)
+      {
+        driver.GetVArguments().Die("Bad benchmark AEPS '%s': %s", aeps, errmsg);
+      }
+      driver.m_benchAEPS = (u32) out;
+    }
+
+    static void SetBenchStallFromArgs(const char* secs, void* driverptr)
+    {
+      MFMBenchDriver & driver = *((MFMBenchDriver*) driverptr);
+      s32 out;
+      const char * errmsg = AbstractDriver<GC>::GetNumberFromString(secs, out, 0, S32_MAX / 2);
+      if (errmsg)
+      {
+        driver.GetVArguments().Die("Bad benchmark stall seconds '%s': %s", secs, errmsg);
+      }
+      driver.m_stallSeconds = (u32) out;
+    }
+
+    /**
+     * Ends a run hung somewhere that RunHelper's own stall check
+     * can't see, such as inside UpdateGrid.
+     */
+    static void OnStallAlarm(int signum)
+    {
+      static const char msg[] = "mfmbench: FAILED: grid hung, no AEPS progress\n";
+      if (write(2, msg, sizeof(msg) - 1)) { }
+      _exit(3);
+    }
+
+    void Place(const Element<EC> & elt, u32 x, u32 y)
+    {
+      this->GetGrid().PlaceAtom(elt.GetDefaultAtom(), SPoint(x, y));
+    }
+
+    /**
+     * Seeds the owned sites of the tile at (\c tx, \c ty) for our
+     * scenario.
+     */
+    void SeedTile(u32 tx, u32 ty)
+    {
+      const u32 x0 = tx * OWNED_SIDE;
+      const u32 y0 = ty * OWNED_SIDE;
+      const u32 cx = x0 + OWNED_SIDE / 2;
+      const u32 cy = y0 + OWNED_SIDE / 2;
+
+      switch (m_scenario)
+      {
+      case SCENARIO_DREG:
+        Place(Element_Dreg<EC>::THE_INSTANCE, cx, cy);
+        Place(Element_Res<EC>::THE_INSTANCE, cx + 1, cy);
+        break;
+
+      case SCENARIO_FORKBOMB:
+        Place(Element_ForkBomb1<EC>::THE_INSTANCE, cx, cy);
+        Place(Element_AntiForkBomb<EC>::THE_INSTANCE, x0 + 1, y0 + 1);
+        break;
+
+      case SCENARIO_SORTER:
+        Place(Element_Emitter<EC>::THE_INSTANCE, x0 + 1, cy);
+        Place(Element_Consumer<EC>::THE_INSTANCE, x0 + OWNED_SIDE - 2, cy);
+        for (u32 y = y0 + 1; y < y0 + OWNED_SIDE - 1; y += 2)
+        {
+          Place(Element_Sorter<EC>::THE_INSTANCE, cx, y);
+        }
+        break;
+
+      case SCENARIO_CITY:
+        Place(Element_City_Intersection<EC>::THE_INSTANCE, cx, cy);
+        break;
+
+      case SCENARIO_XTAL:
+        Place(Element_Xtal_Sq1<EC>::THE_INSTANCE, cx, cy);
+        Place(Element_Dreg<EC>::THE_INSTANCE, x0 + 1, y0 + 1);
+        break;
+
+      default:
+        FAIL(ILLEGAL_STATE);
+      }
+    }
+
+    void PrintResults(u32 ms)
+    {
+      Grid<GC> & grid = this->GetGrid();
+      TileCounters c;
+      grid.GetTotalCounters(c);
+
+      const double seconds = ms / 1000.0;
+      const double perEvent = c.m_eventsExecuted ? 1.0 / c.m_eventsExecuted : 0;
+
+      printf("{\"scenario\":\"%s\",\"tile\":\"%c\",\"tileSide\":%u,"
+             "\"gridWidth\":%u,\"gridHeight\":%u,\"sites\":%u,"
+             "\"seed\":%u,\"continuous\":%s,"
+             "\"aeps\":%.3f,\"seconds\":%.3f,"
+             "\"eventsPerSecond\":%.1f,\"aer\":%.3f,"
+             "\"overheadPercent\":%.2f,"
+             "\"packetsPerEvent\":%.4f,\"bytesPerEvent\":%.4f,"
+             "\"counters\":",
+             SCENARIO_NAMES[m_scenario], m_tileCode, (u32) GC::TILE_SIDE,
+             grid.GetWidth(), grid.GetHeight(), grid.GetTotalSites(),
+             m_seed, this->IsContinuous() ? "true" : "false",
+             this->GetAEPS(), seconds,
+             seconds > 0 ? c.m_eventsExecuted / seconds : 0, this->GetAER(),
+             this->GetOverheadPercent(),
+             c.m_packetsShipped * perEvent, c.m_bytesShipped * perEvent);
+
+      c.PrintJSON(STDOUT);  // Shares stdout's buffer with printf
+
+      if (m_scenario == SCENARIO_SORTER)
+      {
+        typedef Element_Emitter<EC> Emitter;
+        typedef Element_Consumer<EC> Consumer;
+        const u32 em = Emitter::THE_INSTANCE.GetType();
+        const u32 cn = Consumer::THE_INSTANCE.GetType();
+        printf(",\"sorter\":{\"emitAttempts\":%lu,\"overflow\":%lu,"
+               "\"dataOut\":%lu,\"sortError\":%lu}",
+               (unsigned long) grid.GetTotalElementData(em, Emitter::DATUMS_EMITTED_SLOT,
+                                                        Emitter::DATA_SLOT_COUNT),
+               (unsigned long) grid.GetTotalElementData(em, Emitter::DATUMS_REJECTED_SLOT,
+                                                        Emitter::DATA_SLOT_COUNT),
+               (unsigned long) grid.GetTotalElementData(cn, Consumer::DATUMS_CONSUMED_SLOT,
+                                                        Consumer::DATA_SLOT_COUNT),
+               (unsigned long) grid.GetTotalElementData(cn, Consumer::TOTAL_BUCKET_ERROR_SLOT,
+                                                        Consumer::DATA_SLOT_COUNT));
+      }
+
+      if (grid.GetIntertileMode() == Grid<GC>::INTERTILE_DIRECT)
+      {
+        printf(",\"directCaches\":true");
+      }
+
+      if (grid.GetPartitions() > 1)
+      {
+        printf(",\"partition\":%u,\"partitions\":%u",
+               grid.GetPartition(), grid.GetPartitions());
+        if (grid.GetPartitionSharedMemoryBytes() > 0)
+        {
+          printf(",\"sharedMemoryBytes\":%u", grid.GetPartitionSharedMemoryBytes());
+        }
+      }
+
+      if (m_stalled)
+      {
+        printf(",\"stalled\":true,\"stallSeconds\":%u", m_stallSeconds);
+      }
+
+      printf(",\"siteBytes\":%u", (u32) sizeof(typename GC::EVENT_CONFIG::SITE));
+
+      const HugePageBlock & block = grid.GetTileBlock();
+      printf(",\"tilePages\":\"%s\",\"tilePageBytes\":%lu,\"tileHugeBytes\":%lu",
+             HugePageBlock::GetBackingName(block.GetBacking()),
+             (unsigned long) block.GetPageBytes(),
+             (unsigned long) block.GetHugeBytes());
+
+      if (grid.GetThreadPlacement() != Grid<GC>::PLACE_ANYWHERE)
+      {
+        printf(",\"threadPlacement\":\"%s\"",
+               grid.GetThreadPlacement() == Grid<GC>::PLACE_NUMA ? "numa" : "pinned");
+      }
+
+      if (grid.GetCachePipelineDepth() > 1)
+      {
+        printf(",\"cachePipelineDepth\":%u", grid.GetCachePipelineDepth());
+      }
+
+      if (grid.GetCacheDigestPeriod() > 0)
+      {
+        printf(",\"cacheDigestPeriod\":%u", grid.GetCacheDigestPeriod());
+      }
+
+      if (grid.GetIntertileBufferSize() != GridTransceiver::DEFAULT_BUFFER_SIZE)
+      {
+        printf(",\"intertileBufferBytes\":%u", grid.GetIntertileBufferSize());
+      }
+
+      if (grid.GetPhaseSampleOdds() > 0)
+      {
+        PhaseHistograms ph;
+        grid.GetTotalPhaseHistograms(ph);
+        printf(",\"phaseSampleOdds\":%u,\"phases\":", grid.GetPhaseSampleOdds());
+        ph.PrintJSON(STDOUT);
+      }
+      printf("}\n");
+      fflush(stdout);
+    }
+
+  public:
+
+    MFMBenchDriver(char tileCode, u32 gridWidth, u32 gridHeight)
+      : Super(gridWidth, gridHeight)
+      , m_tileCode(tileCode)
+      , m_scenario(SCENARIO_DREG)
+      , m_benchAEPS(100)
+      , m_seed(1)
+      , m_stallSeconds(60)
+      , m_stalled(false)
+    {
+      // No epochs or autosaves unless asked for: they would be timed too
+      this->m_AEPSPerEpoch = -1;
+      this->m_autosavePerEpochs = 0;
+    }
+
+    virtual void AddDriverArguments()
+    {
+      Super::AddDriverArguments();
+      this->RegisterSection("Benchmark switches");
+
+      this->RegisterArgument("Seed the grid for scenario ARG "
+                             "(dreg, forkbomb, sorter, city, xtal)",
+                             "--scenario", &SetScenarioFromArgs, this, true);
+      this->RegisterArgument("Run the benchmark for ARG AEPS (default 100)",
+                             "--benchaeps", &SetBenchAEPSFromArgs, this, true);
+      this->RegisterArgument("Give up if the grid makes no AEPS progress for ARG seconds "
+                             "(default 60; 0 for never)",
+                             "--benchstall", &SetBenchStallFromArgs, this, true);
+    }
+
+    bool IsStalled() const
+    {
+      return m_stalled;
+    }
+
+    virtual void OnceOnly(VArguments& args)
+    {
+      Super::OnceOnly(args);
+      if (args.Appeared("--seed"))
+      {
+        m_seed = args.GetInt("--seed");
+      }
+    }
+
+    virtual void ReinitEden()
+    {
+      Grid<GC> & grid = this->GetGrid();
+      for (u32 ty = 0; ty < grid.GetHeight(); ++ty)
+      {
+        for (u32 tx = 0; tx < grid.GetWidth(); ++tx)
+        {
+          SeedTile(tx, ty);
+        }
+      }
+    }
+
+    virtual void RunHelper()
+    {
+      Grid<GC> & grid = this->GetGrid();
+      const u32 startMS = this->GetTicks();
+      u32 progressMS = startMS;
+      double progressAEPS = this->GetAEPS();
+
+      if (m_stallSeconds > 0)
+      {
+        signal(SIGALRM, OnStallAlarm);
+        alarm(2 * m_stallSeconds);
+      }
+
+      while (this->GetAEPS() < m_benchAEPS)
+      {
+        if (this->IsContinuous())
+        {
+          this->UpdateGridContinuously(grid);
+          SleepUsec(CONTINUOUS_SAMPLE_MICROS);
+        }
+        else
+        {
+          this->UpdateGrid(grid);
+        }
+
+        const u32 nowMS = this->GetTicks();
+        if (this->GetAEPS() > progressAEPS)
+        {
+          progressAEPS = this->GetAEPS();
+          progressMS = nowMS;
+          if (m_stallSeconds > 0)
+          {
+            alarm(2 * m_stallSeconds);
+          }
+        }
+        else if (m_stallSeconds > 0 && nowMS - progressMS >= 1000 * m_stallSeconds)
+        {
+          LOG.Error("No AEPS progress in %d seconds, at %d of %d AEPS; giving up",
+                    m_stallSeconds, (u32) progressAEPS, m_benchAEPS);
+          m_stalled = true;
+          break;
+        }
+      }
+      this->StopContinuousRun(grid);
+
+      PrintResults(this->GetTicks() - startMS);
+
+      grid.ShutdownTileThreads();
+      alarm(0);
+    }
+  };
+
+  template <class CONFIG>
+  int BenchRunner(char tileCode, int argc, const char** argv, u32 gridWidth, u32 gridHeight)
+  {
+    // The driver lives on the stack, as in mfmc; make sure it fits
+    struct rlimit lim;
+    const rlim_t needed = 110*sizeof(MFMBenchDriver<CONFIG>) / 100;
+    if (!getrlimit(RLIMIT_STACK, &lim) && lim.rlim_cur != RLIM_INFINITY &&
+        lim.rlim_cur < needed)
+    {
+      lim.rlim_cur = lim.rlim_max == RLIM_INFINITY || lim.rlim_max > needed ? needed : lim.rlim_max;
+      if (setrlimit(RLIMIT_STACK, &lim))
+      {
+        fprintf(stderr,"WARNING: Unable to increase stack limit (may segfault): %s\n",
+                strerror(errno));
+      }
+    }
+
+    MFMBenchDriver<CONFIG> bench(tileCode, gridWidth, gridHeight);
+    bench.ProcessArguments(argc, argv);
+    bench.Init();
+    bench.Run();
+    return bench.IsStalled() ? 2 : 0;
+  }
+
+  /////
+  // Tile types
+#define XX(A,B) \
+  typedef GridConfig<OurEventConfigAll, B> OurGridConfigTile##A;
+#include "TileSizes.inc"
+#undef XX
+
+  static int BenchRunConfig(char tileCode, u32 w, u32 h, int argc, const char** argv)
+  {
+#define XX(A,B) \
+    if (tileCode == *#A) return BenchRunner<OurGridConfigTile##A>(tileCode, argc, argv, w, h);
+#include "TileSizes.inc"
+#undef XX
+    fprintf(stderr, "%s: Unknown tile type '%c'\n", argv[0], tileCode);
+    return 1;
+  }
+
+  static bool IsTileCode(char tileCode)
+  {
+#define XX(A,B) if (tileCode == *#A) return true;
+#include "TileSizes.inc"
+#undef XX
+    return false;
+  }
+
+  /**
+   * Appends \c str to the null-terminated \c cmd , single-quoted for
+   * the shell, with any single quotes within it escaped.
+   *
+   * @returns false, leaving \c cmd unchanged, if the \c size bytes
+   *          of \c cmd have no room for it.
+   */
+  static bool AppendShellQuoted(char * cmd, u32 size, const char * str)
+  {
+    u32 len = strlen(cmd);
+    u32 needed = 2;  // The enclosing quotes
+    for (const char * p = str; *p; ++p)
+    {
+      needed += *p == '\'' ? 4 : 1;
+    }
+    if (len + needed >= size)
+    {
+      return false;
+    }
+
+    cmd[len++] = '\'';
+    for (const char * p = str; *p; ++p)
+    {
+      if (*p == '\'')
+      {
+        // Close the quote, add an escaped quote, and reopen it
+        memcpy(cmd + len, "'\\''", 4);
+        len += 4;
+      }
+      else
+      {
+        cmd[len++] = *p;
+      }
+    }
+    cmd[len++] = '\'';
+    cmd[len] = '\0';
+    return true;
+  }
+
+  /**
+   * Runs each suite combination in a child mfmbench, and gathers their
+   * JSON results into one JSON object on stdout.
+   */
+  static int RunSuite(int argc, const char** argv)
+  {
+    const char * tiles = "ABCDEFGHIJ";
+    const char * shapes = "1x1,2x2,4x2";
+    const char * scenarios = "dreg,forkbomb,sorter,city,xtal";
+    const char * dir = "/tmp/mfmbench";
+    u32 aeps = 100;
+    u32 seed = 1;
+    u32 phaseTiming = 0;
+    u32 cachePipeline = 1;
+    u32 cacheDigest = 0;
+    u32 intertileBuffer = GridTransceiver::DEFAULT_BUFFER_SIZE;
+    bool continuous = false;
+    bool directCaches = false;
+    const char * placement = "";
+
+    for (int i = 1; i < argc; ++i)
+    {
+      const char * arg = argv[i];
+      const char * val = i + 1 < argc ? argv[i + 1] : 0;
+      bool hasVal = true;
+      if (!strcmp(arg, "--aeps") && val) aeps = strtoul(val, 0, 10);
+      else if (!strcmp(arg, "--tiles") && val) tiles = val;
+      else if (!strcmp(arg, "--shapes") && val) shapes = val;
+      else if (!strcmp(arg, "--scenarios") && val) scenarios = val;
+      else if (!strcmp(arg, "--seed") && val) seed = strtoul(val, 0, 10);
+      else if (!strcmp(arg, "--dir") && val) dir = val;
+      else if (!strcmp(arg, "--phasetiming") && val) phaseTiming = strtoul(val, 0, 10);
+      else if (!strcmp(arg, "--cachepipeline") && val) cachePipeline = strtoul(val, 0, 10);
+      else if (!strcmp(arg, "--cachedigest") && val) cacheDigest = strtoul(val, 0, 10);
+      else if (!strcmp(arg, "--intertilebuffer") && val) intertileBuffer = strtoul(val, 0, 10);
+      else if (!strcmp(arg, "--continuous")) continuous = true, hasVal = false;
+      else if (!strcmp(arg, "--directcaches")) directCaches = true, hasVal = false;
+      else if (!strcmp(arg, "--pin")) placement = " --pin", hasVal = false;
+      else if (!strcmp(arg, "--numa")) placement = " --numa", hasVal = false;
+      else
+      {
+        fprintf(stderr,
+                "Usage: %s [--aeps N] [--tiles LETTERS] [--shapes WxH,...]\n"
+                "          [--scenarios NAME,...] [--seed N] [--dir DIR] [--continuous]\n"
+                "          [--phasetiming N] [--cachepipeline N] [--cachedigest N]\n"
+                "          [--intertilebuffer BYTES]\n"
+                "          [--directcaches] [--pin | --numa]\n"
+                "   or: %s {WTH} [--scenario NAME] [--benchaeps N] [driver switches]\n",
+                argv[0], argv[0]);
+        return 1;
+      }
+      if (hasVal) ++i;
+    }
+
+    if (aeps == 0 || seed == 0)
+    {
+      fprintf(stderr, "%s: --aeps and --seed must be positive\n", argv[0]);
+      return 1;
+    }
+
+    if (mkdir(dir, 0777) && errno != EEXIST)
+    {
+      fprintf(stderr, "%s: Couldn't make directory '%s': %s\n", argv[0], dir, strerror(errno));
+      return 1;
+    }
+
+    for (const char * t = tiles; *t; ++t)
+    {
+      if (!IsTileCode(*t))
+      {
+        fprintf(stderr, "%s: Unknown tile type '%c'\n", argv[0], *t);
+        return 1;
+      }
+    }
+
+    printf("{\"mfmbench\":1,\"aeps\":%u,\"seed\":%u,\"runs\":[\n", aeps, seed);
+    fflush(stdout);
+
+    u32 runs = 0;
+    u32 failures = 0;
+    for (const char * sc = scenarios; *sc; )
+    {
+      const char * scEnd = strchr(sc, ',');
+      u32 scLen = scEnd ? scEnd - sc : strlen(sc);
+      if (FindScenario(sc, scLen) < 0)
+      {
+        fprintf(stderr, "%s: Unknown scenario '%.*s'\n", argv[0], (int) scLen, sc);
+        return 1;
+      }
+
+      for (const char * t = tiles; *t; ++t)
+      {
+        for (const char * sh = shapes; *sh; )
+        {
+          u32 w, h;
+          if (sscanf(sh, "%ux%u", &w, &h) != 2 || w == 0 || h == 0)
+          {
+            fprintf(stderr, "%s: Bad shape in '%s'\n", argv[0], sh);
+            return 1;
+          }
+
+          // Paths go through the shell quoted, whatever they contain
+          char runDir[1024];
+          snprintf(runDir, sizeof(runDir), "%s/%.*s-%u%c%u",
+                   dir, (int) scLen, sc, w, *t, h);
+
+          char cmd[4096] = "";
+          char args[512];
+          snprintf(args, sizeof(args),
+                   " '{%u%c%u}' --scenario %.*s --benchaeps %u --seed %u -d ",
+                   w, *t, h, (int) scLen, sc, aeps, seed);
+          bool fits = AppendShellQuoted(cmd, sizeof(cmd), argv[0]) &&
+            strlen(cmd) + strlen(args) < sizeof(cmd);
+          if (fits)
+          {
+            strcat(cmd, args);
+            fits = AppendShellQuoted(cmd, sizeof(cmd), runDir);
+          }
+          snprintf(args, sizeof(args),
+                   " -l 0 --phasetiming %u --cachepipeline %u"
+                   " --cachedigest %u --intertilebuffer %u%s%s%s",
+                   phaseTiming, cachePipeline, cacheDigest, intertileBuffer,
+                   continuous ? " --continuous" : "",
+                   directCaches ? " --directcaches" : "",
+                   placement);
+          if (!fits || strlen(cmd) + strlen(args) >= sizeof(cmd))
+          {
+            fprintf(stderr, "%s: Command line too long for '%s'\n", argv[0], runDir);
+            return 1;
+          }
+          strcat(cmd, args);
+
+          fprintf(stderr, "mfmbench: %s\n", cmd);
+          FILE * child = popen(cmd, "r");
+          char line[8192];
+          bool got = false;
+          while (child && fgets(line, sizeof(line), child))
+          {
+            if (line[0] == '{' && !got)
+            {
+              printf("%s%s", runs ? "," : "", line);
+              fflush(stdout);
+              got = true;
+              ++runs;
+            }
+          }
+          if (!child || pclose(child) != 0 || !got)
+          {
+            fprintf(stderr, "mfmbench: FAILED: %s\n", cmd);
+            ++failures;
+          }
+
+          sh = strchr(sh, ',');
+          if (sh) ++sh;
+          else break;
+        }
+      }
+      sc = scEnd ? scEnd + 1 : sc + scLen;
+    }
+
+    printf("],\"failures\":%u}\n", failures);
+    return failures ? 2 : 0;
+  }
+
+  int MainDispatch(int argc, const char** argv)
+  {
+    LOG.SetByteSink(STDERR);
+    LOG.SetLevel(LOG.MESSAGE);
+
+    u32 w, h;
+    char tileCode;
+    char end;
+    if (argc >= 2 &&
+        sscanf(argv[1], "{%u%c%u%c", &w, &tileCode, &h, &end) == 4 && end == '}')
+    {
+      if (w == 0 || h == 0)
+      {
+        fprintf(stderr, "%s: Bad geometry '%s'\n", argv[0], argv[1]);
+        return 1;
+      }
+      return BenchRunConfig(tileCode, w, h, argc, argv);
+    }
+    return RunSuite(argc, argv);
+  }
+}
+
+int main(int argc, const char** argv)
+{
+  return MFM::MainDispatch(argc, argv);
+}
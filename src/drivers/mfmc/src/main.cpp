@@ -14,6 +14,16 @@ namespace MFM
     enum { WIDTH = W, HEIGHT = H };
   };
 
+  /////
+  // For all models
+
+  typedef P3Atom OurAtomAll;
+  typedef Site<P3AtomConfig> OurSiteAll;
+  typedef EventConfig<OurSiteAll,4> OurEventConfigAll;
+
+  // Tiles of any side, chosen at startup
+  typedef GridConfig<OurEventConfigAll, 0> OurGridConfigTileRuntime;
+
   struct GridConfigCode {
 
     enum TileType { TileUNSPEC
@@ -21,6 +31,7 @@ namespace MFM
 #include "TileSizes.inc"
 #undef XX
       , TileUPPER_BOUND
+      , TileRUNTIME  // Any other side, chosen at runtime
     };
 
     static u8 GetTileTypeCode(TileType t)
@@ -44,14 +55,28 @@ namespace MFM
       return GetTileTypeCode((TileType) (TileUPPER_BOUND - 1));
     }
 
+    /**
+       The compiled tile type whose side is \c side, or TileRUNTIME if
+       there isn't one.
+     */
+    static TileType GetTileTypeOfSide(u32 side)
+    {
+#define XX(A,B) if (side == B) return Tile##A;
+#include "TileSizes.inc"
+#undef XX
+      return TileRUNTIME;
+    }
+
     TileType tileType;
     u32 gridWidth;
     u32 gridHeight;
+    u32 tileSide;  // For TileRUNTIME only
 
     GridConfigCode(TileType t = TileUNSPEC, u32 width = 0, u32 height = 0)
       : tileType(t)
       , gridWidth(width)
       , gridHeight(height)
+      , tileSide(0)
     { }
 
     bool Set(TileType t, u32 width, u32 height)
@@ -81,36 +106,60 @@ namespace MFM
       return true;
     }
 
+    /**
+       Read a code of the form {WTH}, for W x H tiles of compiled type
+       T, or {WxH@S}, for W x H tiles of side S.  S may be any side
+       Grid allows for a runtime tile side; a side that some compiled
+       type has gets that type instead, so it runs just the same.
+     */
     bool Read(ByteSource & bs)
     {
-      u32 w, h;
+      u32 w, h, side = 0;
       u8 ch;
 
-      if (bs.Scanf("{%d%c%d}", &w, &ch, &h) != 5)
+      if (bs.Scanf("{%d%c", &w, &ch) != 3)
         return false;
 
-      if (ch < GridConfigCode::GetMinTypeCode() ||
-          ch > GridConfigCode::GetMaxTypeCode())
-        return false;
+      if (ch == 'x')
+      {
+        typedef Grid<OurGridConfigTileRuntime> RuntimeGrid;
+
+        if (bs.Scanf("%d@%d}", &h, &side) != 4)
+          return false;
+
+        if (side < RuntimeGrid::MIN_TILE_SIDE ||
+            side > RuntimeGrid::MAX_TILE_SIDE || side % 2 != 0)
+          return false;
+      }
+      else
+      {
+        if (bs.Scanf("%d}", &h) != 2)
+          return false;
+
+        if (ch < GridConfigCode::GetMinTypeCode() ||
+            ch > GridConfigCode::GetMaxTypeCode())
+          return false;
+      }
 
       if (bs.Read() >= 0)  // need EOF here
         return false;
 
       SetGridWidth(w);
       SetGridHeight(h);
-      SetTileType((GridConfigCode::TileType)
-                  ((ch - GridConfigCode::GetMinTypeCode()) + GridConfigCode::TileA));
+      if (side == 0)
+      {
+        SetTileType((GridConfigCode::TileType)
+                    ((ch - GridConfigCode::GetMinTypeCode()) + GridConfigCode::TileA));
+      }
+      else
+      {
+        SetTileType(GetTileTypeOfSide(side));
+        tileSide = side;
+      }
       return true;
     }
   };
 
-  /////
-  // For all models
-
-  typedef P3Atom OurAtomAll;
-  typedef Site<P3AtomConfig> OurSiteAll;
-  typedef EventConfig<OurSiteAll,4> OurEventConfigAll;
-
   /////
   // Tile types
 #define XX(A,B) \
@@ -218,6 +267,9 @@ namespace MFM
     fprintf(stderr, "  Type '%s': %d non-cache sites (%d x %d site storage)\n", #A, (B-8)*(B-8), B, B);
 #include "TileSizes.inc"
 #undef XX
+      fprintf(stderr, "  Or {WxH@SIDE}: any even SIDE from %d to %d, sized at startup\n",
+              Grid<OurGridConfigTileRuntime>::MIN_TILE_SIDE,
+              Grid<OurGridConfigTileRuntime>::MAX_TILE_SIDE);
 
       exit(0);
     }
@@ -225,8 +277,8 @@ namespace MFM
 
   public:
 
-    MFMCDriver(u32 gridWidth, u32 gridHeight)
-      : Super(gridWidth, gridHeight)
+    MFMCDriver(u32 gridWidth, u32 gridHeight, u32 tileSide)
+      : Super(gridWidth, gridHeight, tileSide)
       , m_stamper(*this)
     {
       MFM::LOG.SetTimeStamper(&m_stamper);
@@ -261,9 +313,9 @@ namespace MFM
   };
 
   template <class CONFIG>
-  int SimRunner(int argc, const char** argv,u32 gridWidth,u32 gridHeight)
+  int SimRunner(int argc, const char** argv,u32 gridWidth,u32 gridHeight,u32 tileSide)
   {
-    MFMCDriver<CONFIG> sim(gridWidth,gridHeight);
+    MFMCDriver<CONFIG> sim(gridWidth,gridHeight,tileSide);
     sim.ProcessArguments(argc, argv);
     sim.AddInternalLogging();
     sim.Init();
@@ -276,7 +328,8 @@ namespace MFM
      grid sizing (since we're not in core/ here).  But it shouldn't
      hurt anything so for now anyway we're leaving it in. */
   template <class CONFIG>
-  int SimCheckAndRun(int argc, const char** argv, u32 gridWidth, u32 gridHeight)
+  int SimCheckAndRun(int argc, const char** argv, u32 gridWidth, u32 gridHeight,
+                     u32 tileSide = CONFIG::TILE_SIDE)
   {
     struct rlimit lim;
     if (getrlimit(RLIMIT_STACK, &lim))
@@ -301,7 +354,7 @@ namespace MFM
         }
       }
     }
-    return SimRunner<CONFIG>(argc,argv,gridWidth,gridHeight);
+    return SimRunner<CONFIG>(argc,argv,gridWidth,gridHeight,tileSide);
   }
 
   int SimRunConfig(const GridConfigCode & gcc, int argc, const char** argv)
@@ -310,9 +363,18 @@ namespace MFM
     u32 h = gcc.gridHeight;
     switch (gcc.tileType)
     {
+#ifdef MFMC_RUNTIME_TILES_ONLY
+      /* Build just one engine, and size even the lettered tile types
+         at startup */
+#define XX(A,B) case GridConfigCode::Tile##A: \
+      return SimCheckAndRun<OurGridConfigTileRuntime>(argc, argv, w, h, B);
+#else
 #define XX(A,B) case GridConfigCode::Tile##A: return SimCheckAndRun<OurGridConfigTile##A>(argc, argv, w, h);
+#endif
 #include "TileSizes.inc"
 #undef XX
+    case GridConfigCode::TileRUNTIME:
+      return SimCheckAndRun<OurGridConfigTileRuntime>(argc, argv, w, h, gcc.tileSide);
     default:
       FAIL(ILLEGAL_STATE);
     }
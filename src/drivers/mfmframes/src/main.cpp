@@ -0,0 +1,76 @@
+#include "main.h"
+#include <stdio.h>   /* For fopen, fread, snprintf */
+#include <string.h>  /* For strerror, memcmp */
+#include <errno.h>   /* For errno */
+
+using namespace MFM;
+
+/*
+ * Converts frame dump files written by mfms --framedump into one PNG
+ * per frame, in OUTDIR, named as they would have been without
+ * --framedump.  So for example:
+ *
+ *   mfmframes SIMDIR/vid/frames.dump SIMDIR/vid
+ *
+ * leaves SIMDIR/vid ready for tools/RenderPNGsCenteredToHD.
+ */
+int main(int argc, char** argv)
+{
+  if (argc < 3)
+  {
+    fprintf(stderr, "Usage: %s DUMPFILE... OUTDIR\n", argv[0]);
+    return 1;
+  }
+
+  const char * outDir = argv[argc - 1];
+  u32 * pixels = 0;
+  u32 capacity = 0;
+  u32 frames = 0;
+
+  for (int i = 1; i < argc - 1; ++i)
+  {
+    FILE * fp = fopen(argv[i], "r");
+    if (!fp)
+    {
+      fprintf(stderr, "%s: Can't read '%s': %s\n", argv[0], argv[i], strerror(errno));
+      return 2;
+    }
+
+    CameraFrameHeader header;
+    while (fread(&header, sizeof(header), 1, fp) == 1)
+    {
+      if (memcmp(header.m_magic, CAMERA_FRAME_MAGIC, sizeof(header.m_magic)) ||
+          header.m_name[CameraFrameHeader::NAME_LENGTH - 1] != '\0')
+      {
+        fprintf(stderr, "%s: '%s' is not a frame dump, or is corrupt\n", argv[0], argv[i]);
+        return 3;
+      }
+
+      const u32 size = header.m_width * header.m_height;
+      if (size > capacity)
+      {
+        delete [] pixels;
+        pixels = new u32[size];
+        capacity = size;
+      }
+      if (fread(pixels, sizeof(u32), size, fp) != size)
+      {
+        fprintf(stderr, "%s: '%s' ends mid-frame\n", argv[0], argv[i]);
+        break;
+      }
+
+      char path[Camera::PATH_MAX_LENGTH];
+      snprintf(path, sizeof(path), "%s/%s", outDir, header.m_name);
+      if (Camera::SavePNG(path, pixels, header.m_width, header.m_height))
+      {
+        return 4;
+      }
+      ++frames;
+    }
+    fclose(fp);
+  }
+
+  delete [] pixels;
+  fprintf(stderr, "%s: Wrote %d pngs to %s\n", argv[0], frames, outDir);
+  return 0;
+}
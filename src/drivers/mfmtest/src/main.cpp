@@ -20,6 +20,9 @@ int main(int argc, char** argv)
   TEST(UlamElement_Test);
 
   TEST(GridTransceiver_Test);
+  TEST(SharedMemoryChannel_Test);
+  TEST(CpuPlacement_Test);
+  TEST(HugePageBlock_Test);
   TEST(ElementRegistry_Test);
   TEST(ByteSource_Test);
   TEST(LineTailByteSink_Test);
@@ -54,6 +57,8 @@ int main(int argc, char** argv)
   TEST(Tile_Test);
 
   Grid_Test::Test_gridPlaceAtom();
+  Grid_Test::Test_gridRuntimeTileSide();
+  Grid_Test::Test_gridPublishedAtomCounts();
 
   TEST(ExternalConfig_Test);
 
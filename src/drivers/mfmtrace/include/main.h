@@ -0,0 +1,7 @@
+#ifndef MAIN_H
+#define MAIN_H
+
+#include "TraceBuffer.h"
+#include "FileByteSink.h"
+
+#endif  /* MAIN_H */
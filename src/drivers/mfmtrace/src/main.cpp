@@ -0,0 +1,42 @@
+#include "main.h"
+#include <stdio.h>   /* For fopen, fread */
+#include <string.h>  /* For strerror */
+#include <errno.h>   /* For errno */
+
+using namespace MFM;
+
+/*
+ * Decodes binary trace files written by --trace into one text line
+ * per record, on stdout:
+ *
+ *   SECONDS.NANOS TILEID EVENTID CODE ARG0 ARG1 ARG2
+ *
+ * Records are printed in file order.  To interleave several tiles'
+ * traces by time: mfmtrace trace/tile-*.bin | sort -n
+ */
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    fprintf(stderr, "Usage: %s TRACEFILE...\n", argv[0]);
+    return 1;
+  }
+
+  for (int i = 1; i < argc; ++i)
+  {
+    FILE * fp = fopen(argv[i], "r");
+    if (!fp)
+    {
+      fprintf(stderr, "%s: Can't read '%s': %s\n", argv[0], argv[i], strerror(errno));
+      return 2;
+    }
+
+    TraceRecord rec;
+    while (fread(&rec, sizeof(rec), 1, fp) == 1)
+    {
+      rec.PrintTo(STDOUT);
+    }
+    fclose(fp);
+  }
+  return 0;
+}
@@ -72,30 +72,6 @@ namespace MFM
       Element<EC>::SetName("Consumer");
     }
 
-    u64 GetAndResetDatumsConsumed(Tile<EC> & t) const
-    {
-      ElementTable<EC> & et = t.GetElementTable();
-      u64 * datap = et.GetDataIfRegistered(this->GetType(), DATA_SLOT_COUNT);
-      if (!datap)
-        return 0;
-
-      u64 ret = datap[DATUMS_CONSUMED_SLOT];
-      datap[DATUMS_CONSUMED_SLOT] = 0;
-      return ret;
-    }
-
-    u64 GetAndResetBucketError(Tile<EC> & t) const
-    {
-      ElementTable<EC> & et = t.GetElementTable();
-      u64 * datap = et.GetDataIfRegistered(this->GetType(), DATA_SLOT_COUNT);
-      if (!datap)
-        return 0;
-
-      u64 ret = datap[TOTAL_BUCKET_ERROR_SLOT];
-      datap[TOTAL_BUCKET_ERROR_SLOT] = 0;
-      return ret;
-    }
-
     virtual u32 PercentMovable(const T& you,
                                const T& me, const SPoint& offset) const
     {
@@ -156,15 +132,12 @@ namespace MFM
 
             u32 bucketsOff = diff / bucketSize;
 
-#if 0 //XXX  Fri Jan 30 22:13:11 2015 EDS unreimplemented
-
             Tile<EC> & tile = window.GetTile();
             ElementTable<EC> & et = tile.GetElementTable();
 
             u64 * datap = et.GetDataAndRegister(this->GetType(), DATA_SLOT_COUNT);
             ++datap[DATUMS_CONSUMED_SLOT];                 // Count datums consumed
             datap[TOTAL_BUCKET_ERROR_SLOT] += bucketsOff;  // Count total bucket error
-#endif
             LOG.Debug("Consumed %d bucketsOff",bucketsOff);
 
             /*
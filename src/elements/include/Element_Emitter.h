@@ -105,13 +105,11 @@ namespace MFM
 
       if(random.OddsOf(DATA_CREATE_PER_1000,1000))
       {
-#if 0 //XXX Fri Jan 30 22:12:52 2015 EDS unreimplemented in v3
         Tile<EC> & tile = window.GetTile();
         ElementTable<EC> & et = tile.GetElementTable();
 
         u64 * datap = et.GetDataAndRegister(this->GetType(), DATA_SLOT_COUNT);
         ++datap[DATUMS_EMITTED_SLOT];                  // Count emission attempts
-#endif
 
         // Pick random nearest empty, if any
         const MDist<R> & md = MDist<R>::get();
@@ -141,7 +139,7 @@ namespace MFM
           }
         }
 
-        //XXX        ++datap[DATUMS_REJECTED_SLOT];  // Opps, no room at the inn
+        ++datap[DATUMS_REJECTED_SLOT];  // Opps, no room at the inn
       }
     }
   };
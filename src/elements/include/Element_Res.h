@@ -60,6 +60,12 @@ namespace MFM
     {
       Element<EC>::SetAtomicSymbol("R");
       Element<EC>::SetName("Res");
+      Element<EC>::SetBehaviorFunction(&DoBehavior);
+    }
+
+    static void DoBehavior(const Element<EC> & elt, EventWindow<EC>& window)
+    {
+      window.Diffuse();
     }
 
     virtual u32 PercentMovable(const T& you,
@@ -82,7 +88,7 @@ namespace MFM
 
     virtual void Behavior(EventWindow<EC>& window) const
     {
-      window.Diffuse();
+      DoBehavior(*this, window);
     }
   };
 
@@ -55,8 +55,13 @@ namespace MFM
     {
       Element<EC>::SetAtomicSymbol("W");
       Element<EC>::SetName("Wall");
+      Element<EC>::SetBehaviorFunction(&DoBehavior);
+      Element<EC>::SetInert(true);
     }
 
+    static void DoBehavior(const Element<EC> & elt, EventWindow<EC>& window)
+    { }
+
     virtual const T & GetDefaultAtom() const
     {
       static T defaultAtom(TYPE(),0,0,0);
@@ -94,7 +99,9 @@ namespace MFM
     }
 
     virtual void Behavior(EventWindow<EC>& window) const
-    { }
+    {
+      DoBehavior(*this, window);
+    }
   };
 
   template <class EC>
@@ -64,6 +64,9 @@ namespace MFM
 {
 #define FRAMES_PER_SECOND 100.0
 
+/* Tile snapshot period when running continuously; about 30 fps */
+#define SNAPSHOT_PERIOD_MS 33
+
 #define CAMERA_SLOW_SPEED 2
 #define CAMERA_FAST_SPEED 50
 
@@ -95,6 +98,7 @@ namespace MFM
     bool m_bigText;
     u32 m_thisEpochAEPS;
     bool m_captureScreenshots;
+    bool m_dumpFrames;       // Capture into one raw frame dump, not pngs
     s32 m_screenshotTargetFPS;
     u32 m_saveStateIndex;
     u32 m_epochSaveStateIndex;
@@ -637,10 +641,20 @@ namespace MFM
 
       m_buttonPanel.SetAnchor(ANCHOR_SOUTH);
       m_buttonPanel.SetAnchor(ANCHOR_EAST);
+
+      if (Super::IsContinuous())
+      {
+        Super::GetGrid().SetSnapshotPeriodMS(SNAPSHOT_PERIOD_MS);
+      }
     }
 
     void Update(OurGrid& grid)
     {
+      if (m_keyboard.AnyDown())
+      {
+        Super::StopContinuousRun(grid);  // Keys may edit the grid
+      }
+
       KeyboardUpdate(grid);
 
       if (m_singleStep)
@@ -649,7 +663,15 @@ namespace MFM
       }
 
       m_gridPaused = m_keyboardPaused || m_mousePaused;
-      if (!m_gridPaused)
+      if (!m_gridPaused && Super::IsContinuous() && !m_singleStep)
+      {
+        // Started by RunHelper after painting, if not running now
+        if (Super::IsRunningContinuously())
+        {
+          Super::UpdateGridContinuously(grid);
+        }
+      }
+      else if (!m_gridPaused)
       {
         Super::UpdateGrid(grid);
         if (m_singleStep)
@@ -660,6 +682,7 @@ namespace MFM
       }
       else
       {
+        Super::StopContinuousRun(grid);
         //        SleepMsec(33); // 33 ms ~= 30 fps idle
         SleepMsec(100); // 100 ms ~= 10 fps idle
       }
@@ -808,12 +831,13 @@ namespace MFM
         Super::SaveGrid(filename);
     }
 
-    AbstractGUIDriver(u32 gridWidth, u32 gridHeight)
-      : Super(gridWidth, gridHeight)
+    AbstractGUIDriver(u32 gridWidth, u32 gridHeight, u32 tileSide = GC::TILE_SIDE)
+      : Super(gridWidth, gridHeight, tileSide)
       , m_startPaused(true)
       , m_thisUpdateIsEpoch(false)
       , m_bigText(false)
       , m_captureScreenshots(false)
+      , m_dumpFrames(false)
       , m_saveStateIndex(0)
       , m_epochSaveStateIndex(0)
       , m_renderStats(false)
@@ -957,6 +981,29 @@ namespace MFM
       driver.m_startPaused = false;
     }
 
+    static void SetDumpFramesFromArgs(const char* not_used, void* driverptr)
+    {
+      AbstractGUIDriver& driver = *((AbstractGUIDriver*)driverptr);
+
+      driver.m_dumpFrames = true;
+    }
+
+    static void SetPNGThreadsFromArgs(const char* str, void* driverptr)
+    {
+      AbstractGUIDriver& driver = *((AbstractGUIDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg =
+        AbstractDriver<GC>::GetNumberFromString(str, out, 1, Camera::MAX_ENCODER_THREADS);
+      if (errmsg)
+      {
+        args.Die("Bad png thread count '%s': %s", str, errmsg);
+      }
+
+      driver.camera.SetEncoderThreads((u32) out);
+    }
+
     static void DontShowHelpPanelOnStart(const char* not_used, void* driverptr)
     {
       AbstractGUIDriver& driver = *((AbstractGUIDriver*)driverptr);
@@ -997,6 +1044,13 @@ namespace MFM
       this->RegisterArgument("Record a png per epoch for playback at ARG fps",
                              "-p|--pngs", &SetRecordScreenshotPerAEPSFromArgs, this, true);
 
+      this->RegisterArgument("Record -p frames uncompressed into vid/frames.dump, "
+                             "for conversion to pngs later by mfmframes",
+                             "--framedump", &SetDumpFramesFromArgs, this, false);
+
+      this->RegisterArgument("Encode recorded frames using ARG background threads",
+                             "--pngthreads", &SetPNGThreadsFromArgs, this, true);
+
       this->RegisterArgument("Simulation begins upon program startup.",
                              "--run", &SetStartPausedFromArgs, this, false);
 
@@ -1292,6 +1346,7 @@ namespace MFM
 
           mousebuttondispatch:
             {
+              Super::StopContinuousRun(Super::GetGrid());  // Tools edit the grid
               MouseButtonEvent mbe(m_keyboard, event, m_selectedTool);
               m_rootPanel.Dispatch(mbe,
                                    Rect(SPoint(),
@@ -1301,6 +1356,10 @@ namespace MFM
 
           case SDL_MOUSEMOTION:
           {
+            if (mouseButtonsDown)
+            {
+              Super::StopContinuousRun(Super::GetGrid());  // Drags edit the grid
+            }
             MouseMotionEvent mme(m_keyboard, event,
                                  mouseButtonsDown, dragStartPositions, m_selectedTool);
             m_rootPanel.Dispatch(mme,
@@ -1336,22 +1395,48 @@ namespace MFM
 
         m_rootDrawing.Clear();
 
+        m_grend.SetRenderFromSnapshots(Super::IsRunningContinuously());
+
         m_rootPanel.Paint(m_rootDrawing);
 
         if (m_thisUpdateIsEpoch)
         {
           if (m_captureScreenshots)
           {
+            if (m_dumpFrames && !camera.IsFrameDumpOpen())
+            {
+              camera.OpenFrameDump(Super::GetSimDirPathTemporary("vid/frames.dump"));
+            }
+
             const char * path = Super::GetSimDirPathTemporary("vid/%010d.png", m_thisEpochAEPS);
 
-            camera.DrawSurface(screen,path);
+            if (m_dumpFrames)
+            {
+              camera.DumpSurface(screen,path);
+            }
+            else
+            {
+              camera.DrawSurface(screen,path);
+            }
           }
         }
 
         running = this->RunHelperExiter();
+
+        // (Re)start continuous running only after a paint from the
+        // paused grid, so edits show while the first snapshots publish
+        if (running && Super::IsContinuous() && !m_gridPaused)
+        {
+          Super::StartContinuousRun(Super::GetGrid());
+        }
+
         SDL_Flip(screen);
       }
 
+      Super::StopContinuousRun(Super::GetGrid());
+
+      camera.Flush();  // Finish writing any recorded frames
+
       AssetManager::Destroy();
       SDL_FreeSurface(screen);
       TTF_Quit();
@@ -29,23 +29,73 @@
 #define CAMERA_H
 
 #include "itype.h"
+#include "Mutex.h"
 #include "SDL.h"
+#include <stdio.h>    /* for FILE */
+#include <pthread.h>
 
 namespace MFM
 {
 
+  /**
+   * The header preceding each frame in a frame dump file written by
+   * Camera::DumpSurface.  The header is followed by m_width *
+   * m_height u32 pixels, rows top to bottom, in host byte order.
+   * All frames of one recording are the same size unless the window
+   * is resized during it.
+   */
+  struct CameraFrameHeader
+  {
+    enum { NAME_LENGTH = 116 };
+
+    char m_magic[4];          ///< CAMERA_FRAME_MAGIC
+    u32 m_width;
+    u32 m_height;
+    char m_name[NAME_LENGTH]; ///< Null-terminated PNG file name, no directory
+  };
+
   /**
    * A class which represents a layer that a SDL_Surface* must go
    * through in order to be drawn to the screen. This allows a user to
    * intercept the image as it is being drawn in order to capture the
    * images in the form of a PNG sequence to make primitive videos.
    *
+   * Capturing only copies the surface into one of a small pool of
+   * preallocated frame buffers; a pool of encoder threads then
+   * writes the frames out, so the caller waits only if every buffer
+   * is still queued for encoding.  Frames are written either as
+   * individual PNGs (DrawSurface) or, faster, uncompressed into a
+   * single frame dump file (DumpSurface) for later conversion to
+   * PNGs by the mfmframes program.
+   *
    * At the moment, this only supports writing 10 million frames. This
    * is a whole lot, but keep this in mind if wanting to make a really
    * long video.
    */
   class Camera
   {
+  public:
+
+    enum {
+      /** Frame buffers, and so the most frames queued for encoding */
+      FRAME_BUFFERS = 8,
+
+      /** Most encoder threads allowed */
+      MAX_ENCODER_THREADS = 8,
+
+      DEFAULT_ENCODER_THREADS = 2,
+
+      PATH_MAX_LENGTH = 256
+    };
+
+    /**
+     * Writes \c width * \c height pixels, as captured from a 32 bit
+     * SDL_Surface, to a PNG file at \c filename .
+     *
+     * @returns 0 on success, else nonzero.
+     */
+    static u32 SavePNG(const char* filename, const u32 * pixels, u32 width, u32 height);
+
   private:
 
     static const u32 VIDEO_NAME_MAX_LENGTH = 64;
@@ -58,20 +108,143 @@ namespace MFM
 
     u32 GetPNGColorType(SDL_Surface* sfc);
 
-    u32 SavePNG(const char* filename, SDL_Surface* sfc) const;
+    struct Frame
+    {
+      u32 * m_pixels;
+      u32 m_capacity;    // In pixels
+      u32 m_width;
+      u32 m_height;
+      bool m_dump;       // Write to the frame dump rather than a PNG
+      char m_path[PATH_MAX_LENGTH];
+    };
+
+    Frame m_frames[FRAME_BUFFERS];
+
+    Mutex m_lock;            // Guards everything below, except m_dumpFile
+
+    u32 m_idle[FRAME_BUFFERS];     // Stack of free frame indices
+    u32 m_idleCount;
+
+    u32 m_queue[FRAME_BUFFERS];    // Ring of frame indices to encode
+    u32 m_queueHead;
+    u32 m_queueCount;
+
+    bool m_stopping;
+
+    pthread_t m_threads[MAX_ENCODER_THREADS];
+    u32 m_threadCount;
+    u32 m_desiredThreads;
+
+    Mutex m_dumpLock;        // Guards m_dumpFile contents
+    FILE * m_dumpFile;
+
+    struct IdleFramePredicate : public Mutex::Predicate
+    {
+      Camera & m_camera;
+      IdleFramePredicate(Camera & camera) :
+        Mutex::Predicate(camera.m_lock), m_camera(camera) { }
+      virtual bool EvaluatePrecondition() { return true; }
+      virtual bool EvaluatePredicate() { return m_camera.m_idleCount > 0; }
+    } m_idleFrame;
+
+    struct QueuedFramePredicate : public Mutex::Predicate
+    {
+      Camera & m_camera;
+      QueuedFramePredicate(Camera & camera) :
+        Mutex::Predicate(camera.m_lock), m_camera(camera) { }
+      virtual bool EvaluatePrecondition() { return true; }
+      virtual bool EvaluatePredicate()
+      {
+        return m_camera.m_queueCount > 0 || m_camera.m_stopping;
+      }
+    } m_queuedFrame;
+
+    struct AllIdlePredicate : public Mutex::Predicate
+    {
+      Camera & m_camera;
+      AllIdlePredicate(Camera & camera) :
+        Mutex::Predicate(camera.m_lock), m_camera(camera) { }
+      virtual bool EvaluatePrecondition() { return true; }
+      virtual bool EvaluatePredicate()
+      {
+        return m_camera.m_idleCount == FRAME_BUFFERS;
+      }
+    } m_allIdle;
+
+    bool CaptureSurface(SDL_Surface* sfc, const char * path, bool dump);
+
+    void StartEncoders();
+
+    void StopEncoders();
+
+    static void * EncoderRunner(void * arg);
+
+    void Encode(Frame & frame);
+
+    Camera(const Camera &) ; // Declare away
+    Camera & operator=(const Camera &) ; // Declare away
 
   public:
 
     Camera();
 
+    ~Camera();
+
     void ToggleRecord();
 
     bool IsRecording();
 
     void SetRecording(bool recording);
 
-    bool DrawSurface(SDL_Surface* sfc, const char * pngPath) const;
+    /**
+     * Sets the number of encoder threads to use from the next
+     * capture on.  FAILs with ILLEGAL_ARGUMENT unless \c threads is
+     * from 1 to MAX_ENCODER_THREADS.
+     */
+    void SetEncoderThreads(u32 threads);
+
+    /**
+     * Queues a copy of \c sfc , which must be 32 bits per pixel, to
+     * be written as a PNG to \c pngPath .
+     *
+     * @returns \c true if the frame was queued.
+     */
+    bool DrawSurface(SDL_Surface* sfc, const char * pngPath);
+
+    /**
+     * Opens \c path , appending, as the frame dump file for
+     * DumpSurface.  Any previous frame dump is flushed and closed.
+     *
+     * @returns \c true if the file was opened.
+     */
+    bool OpenFrameDump(const char * path);
+
+    bool IsFrameDumpOpen() const
+    {
+      return m_dumpFile != 0;
+    }
+
+    /**
+     * Queues a copy of \c sfc , which must be 32 bits per pixel, to
+     * be appended to the frame dump file.  Frames from different
+     * encoder threads may land in the dump out of order; the name
+     * (without directory) of \c pngPath is saved with each one.
+     *
+     * @returns \c true if the frame was queued.
+     */
+    bool DumpSurface(SDL_Surface* sfc, const char * pngPath);
+
+    /**
+     * Waits until every queued frame has been written, and then
+     * stops the encoder threads and closes any frame dump.
+     */
+    void Flush();
   };
+
+  /**
+   * The four bytes beginning every CameraFrameHeader
+   */
+  extern const char CAMERA_FRAME_MAGIC[4];
 }
 
 #endif /* CAMERA_H */
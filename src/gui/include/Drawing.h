@@ -306,6 +306,12 @@ namespace MFM {
      */
     void BlitImage(SDL_Surface* image, UPoint loc, UPoint maxSize) const;
 
+    /**
+     * Draw all of a specified image with its top left at \c loc ,
+     * which may be partly outside the window.
+     */
+    void BlitImage(SDL_Surface* image, const SPoint & loc) const;
+
     /**
      * Draw a specified Asset (corresponding to an SDL_Surface*) to the screen.
      */
@@ -314,6 +320,19 @@ namespace MFM {
 
     static void Convert(const Rect & rect, SDL_Rect & toFill) ;
 
+    /**
+     * Get direct access to the pixels of the current drawing window,
+     * for renderers that set so many individual pixels that per-call
+     * FillRect overhead dominates.  On success, window pixel (x,y) is
+     * at the returned pointer[y * pitch + x], for x < size.GetX() and
+     * y < size.GetY(), which are already clipped to the surface.
+     * Pixels take the same u32 colors as FillRect.
+     *
+     * @returns The address of window pixel (0,0), or null if direct
+     *          access is not possible, in which case use FillRect.
+     */
+    u32 * GetWindowPixels(u32 & pitch, UPoint & size) const ;
+
   private:
     // Let's try to deprecate SetPixel.  Bounds-checking every pixel is
     // slow, and SDL_FillRect is (like SSE) fast and also clips against
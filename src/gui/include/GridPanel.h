@@ -63,8 +63,6 @@ namespace MFM
       return m_mainGrid->GetHeightSites();
     }
     enum { R = EC::EVENT_WINDOW_RADIUS};
-    enum { TILE_SIDE_CACHE_SITES = GC::TILE_SIDE};
-    enum { TILE_SIDE_LIVE_SITES = TILE_SIDE_CACHE_SITES - 2*R};
     enum { MAX_BUCKET_FILL_DEPTH = 10000 };
 
     typedef Grid<GC> OurGrid;
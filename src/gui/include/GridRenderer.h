@@ -75,6 +75,14 @@ namespace MFM
 
     EventWindowRenderMode m_currentEWRenderMode;
 
+    /**
+     * One cached drawing per Tile of the last Grid rendered, indexed
+     * by y * width + x.
+     */
+    TileRenderer::TileBitmap * m_tileBitmaps;
+
+    u32 m_tileBitmapCount;
+
    public:
 
     GridRenderer(TileRenderer* tr);
@@ -115,6 +123,11 @@ namespace MFM
       m_tileRenderer.ToggleDrawAtomsAsSquares();
     }
 
+    void SetRenderFromSnapshots(bool fromSnapshots)
+    {
+      m_tileRenderer.SetRenderFromSnapshots(fromSnapshots);
+    }
+
     bool* GetGridEnabledPointer()
     {
       return m_tileRenderer.GetGridEnabledPointer();
@@ -9,7 +9,7 @@ namespace MFM
     SPoint current;
     SPoint eventLoc;
     const u32 tileSize = m_tileRenderer.GetAtomSize() *
-      (GC::TILE_SIDE -
+      (grid.GetTileSide() -
        2 * GC::EVENT_CONFIG::EVENT_WINDOW_RADIUS);
     const u32 atomSize = m_tileRenderer.GetAtomSize();
     SPoint atomTile(-1, -1);
@@ -27,6 +27,14 @@ namespace MFM
                     m_cloneOrigin.GetY() / (tileSize / atomSize));
     }
 
+    const u32 tileCount = grid.GetWidth() * grid.GetHeight();
+    if(tileCount != m_tileBitmapCount)
+    {
+      delete [] m_tileBitmaps;
+      m_tileBitmaps = new TileRenderer::TileBitmap[tileCount];
+      m_tileBitmapCount = tileCount;
+    }
+
     for(u32 x = 0; x < grid.GetWidth(); x++)
     {
       current.SetX(x);
@@ -59,7 +67,8 @@ namespace MFM
                                   current.GetX() == (s32)m_selectedTile.GetX() &&
                                   current.GetY() == (s32)m_selectedTile.GetY(),
                                   selectedAtomPtr,
-                                  cloneAtomPtr);
+                                  cloneAtomPtr,
+                                  &m_tileBitmaps[y * grid.GetWidth() + x]);
       }
     }
 
@@ -116,7 +125,7 @@ namespace MFM
       u32 atomSize = m_tileRenderer.GetAtomSize();
 
       u32 tileSize = atomSize *
-        (GC::TILE_SIDE -
+        (grid.GetTileSide() -
          2 * GC::EVENT_CONFIG::EVENT_WINDOW_RADIUS);
 
       m_selectedAtom.Set(-1, -1);
@@ -156,7 +165,7 @@ namespace MFM
     cp.SetY(cp.GetY() - offset.GetY());
 
     u32 tileSize = m_tileRenderer.GetAtomSize() *
-      (GC::TILE_SIDE + 1);
+      (grid.GetTileSide() + 1);
 
     if(!m_renderTilesSeparated)
     {
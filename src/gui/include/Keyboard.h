@@ -61,6 +61,8 @@ namespace MFM {
 
     bool IsUp(u32 key) const;
 
+    bool AnyDown() const;
+
     bool SemiAuto(u32 key);
 
     void Flip();
@@ -112,6 +112,11 @@ namespace MFM {
         m_grid = grid;
       }
 
+      const Element<EC> * GetElement() const
+      {
+        return m_element;
+      }
+
       virtual const char * GetLabel() const
       {
         if (m_element)
@@ -154,6 +159,13 @@ namespace MFM {
       u32 m_outOfSlots;
       bool m_resetOnRead;
 
+      /**
+       * The sum as of the last end of epoch, when resetting on read.
+       * The tiles' slots are never reset by us, since only their own
+       * threads may write them.
+       */
+      mutable u64 m_sumAtReset;
+
      public:
       ElementDataSlotSum() :
         m_grid(0),
@@ -161,7 +173,8 @@ namespace MFM {
         m_elementType(0),
         m_slot(0),
         m_outOfSlots(0),
-        m_resetOnRead(false)
+        m_resetOnRead(false),
+        m_sumAtReset(0)
       { }
 
       void Set(Grid<GC> & grid, const char * label, u32 elementType,
@@ -173,6 +186,7 @@ namespace MFM {
         m_slot = slot;
         m_outOfSlots = outOfSlots;
         m_resetOnRead = resetOnRead;
+        m_sumAtReset = 0;
       }
 
       virtual const char * GetLabel() const
@@ -199,25 +213,22 @@ namespace MFM {
           return -1;
         }
 
-        u64 sum = 0;
-        for (typename Grid<GC>::iterator_type i = m_grid->begin(); i != m_grid->end(); ++i)
+        u64 sum = m_grid->GetTotalElementData(m_elementType, m_slot, m_outOfSlots);
+        if (!m_resetOnRead)
         {
-          //XXX DEIMPLEMENTED          ElementTable<EC> & et = i->GetElementTable();
-          //XXX DEIMPLEMENTED          u64 * eds = et.GetElementDataSlotsFromType(m_elementType,m_outOfSlots);
-          u64 * eds = 0;
-
-          if (!eds)
-          {
-            continue;
-          }
-          sum += eds[m_slot];
-          if (endOfEpoch && m_resetOnRead)
-          {
-            eds[m_slot] = 0;
-          }
+          return (double) sum;
         }
 
-        return (double) sum;
+        if (sum < m_sumAtReset)
+        {
+          m_sumAtReset = 0;  // The grid was reinitted
+        }
+        u64 sinceReset = sum - m_sumAtReset;
+        if (endOfEpoch)
+        {
+          m_sumAtReset = sum;
+        }
+        return (double) sinceReset;
       }
     };
 
@@ -226,6 +237,7 @@ namespace MFM {
     SPoint m_drawPoint;
 
     static const u32 MAX_TYPES = 32;
+    static const u32 MAX_PROFILE_LINES = 8;
     const DataReporter *(m_reporters[MAX_TYPES]);
     u32 m_reportersInUse;
 
@@ -343,6 +355,14 @@ namespace MFM {
 
     void RenderGridStatistics(Drawing & drawing, Grid<GC>& grid, double aeps, double aer, u32 AEPSperFrame, double overhead, bool endOfEpoch, u32 aepsInCurrentEpoch);
 
+    /**
+     * While the grid is profiling element behaviors, lists the
+     * displayed elements costing the most behavior cycles, with
+     * their percentage of all such cycles and cycles per call.
+     * Returns the y coordinate below the last line drawn.
+     */
+    u32 RenderElementProfiles(Drawing & drawing, Grid<GC>& grid, u32 baseY);
+
     void WriteRegisteredCounts(ByteSink & fp, bool writeHeader, Grid<GC>& grid, double aeps, double aer, u32 AEPSperFrame, double overhead, bool doResets);
   };
 } /* namespace MFM */
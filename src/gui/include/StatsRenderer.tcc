@@ -167,6 +167,72 @@ namespace MFM {
         baseY += ROW_HEIGHT;
       }
     }
+
+    if (grid.IsElementProfiling())
+    {
+      baseY = RenderElementProfiles(drawing, grid, baseY);
+    }
+  }
+
+  template <class GC>
+  u32 StatsRenderer<GC>::RenderElementProfiles(Drawing & drawing, Grid<GC>& grid, u32 baseY)
+  {
+    const u32 ROW_HEIGHT = LINE_HEIGHT_PIXELS;
+    const u32 STR_BUFFER_SIZE = 32;
+    char strBuffer[STR_BUFFER_SIZE];
+
+    ElementProfile profiles[MAX_TYPES];
+    bool shown[MAX_TYPES];
+    u64 totalCycles = 0;
+    for (u32 i = 0; i < m_displayElementsInUse; ++i)
+    {
+      grid.GetTotalElementProfile(m_displayElements[i].GetElement()->GetType(), profiles[i]);
+      totalCycles += profiles[i].m_cycles;
+      shown[i] = false;
+    }
+
+    if (totalCycles == 0)
+    {
+      return baseY;
+    }
+
+    baseY += ROW_HEIGHT / 2;
+    drawing.SetFont(AssetManager::Get(FONT_ASSET_ELEMENT));
+    drawing.SetForeground(Drawing::GREY80);
+    drawing.BlitText("  cyc% c/call", Point<u32>(m_drawPoint.GetX(), baseY),
+                     Point<u32>(m_dimensions.GetX(), ROW_HEIGHT));
+    baseY += ROW_HEIGHT;
+
+    drawing.SetForeground(Drawing::WHITE);
+    for (u32 line = 0; line < MAX_PROFILE_LINES; ++line)
+    {
+      s32 most = -1;
+      for (u32 i = 0; i < m_displayElementsInUse; ++i)
+      {
+        if (!shown[i] && profiles[i].m_calls > 0 &&
+            (most < 0 || profiles[i].m_cycles > profiles[most].m_cycles))
+        {
+          most = i;
+        }
+      }
+      if (most < 0)
+      {
+        break;
+      }
+      shown[most] = true;
+
+      const ElementProfile & p = profiles[most];
+      snprintf(strBuffer, STR_BUFFER_SIZE, "%7.1f ", 100.0 * p.m_cycles / totalCycles);
+      OString64 output;
+      output.Print(strBuffer);
+      output.PrintAbbreviatedNumber(p.m_cycles / p.m_calls);
+      output.Printf(" %s", m_displayElements[most].GetLabel());
+
+      drawing.BlitText(output.GetZString(), Point<u32>(m_drawPoint.GetX(), baseY),
+                       Point<u32>(m_dimensions.GetX(), ROW_HEIGHT));
+      baseY += ROW_HEIGHT;
+    }
+    return baseY;
   }
 
   template <class GC>
@@ -39,6 +39,38 @@ namespace MFM
 {
   class TileRenderer
   {
+   public:
+
+    /**
+     * A cached drawing of one Tile's atoms.  RenderTile redraws only
+     * the change blocks of the Tile that have changed since it was
+     * last drawn, and then blits the whole thing.  Owned by the
+     * caller of RenderTile, one per Tile.
+     */
+    class TileBitmap
+    {
+    public:
+      TileBitmap() ;
+
+      ~TileBitmap() ;
+
+      /**
+       * Frees the cached drawing, if any.
+       */
+      void Release() ;
+
+    private:
+      friend class TileRenderer;
+
+      SDL_Surface * m_surface;
+      bool m_valid;        // m_surface holds a complete drawing
+      u32 m_generation;    // Tile change generation drawn
+      u32 m_settings;      // From GetBitmapSettings, when drawn
+
+      TileBitmap(const TileBitmap &) ; // Declare away
+      TileBitmap & operator=(const TileBitmap &) ; // Declare away
+    };
+
    private:
     bool m_drawGrid;
     enum DrawRegionType { FULL, NO, EDGE, AGE, AGE_ONLY, MAX} m_drawMemRegions;
@@ -47,6 +79,8 @@ namespace MFM
 
     bool m_renderSquares;
 
+    bool m_renderFromSnapshots;
+
     u32 m_gridColor;
 
     u32 m_cacheColor;
@@ -64,9 +98,42 @@ namespace MFM
 
     enum
     {
-      MAX_HEATMAP_SELECTIONS = 5
+      MAX_HEATMAP_SELECTIONS = 5,
+
+      /** Largest atom size drawn by writing pixels directly */
+      MAX_LOD_ATOM_SIZE = 2,
+
+      LOD_COLOR_CACHE_SIZE = 256,
+
+      /** Largest drawing, in pixels per side, kept in a TileBitmap */
+      MAX_TILE_BITMAP_SIDE = 512
     };
 
+    /**
+     * The alpha of every atom pixel in a TileBitmap, whatever the
+     * alpha of the atom's color.  Pixels of empty sites have alpha
+     * zero, so they leave the background alone when blitted.
+     */
+    static const u32 TILE_BITMAP_OPAQUE = 0xff000000;
+
+    /**
+     * Direct-mapped cache of element type to color for the current
+     * tile, used by RenderAtomsLOD.  An unused entry has type
+     * LOD_NO_TYPE, which is not a legal atom type.
+     */
+    u32 m_lodTypes[LOD_COLOR_CACHE_SIZE];
+    u32 m_lodColors[LOD_COLOR_CACHE_SIZE];
+
+    static const u32 LOD_NO_TYPE = 0xffffffff;
+
+    /**
+     * Narrows the range of sites [start,end) in one dimension to those
+     * whose drawing would begin on screen, given the screen position
+     * \c base of site 0 and the screen extent \c limit .
+     */
+    void GetVisibleSites(s32 base, u32 limit, u32 start, u32 end,
+                         u32 & visibleStart, u32 & visibleEnd) const ;
+
     template <class EC>
     void RenderMemRegions(Drawing & drawing, SPoint& pt,
                           bool renderCache, bool selected, bool lowlight,
@@ -91,17 +158,41 @@ namespace MFM
 
     template <class EC>
     void RenderAtoms(Drawing & drawing, SPoint& pt, Tile<EC>& tile,
+                     const typename EC::SITE * snapshot,
                      bool renderCache, bool lowlight);
 
+    template <class EC>
+    bool RenderAtomsCached(Drawing & drawing, SPoint& pt, Tile<EC>& tile,
+                           const typename EC::SITE * snapshot,
+                           bool renderCache, bool lowlight, TileBitmap & bitmap);
+
+    /**
+     * Packs every setting that affects how atoms are drawn into a
+     * TileBitmap, so a change in any of them forces a full redraw.
+     */
+    template <class EC>
+    u32 GetBitmapSettings(bool renderCache, bool lowlight) const ;
+
+    template <class EC>
+    void RenderAtomsLOD(u32 * pixels, u32 pitch, const UPoint & size,
+                        Tile<EC>& tile, const typename EC::SITE * snapshot,
+                        s32 baseX, s32 baseY,
+                        u32 xstart, u32 xend, u32 ystart, u32 yend,
+                        bool lowlight);
+
+    template <class EC>
+    u32 GetLODColor(Tile<EC>& tile, u32 type, bool lowlight);
+
     template <class EC>
     void RenderAtom(Drawing & drawing, const SPoint& atomLoc, const UPoint& rendPt,
-                    Tile<EC>& tile, bool lowlight);
+                    Tile<EC>& tile, const typename EC::SITE * snapshot,
+                    bool lowlight);
 
     template <class EC>
     void RenderBadAtom(Drawing& drawing, const UPoint& rendPt);
 
     template <class EC>
-    u32 GetSiteColor(Tile<EC>& tile, const Site<typename EC::ATOM_CONFIG> & site, u32 selector = 0);
+    u32 GetSiteColor(Tile<EC>& tile, const typename EC::SITE & site, u32 selector = 0);
 
 #if 0
     template <class EC>
@@ -115,9 +206,15 @@ namespace MFM
 
     TileRenderer();
 
+    /**
+     * Draws Tile \c t at Tile position \c loc in its Grid.  If \c
+     * bitmap is supplied, it is used to cache \c t 's atoms from one
+     * call to the next, for when most atoms are unchanged.
+     */
     template <class EC>
     void RenderTile(Drawing & drawing, Tile<EC>& t, SPoint& loc, bool renderWindow,
-                    bool renderCache, bool selected, SPoint* selectedAtom, SPoint* cloneOrigin);
+                    bool renderCache, bool selected, SPoint* selectedAtom, SPoint* cloneOrigin,
+                    TileBitmap * bitmap = 0);
 
     void SetDimensions(Point<u32> dimensions)
     {
@@ -134,6 +231,18 @@ namespace MFM
       m_renderSquares = !m_renderSquares;
     }
 
+    /**
+     * Sets whether to draw atoms from each Tile's most recently
+     * published snapshot, rather than from the Tile itself.  Needed
+     * whenever the Tiles may be running while being rendered.
+     *
+     * @see Tile::AcquireSnapshot
+     */
+    void SetRenderFromSnapshots(bool fromSnapshots)
+    {
+      m_renderFromSnapshots = fromSnapshots;
+    }
+
     bool* GetDrawDataHeatPointer()
     {
       return &m_drawDataHeat;
@@ -6,14 +6,15 @@ namespace MFM
 {
 
   template <class EC>
-  u32 TileRenderer::GetSiteColor(Tile<EC>& tile, const Site<typename EC::ATOM_CONFIG> & site,
+  u32 TileRenderer::GetSiteColor(Tile<EC>& tile, const typename EC::SITE & site,
                                  u32 selector)
   {
     const typename EC::ATOM_CONFIG::ATOM_TYPE & atom = site.GetAtom();
     const Element<EC> * elt = tile.GetElementTable().Lookup(atom.GetType());
     if (elt)
     {
-      return elt->LocalPhysicsColor(site,selector);
+      Site<typename EC::ATOM_CONFIG> scratch;
+      return elt->LocalPhysicsColor(AsFullSite(site, scratch), selector);
     }
     return 0xffffffff;
   }
@@ -29,6 +30,7 @@ namespace MFM
 
   template <class EC>
   void TileRenderer::RenderAtoms(Drawing & drawing, SPoint& pt, Tile<EC>& tile,
+                                 const typename EC::SITE * snapshot,
                                  bool renderCache, bool lowlight)
   {
     u32 astart = renderCache ? 0 : EC::EVENT_WINDOW_RADIUS;
@@ -36,56 +38,272 @@ namespace MFM
 
     u32 cacheOffset = renderCache ? 0 : -EC::EVENT_WINDOW_RADIUS * m_atomDrawSize;
 
+    // Visit only the sites that land on screen
+    const s32 baseX = pt.GetX() + m_windowTL.GetX() + (s32) cacheOffset;
+    const s32 baseY = pt.GetY() + m_windowTL.GetY() + (s32) cacheOffset;
+
+    u32 xstart, xend, ystart, yend;
+    GetVisibleSites(baseX, m_dimensions.GetX(), astart, aend, xstart, xend);
+    GetVisibleSites(baseY, m_dimensions.GetY(), astart, aend, ystart, yend);
+    if (xstart == xend || ystart == yend)
+    {
+      return;
+    }
+
+    // Zoomed way out, skip the per-atom colors and fills if we can
+    if (m_atomDrawSize <= MAX_LOD_ATOM_SIZE && m_heatmapSelector == 0 &&
+        m_drawMemRegions != AGE && m_drawMemRegions != AGE_ONLY)
+    {
+      u32 pitch;
+      UPoint size;
+      u32 * pixels = drawing.GetWindowPixels(pitch, size);
+      if (pixels)
+      {
+        RenderAtomsLOD(pixels, pitch, size, tile, snapshot,
+                       baseX, baseY, xstart, xend, ystart, yend, lowlight);
+        return;
+      }
+    }
+
     SPoint atomLoc;
 
     Point<u32> rendPt;
 
-    for(u32 x = astart; x < aend; x++)
+    for(u32 x = xstart; x < xend; x++)
     {
       rendPt.SetX(pt.GetX() + m_atomDrawSize * x +
                   m_windowTL.GetX() + cacheOffset);
-      if(rendPt.GetX() + m_atomDrawSize < m_dimensions.GetX())
+      atomLoc.SetX(x);
+      for(u32 y = ystart; y < yend; y++)
+      {
+        rendPt.SetY(pt.GetY() + m_atomDrawSize * y +
+                    m_windowTL.GetY() + cacheOffset);
+        atomLoc.SetY(y);
+        if ((m_drawMemRegions == AGE || m_drawMemRegions == AGE_ONLY) &&
+            tile.IsOwnedSite(atomLoc))
+        {
+          // Draw background 'write heat' map
+          u32 writeAge = tile.GetUncachedWriteAge32(atomLoc -
+                                                    SPoint(EC::EVENT_WINDOW_RADIUS,
+                                                           EC::EVENT_WINDOW_RADIUS));
+          u32 colorIndex = 0;
+          const u32 MAX_IDX = 10000;       // Potential (interpolated) colors
+          const u32 AGE_PER_AEPS = tile.GetSites();
+          const double MAX_EXPT = 4.0;     // 10**4.0 == 10kAEPS for fully black
+          const double LOG_SCALER = MAX_IDX/MAX_EXPT;
+          double writeAgeAEPS = 1.0 * writeAge / AGE_PER_AEPS + 1;
+
+          colorIndex = MIN(MAX_IDX, (u32) (LOG_SCALER*log10(writeAgeAEPS)));
+          u32 color =
+            ColorMap_CubeHelixRev::THE_INSTANCE.
+            GetInterpolatedColor(colorIndex,0,MAX_IDX,0xffff0000);
+
+          drawing.SetForeground(color);
+          drawing.FillRect(rendPt.GetX(),
+                           rendPt.GetY(),
+                           m_atomDrawSize,
+                           m_atomDrawSize);
+
+          if (m_drawMemRegions == AGE_ONLY)
+          {
+            continue;
+          }
+        }
+
+        RenderAtom(drawing, atomLoc, rendPt, tile, snapshot, lowlight);
+      }
+    }
+  }
+
+  template <class EC>
+  u32 TileRenderer::GetBitmapSettings(bool renderCache, bool lowlight) const
+  {
+    return (m_atomDrawSize & 0x1ff) |
+      (renderCache ? 1 << 9 : 0) |
+      (lowlight ? 1 << 10 : 0) |
+      (m_renderSquares ? 1 << 11 : 0) |
+      ((m_heatmapSelector & 0x7) << 12) |
+      (Element<EC>::GetPhysicsColorChanges() << 18);
+  }
+
+  template <class EC>
+  bool TileRenderer::RenderAtomsCached(Drawing & drawing, SPoint& pt, Tile<EC>& tile,
+                                       const typename EC::SITE * snapshot,
+                                       bool renderCache, bool lowlight, TileBitmap & bitmap)
+  {
+    const u32 TILE_SIDE = tile.TILE_SIDE;
+    const u32 first = renderCache ? 0 : EC::EVENT_WINDOW_RADIUS;
+    const u32 end   = renderCache ? TILE_SIDE : TILE_SIDE - EC::EVENT_WINDOW_RADIUS;
+    const u32 side = (end - first) * m_atomDrawSize;
+
+    // Write ages change without the atoms changing, so never cache
+    // them; and zoomed way out, RenderAtoms' culled direct pixel
+    // writes beat redrawing the bitmap's changed blocks
+    if (m_drawMemRegions == AGE || m_drawMemRegions == AGE_ONLY ||
+        (m_atomDrawSize <= MAX_LOD_ATOM_SIZE && m_heatmapSelector == 0) ||
+        side > MAX_TILE_BITMAP_SIDE)
+    {
+      bitmap.Release();
+      return false;
+    }
+
+    if (bitmap.m_surface &&
+        ((u32) bitmap.m_surface->w != side || (u32) bitmap.m_surface->h != side))
+    {
+      bitmap.Release();
+    }
+
+    if (!bitmap.m_surface)
+    {
+      bitmap.m_surface =
+        SDL_CreateRGBSurface(SDL_SWSURFACE | SDL_SRCALPHA, side, side, 32,
+                             0x00ff0000, 0x0000ff00, 0x000000ff, TILE_BITMAP_OPAQUE);
+      if (!bitmap.m_surface)
       {
-        atomLoc.SetX(x);
-        for(u32 y = astart; y < aend; y++)
+        return false;
+      }
+      SDL_SetAlpha(bitmap.m_surface, SDL_SRCALPHA, SDL_ALPHA_OPAQUE);
+      bitmap.m_valid = false;
+    }
+
+    const u32 settings = GetBitmapSettings<EC>(renderCache, lowlight);
+    const u32 generation = snapshot ? tile.GetSnapshotGeneration() : tile.GetChangeGeneration();
+    const bool redrawAll = !bitmap.m_valid || bitmap.m_settings != settings;
+
+    if (redrawAll || generation != bitmap.m_generation)
+    {
+      Drawing bitmapDrawing(bitmap.m_surface);
+      const u32 BLOCK_SIDE = Tile<EC>::CHANGE_BLOCK_SIDE;
+      const u32 blocks = tile.GetChangeBlocksPerSide();
+
+      Point<u32> rendPt;
+      SPoint atomLoc;
+      for (u32 by = 0; by < blocks; ++by)
+      {
+        const u32 ystart = MFM::MAX(first, by * BLOCK_SIDE);
+        const u32 yend = MIN(end, (by + 1) * BLOCK_SIDE);
+        for (u32 bx = 0; bx < blocks; ++bx)
         {
-          rendPt.SetY(pt.GetY() + m_atomDrawSize * y +
-                      m_windowTL.GetY() + cacheOffset);
-          if(rendPt.GetY() + m_atomDrawSize < m_dimensions.GetY())
+          const u32 xstart = MFM::MAX(first, bx * BLOCK_SIDE);
+          const u32 xend = MIN(end, (bx + 1) * BLOCK_SIDE);
+          if (xstart >= xend || ystart >= yend)
           {
+            continue;
+          }
+
+          // Blocks stamped after the last drawing have changed since
+          const u32 blockGeneration = snapshot ?
+            tile.GetSnapshotBlockChangeGeneration(bx, by) :
+            tile.GetBlockChangeGeneration(bx, by);
+          if (!redrawAll && (s32) (blockGeneration - bitmap.m_generation) <= 0)
+          {
+            continue;
+          }
+
+          bitmapDrawing.FillRect((xstart - first) * m_atomDrawSize,
+                                 (ystart - first) * m_atomDrawSize,
+                                 (xend - xstart) * m_atomDrawSize,
+                                 (yend - ystart) * m_atomDrawSize,
+                                 0);  // Fully transparent
+
+          for (u32 y = ystart; y < yend; ++y)
+          {
+            rendPt.SetY((y - first) * m_atomDrawSize);
             atomLoc.SetY(y);
-            if ((m_drawMemRegions == AGE || m_drawMemRegions == AGE_ONLY) &&
-                tile.IsOwnedSite(atomLoc))
+            for (u32 x = xstart; x < xend; ++x)
             {
-              // Draw background 'write heat' map
-              u32 writeAge = tile.GetUncachedWriteAge32(atomLoc -
-                                                        SPoint(EC::EVENT_WINDOW_RADIUS,
-                                                               EC::EVENT_WINDOW_RADIUS));
-              u32 colorIndex = 0;
-              const u32 MAX_IDX = 10000;       // Potential (interpolated) colors
-              const u32 AGE_PER_AEPS = tile.GetSites();
-              const double MAX_EXPT = 4.0;     // 10**4.0 == 10kAEPS for fully black
-              const double LOG_SCALER = MAX_IDX/MAX_EXPT;
-              double writeAgeAEPS = 1.0 * writeAge / AGE_PER_AEPS + 1;
-
-              colorIndex = MIN(MAX_IDX, (u32) (LOG_SCALER*log10(writeAgeAEPS)));
-              u32 color =
-                ColorMap_CubeHelixRev::THE_INSTANCE.
-                GetInterpolatedColor(colorIndex,0,MAX_IDX,0xffff0000);
-
-              drawing.SetForeground(color);
-              drawing.FillRect(rendPt.GetX(),
-                               rendPt.GetY(),
-                               m_atomDrawSize,
-                               m_atomDrawSize);
-
-              if (m_drawMemRegions == AGE_ONLY)
-              {
-                continue;
-              }
+              rendPt.SetX((x - first) * m_atomDrawSize);
+              atomLoc.SetX(x);
+              RenderAtom(bitmapDrawing, atomLoc, rendPt, tile, snapshot, lowlight);
             }
+          }
+        }
+      }
 
-            RenderAtom(drawing, atomLoc, rendPt, tile, lowlight);
+      bitmap.m_valid = true;
+      bitmap.m_settings = settings;
+      bitmap.m_generation = generation;
+    }
+
+    drawing.BlitImage(bitmap.m_surface,
+                      SPoint(pt.GetX() + m_windowTL.GetX(), pt.GetY() + m_windowTL.GetY()));
+    return true;
+  }
+
+  template <class EC>
+  u32 TileRenderer::GetLODColor(Tile<EC>& tile, u32 type, bool lowlight)
+  {
+    const u32 idx = type % LOD_COLOR_CACHE_SIZE;
+    if (m_lodTypes[idx] != type)
+    {
+      const Element<EC> * elt = tile.GetElementTable().Lookup(type);
+      u32 color = elt ? elt->PhysicsColor() : 0xffffffff;
+      if (lowlight)
+      {
+        color = Drawing::HalfColor(color);
+      }
+      m_lodTypes[idx] = type;
+      m_lodColors[idx] = color;
+    }
+    return m_lodColors[idx];
+  }
+
+  template <class EC>
+  void TileRenderer::RenderAtomsLOD(u32 * pixels, u32 pitch, const UPoint & size,
+                                    Tile<EC>& tile, const typename EC::SITE * snapshot,
+                                    s32 baseX, s32 baseY,
+                                    u32 xstart, u32 xend, u32 ystart, u32 yend,
+                                    bool lowlight)
+  {
+    typedef typename EC::ATOM_CONFIG::ATOM_TYPE T;
+    const u32 TILE_SIDE = tile.TILE_SIDE;
+    const s32 atomSize = (s32) m_atomDrawSize;
+    const s32 width = (s32) size.GetX();
+    const s32 height = (s32) size.GetY();
+
+    // Colors are per element type, not per atom, and this tile's
+    // table and lowlighting may differ from the last tile's
+    for (u32 i = 0; i < LOD_COLOR_CACHE_SIZE; ++i)
+    {
+      m_lodTypes[i] = LOD_NO_TYPE;
+    }
+
+    for (u32 y = ystart; y < yend; ++y)
+    {
+      const s32 py = baseY + atomSize * (s32) y;
+      for (u32 x = xstart; x < xend; ++x)
+      {
+        const typename EC::SITE & site = snapshot ?
+          snapshot[y * TILE_SIDE + x] :
+          tile.GetSite(SPoint(x, y));
+        const T & atom = site.GetAtom();
+
+        u32 color;
+        if (!atom.IsSane())
+        {
+          color = Drawing::YELLOW;
+        }
+        else
+        {
+          const u32 type = atom.GetType();
+          if (type == T::ATOM_EMPTY_TYPE)
+          {
+            continue;
+          }
+          color = GetLODColor(tile, type, lowlight);
+          if (!color)
+          {
+            continue;
+          }
+        }
+
+        const s32 px = baseX + atomSize * (s32) x;
+        for (s32 dy = MFM::MAX(0, -py); dy < atomSize && py + dy < height; ++dy)
+        {
+          u32 * row = pixels + (py + dy) * pitch;
+          for (s32 dx = MFM::MAX(0, -px); dx < atomSize && px + dx < width; ++dx)
+          {
+            row[px + dx] = color;
           }
         }
       }
@@ -116,10 +334,13 @@ namespace MFM
 
   template <class EC>
   void TileRenderer::RenderAtom(Drawing & drawing, const SPoint& atomLoc,
-                                const UPoint& rendPt,  Tile<EC>& tile, bool lowlight)
+                                const UPoint& rendPt,  Tile<EC>& tile,
+                                const typename EC::SITE * snapshot, bool lowlight)
   {
     typedef typename EC::ATOM_CONFIG::ATOM_TYPE T;
-    const Site<typename EC::ATOM_CONFIG> & site = tile.GetSite(atomLoc);
+    const typename EC::SITE & site = snapshot ?
+      snapshot[atomLoc.GetY() * tile.TILE_SIDE + atomLoc.GetX()] :
+      tile.GetSite(atomLoc);
     const T & atom = site.GetAtom();
     if(!atom.IsSane())
     {
@@ -134,47 +355,46 @@ namespace MFM
       color = Drawing::HalfColor(color);
     }
 
-    if(rendPt.GetX() + m_atomDrawSize < m_dimensions.GetX() &&
-       rendPt.GetY() + m_atomDrawSize < m_dimensions.GetY())
+    // Callers have already culled to the visible sites
+    if(color)
     {
-      if(color)
-      {
-        // Round up on radius.  Better to overlap than vanish
-        u32 radius = (m_atomDrawSize + 1) / 2;
+      color |= TILE_BITMAP_OPAQUE;  // Screens ignore alpha anyway
 
-        drawing.SetForeground(color);
-        if(m_renderSquares)
-        {
-          drawing.FillRect(rendPt.GetX(),
+      // Round up on radius.  Better to overlap than vanish
+      u32 radius = (m_atomDrawSize + 1) / 2;
+
+      drawing.SetForeground(color);
+      if(m_renderSquares)
+      {
+        drawing.FillRect(rendPt.GetX(),
+                         rendPt.GetY(),
+                         m_atomDrawSize,
+                         m_atomDrawSize);
+      }
+      else
+      {
+        drawing.FillCircle(rendPt.GetX(),
                            rendPt.GetY(),
                            m_atomDrawSize,
-                           m_atomDrawSize);
-        }
-        else
-        {
-          drawing.FillCircle(rendPt.GetX(),
-                             rendPt.GetY(),
-                             m_atomDrawSize,
-                             m_atomDrawSize,
-                             radius);
-        }
+                           m_atomDrawSize,
+                           radius);
+      }
 
-        if (m_atomDrawSize > 40)
+      if (m_atomDrawSize > 40)
+      {
+        const Element<EC> * elt = tile.GetElement(atom.GetType());
+        if (elt)
         {
-          const Element<EC> * elt = tile.GetElement(atom.GetType());
-          if (elt)
+          drawing.SetFont(AssetManager::Get(FONT_ASSET_ELEMENT));
+          const char * sym = elt->GetAtomicSymbol();
+          const SPoint size = drawing.GetTextSize(sym);
+          const UPoint box = UPoint(m_atomDrawSize, m_atomDrawSize);
+          if (size.GetX() > 0 && size.GetY() > 0)
           {
-            drawing.SetFont(AssetManager::Get(FONT_ASSET_ELEMENT));
-            const char * sym = elt->GetAtomicSymbol();
-            const SPoint size = drawing.GetTextSize(sym);
-            const UPoint box = UPoint(m_atomDrawSize, m_atomDrawSize);
-            if (size.GetX() > 0 && size.GetY() > 0)
-            {
-              const UPoint usize(size.GetX(), size.GetY());
-              drawing.SetBackground(Drawing::BLACK);
-              drawing.SetForeground(Drawing::WHITE);
-              drawing.BlitBackedTextCentered(sym, rendPt, box);
-            }
+            const UPoint usize(size.GetX(), size.GetY());
+            drawing.SetBackground(Drawing::BLACK);
+            drawing.SetForeground(Drawing::WHITE);
+            drawing.BlitBackedTextCentered(sym, rendPt, box);
           }
         }
       }
@@ -184,7 +404,7 @@ namespace MFM
   template <class EC>
   void TileRenderer::RenderTile(Drawing & drawing, Tile<EC>& t, SPoint& loc, bool renderWindow,
                                 bool renderCache, bool selected, SPoint* selectedAtom,
-                                SPoint* cloneOrigin)
+                                SPoint* cloneOrigin, TileBitmap * bitmap)
   {
     const u32 TILE_SIDE = t.TILE_SIDE;
 
@@ -206,8 +426,10 @@ namespace MFM
 
     realPt.Add(m_windowTL);
 
-    if(realPt.GetX() + tileHeight >= 0 &&
-       realPt.GetY() + tileHeight >= 0)
+    if(realPt.GetX() + (s32) tileHeight >= 0 &&
+       realPt.GetY() + (s32) tileHeight >= 0 &&
+       realPt.GetX() < (s32) m_dimensions.GetX() &&
+       realPt.GetY() < (s32) m_dimensions.GetY())
     {
       switch (m_drawMemRegions)
       {
@@ -229,9 +451,17 @@ namespace MFM
         RenderEventWindow(drawing, multPt, t, renderCache);
       }
 
-      RenderAtoms(drawing, multPt, t, renderCache, lowlight);
+      // Falls back to the tile itself until a snapshot is published
+      const typename EC::SITE * snapshot =
+        m_renderFromSnapshots ? t.AcquireSnapshot() : 0;
+
+      if(!bitmap ||
+         !RenderAtomsCached(drawing, multPt, t, snapshot, renderCache, lowlight, *bitmap))
+      {
+        RenderAtoms(drawing, multPt, t, snapshot, renderCache, lowlight);
+      }
 
-      if(m_drawGrid)
+      if(m_drawGrid && m_atomDrawSize > MAX_LOD_ATOM_SIZE)  // Else all grid
       {
         RenderGrid<EC>(drawing, &multPt, renderCache, TILE_SIDE);
       }
@@ -1,6 +1,8 @@
 #include "Camera.h"
+#include "Logger.h"
 
 #include <stdlib.h>    /* for malloc, free */
+#include <string.h>    /* for strrchr, strncpy, memcpy */
 #include <png.h>
 
 /* libpng is ghetto and needs these */
@@ -15,9 +17,36 @@ static void libpng_error(png_structp context, png_const_charp msg)
 
 namespace MFM
 {
-  Camera::Camera()
+  const char CAMERA_FRAME_MAGIC[4] = { 'M', 'F', 'M', 'F' };
+
+  Camera::Camera() :
+    m_idleCount(FRAME_BUFFERS),
+    m_queueHead(0),
+    m_queueCount(0),
+    m_stopping(false),
+    m_threadCount(0),
+    m_desiredThreads(DEFAULT_ENCODER_THREADS),
+    m_dumpFile(0),
+    m_idleFrame(*this),
+    m_queuedFrame(*this),
+    m_allIdle(*this)
   {
     m_recording = false;
+    for (u32 i = 0; i < FRAME_BUFFERS; ++i)
+    {
+      m_frames[i].m_pixels = 0;
+      m_frames[i].m_capacity = 0;
+      m_idle[i] = i;
+    }
+  }
+
+  Camera::~Camera()
+  {
+    Flush();
+    for (u32 i = 0; i < FRAME_BUFFERS; ++i)
+    {
+      delete [] m_frames[i].m_pixels;
+    }
   }
 
   void Camera::ToggleRecord()
@@ -39,13 +68,196 @@ namespace MFM
     }
   }
 
-  bool Camera::DrawSurface(SDL_Surface* sfc, const char * pngDirPath) const
+  void Camera::SetEncoderThreads(u32 threads)
+  {
+    MFM_API_ASSERT_ARG(threads >= 1 && threads <= MAX_ENCODER_THREADS);
+    m_desiredThreads = threads;
+  }
+
+  bool Camera::DrawSurface(SDL_Surface* sfc, const char * pngPath)
+  {
+    return CaptureSurface(sfc, pngPath, false);
+  }
+
+  bool Camera::DumpSurface(SDL_Surface* sfc, const char * pngPath)
+  {
+    if (!m_dumpFile)
+    {
+      return false;
+    }
+    return CaptureSurface(sfc, pngPath, true);
+  }
+
+  bool Camera::OpenFrameDump(const char * path)
+  {
+    Flush();
+    m_dumpFile = fopen(path, "ab");
+    if (!m_dumpFile)
+    {
+      LOG.Error("Can't open frame dump '%s'", path);
+      return false;
+    }
+    LOG.Message("Dumping frames to '%s'", path);
+    return true;
+  }
+
+  bool Camera::CaptureSurface(SDL_Surface* sfc, const char * path, bool dump)
+  {
+    if (!sfc || sfc->format->BytesPerPixel != 4 || strlen(path) >= PATH_MAX_LENGTH)
+    {
+      return false;
+    }
+
+    if (m_threadCount != m_desiredThreads)
+    {
+      StopEncoders();
+      StartEncoders();
+    }
+
+    // Wait, if need be, for the encoders to free up a frame buffer
+    u32 index;
+    {
+      Mutex::ScopeLock lock(m_lock);
+      m_idleFrame.WaitForCondition();
+      index = m_idle[--m_idleCount];
+    }
+
+    // We own the frame until it's queued
+    Frame & frame = m_frames[index];
+    const u32 width = sfc->w;
+    const u32 height = sfc->h;
+    if (frame.m_capacity < width * height)
+    {
+      delete [] frame.m_pixels;
+      frame.m_pixels = new u32[width * height];
+      frame.m_capacity = width * height;
+    }
+    frame.m_width = width;
+    frame.m_height = height;
+    frame.m_dump = dump;
+    strcpy(frame.m_path, path);
+
+    if (SDL_MUSTLOCK(sfc))
+    {
+      SDL_LockSurface(sfc);
+    }
+    for (u32 y = 0; y < height; ++y)
+    {
+      memcpy(frame.m_pixels + y * width,
+             (const u8 *) sfc->pixels + y * sfc->pitch,
+             width * sizeof(u32));
+    }
+    if (SDL_MUSTLOCK(sfc))
+    {
+      SDL_UnlockSurface(sfc);
+    }
+
+    {
+      Mutex::ScopeLock lock(m_lock);
+      m_queue[(m_queueHead + m_queueCount) % FRAME_BUFFERS] = index;
+      ++m_queueCount;
+      m_queuedFrame.SignalCondition();
+    }
+    return true;
+  }
+
+  void Camera::StartEncoders()
   {
-    // m_currentFrame++
-    bool ret = SavePNG(pngDirPath, sfc);
+    m_stopping = false;
+    for (m_threadCount = 0; m_threadCount < m_desiredThreads; ++m_threadCount)
+    {
+      MFM_API_ASSERT_STATE(!pthread_create(&m_threads[m_threadCount], NULL,
+                                           EncoderRunner, this));
+    }
+  }
+
+  void Camera::StopEncoders()
+  {
+    if (m_threadCount == 0)
+    {
+      return;
+    }
+
+    {
+      Mutex::ScopeLock lock(m_lock);
+      m_allIdle.WaitForCondition();
+      m_stopping = true;
+      for (u32 i = 0; i < m_threadCount; ++i)
+      {
+        m_queuedFrame.SignalCondition();
+      }
+    }
+
+    for (u32 i = 0; i < m_threadCount; ++i)
+    {
+      pthread_join(m_threads[i], NULL);
+    }
+    m_threadCount = 0;
+  }
 
-    //    SDL_Flip(sfc);
-    return ret;
+  void Camera::Flush()
+  {
+    StopEncoders();
+    if (m_dumpFile)
+    {
+      fclose(m_dumpFile);
+      m_dumpFile = 0;
+    }
+  }
+
+  void * Camera::EncoderRunner(void * arg)
+  {
+    Camera & camera = *(Camera *) arg;
+    while (true)
+    {
+      u32 index;
+      {
+        Mutex::ScopeLock lock(camera.m_lock);
+        camera.m_queuedFrame.WaitForCondition();
+        if (camera.m_queueCount == 0)
+        {
+          break;   // Stopping, and nothing left to do
+        }
+        index = camera.m_queue[camera.m_queueHead];
+        camera.m_queueHead = (camera.m_queueHead + 1) % FRAME_BUFFERS;
+        --camera.m_queueCount;
+      }
+
+      camera.Encode(camera.m_frames[index]);
+
+      {
+        Mutex::ScopeLock lock(camera.m_lock);
+        camera.m_idle[camera.m_idleCount++] = index;
+        camera.m_idleFrame.SignalCondition();
+        camera.m_allIdle.SignalCondition();
+      }
+    }
+    return 0;
+  }
+
+  void Camera::Encode(Frame & frame)
+  {
+    if (!frame.m_dump)
+    {
+      SavePNG(frame.m_path, frame.m_pixels, frame.m_width, frame.m_height);
+      return;
+    }
+
+    CameraFrameHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_magic, CAMERA_FRAME_MAGIC, sizeof(header.m_magic));
+    header.m_width = frame.m_width;
+    header.m_height = frame.m_height;
+    const char * slash = strrchr(frame.m_path, '/');
+    strncpy(header.m_name, slash ? slash + 1 : frame.m_path, CameraFrameHeader::NAME_LENGTH - 1);
+
+    Mutex::ScopeLock lock(m_dumpLock);
+    if (fwrite(&header, sizeof(header), 1, m_dumpFile) != 1 ||
+        fwrite(frame.m_pixels, sizeof(u32) * frame.m_width, frame.m_height, m_dumpFile)
+        != frame.m_height)
+    {
+      LOG.Error("Frame dump write failed for '%s'", header.m_name);
+    }
   }
 
   // Currently unused..
@@ -65,7 +277,7 @@ namespace MFM
     return ctype;
   }
 
-  u32 Camera::SavePNG(const char* filename, SDL_Surface* sfc) const
+  u32 Camera::SavePNG(const char* filename, const u32 * pixels, u32 width, u32 height)
   {
     FILE* fp = fopen(filename, "wb");
     if(fp == NULL)
@@ -104,18 +316,18 @@ namespace MFM
 
     //    u32 ctype = GetPNGColorType(sfc);
     u32 ctype = PNG_COLOR_TYPE_RGB_ALPHA;
-    png_set_IHDR(png_ptr, info_ptr, sfc->w, sfc->h, 8, ctype, PNG_INTERLACE_NONE,
+    png_set_IHDR(png_ptr, info_ptr, width, height, 8, ctype, PNG_INTERLACE_NONE,
 		 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
 
     png_write_info(png_ptr, info_ptr);
     png_set_bgr(png_ptr);
     png_set_packing(png_ptr);
 
-    png_bytep* rows = (png_bytep*)malloc(sizeof(png_bytep) * sfc->h);
+    png_bytep* rows = (png_bytep*)malloc(sizeof(png_bytep) * height);
 
-    for(s32 i = 0; i < sfc->h; i++)
+    for(u32 i = 0; i < height; i++)
     {
-      rows[i] = (png_bytep)((u8*)sfc->pixels + i * sfc->pitch);
+      rows[i] = (png_bytep)(pixels + i * width);
     }
     png_write_image(png_ptr, rows);
     png_write_end(png_ptr, info_ptr);
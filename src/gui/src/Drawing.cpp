@@ -132,6 +132,27 @@ namespace MFM
     SDL_FillRect(m_dest, &rect, color);
   }
 
+  u32 * Drawing::GetWindowPixels(u32 & pitch, UPoint & size) const
+  {
+    if (!m_dest || !m_dest->pixels ||
+        m_dest->format->BytesPerPixel != sizeof(u32) || SDL_MUSTLOCK(m_dest))
+    {
+      return 0;
+    }
+
+    const s32 x = m_rect.GetX();
+    const s32 y = m_rect.GetY();
+    if (x < 0 || y < 0 || x >= m_dest->w || y >= m_dest->h)
+    {
+      return 0;
+    }
+
+    pitch = m_dest->pitch / sizeof(u32);
+    size.Set(MIN((s32) m_rect.GetWidth(), m_dest->w - x),
+             MIN((s32) m_rect.GetHeight(), m_dest->h - y));
+    return ((u32 *) m_dest->pixels) + y * pitch + x;
+  }
+
   void Drawing::FillCircle(int x, int y, int w, int h, int radius) const
   {
     double cx = x+w/2.0;
@@ -164,6 +185,26 @@ namespace MFM
     SDL_BlitSurface(src, NULL, m_dest, &rect);
   }
 
+  void Drawing::BlitImage(SDL_Surface* src, const SPoint & loc) const
+  {
+    if(!src)
+    {
+      FAIL(ILLEGAL_STATE);
+    }
+
+    SDL_Rect rect;
+    rect.x = loc.GetX() + m_rect.GetX();
+    rect.y = loc.GetY() + m_rect.GetY();
+    rect.w = src->w;
+    rect.h = src->h;
+
+    SDL_Rect clip;
+    Convert(m_rect, clip);
+
+    SDL_SetClipRect(m_dest, &clip);
+    SDL_BlitSurface(src, NULL, m_dest, &rect);
+  }
+
   void Drawing::BlitAsset(Asset asset, UPoint loc, UPoint maxSize) const
   {
     BlitImage(AssetManager::Get(asset), loc, maxSize);
@@ -4,7 +4,9 @@ namespace MFM
 {
 
   GridRenderer::GridRenderer() :
-    m_cloneOrigin(-1, -1)
+    m_cloneOrigin(-1, -1),
+    m_tileBitmaps(0),
+    m_tileBitmapCount(0)
   {
     m_currentEWRenderMode = m_defaultRenderMode;
     m_renderTilesSeparated = m_renderTilesSeparatedDefault;
@@ -15,6 +17,7 @@ namespace MFM
 
   GridRenderer::~GridRenderer()
   {
+    delete [] m_tileBitmaps;
   }
 
   void GridRenderer::SetEventWindowRenderMode(EventWindowRenderMode mode)
@@ -47,6 +47,11 @@ namespace MFM {
     return m_current.count(key) > 0;
   }
 
+  bool Keyboard::AnyDown() const
+  {
+    return !m_current.empty();
+  }
+
   bool Keyboard::IsUp(u32 key) const
   {
     return m_current.count(key) == 0;
@@ -6,6 +6,28 @@ namespace MFM
 
 #define MAX_ATOM_SIZE 256
 
+  TileRenderer::TileBitmap::TileBitmap()
+    : m_surface(0)
+    , m_valid(false)
+    , m_generation(0)
+    , m_settings(0)
+  { }
+
+  TileRenderer::TileBitmap::~TileBitmap()
+  {
+    Release();
+  }
+
+  void TileRenderer::TileBitmap::Release()
+  {
+    if (m_surface)
+    {
+      SDL_FreeSurface(m_surface);
+      m_surface = 0;
+    }
+    m_valid = false;
+  }
+
   TileRenderer::TileRenderer()
   {
     m_atomDrawSize = 8;
@@ -13,9 +35,16 @@ namespace MFM
     m_drawGrid = true;
     m_drawDataHeat = false;
     m_renderSquares = false;
+    m_renderFromSnapshots = false;
     m_gridColor = 0xff202020;
     m_heatmapSelector = 0;
 
+    for (u32 i = 0; i < LOD_COLOR_CACHE_SIZE; ++i)
+    {
+      m_lodTypes[i] = LOD_NO_TYPE;
+      m_lodColors[i] = 0;
+    }
+
 #if 0 // Too much range for me..  Also we'd like a lighter palette background on some choice..
     m_hiddenColor  = 0xff353535;
     m_visibleColor = 0xff595959;
@@ -74,6 +103,21 @@ namespace MFM
     m_drawDataHeat = !m_drawDataHeat;
   }
 
+  void TileRenderer::GetVisibleSites(s32 base, u32 limit, u32 start, u32 end,
+                                     u32 & visibleStart, u32 & visibleEnd) const
+  {
+    // Site i is drawn if it starts less than one site off the low
+    // edge and ends short of the high edge (see RenderAtom)
+    const s32 size = (s32) m_atomDrawSize;
+    const s32 room = (s32) limit - 1 - base;
+
+    u32 lo = base >= 0 ? 0 : (u32) (-base / size);
+    u32 hi = room >= size ? (u32) (room / size) : 0;
+
+    visibleStart = MFM::MAX(start, lo);
+    visibleEnd = MFM::MAX(visibleStart, MIN(end, hi));
+  }
+
   void TileRenderer::ChangeAtomSize(bool increase, SPoint around)
   {
     SPoint atomLoc = (around - m_windowTL) / m_atomDrawSize;
@@ -57,6 +57,9 @@
 
 #define INITIAL_AEPS_PER_FRAME 1
 
+/* How often a --continuous headless run samples the running grid */
+#define CONTINUOUS_SAMPLE_MICROS 10000
+
 namespace MFM
 {
   /**
@@ -231,6 +234,136 @@ namespace MFM
 
       WriteTimeBasedData(fbs, exists);
       fclose(fp);
+
+      WriteCountersData();
+
+      if (GetGrid().GetPhaseSampleOdds() > 0)
+      {
+        WritePhasesData();
+      }
+
+      if (GetGrid().IsElementProfiling())
+      {
+        WriteElementProfileData();
+      }
+    }
+
+    /**
+     * Opens \c relPath , in the simulation directory, for appending
+     * rows of comma-separated values, first writing \c header and a
+     * newline if the file is empty.  Logs an error and returns null
+     * if it can't be opened; otherwise the caller must fclose it.
+     */
+    FILE * OpenCsvAppend(const char * relPath, const char * header)
+    {
+      const char* path = GetSimDirPathTemporary("%s", relPath);
+      FILE* fp = fopen(path, "a");
+      if (!fp)
+      {
+        LOG.Error("Can't append to %s: %s", path, strerror(errno));
+        return 0;
+      }
+
+      fseek(fp, 0, SEEK_END);
+      if (ftell(fp) == 0)
+      {
+        fprintf(fp, "%s\n", header);
+      }
+      return fp;
+    }
+
+    /**
+     * Appends a row of the held Grid's total hot-path counters (see
+     * TileCounters) to tbd/counters.csv, headed by a row of column
+     * names when the file is new.
+     */
+    void WriteCountersData()
+    {
+      OString1024 header;
+      header.Printf("aeps,");
+      TileCounters::PrintCSVHeader(header);
+      FILE* fp = OpenCsvAppend("tbd/counters.csv", header.GetZString());
+      if (!fp)
+      {
+        return;
+      }
+      FileByteSink fbs(fp);
+
+      TileCounters counters;
+      GetGrid().GetTotalCounters(counters);
+
+      fbs.Print((u64) GetAEPS());
+      fbs.WriteByte(',');
+      counters.PrintCSV(fbs);
+      fbs.Println();
+      fclose(fp);
+    }
+
+    /**
+     * Appends one row per event phase of the held Grid's total phase
+     * histograms (see PhaseHistograms) to tbd/phases.csv, headed by a
+     * row of column names when the file is new.  The histograms are
+     * cumulative, so subtracting rows from an earlier epoch gives the
+     * histograms for the epochs since.
+     */
+    void WritePhasesData()
+    {
+      OString1024 header;
+      header.Printf("aeps,");
+      PhaseHistograms::PrintCSVHeader(header);
+      FILE* fp = OpenCsvAppend("tbd/phases.csv", header.GetZString());
+      if (!fp)
+      {
+        return;
+      }
+      FileByteSink fbs(fp);
+
+      PhaseHistograms histograms;
+      GetGrid().GetTotalPhaseHistograms(histograms);
+
+      OString32 prefix;
+      prefix.Printf("%d,", (u32) GetAEPS());
+      histograms.PrintCSV(fbs, prefix.GetZString());
+      fclose(fp);
+    }
+
+    /**
+     * Appends one row per needed Element, of its behavior profile
+     * summed over the held Grid (see ElementProfile), to
+     * tbd/elements.csv, headed by a row of column names when the file
+     * is new.  Like the profiles, the rows are cumulative.
+     */
+    void WriteElementProfileData()
+    {
+      FILE* fp = OpenCsvAppend("tbd/elements.csv",
+                               "aeps,element,type,calls,cycles,maxCycles,sitesWritten");
+      if (!fp)
+      {
+        return;
+      }
+      FileByteSink fbs(fp);
+
+      const u32 aeps = (u32) GetAEPS();
+      for (u32 i = 0; i < m_neededElementCount; ++i)
+      {
+        const Element<EC> & elt = *m_neededElements[i];
+        ElementProfile profile;
+        GetGrid().GetTotalElementProfile(elt.GetType(), profile);
+        if (profile.m_calls == 0)
+        {
+          continue;
+        }
+        fbs.Printf("%d,%s,%d,", aeps, elt.GetName(), elt.GetType());
+        fbs.Print(profile.m_calls);
+        fbs.WriteByte(',');
+        fbs.Print(profile.m_cycles);
+        fbs.WriteByte(',');
+        fbs.Print(profile.m_maxCycles);
+        fbs.WriteByte(',');
+        fbs.Print(profile.m_sitesWritten);
+        fbs.Println();
+      }
+      fclose(fp);
     }
 
     /**
@@ -260,25 +393,7 @@ namespace MFM
       u32 thisPeriodMS = m_ticksLastStopped - startMS;
       m_msSpentRunning += thisPeriodMS;
 
-      u64 totalEvents = grid.GetTotalEventsExecuted();
-      u32 totalSites = grid.GetTotalSites();
-      m_AEPS = totalEvents / ((double) totalSites);
-      m_AER = 1000 * (m_AEPS / m_msSpentRunning);
-
-      u64 newEvents = totalEvents - m_lastTotalEvents;
-      m_lastTotalEvents = totalEvents;
-
-      if (thisPeriodMS == 0) {
-        LOG.Warning("Zero ms in sample");
-        thisPeriodMS = 1;
-      }
-      double thisAERsample = 1000.0 * newEvents / totalSites / thisPeriodMS;
-
-      const double BACKWARDS_AVERAGE_RATE = 0.99;
-      m_recentAER = BACKWARDS_AVERAGE_RATE * m_recentAER +
-                    (1 - BACKWARDS_AVERAGE_RATE) * thisAERsample;
-
-      m_overheadPercent = 100.0*m_msSpentOverhead/(m_msSpentRunning+m_msSpentOverhead);
+      UpdateRates(grid, thisPeriodMS);
 
       double diff = m_AEPS - m_lastFrameAEPS;
       double err = MIN(1.0, MAX(-1.0, m_aepsPerFrame - diff));
@@ -294,6 +409,106 @@ namespace MFM
       PostUpdate();
     }
 
+    /**
+     * Unpauses the held Grid and leaves it running across calls to
+     * \c UpdateGridContinuously() , until \c StopContinuousRun() .
+     * Does nothing if already running continuously.
+     *
+     * @param grid The Grid to run.
+     */
+    void StartContinuousRun(OurGrid& grid)
+    {
+      if (m_runningContinuously)
+      {
+        return;
+      }
+
+      grid.Unpause();
+
+      m_ticksLastSampled = GetTicks();
+      if (m_ticksLastStopped != 0)
+        m_msSpentOverhead += m_ticksLastSampled - m_ticksLastStopped;
+      else
+        m_msSpentOverhead = 0;
+
+      m_runningContinuously = true;
+    }
+
+    /**
+     * Pauses the held Grid if it is running continuously, so it may
+     * be examined or modified safely.  Does nothing otherwise.
+     *
+     * @param grid The Grid to pause.
+     */
+    void StopContinuousRun(OurGrid& grid)
+    {
+      if (!m_runningContinuously)
+      {
+        return;
+      }
+
+      m_ticksLastStopped = GetTicks();
+
+      grid.Pause();
+
+      m_msSpentRunning += m_ticksLastStopped - m_ticksLastSampled;
+      m_runningContinuously = false;
+    }
+
+    bool IsRunningContinuously() const
+    {
+      return m_runningContinuously;
+    }
+
+    /**
+     * Checks whether --continuous was given, asking that the held
+     * Grid be run with \c UpdateGridContinuously() rather than \c
+     * UpdateGrid() .
+     */
+    bool IsContinuous() const
+    {
+      return m_continuous;
+    }
+
+    /**
+     * Like \c UpdateGrid() , but leaves the held Grid running between
+     * calls rather than pausing it every frame, so that no simulation
+     * time is lost to pausing and unpausing.  Updates the event rates
+     * from the running Grid, and pauses it only when an epoch is due
+     * that \c EpochNeedsPausedGrid() .  Anything reading the Grid's
+     * sites in the meantime should use Tile snapshots.
+     *
+     * @param grid The Grid which is updated during this call.
+     *
+     * @sa Grid::SetSnapshotPeriodMS
+     */
+    void UpdateGridContinuously(OurGrid& grid)
+    {
+      StartContinuousRun(grid);
+
+      u32 nowMS = GetTicks();
+      u32 thisPeriodMS = nowMS - m_ticksLastSampled;
+      if (thisPeriodMS > 0)
+      {
+        m_ticksLastSampled = nowMS;
+        m_msSpentRunning += thisPeriodMS;
+
+        UpdateRates(grid, thisPeriodMS);
+        m_lastFrameAEPS = m_AEPS;
+      }
+
+      if (IsEpochDue())
+      {
+        if (EpochNeedsPausedGrid(m_epochCount))
+        {
+          StopContinuousRun(grid);  // Restarted by our next call
+        }
+        CheckEpochProcessing(grid);
+      }
+
+      PostUpdate();
+    }
+
     /**
      * Subtracts \c m_aepsPerFrame (or, the number of AEPS which
      * should elapse every call to \c UpdateGrid() ) by one, keeping it
@@ -398,6 +613,23 @@ namespace MFM
       }
       LOG.Message("Writing to simulation directory '%s'", GetSimDirPathTemporary(""));
 
+      MakeSimDirs(args);
+
+      m_elementRegistry.Init(m_grid.GetUlamClassRegistry());
+      u32 dlcount = m_elementRegistry.GetRegisteredElementCount();
+      for (u32 i = 0; i < dlcount; ++i)
+      {
+        NeedElement(m_elementRegistry.GetRegisteredElement(i));
+      }
+
+      DefineNeededElements();
+    }
+
+    /**
+     * Makes the simulation directory and its standard subdirectories.
+     */
+    void MakeSimDirs(VArguments& args)
+    {
       const char* (subs[]) =
       {
         "", "vid", "eps", "tbd", "teps", "save", "screenshot", "autosave", "log"
@@ -412,15 +644,46 @@ namespace MFM
                    path, strerror(errno));
         }
       }
+    }
 
-      m_elementRegistry.Init(m_grid.GetUlamClassRegistry());
-      u32 dlcount = m_elementRegistry.GetRegisteredElementCount();
-      for (u32 i = 0; i < dlcount; ++i)
+    /**
+     * Splits the grid's tiles among m_processes processes (see
+     * Grid::ForkPartitions).  Each partition after the first writes
+     * to its own p<N>/ subdirectory of the simulation directory.
+     * Every process still allocates and Inits the whole grid, so this
+     * spreads CPU load but not memory.
+     */
+    void ForkPartitions()
+    {
+      MFM_API_ASSERT_STATE(SupportsPartitions());
+
+      // An asynchronous log's writer thread wouldn't survive the fork
+      bool async = LOG.IsAsync();
+      LOG.StopAsync();
+
+      u32 partition = m_grid.ForkPartitions(m_processes, m_sharedMemoryBytes);
+      if (partition > 0)
       {
-        NeedElement(m_elementRegistry.GetRegisteredElement(i));
+        u32 len = m_simDirBasePathLength;
+        snprintf(m_simDirBasePath + len, MAX_PATH_LENGTH - len, "p%d/", partition);
+        m_simDirBasePathLength = strlen(m_simDirBasePath);
+        MakeSimDirs(m_varguments);
       }
 
-      DefineNeededElements();
+      if (async)
+      {
+        LOG.StartAsync();
+      }
+    }
+
+    /**
+     * Whether this driver can run its grid in --processes partitions.
+     * Only a headless driver can: a GUI draws and edits the whole
+     * grid, but a partition runs only its own Tiles.
+     */
+    virtual bool SupportsPartitions() const
+    {
+      return false;
     }
 
     /**
@@ -433,18 +696,30 @@ namespace MFM
 
       while(running)
       {
-        UpdateGrid(m_grid);
+        if (m_continuous)
+        {
+          UpdateGridContinuously(m_grid);
+          SleepUsec(CONTINUOUS_SAMPLE_MICROS);
+        }
+        else
+        {
+          UpdateGrid(m_grid);
+        }
         running = RunHelperExiter();
       }
 
     }
 
     virtual bool RunHelperExiter() {
-      double full = m_grid.GetFullSitePercentage();
+      // Only count atoms if we must; if the grid is running these
+      // are the counts its tiles last published
+      double full = (m_haltOnEmpty || m_haltOnFull) ? m_grid.GetFullSitePercentage() : 0.5;
       if((m_haltAfterAEPS > 0 && m_AEPS > m_haltAfterAEPS)
          || (m_haltOnEmpty && full == 0.0)
          || (m_haltOnFull && full == 1.0))
       {
+        StopContinuousRun(m_grid);
+
         // Free final save if halting on --halt*.  Hope for good-looking corpse.
         SaveGridWithConstantFilename("save/final.mfs");
         WriteTimeBasedData();
@@ -478,6 +753,9 @@ namespace MFM
     OurGrid m_grid;
 
     u32 m_ticksLastStopped;
+    u32 m_ticksLastSampled;
+    bool m_continuous;
+    bool m_runningContinuously;
     u32 m_haltAfterAEPS;
     bool m_haltOnEmpty;
     bool m_haltOnFull;
@@ -498,6 +776,23 @@ namespace MFM
 
     bool m_gridImages;
     bool m_tileImages;
+    bool m_directCaches;  // Init the grid in INTERTILE_DIRECT mode
+    u32 m_processes;      // Grid partitions, each in its own process
+    u32 m_sharedMemoryBytes; // Partition channel capacity; 0 for sockets
+    u32 m_intertileBufferBytes; // Each way, per GridTransceiver
+    typename OurGrid::ThreadPlacement m_threadPlacement;
+
+    /**
+     * The highest log level whose trace points are recorded in
+     * binary to per-tile files under trace/, or 0 for no tracing.
+     */
+    u32 m_traceLevel;
+
+    /**
+     * One sink per tile while tracing, indexed by tile id (y *
+     * width + x), else null.
+     */
+    FileByteSink ** m_traceSinks;
 
     double m_AEPS;
     /**
@@ -567,6 +862,11 @@ namespace MFM
       LOG.SetLevel((Logger::Level) val);
     }
 
+    static void SetAsyncLogging(const char* not_needed, void* nullForNone)
+    {
+      LOG.StartAsync();
+    }
+
     static const char * GetNumberFromString(const char* str, s32 & output, s32 min, s32 max)
     {
       MFM_API_ASSERT_NONNULL(str);
@@ -678,6 +978,11 @@ namespace MFM
       ((AbstractDriver*)driver)->m_haltOnFull = 1;
     }
 
+    static void SetContinuousFromArgs(const char* not_needed, void* driver)
+    {
+      ((AbstractDriver*)driver)->m_continuous = true;
+    }
+
     static void SetGridImages(const char* not_needed, void* driver)
     {
       ((AbstractDriver*)driver)->m_gridImages = 1;
@@ -688,6 +993,218 @@ namespace MFM
       ((AbstractDriver*)driver)->m_tileImages = 1;
     }
 
+    static void SetPhaseTimingFromArgs(const char* odds, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg = AbstractDriver<GC>::GetNumberFromString(odds, out, 0, S32_MAX);
+      if (errmsg)
+      {
+        args.Die("Bad phase timing odds '%s': %s", odds, errmsg);
+      }
+
+      driver.m_grid.SetPhaseSampleOdds((u32) out);
+    }
+
+    static void SetCachePipelineFromArgs(const char* depth, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg =
+        AbstractDriver<GC>::GetNumberFromString(depth, out, 1, CacheProcessor<EC>::GetMaxPipelineDepth());
+      if (errmsg)
+      {
+        args.Die("Bad cache pipeline depth '%s': %s", depth, errmsg);
+      }
+
+      driver.m_grid.SetCachePipelineDepth((u32) out);
+    }
+
+    static void SetCacheDigestFromArgs(const char* period, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg = AbstractDriver<GC>::GetNumberFromString(period, out, 0, S32_MAX);
+      if (errmsg)
+      {
+        args.Die("Bad cache digest period '%s': %s", period, errmsg);
+      }
+
+      driver.m_grid.SetCacheDigestPeriod((u32) out);
+    }
+
+    static void SetDirectCachesFromArgs(const char* not_needed, void* driver)
+    {
+      ((AbstractDriver*)driver)->m_directCaches = true;
+    }
+
+    static void SetProcessesFromArgs(const char* count, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg =
+        AbstractDriver<GC>::GetNumberFromString(count, out, 1, driver.m_grid.GetWidth());
+      if (errmsg)
+      {
+        args.Die("Bad process count '%s': %s", count, errmsg);
+      }
+
+      if (out > 1 && !driver.SupportsPartitions())
+      {
+        args.Die("--processes %d needs a headless driver", out);
+      }
+
+      driver.m_processes = (u32) out;
+    }
+
+    static void SetPinFromArgs(const char* not_needed, void* driver)
+    {
+      AbstractDriver & d = *((AbstractDriver*)driver);
+      if (d.m_threadPlacement == OurGrid::PLACE_ANYWHERE)
+      {
+        d.m_threadPlacement = OurGrid::PLACE_PINNED;
+      }
+    }
+
+    static void SetNumaFromArgs(const char* not_needed, void* driver)
+    {
+      ((AbstractDriver*)driver)->m_threadPlacement = OurGrid::PLACE_NUMA;
+    }
+
+    static void SetSharedMemoryFromArgs(const char* bytes, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg =
+        AbstractDriver<GC>::GetNumberFromString(bytes, out,
+                                                SharedMemoryChannel::MIN_CAPACITY,
+                                                SharedMemoryChannel::MAX_CAPACITY);
+      if (errmsg)
+      {
+        args.Die("Bad shared memory channel size '%s': %s", bytes, errmsg);
+      }
+
+      driver.m_sharedMemoryBytes = (u32) out;
+    }
+
+    static void SetIntertileBufferFromArgs(const char* bytes, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg =
+        AbstractDriver<GC>::GetNumberFromString(bytes, out,
+                                                GridTransceiver::MIN_BUFFER_SIZE,
+                                                GridTransceiver::MAX_BUFFER_SIZE);
+      if (!errmsg && (out & (out - 1)) != 0)
+      {
+        errmsg = "Not a power of two";
+      }
+      if (errmsg)
+      {
+        args.Die("Bad intertile buffer size '%s': %s", bytes, errmsg);
+      }
+
+      driver.m_intertileBufferBytes = (u32) out;
+    }
+
+    static void SetElementProfilingFromArgs(const char* not_needed, void* driver)
+    {
+      ((AbstractDriver*)driver)->m_grid.SetElementProfiling(true);
+    }
+
+    static void SetTraceLevelFromArgs(const char* level, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 val = Logger::ParseLevel(level);
+      if (val < 0)
+        args.Die("'%s' not recognized as a logging level", level);
+      if (!MFM_LOG_LEVEL_KEPT(val))
+        args.Die("Level %d trace points are not compiled in (MFM_MAX_LOG_LEVEL is %d)",
+                 val, MFM_MAX_LOG_LEVEL);
+      driver.m_traceLevel = (u32) val;
+    }
+
+    /**
+     * Starts binary tracing in every tile, if requested by --trace.
+     * Must be called while the tile threads are paused.
+     */
+    void StartTracing()
+    {
+      if (m_traceLevel == 0)
+      {
+        return;
+      }
+
+      const char* dir = GetSimDirPathTemporary("trace");
+      if (mkdir(dir, 0777) && errno != EEXIST)
+      {
+        m_varguments.Die("Couldn't make trace directory '%s' : %s",
+                         dir, strerror(errno));
+      }
+      LOG.Message("Tracing levels up to %d in %s", m_traceLevel, dir);
+
+      const u32 width = m_grid.GetWidth();
+      const u32 height = m_grid.GetHeight();
+      m_traceSinks = new FileByteSink * [width * height];
+      for (u32 y = 0; y < height; ++y)
+      {
+        for (u32 x = 0; x < width; ++x)
+        {
+          const u32 tileId = y * width + x;
+          const char* path = GetSimDirPathTemporary("trace/tile-%d-%d.bin", x, y);
+          FILE* fp = fopen(path, "w");
+          if (!fp)
+          {
+            m_varguments.Die("Couldn't open trace file '%s' : %s",
+                             path, strerror(errno));
+          }
+          m_traceSinks[tileId] = new FileByteSink(fp);
+          m_grid.GetTile(x, y).GetTraceBuffer().Start(tileId, *m_traceSinks[tileId], m_traceLevel);
+        }
+      }
+    }
+
+    /**
+     * Flushes and closes all tile traces.  Must be called while the
+     * tile threads are paused or gone.
+     */
+    void StopTracing()
+    {
+      if (!m_traceSinks)
+      {
+        return;
+      }
+
+      const u32 width = m_grid.GetWidth();
+      const u32 height = m_grid.GetHeight();
+      for (u32 y = 0; y < height; ++y)
+      {
+        for (u32 x = 0; x < width; ++x)
+        {
+          const u32 tileId = y * width + x;
+          m_grid.GetTile(x, y).GetTraceBuffer().Stop();
+          m_traceSinks[tileId]->Close();
+          delete m_traceSinks[tileId];
+        }
+      }
+      delete [] m_traceSinks;
+      m_traceSinks = 0;
+    }
+
     static void SetDataDirFromArgs(const char* dirPath, void* driverPtr)
     {
       AbstractDriver& driver = *((AbstractDriver*)driverPtr);
@@ -798,16 +1315,62 @@ namespace MFM
       ++driver.m_configurationPathCount;
     }
 
+    /**
+     * Recomputes the AEPS, event rates, and overhead after the held
+     * Grid has run for another \c thisPeriodMS milliseconds.
+     */
+    void UpdateRates(OurGrid& grid, u32 thisPeriodMS)
+    {
+      u64 totalEvents = grid.GetTotalEventsExecuted();
+      u32 totalSites = grid.GetLocalSites();
+      m_AEPS = totalEvents / ((double) totalSites);
+      m_AER = 1000 * (m_AEPS / m_msSpentRunning);
+
+      u64 newEvents = totalEvents - m_lastTotalEvents;
+      m_lastTotalEvents = totalEvents;
+
+      if (thisPeriodMS == 0) {
+        LOG.Warning("Zero ms in sample");
+        thisPeriodMS = 1;
+      }
+      double thisAERsample = 1000.0 * newEvents / totalSites / thisPeriodMS;
+
+      const double BACKWARDS_AVERAGE_RATE = 0.99;
+      m_recentAER = BACKWARDS_AVERAGE_RATE * m_recentAER +
+                    (1 - BACKWARDS_AVERAGE_RATE) * thisAERsample;
+
+      m_overheadPercent = 100.0*m_msSpentOverhead/(m_msSpentRunning+m_msSpentOverhead);
+    }
+
+    bool IsEpochDue() const
+    {
+      return
+        (m_AEPSPerEpoch >= 0 || m_accelerateAfterEpochs > 0 || m_surgeAfterEpochs > 0)
+        && m_AEPS >= m_nextEpochAEPS;
+    }
+
+    /**
+     * Checks whether the end-of-epoch processing for epoch \c epochs
+     * needs a paused, consistent Grid.  Base class needs one only
+     * for --gridImages, --tileImages, and autosaves; the atom counts
+     * in time-based data are those the Tiles publish while running
+     * (see Grid::GetAtomCount).
+     * Subclasses whose DoEpochEvents examine the Grid closely should
+     * override this method to return \c true as well.
+     */
+    virtual bool EpochNeedsPausedGrid(u32 epochs) const
+    {
+      return m_gridImages || m_tileImages ||
+        (m_autosavePerEpochs > 0 && (epochs % m_autosavePerEpochs) == 0);
+    }
+
     void CheckEpochProcessing(OurGrid& grid)
     {
-      if (m_AEPSPerEpoch >= 0 || m_accelerateAfterEpochs > 0 || m_surgeAfterEpochs > 0)
+      if (IsEpochDue())
       {
-        if (m_AEPS >= m_nextEpochAEPS)
-        {
-          DoEpochEvents(grid, m_epochCount, m_nextEpochAEPS);
-          m_nextEpochAEPS += m_AEPSPerEpoch;
-          ++m_epochCount;
-        }
+        DoEpochEvents(grid, m_epochCount, m_nextEpochAEPS);
+        m_nextEpochAEPS += m_AEPSPerEpoch;
+        ++m_epochCount;
       }
     }
 
@@ -951,12 +1514,15 @@ namespace MFM
 
     }
 
-    AbstractDriver(u32 gridWidth, u32 gridHeight)
+    AbstractDriver(u32 gridWidth, u32 gridHeight, u32 tileSide = GC::TILE_SIDE)
       : GRID_WIDTH(gridWidth)
       , GRID_HEIGHT(gridHeight)
       , m_neededElementCount(0)
-      , m_grid(m_elementRegistry, GRID_WIDTH, GRID_HEIGHT)
+      , m_grid(m_elementRegistry, GRID_WIDTH, GRID_HEIGHT, tileSide)
       , m_ticksLastStopped(0)
+      , m_ticksLastSampled(0)
+      , m_continuous(false)
+      , m_runningContinuously(false)
       , m_haltAfterAEPS(0)
       , m_haltOnEmpty(false)
       , m_haltOnFull(false)
@@ -973,6 +1539,13 @@ namespace MFM
       , m_surgeAfterEpochs(0)
       , m_gridImages(false)
       , m_tileImages(false)
+      , m_directCaches(false)
+      , m_processes(1)
+      , m_sharedMemoryBytes(0)
+      , m_intertileBufferBytes(GridTransceiver::DEFAULT_BUFFER_SIZE)
+      , m_threadPlacement(OurGrid::PLACE_ANYWHERE)
+      , m_traceLevel(0)
+      , m_traceSinks(0)
       , m_AEPS(0)
       , m_recentAER(0)
       , m_lastTotalEvents(0)
@@ -1067,6 +1640,9 @@ namespace MFM
       RegisterArgument("Amount of logging output is ARG (0 -> none, 8 -> max)",
                        "-l|--log", &SetLoggingLevel, NULL, true);
 
+      RegisterArgument("Write log output from a background thread, dropping messages if it falls behind",
+                       "--asynclog", &SetAsyncLogging, NULL, false);
+
       RegisterArgument("Print the brief version number, then exit.",
                        "-v|--version", &PrintVersion, NULL, false);
 
@@ -1096,6 +1672,39 @@ namespace MFM
       RegisterArgument("Each epoch, write tile AEPS image to per-sim teps/ directory",
                        "--tileImages", &SetTileImages, this, false);
 
+      RegisterArgument("Record trace points up to log level ARG in binary to per-sim trace/ directory",
+                       "--trace", &SetTraceLevelFromArgs, this, true);
+
+      RegisterArgument("Time the phases of 1 in ARG events, writing histograms each epoch to per-sim tbd/phases.csv (0 for never)",
+                       "--phasetiming", &SetPhaseTimingFromArgs, this, true);
+
+      RegisterArgument("Let each cache processor have up to ARG (1..8) edge updates awaiting replies (default 1)",
+                       "--cachepipeline", &SetCachePipelineFromArgs, this, true);
+
+      RegisterArgument("Verify tile edge caches by a digest every ARG updates, instead of by resending unchanged atoms (0 for never)",
+                       "--cachedigest", &SetCacheDigestFromArgs, this, true);
+
+      RegisterArgument("Update tile edge caches by writing directly into neighboring tiles, instead of by packets",
+                       "--directcaches", &SetDirectCachesFromArgs, this, false);
+
+      RegisterArgument("Run the grid's tiles in ARG processes, each owning a strip of tile columns (headless drivers only; every process still allocates and Inits the whole grid)",
+                       "--processes", &SetProcessesFromArgs, this, true);
+
+      RegisterArgument("Connect --processes partitions by shared memory rings of ARG bytes each way, instead of sockets",
+                       "--sharedmemory", &SetSharedMemoryFromArgs, this, true);
+
+      RegisterArgument("Give each intertile channel ARG bytes (a power of two) of buffer each way (default 2048)",
+                       "--intertilebuffer", &SetIntertileBufferFromArgs, this, true);
+
+      RegisterArgument("Pin each tile's thread to a CPU, keeping neighboring tiles on one NUMA node where possible",
+                       "--pin", &SetPinFromArgs, this, false);
+
+      RegisterArgument("As --pin, and also move each tile's memory to its CPU's NUMA node",
+                       "--numa", &SetNumaFromArgs, this, false);
+
+      RegisterArgument("Profile element behaviors, writing totals each epoch to per-sim tbd/elements.csv",
+                       "--profileelements", &SetElementProfilingFromArgs, this, false);
+
       RegisterArgument("If ARG > 0, Halts after ARG elapsed aeps.",
                        "--haltafteraeps", &SetHaltAfterAEPSFromArgs, this, true);
 
@@ -1105,6 +1714,9 @@ namespace MFM
       RegisterArgument("Halts if grid is full.",
                        "--haltonfull", &SetHaltOnFull, this, false);
 
+      RegisterArgument("Keep the grid running, pausing only for epochs that need it (and to edit)",
+                       "--continuous", &SetContinuousFromArgs, this, false);
+
       RegisterArgument("Store data in per-sim directories under ARG (string)",
                        "-d|--dir", &SetDataDirFromArgs, this, true);
 
@@ -1189,10 +1801,24 @@ namespace MFM
 
       ReinitUs();
 
-      m_grid.Init();
+      if (m_processes > 1)
+      {
+        ForkPartitions();
+      }
+
+      m_grid.SetIntertileBufferSize(m_intertileBufferBytes);
+      m_grid.Init(m_directCaches ? OurGrid::INTERTILE_DIRECT : OurGrid::INTERTILE_PACKETS);
 
+      m_grid.SetThreadPlacement(m_threadPlacement);
       m_grid.InitThreads();
 
+      const HugePageBlock & block = m_grid.GetTileBlock();
+      LOG.Message("Tile memory: %d KB on %s pages of %d KB (%d KB huge now)",
+                  (u32) (block.GetBytes() / 1024),
+                  HugePageBlock::GetBackingName(block.GetBacking()),
+                  (u32) (block.GetPageBytes() / 1024),
+                  (u32) (block.GetHugeBytes() / 1024));
+
       //m_grid.Needed(Element_Empty<EC>::THE_INSTANCE);
       NeedElement(&Element_Empty<EC>::THE_INSTANCE);
 
@@ -1204,6 +1830,8 @@ namespace MFM
 
       LoadFromConfigurationPath();
 
+      StartTracing();
+
       m_grid.SetGridRunning(true);
 
     }
@@ -1218,7 +1846,11 @@ namespace MFM
        },
        {
          RunHelper();
+         StopContinuousRun(m_grid);
+         StopTracing();
+         m_grid.WaitForPartitions();
          LOG.Message("Simulation driver exiting");
+         LOG.StopAsync();
        });
     }
   };
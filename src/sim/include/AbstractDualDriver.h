@@ -55,7 +55,8 @@ namespace MFM
 
   protected:
 
-    AbstractDualDriver(u32 gridWidth, u32 gridHeight) : Super(gridWidth, gridHeight)
+    AbstractDualDriver(u32 gridWidth, u32 gridHeight, u32 tileSide = GC::TILE_SIDE)
+      : Super(gridWidth, gridHeight, tileSide)
     { }
 
     virtual void AddDriverArguments()
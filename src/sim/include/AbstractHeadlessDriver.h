@@ -52,8 +52,8 @@ namespace MFM
   protected:
     typedef typename Super::OurGrid OurGrid;
 
-    AbstractHeadlessDriver(u32 gridWidth, u32 gridHeight)
-      : AbstractDriver<GC>(gridWidth, gridHeight)
+    AbstractHeadlessDriver(u32 gridWidth, u32 gridHeight, u32 tileSide = GC::TILE_SIDE)
+      : AbstractDriver<GC>(gridWidth, gridHeight, tileSide)
     { }
 
     virtual void AddDriverArguments()
@@ -66,6 +66,11 @@ namespace MFM
       Super::OnceOnly(args);
     }
 
+    virtual bool SupportsPartitions() const
+    {
+      return true;
+    }
+
     virtual void PostUpdate()
     {
       LOG.Debug("AEPS: %d", (u32)Super::GetAEPS());
@@ -0,0 +1,130 @@
+/*                                              -*- mode:C++ -*-
+  CpuPlacement.h The CPUs and NUMA nodes available for tile threads
+  Copyright (C) 2014 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file CpuPlacement.h The CPUs and NUMA nodes available for tile threads
+  \author David H. Ackley.
+  \date (C) 2014 All rights reserved.
+  \lgpl
+ */
+#ifndef CPUPLACEMENT_H
+#define CPUPLACEMENT_H
+
+#include "itype.h"
+#include "Fail.h"
+
+namespace MFM
+{
+  /**
+    The CPUs this process may run on, ordered node by node, so that
+    threads given neighboring slots in that order share a NUMA node
+    whenever possible.  Read from /sys/devices/system/node; a machine
+    without that information is treated as one node.
+   */
+  class CpuPlacement
+  {
+  public:
+
+    enum {
+      MAX_CPUS = 1024,  // As in glibc's cpu_set_t
+      MAX_NODES = 64
+    };
+
+    CpuPlacement() ;
+
+    /**
+       Find the CPUs we're allowed and the NUMA node of each.
+
+       \fail ILLEGAL_STATE if our CPU affinity can't be read
+     */
+    void Init() ;
+
+    u32 GetCpuCount() const
+    {
+      return m_cpuCount;
+    }
+
+    u32 GetNodeCount() const
+    {
+      return m_nodeCount;
+    }
+
+    /**
+       The CPU in slot \c slot of our node-by-node order.
+     */
+    u32 GetCpu(u32 slot) const
+    {
+      MFM_API_ASSERT_ARG(slot < m_cpuCount);
+      return m_cpus[slot];
+    }
+
+    /**
+       The NUMA node of the CPU in slot \c slot.
+     */
+    u32 GetNode(u32 slot) const
+    {
+      MFM_API_ASSERT_ARG(slot < m_cpuCount);
+      return m_nodes[slot];
+    }
+
+    /**
+       Parse a Linux CPU list such as "0-3,8,10-11" into \c flags,
+       setting flags[n] for each listed CPU n below \c size.  Return
+       false, leaving \c flags partly set, if \c list is malformed.
+     */
+    static bool ParseCpuList(const char * list, bool * flags, u32 size) ;
+
+    /**
+       Restrict the calling thread to \c cpu.  Return false if that
+       isn't allowed.
+     */
+    static bool PinThisThread(u32 cpu) ;
+
+    /**
+       Find the pages of \c pageBytes bytes, aligned to that size,
+       whose middles lie within the \c bytes bytes at \c start, so
+       that neighboring ranges claim each page at most once.  Set \c
+       first and \c last to the start of the first such page and the
+       end of the last, and return false if there are none.
+     */
+    static bool GetClaimedPages(uptr start, u64 bytes, u64 pageBytes,
+                                uptr & first, uptr & last) ;
+
+    /**
+       Ask that the pages claimed (see GetClaimedPages) by the \c
+       bytes bytes at \c start live on NUMA node \c node, moving any
+       already there.  \c pageBytes must be the size of the pages
+       the range is mapped for, such as HugePageBlock::GetPageBytes,
+       or 0 for ordinary pages; moving only whole, aligned pages of
+       that size keeps mbind from failing on reserved huge pages and
+       from splitting transparent ones.  Return false if the kernel
+       wouldn't.
+     */
+    static bool MoveToNode(void * start, u64 bytes, u32 node, u64 pageBytes = 0) ;
+
+  private:
+    u32 m_cpuCount;
+    u32 m_nodeCount;
+    u16 m_cpus[MAX_CPUS];
+    u8 m_nodes[MAX_CPUS];
+  };
+}
+
+#endif /* CPUPLACEMENT_H */
@@ -35,9 +35,15 @@
 #include "Sense.h"
 #include "GridConfig.h"
 #include "GridTransceiver.h"
+#include "SocketChannel.h"
+#include "SharedMemoryChannel.h"
+#include "CpuPlacement.h"
+#include "HugePageBlock.h"
 #include "ElementRegistry.h"
 #include "Logger.h"
 #include <time.h>  /* For struct timespec, clock_gettime */
+#include <sys/types.h>  /* For pid_t */
+#include <new>  /* For placement new */
 
 namespace MFM {
 
@@ -56,11 +62,41 @@ namespace MFM {
     enum { MAX_TILES_SUPPORTED = 500 };  // Yeah right.  Used for sizing m_rgi
 
     enum { R = EC::EVENT_WINDOW_RADIUS};
-    enum { TILE_SIDE = GC::TILE_SIDE};
-    enum { OWNED_SIDE = TILE_SIDE - 2 * R }; // Duplicating the OWNED_SIDE computation in Tile.tcc!
+    enum { TILE_SIDE = GC::TILE_SIDE};  // 0 if chosen at runtime
+    enum { OWNED_SIDE = GC::OWNED_SIDE };
+
+    /**
+     * The Tile sides a Grid with a runtime TILE_SIDE will accept.
+     * Sides must also be even (see Tile::Tile).
+     */
+    enum {
+      MIN_TILE_SIDE = 6 * R,
+      MAX_TILE_SIDE = 1024
+    };
 
     typedef SizedTile<EC,TILE_SIDE> GridTile;
 
+    /**
+     * How neighboring Tiles keep each other's caches up to date,
+     * chosen once per Grid at Init.
+     */
+    enum IntertileMode
+    {
+      INTERTILE_PACKETS,  // Cache update packets via GridTransceivers
+      INTERTILE_DIRECT    // Writes straight into neighbors' cache sites
+    };
+
+    /**
+     * Where Tile threads run, and where their memory lives, chosen
+     * before InitThreads.
+     */
+    enum ThreadPlacement
+    {
+      PLACE_ANYWHERE,     // Wherever the scheduler likes
+      PLACE_PINNED,       // Each on one CPU, neighbors on one node if possible
+      PLACE_NUMA          // Pinned, with Tile and driver memory on its node
+    };
+
   private:
     Random m_random;
 
@@ -70,11 +106,68 @@ namespace MFM {
 
     const u32 m_width, m_height;
 
+    const u32 m_tileSide;   // TILE_SIDE, unless that is 0
+    const u32 m_ownedSide;  // Duplicating the OWNED_SIDE computation in Tile.tcc!
+
+    static u32 CheckTileSide(u32 tileSide)
+    {
+      if (TILE_SIDE == 0)
+      {
+        MFM_API_ASSERT_ARG(tileSide >= MIN_TILE_SIDE && tileSide <= MAX_TILE_SIDE &&
+                           tileSide % 2 == 0);
+      }
+      else
+      {
+        MFM_API_ASSERT_ARG(tileSide == TILE_SIDE);
+      }
+      return tileSide;
+    }
+
     SPoint m_lastEventTile;
 
     ElementTypeNumberMap<EC> m_elementTypeNumberMap;
 
+    /**
+       Holds m_tiles, followed by any storage they need beyond
+       sizeof(GridTile) (see SizedTile<EC,0>) -- one slot per Tile,
+       plus one for m_heroTile -- on huge pages if possible.
+     */
+    HugePageBlock m_tileBlock;
     GridTile * const m_tiles;
+
+    static u64 CacheLineRound(u64 bytes)
+    {
+      return (bytes + 63) & ~(u64) 63;
+    }
+
+    u64 GetTileStorageBytes() const
+    {
+      return CacheLineRound(GridTile::StorageBytes(m_tileSide));
+    }
+
+    /**
+       The storage for Tile \c index of m_tiles, or for m_heroTile if
+       \c index is the number of Tiles.
+     */
+    void * GetTileStorage(u32 index) const
+    {
+      const u64 tilesBytes = CacheLineRound(((u64) m_width) * m_height * sizeof(GridTile));
+      return ((u8 *) m_tiles) + tilesBytes + index * GetTileStorageBytes();
+    }
+
+    GridTile * NewTiles(u32 count)
+    {
+      const u64 tilesBytes = CacheLineRound(((u64) count) * sizeof(GridTile));
+      GridTile * tiles = (GridTile *)
+        m_tileBlock.Allocate(tilesBytes + (count + 1) * GetTileStorageBytes());
+      const u8 * storage = ((u8 *) tiles) + tilesBytes;
+      for (u32 i = 0; i < count; ++i)
+      {
+        new (&tiles[i]) GridTile(m_tileSide, (void *) (storage + i * GetTileStorageBytes()));
+      }
+      return tiles;
+    }
+
     GridTile & _getTile(u32 x, u32 y) { return m_tiles[x*m_height + y]; }
     const GridTile & _getTile(u32 x, u32 y) const { return m_tiles[x*m_height + y]; }
 
@@ -99,6 +192,99 @@ namespace MFM {
       Grid* m_gridPtr;
       pthread_t m_threadId;
       GridTransceiver m_channels[4]; // 4: NE, E, SE, S == dir-Dirs::NORTHEAST
+      u64 m_lastSnapshotNS;
+      u64 m_lastAtomCountNS;
+
+      /**
+         Channels from this driver's Tile to Tiles in other processes,
+         indexed by Dir, or null.  Advanced by this driver's thread.
+       */
+      SocketChannel * m_sockets[Dirs::DIR_COUNT];
+
+      /**
+         Shared memory channels standing in for m_channels where the
+         Tile pair straddles processes, indexed likewise, or null.
+       */
+      SharedMemoryChannel * m_sharedChannels[4];
+
+      /**
+         The shared memory channels this driver's Tile uses, from
+         either end's m_sharedChannels, indexed by Dir, or null.
+       */
+      SharedMemoryChannel * m_sharedLinks[Dirs::DIR_COUNT];
+
+      s32 m_cpu;           // Pinned to this CPU, if nonnegative
+      u32 m_numaNode;      // The NUMA node of m_cpu
+
+      TileDriver()
+        : m_cpu(-1)
+        , m_numaNode(0)
+      {
+        for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+        {
+          m_sockets[d] = 0;
+          m_sharedLinks[d] = 0;
+        }
+        for (u32 c = 0; c < 4; ++c)
+        {
+          m_sharedChannels[c] = 0;
+        }
+      }
+
+      ~TileDriver()
+      {
+        for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+        {
+          delete m_sockets[d];
+        }
+        for (u32 c = 0; c < 4; ++c)
+        {
+          delete m_sharedChannels[c];
+        }
+      }
+
+      /**
+         If our Tile is waiting on a Tile in another process for
+         something to arrive over shared memory (see
+         CacheProcessor::IsWaitingForPeer), sleep until it does, or
+         for at most \c timeoutUsec microseconds in all, and return
+         true.  Otherwise return false at once.  With several links
+         waiting, each gets a turn at the sleep, and any that can
+         already be read ends it.
+       */
+      bool WaitForSharedLink(u32 timeoutUsec)
+      {
+        Tile<EC> & tile = GetTile();
+        Dir waiting[Dirs::DIR_COUNT];
+        u32 count = 0;
+        for (Dir d = 0; d < Dirs::DIR_COUNT; ++d)
+        {
+          if (!m_sharedLinks[d] || !tile.GetCacheProcessor(d).IsWaitingForPeer())
+          {
+            continue;
+          }
+          if (m_sharedLinks[d]->CanRead(IsSideA(d)) > 0)
+          {
+            return true;  // Already here
+          }
+          waiting[count++] = d;
+        }
+
+        for (u32 i = 0; i < count; ++i)
+        {
+          const Dir d = waiting[i];
+          if (m_sharedLinks[d]->WaitToRead(IsSideA(d), timeoutUsec / count))
+          {
+            break;
+          }
+        }
+        return count > 0;
+      }
+
+      static bool IsSideA(Dir d)
+      {
+        return d >= Dirs::NORTHEAST && d <= Dirs::SOUTH;
+      }
 
       State GetState()
       {
@@ -125,8 +311,46 @@ namespace MFM {
     }
 
     bool m_threadsInitted;
+    bool m_gridRunning;  // Tile threads advancing, per SetGridRunning
     static void * TileDriverRunner(void *) ;
 
+    u64 m_snapshotPeriodNS;  // 0 means no tile snapshots
+
+    IntertileMode m_intertileMode;  // As of the last Init
+
+    u32 m_intertileBufferSize;  // Of each GridTransceiver direction
+
+    ThreadPlacement m_threadPlacement;  // For the next InitThreads
+
+    enum { MAX_PARTITIONS = 64 };
+
+    /**
+       This process runs only the Tiles in the m_localColumns columns
+       starting at m_firstLocalColumn (see ForkPartitions).
+     */
+    u32 m_firstLocalColumn;
+    u32 m_localColumns;
+    u32 m_partition;      // Which of m_partitions this process runs
+    u32 m_partitions;
+    u32 m_partitionSharedBytes;  // Shared memory channel size; 0 for sockets
+    pid_t m_childPids[MAX_PARTITIONS];  // In partition 0 only
+
+    u32 GetPartitionFirstColumn(u32 partition) const
+    {
+      return partition * m_width / m_partitions;
+    }
+
+    u32 GetPartitionOfColumn(u32 column) const
+    {
+      u32 partition = 0;
+      while (partition + 1 < m_partitions &&
+             GetPartitionFirstColumn(partition + 1) <= column)
+      {
+        ++partition;
+      }
+      return partition;
+    }
+
     bool m_backgroundRadiationEnabled;
 
     ElementRegistry<EC> m_er;
@@ -285,6 +509,72 @@ namespace MFM {
       m_heroTile.SetWarpFactor(wf);
     }
 
+    /**
+     * Has every Tile time the phases of one in every \c oneIn of its
+     * events, or of none if \c oneIn is 0 (see
+     * Tile::SetPhaseSampleOdds).  Call only while the Grid is paused.
+     */
+    void SetPhaseSampleOdds(u32 oneIn) ;
+
+    u32 GetPhaseSampleOdds() const
+    {
+      return m_heroTile.GetPhaseSampleOdds();
+    }
+
+    /**
+     * Starts or stops profiling Element behaviors in every Tile (see
+     * ElementTable::SetProfiling).  Call only while the Grid is
+     * paused.
+     */
+    void SetElementProfiling(bool on) ;
+
+    bool IsElementProfiling() const
+    {
+      return m_heroTile.IsElementProfiling();
+    }
+
+    /**
+     * Sets how many cache updates each CacheProcessor may have
+     * awaiting replies at once, 1 for the classic protocol (see
+     * CacheProcessor::SetPipelineDepth).  Call only while the Grid is
+     * paused.
+     */
+    void SetCachePipelineDepth(u32 depth) ;
+
+    u32 GetCachePipelineDepth() const
+    {
+      return m_heroTile.GetCachePipelineDepth();
+    }
+
+    /**
+     * Has every CacheProcessor verify its peer's copy of the strip
+     * only they share by a digest every \c period updates, or by
+     * CHECK packets if \c period is 0 (see
+     * CacheProcessor::SetDigestPeriod).  Call only while the Grid is
+     * paused.
+     */
+    void SetCacheDigestPeriod(u32 period) ;
+
+    u32 GetCacheDigestPeriod() const
+    {
+      return m_heroTile.GetCacheDigestPeriod();
+    }
+
+    /**
+     * Has each Tile's thread publish a snapshot of its sites about
+     * every \c periodMS milliseconds while the Grid is running, for
+     * readers that cannot wait for the Grid to pause.  Call only
+     * while the Grid is paused.
+     *
+     * @see Tile::AcquireSnapshot
+     */
+    void SetSnapshotPeriodMS(u32 periodMS) ;
+
+    bool IsSnapshotting() const
+    {
+      return m_snapshotPeriodNS != 0;
+    }
+
     double GetAverageCacheRedundancy() const;
     void SetCacheRedundancy(u32 redundancyOddsType) ;
 
@@ -301,14 +591,33 @@ namespace MFM {
 
     void SetSeed(u32 seed);
 
-    Grid(ElementRegistry<EC>& elts, u32 width, u32 height)
+    /**
+     * Makes a Grid of width x height Tiles, each \c tileSide sites
+     * on a side, caches included.  \c tileSide must be TILE_SIDE,
+     * unless that is 0, in which case it may be any even number from
+     * MIN_TILE_SIDE to MAX_TILE_SIDE.
+     */
+    Grid(ElementRegistry<EC>& elts, u32 width, u32 height, u32 tileSide = TILE_SIDE)
       : m_seed(0)
       , m_width(width)
       , m_height(height)
-      , m_tiles(new GridTile[m_width * m_height])
+      , m_tileSide(CheckTileSide(tileSide))
+      , m_ownedSide(m_tileSide - 2 * R)
+      , m_tiles(NewTiles(m_width * m_height))
       , m_intertileLocks(new LonglivedLock[m_width * m_height * 3])
-      , m_tileDrivers(new TileDriver[m_width * m_height * 3])
+      , m_heroTile(m_tileSide, GetTileStorage(m_width * m_height))
+      , m_tileDrivers(new TileDriver[m_width * m_height])
       , m_threadsInitted(false)
+      , m_gridRunning(false)
+      , m_snapshotPeriodNS(0)
+      , m_intertileMode(INTERTILE_PACKETS)
+      , m_intertileBufferSize(GridTransceiver::DEFAULT_BUFFER_SIZE)
+      , m_threadPlacement(PLACE_ANYWHERE)
+      , m_firstLocalColumn(0)
+      , m_localColumns(width)
+      , m_partition(0)
+      , m_partitions(1)
+      , m_partitionSharedBytes(0)
       , m_backgroundRadiationEnabled(false)
       , m_er(elts)
       , m_xraySiteOdds(1000)
@@ -325,7 +634,139 @@ namespace MFM {
       return &m_xraySiteOdds;
     }
 
-    void Init();
+    /**
+     * Initializes every Tile and connects each to its neighbors.
+     * With INTERTILE_DIRECT, each pair of neighboring Tiles updates
+     * each other's caches by writing into them directly, while
+     * holding the lock they share, rather than by packets (see
+     * CacheProcessor::SetDirectPeer).  Direct mode requires every
+     * Tile of the Grid to live in this process, which is always the
+     * case today; it trades the packet protocol's consistency checks
+     * for skipping its shipping, replies, and BLOCKING.
+     */
+    void Init(IntertileMode mode = INTERTILE_PACKETS);
+
+    IntertileMode GetIntertileMode() const
+    {
+      return m_intertileMode;
+    }
+
+    /**
+     * Sets the size of the buffer Init gives each direction of each
+     * GridTransceiver connecting neighboring Tiles.  Only connected
+     * GridTransceivers get buffers, so border Tiles pay nothing for
+     * the neighbors they lack.
+     *
+     * @fails ILLEGAL_ARGUMENT if bytes is not a power of two in
+     *        GridTransceiver::MIN_BUFFER_SIZE..MAX_BUFFER_SIZE, or
+     *        ILLEGAL_STATE if the threads have already started
+     */
+    void SetIntertileBufferSize(u32 bytes)
+    {
+      MFM_API_ASSERT_STATE(!m_threadsInitted);
+      MFM_API_ASSERT_ARG(bytes >= GridTransceiver::MIN_BUFFER_SIZE &&
+                         bytes <= GridTransceiver::MAX_BUFFER_SIZE &&
+                         (bytes & (bytes - 1)) == 0);
+      m_intertileBufferSize = bytes;
+    }
+
+    u32 GetIntertileBufferSize() const
+    {
+      return m_intertileBufferSize;
+    }
+
+    /**
+     * Sets where InitThreads will run the Tile threads.  Placements
+     * other than PLACE_ANYWHERE spread the Tiles, column by column,
+     * evenly over the CPUs this process may use, taken node by node
+     * (see CpuPlacement), so that neighboring Tiles -- and the Tiles
+     * of each ForkPartitions partition -- share a NUMA node where
+     * possible, and cross-node traffic is mostly at node boundaries.
+     *
+     * @fails ILLEGAL_STATE if the threads have already started
+     */
+    void SetThreadPlacement(ThreadPlacement placement)
+    {
+      MFM_API_ASSERT_STATE(!m_threadsInitted);
+      m_threadPlacement = placement;
+    }
+
+    ThreadPlacement GetThreadPlacement() const
+    {
+      return m_threadPlacement;
+    }
+
+    /**
+     * Splits this Grid's Tiles among \c processes processes, each
+     * running a strip of whole columns, by forking \c processes - 1
+     * children of this one.  Every Tile pair that straddles a strip
+     * boundary gets a socketpair -- or, if \c sharedMemoryBytes is
+     * nonzero, a SharedMemoryChannel of that capacity -- and in Init
+     * the two processes' Tiles connect through it with remote locks
+     * (see CacheProcessor::SetRemoteLock) instead of through a
+     * GridTransceiver.  Each process still allocates and Inits the
+     * whole Grid -- so a Grid too big for one process's memory is too
+     * big for ForkPartitions as well -- but starts threads for,
+     * drives, and controls only its own Tiles, so Pause, Unpause, and
+     * the totals over all Tiles (which are zero for Tiles not run
+     * here) are per-process.
+     *
+     * Call at most once, before Init and before this process has
+     * started any threads.
+     *
+     * @returns This process's partition number, 0 in the original
+     *          process and 1..processes-1 in the children.
+     *
+     * @fails ILLEGAL_ARGUMENT if processes is 0 or exceeds the
+     *        Grid's width, or ILLEGAL_STATE if the sockets or
+     *        processes cannot be made.
+     */
+    u32 ForkPartitions(u32 processes, u32 sharedMemoryBytes = 0) ;
+
+    /**
+     * In partition 0 of a Grid split by ForkPartitions, waits for
+     * every other partition's process to exit.  Does nothing in the
+     * other partitions.
+     */
+    void WaitForPartitions() ;
+
+    u32 GetPartition() const
+    {
+      return m_partition;
+    }
+
+    u32 GetPartitions() const
+    {
+      return m_partitions;
+    }
+
+    /**
+     * Returns the capacity of the shared memory channels between
+     * partitions, or 0 if they are connected by sockets.
+     */
+    u32 GetPartitionSharedMemoryBytes() const
+    {
+      return m_partitionSharedBytes;
+    }
+
+    /**
+     * Returns true if the Tile at \c tileInGrid is run by this
+     * process, which is every Tile unless ForkPartitions was used.
+     */
+    bool IsLocalTile(const SPoint & tileInGrid) const
+    {
+      return (u32) tileInGrid.GetX() >= m_firstLocalColumn &&
+        (u32) tileInGrid.GetX() < m_firstLocalColumn + m_localColumns;
+    }
+
+    /**
+     * Return the number of (non-cache) sites in the Tiles run by
+     * this process; GetTotalSites unless ForkPartitions was used.
+     */
+    u32 GetLocalSites() const
+    {
+      return m_localColumns * m_ownedSide * GetHeightSites();
+    }
 
     /**
        Init the 'TileDriver' threads.  This is done separately from
@@ -433,7 +874,10 @@ namespace MFM {
 
     ~Grid()
     {
-      delete [] m_tiles;
+      for (u32 i = 0; i < m_width * m_height; ++i)
+      {
+        m_tiles[i].~GridTile();
+      }
       delete [] m_intertileLocks;
       delete [] m_tileDrivers;
     }
@@ -526,7 +970,7 @@ namespace MFM {
      */
     u32 GetHeightSites() const
     {
-      return GetHeight() * OWNED_SIDE;
+      return GetHeight() * m_ownedSide;
     }
 
     /**
@@ -534,7 +978,23 @@ namespace MFM {
      */
     u32 GetWidthSites() const
     {
-      return GetWidth() * OWNED_SIDE;
+      return GetWidth() * m_ownedSide;
+    }
+
+    /**
+     * Return the side of each Tile in sites, caches included
+     */
+    u32 GetTileSide() const
+    {
+      return m_tileSide;
+    }
+
+    /**
+     * Return the side of each Tile in (non-cache) sites
+     */
+    u32 GetOwnedSide() const
+    {
+      return m_ownedSide;
     }
 
     /**
@@ -545,6 +1005,10 @@ namespace MFM {
       LOG.Message("Sending exit requests to the tiles");
       for (iterator_type i = begin(); i != end(); ++i)
       {
+        if (!IsLocalTile(SPoint(i.GetX(), i.GetY())))
+        {
+          continue;
+        }
         TileDriver & td = _getTileDriver(i.GetX(),i.GetY());
         td.SetState(TileDriver::EXIT_REQUEST);
       }
@@ -629,18 +1093,68 @@ namespace MFM {
     inline const Tile<EC> & GetTile(u32 x, u32 y) const
     { return _getTile(x,y); }
 
+    /**
+     * Returns the memory holding the Tiles, to see whether and how
+     * much of it is on huge pages.
+     */
+    const HugePageBlock & GetTileBlock() const
+    {
+      return m_tileBlock;
+    }
+
     /* Don't count caches! */
     inline const u32 GetTotalSites()
     { return GetWidthSites() * GetHeightSites(); }
 
     u64 GetTotalEventsExecuted() const;
 
+    /**
+     * Sets \c counters to the sum of the hot-path counters of every
+     * Tile in this Grid.  Approximate if the Grid is running.
+     */
+    void GetTotalCounters(TileCounters & counters) const;
+
+    /**
+     * Sets \c histograms to the sum of the event phase histograms of
+     * every Tile in this Grid.  Approximate if the Grid is running.
+     */
+    void GetTotalPhaseHistograms(PhaseHistograms & histograms) const;
+
+    /**
+     * Sets \c profile to the sum of the ElementProfile of the Element
+     * of type \c elementType in every Tile in this Grid.
+     * Approximate if the Grid is running.
+     */
+    void GetTotalElementProfile(u32 elementType, ElementProfile & profile) const;
+
+    /**
+     * Gets the sum over every Tile of slot \c slot of the \c
+     * outOfSlots u64's of element-specific data of the Element of
+     * type \c elementType (see ElementTable::GetDataAndRegister), or
+     * 0 if no Tile has such data.  Approximate if the Grid is
+     * running.
+     */
+    u64 GetTotalElementData(u32 elementType, u32 slot, u32 outOfSlots) ;
+
     void WriteEPSImage(ByteSink & outstrm) const;
 
     void WriteEPSAverageImage(ByteSink & outstrm) const;
 
     void ResetEPSCounts();
 
+    /**
+     * How often, at most, each Tile's thread publishes its atom
+     * counts while the Grid is running (see GetAtomCount).
+     */
+    static const u64 ATOM_COUNT_PERIOD_NS = 50 * 1000 * 1000;
+
+    /**
+     * Counts the atoms of type \c atomType in this Grid.  While the
+     * Grid is running, this sums the counts each Tile's thread last
+     * published, up to ATOM_COUNT_PERIOD_NS old, rather than touching
+     * the Tiles; while it is paused, it recounts any Tile that has
+     * changed.
+     */
     u32 GetAtomCount(ElementType atomType) const;
 
     /**
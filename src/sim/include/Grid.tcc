@@ -3,6 +3,11 @@
 #include "Grid.h"
 #include "Utils.h"   /* For Sleep */
 #include "FileByteSink.h"
+#include <errno.h>       /* For errno */
+#include <string.h>      /* For strerror */
+#include <unistd.h>      /* For fork, close */
+#include <sys/socket.h>  /* For socketpair */
+#include <sys/wait.h>    /* For waitpid */
 
 #define XRAY_BIT_ODDS 100
 
@@ -57,7 +62,9 @@ namespace MFM {
   }
 
   template <class GC>
-  void Grid<GC>::Init() {
+  void Grid<GC>::Init(IntertileMode mode) {
+
+    m_intertileMode = mode;
 
     /* Reseed grid PRNG and push seeds to the tile PRNGs */
     InitSeed();
@@ -108,9 +115,75 @@ namespace MFM {
           Dir odir = Dirs::OppositeDir(d);
           LonglivedLock & otl = GetIntertileLock(npt.GetX(),npt.GetY(),odir);
 
+          // Pairs straddling partitions connect our side by socket
+          if (IsLocalTile(tpt) != IsLocalTile(npt))
+          {
+            // Crossing diagonals share a corner lock (see
+            // GetIntertileLock), so the NE one speaks for both
+            SPoint apt = tpt;
+            Dir ad = d;
+            SPoint spt = tpt + Dirs::GetOffset(Dirs::SOUTH);
+            if (d == Dirs::SOUTHEAST && IsLegalTileIndex(spt))
+            {
+              apt = spt;
+              ad = Dirs::NORTHEAST;
+            }
+
+            // Use shared memory if we made it, else a socket
+            SharedMemoryChannel * shared = td.m_sharedChannels[d - Dirs::NORTHEAST];
+
+            // The left side starts out holding every shared lock
+            if (IsLocalTile(tpt))
+            {
+              td.m_sharedLinks[d] = shared;
+              if (shared)
+              {
+                ctile.Connect(*shared, ctl, d);
+              }
+              else
+              {
+                ctile.Connect(*td.m_sockets[d], ctl, d);
+              }
+              ctile.GetCacheProcessor(d).
+                SetRemoteLock(true, GetTile(apt).GetCacheProcessor(ad));
+            }
+            else
+            {
+              TileDriver & otd = _getTileDriver(npt.GetX(),npt.GetY());
+              otd.m_sharedLinks[odir] = shared;
+              if (shared)
+              {
+                otile.Connect(*shared, otl, odir);
+              }
+              else
+              {
+                otile.Connect(*otd.m_sockets[odir], otl, odir);
+              }
+              otile.GetCacheProcessor(odir).
+                SetRemoteLock(false, GetTile(apt + Dirs::GetOffset(ad)).
+                              GetCacheProcessor(Dirs::OppositeDir(ad)));
+            }
+            continue;
+          }
+
+          if (!IsLocalTile(tpt))
+          {
+            continue;
+          }
+
           ctile.Connect(gt, ctl, d);
           otile.Connect(gt, otl, odir);
 
+          if (m_intertileMode == INTERTILE_DIRECT)
+          {
+            CacheProcessor<EC> & ccp = ctile.GetCacheProcessor(d);
+            CacheProcessor<EC> & ocp = otile.GetCacheProcessor(odir);
+            ccp.SetDirectPeer(ocp);
+            ocp.SetDirectPeer(ccp);
+          }
+
+          gt.SetEnabled(false);
+          gt.SetBufferSize(m_intertileBufferSize);
           gt.SetEnabled(true);
           gt.SetDataRate(100000000);
           gt.SetMaxInFlight(0);
@@ -119,6 +192,133 @@ namespace MFM {
     }
   }
 
+  template <class GC>
+  u32 Grid<GC>::ForkPartitions(u32 processes, u32 sharedMemoryBytes)
+  {
+    MFM_API_ASSERT_ARG(processes > 0 && processes <= m_width && processes <= MAX_PARTITIONS);
+    MFM_API_ASSERT_STATE(m_partitions == 1 && !m_threadsInitted);
+
+    m_partitions = processes;
+    m_partitionSharedBytes = sharedMemoryBytes;
+
+    // One socketpair or shared memory channel for each Tile pair
+    // straddling a partition boundary, visited as Init connects them
+    for(u32 x = 0; x < m_width; x++)
+    {
+      for(u32 y = 0; y < m_height; y++)
+      {
+        for (Dir d = Dirs::NORTHEAST; d <= Dirs::SOUTH; ++d)
+        {
+          SPoint tpt(x,y);
+          SPoint npt = tpt + Dirs::GetOffset(d);
+          if (!IsLegalTileIndex(npt) ||
+              GetPartitionOfColumn(x) == GetPartitionOfColumn(npt.GetX()))
+          {
+            continue;
+          }
+
+          TileDriver & td = _getTileDriver(x,y);
+          if (sharedMemoryBytes > 0)
+          {
+            SharedMemoryChannel * & shared = td.m_sharedChannels[d - Dirs::NORTHEAST];
+            shared = new SharedMemoryChannel();
+            shared->Create(sharedMemoryBytes);
+            continue;
+          }
+
+          int fds[2];
+          if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds))
+          {
+            LOG.Error("Can't make socketpair: %s", strerror(errno));
+            FAIL(ILLEGAL_STATE);
+          }
+
+          TileDriver & otd = _getTileDriver(npt.GetX(),npt.GetY());
+          td.m_sockets[d] = new SocketChannel();
+          td.m_sockets[d]->Open(fds[0], true);
+          otd.m_sockets[Dirs::OppositeDir(d)] = new SocketChannel();
+          otd.m_sockets[Dirs::OppositeDir(d)]->Open(fds[1], false);
+        }
+      }
+    }
+
+    // Flush stdio so children don't repeat our buffered output
+    fflush(NULL);
+
+    m_partition = 0;
+    for (u32 p = 1; p < processes; ++p)
+    {
+      pid_t pid = fork();
+      if (pid < 0)
+      {
+        LOG.Error("Can't fork partition %d: %s", p, strerror(errno));
+        FAIL(ILLEGAL_STATE);
+      }
+      if (pid == 0)
+      {
+        m_partition = p;
+        break;
+      }
+      m_childPids[p] = pid;
+    }
+
+    m_firstLocalColumn = GetPartitionFirstColumn(m_partition);
+    m_localColumns =
+      (m_partition + 1 < m_partitions ? GetPartitionFirstColumn(m_partition + 1) : m_width)
+      - m_firstLocalColumn;
+
+    // Keep only the socket ends of our own Tiles, and the shared
+    // memory channels with one of our Tiles at either end
+    for(u32 x = 0; x < m_width; x++)
+    {
+      for(u32 y = 0; y < m_height; y++)
+      {
+        SPoint tpt(x,y);
+        TileDriver & td = _getTileDriver(x,y);
+        for (Dir d = Dirs::NORTHEAST; d <= Dirs::SOUTH; ++d)
+        {
+          SharedMemoryChannel * & shared = td.m_sharedChannels[d - Dirs::NORTHEAST];
+          if (shared && !IsLocalTile(tpt) && !IsLocalTile(tpt + Dirs::GetOffset(d)))
+          {
+            delete shared;
+            shared = 0;
+          }
+        }
+
+        if (IsLocalTile(tpt))
+        {
+          continue;
+        }
+        for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+        {
+          delete td.m_sockets[d];
+          td.m_sockets[d] = 0;
+        }
+      }
+    }
+
+    LOG.Message("Partition %d of %d running tile columns %d..%d",
+                m_partition, m_partitions,
+                m_firstLocalColumn, m_firstLocalColumn + m_localColumns - 1);
+    return m_partition;
+  }
+
+  template <class GC>
+  void Grid<GC>::WaitForPartitions()
+  {
+    if (m_partition != 0)
+    {
+      return;
+    }
+
+    for (u32 p = 1; p < m_partitions; ++p)
+    {
+      int status;
+      while (waitpid(m_childPids[p], &status, 0) < 0 && errno == EINTR)
+      { }
+    }
+  }
+
   template <class GC>
   double Grid<GC>::GetAverageCacheRedundancy() const
   {
@@ -165,14 +365,40 @@ namespace MFM {
       FAIL(ILLEGAL_STATE);
     }
 
+    CpuPlacement cpus;
+    if (m_threadPlacement != PLACE_ANYWHERE)
+    {
+      cpus.Init();
+    }
+
     /* Init the tile thread drivers */
     for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
     {
       SPoint tpt = IteratorIndexToCoord(m_rgi.Next());
+      if (!IsLocalTile(tpt))
+      {
+        continue;
+      }
       TileDriver & td = _getTileDriver(tpt.GetX(),tpt.GetY());
       td.m_loc = tpt;
       td.m_gridPtr = this;
+      td.m_lastSnapshotNS = 0;
+      td.m_lastAtomCountNS = 0;
+
+      if (cpus.GetCpuCount() > 0)
+      {
+        // Consecutive Tiles, column by column, get consecutive slots
+        u64 index = tpt.GetX() * m_height + tpt.GetY();
+        u32 slot = (u32) (index * cpus.GetCpuCount() / (m_width * m_height));
+        td.m_cpu = cpus.GetCpu(slot);
+        td.m_numaNode = cpus.GetNode(slot);
+      }
       td.SetState(TileDriver::PAUSED);
+
+      // Request passive here, not in the new thread, where it could
+      // clobber an Unpause request made before the thread got going
+      td.GetTile().RequestStatePassive();
+
       if (pthread_create(&td.m_threadId, NULL, TileDriverRunner, &td))
       {
         FAIL(ILLEGAL_STATE);
@@ -188,15 +414,37 @@ namespace MFM {
     //    /* Notify the transceivers */
     //    m_gtDriver.SetState(running ? GTDriver::ADVANCING : GTDriver::PAUSED);
 
+    m_gridRunning = running;
+
     /* Notify the Tiles */
     for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
     {
       SPoint tpt = IteratorIndexToCoord(m_rgi.Next());
+      if (!IsLocalTile(tpt))
+      {
+        continue;
+      }
       TileDriver & td = _getTileDriver(tpt.GetX(),tpt.GetY());
       td.SetState(running? TileDriver::ADVANCING : TileDriver::PAUSED);
     }
   }
 
+  template <class GC>
+  void Grid<GC>::SetSnapshotPeriodMS(u32 periodMS)
+  {
+    if (periodMS > 0)
+    {
+      for (u32 x = 0; x < m_width; ++x)
+      {
+        for (u32 y = 0; y < m_height; ++y)
+        {
+          _getTile(x, y).InitSnapshots();
+        }
+      }
+    }
+    m_snapshotPeriodNS = ((u64) periodMS) * 1000000;
+  }
+
   template <class GC>
   void* Grid<GC>::TileDriverRunner(void * arg)
   {
@@ -212,7 +460,36 @@ namespace MFM {
               td->m_loc.GetY(),
               ctile.GetLabel());
 
-    ctile.RequestStatePassive();
+    if (td->m_cpu >= 0)
+    {
+      if (!CpuPlacement::PinThisThread(td->m_cpu))
+      {
+        LOG.Warning("Tile %s can't be pinned to CPU %d", ctile.GetLabel(), td->m_cpu);
+      }
+
+      // Now that we're there, bring our memory to our node
+      if (td->m_gridPtr->m_threadPlacement == PLACE_NUMA)
+      {
+        Grid & grid = *td->m_gridPtr;
+        const u32 x = td->m_loc.GetX(), y = td->m_loc.GetY();
+        GridTile & gt = grid._getTile(x, y);
+        const u64 blockPage = grid.m_tileBlock.GetPageBytes();
+        bool moved =
+          CpuPlacement::MoveToNode(&gt, sizeof(gt), td->m_numaNode, blockPage) &&
+          CpuPlacement::MoveToNode(grid.GetTileStorage(x * grid.m_height + y),
+                                   grid.GetTileStorageBytes(), td->m_numaNode, blockPage) &&
+          CpuPlacement::MoveToNode(td, sizeof(*td), td->m_numaNode);
+        for (u32 c = 0; c < 4; ++c)
+        {
+          moved = moved && td->m_channels[c].MoveToNode(td->m_numaNode);
+        }
+        if (!moved)
+        {
+          LOG.Warning("Tile %s memory can't be moved to NUMA node %d",
+                      ctile.GetLabel(), td->m_numaNode);
+        }
+      }
+    }
 
     bool running = true;
     while (running)
@@ -230,19 +507,53 @@ namespace MFM {
         clock_gettime(CLOCK_MONOTONIC, &now);
         for (u32 c = 0; c < 4; ++c)
         {
-          td->m_channels[c].AdvanceToTime(now);
+          if (td->m_channels[c].IsEnabled())
+          {
+            td->m_channels[c].AdvanceToTime(now);
+          }
+        }
+        for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+        {
+          if (td->m_sockets[d])
+          {
+            td->m_sockets[d]->Advance();
+          }
+        }
+
+        // Publish a snapshot for renderers, if it's time
+        const u64 nowNS = ((u64) now.tv_sec) * 1000000000 + now.tv_nsec;
+        const u64 period = td->m_gridPtr->m_snapshotPeriodNS;
+        if (period && nowNS - td->m_lastSnapshotNS >= period)
+        {
+          ctile.PublishSnapshot();
+          td->m_lastSnapshotNS = nowNS;
+        }
+
+        // And atom counts for the driver, likewise
+        if (nowNS - td->m_lastAtomCountNS >= ATOM_COUNT_PERIOD_NS)
+        {
+          ctile.PublishAtomCounts();
+          td->m_lastAtomCountNS = nowNS;
         }
 
         // Drive the tile itself
         if (!ctile.Advance())
         {
-          // We accomplished nothing.  Let somebody else try
-          pthread_yield();
+          // We accomplished nothing.  If that's for want of bytes
+          // from another process, doze until they come; otherwise
+          // let somebody else try
+          if (!td->WaitForSharedLink(100))
+          {
+            pthread_yield();
+          }
         }
         break;
       }
 
       case TileDriver::PAUSED:
+        // Publish again as soon as we resume, to show any edits
+        td->m_lastSnapshotNS = 0;
+
         // Sleep a little
         SleepUsec(ctile.GetRandom().Between(10,100));  // 0.01ms..1ms
         break;
@@ -315,7 +626,7 @@ namespace MFM {
     }
 
     Tile<EC> & owner = GetTile(tileInGrid);
-    Site<AC> & site = owner.GetSite(siteInTile);
+    typename EC::SITE & site = owner.GetSite(siteInTile);
     site.Sense(gte.m_touchType);
   }
 
@@ -335,7 +646,7 @@ namespace MFM {
     if (siteInGrid.GetX() < 0 || siteInGrid.GetY() < 0)
       return false;
 
-    SPoint t = siteInGrid/OWNED_SIDE;
+    SPoint t = siteInGrid/m_ownedSide;
 
     if (!IsLegalTileIndex(t))
       return false;
@@ -343,7 +654,7 @@ namespace MFM {
     // Set up return values
     tileInGrid = t;
     siteInTile =
-      siteInGrid % OWNED_SIDE;  // get index into just 'owned' sites
+      siteInGrid % m_ownedSide;  // get index into just 'owned' sites
     return true;
   }
 
@@ -394,7 +705,7 @@ namespace MFM {
       // (excluding caches) maps into including-cache coords on their
       // side.  Hmm.
 
-      SPoint otherIndex = siteInTile - tileOffset * OWNED_SIDE;
+      SPoint otherIndex = siteInTile - tileOffset * m_ownedSide;
 
       other.PlaceAtom(atom,otherIndex);
     }
@@ -454,6 +765,10 @@ namespace MFM {
     for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
     {
       SPoint i = IteratorIndexToCoord(m_rgi.Next());
+      if (!IsLocalTile(i))
+      {
+        continue;
+      }
       u32 x = i.GetX();
       u32 y = i.GetY();
       TileDriver & td = _getTileDriver(x,y);
@@ -470,6 +785,10 @@ namespace MFM {
     for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
     {
       SPoint i = IteratorIndexToCoord(m_rgi.Next());
+      if (!IsLocalTile(i))
+      {
+        continue;
+      }
       u32 x = i.GetX();
       u32 y = i.GetY();
       TileDriver & td = _getTileDriver(x,y);
@@ -508,6 +827,10 @@ namespace MFM {
       for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
       {
         SPoint i = IteratorIndexToCoord(m_rgi.Next());
+        if (!IsLocalTile(i))
+        {
+          continue;
+        }
         u32 x = i.GetX();
         u32 y = i.GetY();
         TileDriver & td = _getTileDriver(x,y);
@@ -530,6 +853,10 @@ namespace MFM {
     for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
     {
       SPoint i = IteratorIndexToCoord(m_rgi.Next());
+      if (!IsLocalTile(i))
+      {
+        continue;
+      }
       u32 x = i.GetX();
       u32 y = i.GetY();
       TileDriver & td = _getTileDriver(x,y);
@@ -557,6 +884,80 @@ namespace MFM {
     return total;
   }
 
+  template <class GC>
+  void Grid<GC>::GetTotalCounters(TileCounters & counters) const
+  {
+    counters.Clear();
+    for (const_iterator_type i = begin(); i != end(); ++i)
+      i->AddCounters(counters);
+  }
+
+  template <class GC>
+  void Grid<GC>::SetPhaseSampleOdds(u32 oneIn)
+  {
+    m_heroTile.SetPhaseSampleOdds(oneIn);
+    for (iterator_type i = begin(); i != end(); ++i)
+      i->SetPhaseSampleOdds(oneIn);
+  }
+
+  template <class GC>
+  void Grid<GC>::SetCachePipelineDepth(u32 depth)
+  {
+    m_heroTile.SetCachePipelineDepth(depth);
+    for (iterator_type i = begin(); i != end(); ++i)
+      i->SetCachePipelineDepth(depth);
+  }
+
+  template <class GC>
+  void Grid<GC>::SetCacheDigestPeriod(u32 period)
+  {
+    m_heroTile.SetCacheDigestPeriod(period);
+    for (iterator_type i = begin(); i != end(); ++i)
+      i->SetCacheDigestPeriod(period);
+  }
+
+  template <class GC>
+  void Grid<GC>::SetElementProfiling(bool on)
+  {
+    m_heroTile.SetElementProfiling(on);
+    for (iterator_type i = begin(); i != end(); ++i)
+      i->SetElementProfiling(on);
+  }
+
+  template <class GC>
+  void Grid<GC>::GetTotalElementProfile(u32 elementType, ElementProfile & profile) const
+  {
+    profile.Clear();
+    for (const_iterator_type i = begin(); i != end(); ++i)
+    {
+      const ElementProfile * p = i->GetElementTable().GetProfile(elementType);
+      if (p)
+        profile.Add(*p);
+    }
+  }
+
+  template <class GC>
+  u64 Grid<GC>::GetTotalElementData(u32 elementType, u32 slot, u32 outOfSlots)
+  {
+    MFM_API_ASSERT_ARG(slot < outOfSlots);
+    u64 sum = 0;
+    for (iterator_type i = begin(); i != end(); ++i)
+    {
+      const u64 * eds = i->GetElementTable().GetDataIfRegistered(elementType, outOfSlots);
+      if (eds)
+        sum += eds[slot];
+    }
+    return sum;
+  }
+
+  template <class GC>
+  void Grid<GC>::GetTotalPhaseHistograms(PhaseHistograms & histograms) const
+  {
+    histograms.Clear();
+    for (const_iterator_type i = begin(); i != end(); ++i)
+      histograms.Add(i->GetPhaseHistograms());
+  }
+
   template <class GC>
   void Grid<GC>::WriteEPSImage(ByteSink & outstrm) const
   {
@@ -586,8 +987,8 @@ namespace MFM {
   void Grid<GC>::WriteEPSAverageImage(ByteSink & outstrm) const
   {
     u64 max = 0;
-    const u32 swidth = OWNED_SIDE;
-    const u32 sheight = OWNED_SIDE;
+    const u32 swidth = m_ownedSide;
+    const u32 sheight = m_ownedSide;
     const u32 tileCt = GetHeight() * GetWidth();
 
     for(u32 pass = 0; pass < 2; pass++)
@@ -632,7 +1033,9 @@ namespace MFM {
   {
     u32 total = 0;
     for (const_iterator_type i = begin(); i != end(); ++i)
-      total += i->GetAtomCount(atomType);
+      total += m_gridRunning ?
+        i->GetPublishedAtomCount(atomType) :
+        i->GetAtomCount(atomType);
 
     return total;
   }
@@ -642,10 +1045,10 @@ namespace MFM {
   {
     Random& rand = m_random;
 
-    SPoint center(rand.Create(m_width * TILE_SIDE),
-		  rand.Create(m_height * TILE_SIDE));
+    SPoint center(rand.Create(m_width * m_tileSide),
+		  rand.Create(m_height * m_tileSide));
 
-    u32 radius = rand.Between(5, TILE_SIDE);
+    u32 radius = rand.Between(5, m_tileSide);
     T atom(Element_Empty<EC>::THE_INSTANCE.GetDefaultAtom());
 
     SPoint siteInGrid, tileInGrid, siteInTile;
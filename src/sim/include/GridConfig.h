@@ -61,15 +61,15 @@ namespace MFM {
 
     /**
      * TILE_SIDE is the number of sites wide (and high) for a tile in
-     * this GridConfig
+     * this GridConfig, or 0 if that is chosen when the Grid is made
      */
     enum { TILE_SIDE = SIDE };
 
     /**
      * OWNED_SIDE is the number of sites wide (and high) for a tile in
-     * this GridConfig, excluding the caches
+     * this GridConfig, excluding the caches, or 0 if TILE_SIDE is
      */
-    enum { OWNED_SIDE = TILE_SIDE - 2 * EC::EVENT_WINDOW_RADIUS };
+    enum { OWNED_SIDE = TILE_SIDE != 0 ? TILE_SIDE - 2 * EC::EVENT_WINDOW_RADIUS : 0 };
 
   };
 
@@ -41,7 +41,7 @@ namespace MFM
 
     In each direction, a single underlying 'ByteChannel' is used for
     all three data-carrying components, divided up by indices.  The
-    initial state of a BUFFER_SIZE = 32 ByteChannel is:
+    initial state of a buffer size 32 ByteChannel is:
 
     \verbatim
                1    1    2    2    3
@@ -62,8 +62,8 @@ namespace MFM
          CanWrite() == 31  (r+L-w-1)%L
     \endverbatim
 
-    Ignoring wraparound issues at first, a BUFFER_SIZE = 32
-    ByteChannel could look like:
+    Ignoring wraparound issues at first, a buffer size 32 ByteChannel
+    could look like:
 
     \verbatim
                1    1    2    2    3
@@ -151,7 +151,7 @@ namespace MFM
     (and it's kind of bogus that CanWrite changes after a Read, since
     the whole point is that the modeled read and write locations are
     not local to each other.  Really we should have (perhaps settable)
-    max read and write buffer sizes, and as long as BUFFER_SIZE is
+    max read and write buffer sizes, and as long as the buffer size is
     greater than read size + write size + max in flight, reading
     wouldn't affect writing.)
 
@@ -263,6 +263,11 @@ namespace MFM
 
     GridTransceiver() ;
 
+    ~GridTransceiver()
+    {
+      FreeBuffers();
+    }
+
     /**
        Enable or disable this GridTransceiver.  When a GridTransceiver
        is disabled, the only AbstractChannel interface method that can
@@ -273,6 +278,10 @@ namespace MFM
      */
     void SetEnabled(bool enabled)
     {
+      if (enabled)
+      {
+        AllocateBuffers();
+      }
       m_enabled = enabled;
     }
 
@@ -286,6 +295,38 @@ namespace MFM
       return m_enabled;
     }
 
+    /**
+       Set the size of the buffer used for each direction of this
+       GridTransceiver, which holds at most one byte less.  The
+       buffers are allocated when it is first enabled, so a
+       GridTransceiver that is never enabled costs no buffer memory.
+
+       \fail ILLEGAL_STATE if the GridTransceiver is enabled
+       \fail ILLEGAL_ARGUMENT if bytes is not a power of two between
+             MIN_BUFFER_SIZE and MAX_BUFFER_SIZE
+     */
+    void SetBufferSize(u32 bytes) ;
+
+    u32 GetBufferSize() const
+    {
+      return m_bufferSize;
+    }
+
+    /**
+       Ask that this GridTransceiver's buffers, if it has any yet,
+       live on NUMA node \c node.  Return false if the kernel
+       wouldn't.
+
+       \sa CpuPlacement::MoveToNode
+     */
+    bool MoveToNode(u32 node) ;
+
+    enum {
+      DEFAULT_BUFFER_SIZE = 2048,
+      MIN_BUFFER_SIZE = 256,    // Room for a max-size packet and its length
+      MAX_BUFFER_SIZE = 1 << 20
+    };
+
     /**
        Simulate channel communications given the actual wall clock
        time is now.  Return true if any communications occurred.
@@ -360,10 +401,6 @@ namespace MFM
       return didWork;
     }
 
-    enum {
-      BUFFER_SIZE = 2048
-    };
-
     bool m_enabled;
     void FailUnlessEnabled()
     {
@@ -373,6 +410,20 @@ namespace MFM
       }
     }
 
+    u32 m_bufferSize;
+
+    /**
+       Both directions' buffers, in one block of whole pages, so that
+       they can be moved between NUMA nodes without moving anything
+       else; or null until first enabled.
+     */
+    u8 * m_buffers;
+    u32 m_buffersBytes;
+
+    void AllocateBuffers() ;
+
+    void FreeBuffers() ;
+
     u32 m_bytesPerSecond;
 
     u32 m_maxBytesInFlight;
@@ -383,14 +434,15 @@ namespace MFM
 
     struct ByteChannel {
 
-      static inline u32 BytesBetween(u32 idxHi, u32 idxLo)
+      // Buffer sizes are powers of two, so masking wraps the indices
+      inline u32 BytesBetween(u32 idxHi, u32 idxLo) const
       {
-        return (idxHi + BUFFER_SIZE - idxLo) % BUFFER_SIZE;
+        return (idxHi - idxLo) & m_mask;
       }
 
-      static void Increment(u32 & var, u32 amount = 1)
+      void Increment(u32 & var, u32 amount = 1) const
       {
-        var = (var + amount) % BUFFER_SIZE;
+        var = (var + amount) & m_mask;
       }
 
       ByteChannel()
@@ -398,8 +450,16 @@ namespace MFM
         , m_xmitIndex(0)
         , m_rcvIndex(0)
         , m_readIndex(0)
+        , m_mask(0)
+        , m_data(0)
       { }
 
+      /**
+       * Use the \c size bytes at \c data as our empty buffer, or no
+       * buffer if \c data is null.  The caller owns \c data.
+       */
+      void SetBuffer(u8 * data, u32 size) ;
+
       /**
        * Move xmitted bytes to rcvd bytes, and written bytes to
        * xmitted bytes; up to maxBytes each.  Return true if any bytes
@@ -452,7 +512,12 @@ namespace MFM
        */
       u32 m_readIndex;
 
-      u8 m_data[BUFFER_SIZE];
+      /**
+       * Buffer size - 1, or 0 if we have no buffer
+       */
+      u32 m_mask;
+
+      u8 * m_data;
     };
     ByteChannel & GetOutputChannel(bool byA)
     {
@@ -465,6 +530,9 @@ namespace MFM
     ByteChannel m_channelAtoB;
     ByteChannel m_channelBtoA;
 
+    // Not copyable
+    GridTransceiver(const GridTransceiver &) ;
+    GridTransceiver & operator=(const GridTransceiver &) ;
   };
 }
 
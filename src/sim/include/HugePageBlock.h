@@ -0,0 +1,141 @@
+/*                                              -*- mode:C++ -*-
+  HugePageBlock.h A block of memory backed by huge pages when possible
+  Copyright (C) 2014 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file HugePageBlock.h A block of memory backed by huge pages when possible
+  \author David H. Ackley.
+  \date (C) 2014 All rights reserved.
+  \lgpl
+ */
+#ifndef HUGEPAGEBLOCK_H
+#define HUGEPAGEBLOCK_H
+
+#include "itype.h"
+#include "Fail.h"
+
+namespace MFM
+{
+  /**
+    A zeroed, private block of memory for big, uniformly touched data
+    such as a Grid's Tiles, mapped so as to need as few TLB entries
+    as the system allows: from reserved huge pages (MAP_HUGETLB) if
+    there are enough, else from ordinary pages aligned and advised
+    for transparent huge pages (MADV_HUGEPAGE), else from ordinary
+    pages.
+   */
+  class HugePageBlock
+  {
+  public:
+
+    enum Backing
+    {
+      BACKING_NONE,     // Nothing allocated
+      BACKING_HUGETLB,  // Reserved huge pages
+      BACKING_THP,      // Transparent huge pages, as the kernel sees fit
+      BACKING_NORMAL    // Ordinary pages
+    };
+
+    enum {
+      DEFAULT_HUGE_PAGE_BYTES = 2 * 1024 * 1024  // The usual x86-64 huge page
+    };
+
+    /**
+       The size of the system's transparent huge pages, from
+       /sys/kernel/mm/transparent_hugepage/hpage_pmd_size, else of its
+       reserved huge pages, from Hugepagesize in /proc/meminfo, else
+       DEFAULT_HUGE_PAGE_BYTES.  Read once, then remembered.
+     */
+    static u64 GetHugePageBytes() ;
+
+    /**
+       The size of the system's reserved (MAP_HUGETLB) huge pages,
+       from Hugepagesize in /proc/meminfo, else GetHugePageBytes().
+       Read once, then remembered.
+     */
+    static u64 GetHugeTlbPageBytes() ;
+
+    HugePageBlock() ;
+
+    ~HugePageBlock()
+    {
+      Free();
+    }
+
+    /**
+       Map \c bytes of zeroed memory, as huge pages if possible, and
+       return its page-aligned start.  Blocks smaller than a huge
+       page get ordinary pages.
+
+       \fail ILLEGAL_STATE if we already have a block
+       \fail OUT_OF_RESOURCES if the memory cannot be mapped
+     */
+    void * Allocate(u64 bytes) ;
+
+    /**
+       Unmap our block, if we have one.
+     */
+    void Free() ;
+
+    Backing GetBacking() const
+    {
+      return m_backing;
+    }
+
+    static const char * GetBackingName(Backing backing) ;
+
+    u64 GetBytes() const
+    {
+      return m_bytes;
+    }
+
+    /**
+       The size of the pages our block was mapped for: the reserved
+       or transparent huge page size, as per our Backing, or the
+       ordinary page size, or 0 if we have no block.  Our block
+       starts on a boundary of this size, and any part of it aligned
+       to this size may be treated (e.g., mbind) as a unit.
+     */
+    u64 GetPageBytes() const
+    {
+      return m_pageBytes;
+    }
+
+    /**
+       How much of our block is actually on huge pages right now,
+       according to /proc/self/smaps, or 0 if that can't be read.
+       Transparent huge pages may be fewer than advised, and may
+       come and go.
+     */
+    u64 GetHugeBytes() const ;
+
+  private:
+    void * m_start;
+    u64 m_bytes;       // As requested
+    u64 m_mapBytes;    // As mapped, rounded up
+    u64 m_pageBytes;   // As mapped for
+    Backing m_backing;
+
+    // Not copyable
+    HugePageBlock(const HugePageBlock &) ;
+    HugePageBlock & operator=(const HugePageBlock &) ;
+  };
+}
+
+#endif /* HUGEPAGEBLOCK_H */
@@ -0,0 +1,159 @@
+/*                                              -*- mode:C++ -*-
+  SharedMemoryChannel.h An intertile channel in memory shared between processes
+  Copyright (C) 2014 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file SharedMemoryChannel.h An intertile channel in memory shared between processes
+  \author David H. Ackley.
+  \date (C) 2014 All rights reserved.
+  \lgpl
+ */
+#ifndef SHAREDMEMORYCHANNEL_H
+#define SHAREDMEMORYCHANNEL_H
+
+#include "itype.h"
+#include "Fail.h"
+#include "AbstractChannel.h"
+
+namespace MFM
+{
+  /**
+    An AbstractChannel made of two single-producer, single-consumer
+    byte rings -- one each way -- in a shared memory mapping, so that
+    side A and side B may be used from different processes once the
+    mapping is inherited across a fork(2).  Unlike a SocketChannel,
+    bytes written are readable by the far side at once, with no
+    system call and nothing to advance.
+
+    Each ring has exactly one writing thread and one reading thread,
+    which synchronize only through the ring's indices.  A reader with
+    nothing better to do may sleep in WaitToRead, on a futex that the
+    writer wakes -- paying for that system call only when a reader
+    is actually asleep.
+   */
+  class SharedMemoryChannel : public AbstractChannel
+  {
+  public:
+
+    ////
+    // BEGIN AbstractChannel interface
+
+    virtual u32 CanWrite(bool byA)
+    {
+      const Ring & ring = GetRing(byA);
+      return m_ringSize - 1 - Readable(ring);
+    }
+
+    virtual u32 Write(bool byA, const u8 * data, u32 length) ;
+
+    virtual u32 CanRead(bool byA)
+    {
+      return Readable(GetRing(!byA));
+    }
+
+    virtual u32 Read(bool byA, u8 * data, u32 length) ;
+
+    // END AbstractChannel interface
+    ////
+
+    SharedMemoryChannel() ;
+
+    /**
+       Unmaps our rings from this process, if we have them.
+     */
+    virtual ~SharedMemoryChannel() ;
+
+    /**
+       Map fresh rings able to hold \c capacity bytes each way, from
+       a memfd if possible and anonymous shared memory otherwise.
+       Call before forking the process that will use the far side.
+
+       \fail ILLEGAL_STATE if we already have rings
+       \fail ILLEGAL_ARGUMENT if capacity is outside
+             MIN_CAPACITY..MAX_CAPACITY
+       \fail OUT_OF_RESOURCES if the memory cannot be mapped
+     */
+    void Create(u32 capacity) ;
+
+    bool IsCreated() const
+    {
+      return m_mapping != 0;
+    }
+
+    u32 GetCapacity() const
+    {
+      return m_ringSize - 1;
+    }
+
+    /**
+       Sleep until side \c byA can read something, or for at most \c
+       timeoutUsec microseconds.  Return true if it can read now.
+     */
+    bool WaitToRead(bool byA, u32 timeoutUsec) ;
+
+    enum {
+      MIN_CAPACITY = 64,
+      MAX_CAPACITY = 1 << 24
+    };
+
+  private:
+
+    /**
+       The shared control words of one ring, each on its own cache
+       line so that writer and reader don't contend for them.
+     */
+    struct Ring {
+      volatile u32 m_writeIndex;  // Written only by the writer
+      u8 m_pad0[60];
+      volatile u32 m_readIndex;   // Written only by the reader
+      u8 m_pad1[60];
+      volatile u32 m_readerAsleep; // Nonzero while in WaitToRead
+      u8 m_pad2[60];
+    };
+
+    u8 * m_mapping;
+    u32 m_mappingBytes;
+    u32 m_ringSize;       // Bytes of data per ring; holds one less
+
+    /**
+       The ring written by side \c byA and read by the other side.
+     */
+    Ring & GetRing(bool byA) const
+    {
+      MFM_API_ASSERT_STATE(m_mapping);
+      return ((Ring *) m_mapping)[byA ? 0 : 1];
+    }
+
+    u8 * GetData(bool byA) const
+    {
+      return m_mapping + 2 * sizeof(Ring) + (byA ? 0 : m_ringSize);
+    }
+
+    u32 Readable(const Ring & ring) const
+    {
+      return (ring.m_writeIndex + m_ringSize - ring.m_readIndex) % m_ringSize;
+    }
+
+    // Not copyable
+    SharedMemoryChannel(const SharedMemoryChannel &) ;
+    SharedMemoryChannel & operator=(const SharedMemoryChannel &) ;
+  };
+}
+
+#endif /* SHAREDMEMORYCHANNEL_H */
@@ -0,0 +1,226 @@
+/*                                              -*- mode:C++ -*-
+  SocketChannel.h An intertile channel to a Tile in another process
+  Copyright (C) 2014 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file SocketChannel.h An intertile channel to a Tile in another process
+  \author David H. Ackley.
+  \date (C) 2014 All rights reserved.
+  \lgpl
+ */
+#ifndef SOCKETCHANNEL_H
+#define SOCKETCHANNEL_H
+
+#include "itype.h"
+#include "Fail.h"
+#include "AbstractChannel.h"
+
+namespace MFM
+{
+  /**
+    An AbstractChannel whose near side is a Tile in this process and
+    whose far side is a Tile in another process, reached through one
+    end of a connected stream socket (e.g., from socketpair(2) or a
+    Unix domain socket).
+
+    Writes and reads touch only an output and an input ring buffer in
+    memory; Advance moves bytes between those rings and the socket in
+    batches, with at most one nonblocking sendmsg and one nonblocking
+    recvmsg per call.  Only the near side of the channel may be used,
+    and only from the one thread driving the near Tile, which is also
+    the thread that calls Advance, so no locking is needed.
+
+    If the far process closes its end, or the socket fails, the
+    channel stops moving bytes: the near Tile's cache processor will
+    eventually stall, while the rest of its Tile runs on.
+   */
+  class SocketChannel : public AbstractChannel
+  {
+  public:
+
+    ////
+    // BEGIN AbstractChannel interface
+
+    /**
+       \copydoc AbstractChannel::CanWrite
+       \fail ILLEGAL_ARGUMENT if byA does not select our near side
+    */
+    virtual u32 CanWrite(bool byA)
+    {
+      FailUnlessNearSide(byA);
+      return m_out.CanWrite();
+    }
+
+    /**
+       \copydoc AbstractChannel::Write
+       \fail ILLEGAL_ARGUMENT if byA does not select our near side
+    */
+    virtual u32 Write(bool byA, const u8 * data, u32 length)
+    {
+      FailUnlessNearSide(byA);
+      return m_out.Write(data, length);
+    }
+
+    /**
+       \copydoc AbstractChannel::CanRead
+       \fail ILLEGAL_ARGUMENT if byA does not select our near side
+    */
+    virtual u32 CanRead(bool byA)
+    {
+      FailUnlessNearSide(byA);
+      return m_in.CanRead();
+    }
+
+    /**
+       \copydoc AbstractChannel::Read
+       \fail ILLEGAL_ARGUMENT if byA does not select our near side
+    */
+    virtual u32 Read(bool byA, u8 * data, u32 length)
+    {
+      FailUnlessNearSide(byA);
+      return m_in.Read(data, length);
+    }
+
+    // END AbstractChannel interface
+    ////
+
+    SocketChannel() ;
+
+    /**
+       Closes our socket, if we have one.
+     */
+    virtual ~SocketChannel() ;
+
+    /**
+       Take ownership of the connected stream socket \c fd, and make
+       it nonblocking.  Our near side is side A of the channel if \c
+       nearIsA, and side B otherwise.
+
+       \fail ILLEGAL_STATE if we already have a socket
+       \fail IO_ERROR if fd cannot be made nonblocking
+     */
+    void Open(s32 fd, bool nearIsA) ;
+
+    bool IsOpen() const
+    {
+      return m_fd >= 0;
+    }
+
+    /**
+       Send whatever we can of our output ring, and receive whatever
+       fits in our input ring, without blocking.  Return true if any
+       bytes moved.
+     */
+    bool Advance() ;
+
+    u64 GetBytesSent() const
+    {
+      return m_bytesSent;
+    }
+
+    u64 GetBytesReceived() const
+    {
+      return m_bytesReceived;
+    }
+
+    /**
+       The number of sendmsg and recvmsg calls that moved bytes, for
+       judging how well Advance is batching.
+     */
+    u64 GetTransfers() const
+    {
+      return m_transfers;
+    }
+
+  private:
+
+    enum {
+      BUFFER_SIZE = 2048  // As in GridTransceiver
+    };
+
+    /**
+       A byte ring.  Holds at most BUFFER_SIZE - 1 bytes, so that
+       m_readIndex == m_writeIndex means empty.
+     */
+    struct Ring {
+      u32 m_writeIndex;
+      u32 m_readIndex;
+      u8 m_data[BUFFER_SIZE];
+
+      Ring()
+        : m_writeIndex(0)
+        , m_readIndex(0)
+      { }
+
+      u32 CanRead() const
+      {
+        return (m_writeIndex + BUFFER_SIZE - m_readIndex) % BUFFER_SIZE;
+      }
+
+      u32 CanWrite() const
+      {
+        return BUFFER_SIZE - 1 - CanRead();
+      }
+
+      u32 Write(const u8 * data, u32 length) ;
+
+      u32 Read(u8 * data, u32 length) ;
+
+      /**
+         Describe the readable bytes as up to two spans, returning
+         how many.  Used to hand them to sendmsg all at once.
+       */
+      u32 GetReadableSpans(u8 * (starts[2]), u32 lengths[2]) ;
+
+      /**
+         Describe the writable bytes as up to two spans, returning
+         how many.  Used to let recvmsg fill them all at once.
+       */
+      u32 GetWritableSpans(u8 * (starts[2]), u32 lengths[2]) ;
+    };
+
+    s32 m_fd;
+    bool m_nearIsA;
+    Ring m_out;
+    Ring m_in;
+
+    u64 m_bytesSent;
+    u64 m_bytesReceived;
+    u64 m_transfers;
+
+    void FailUnlessNearSide(bool byA) const
+    {
+      if (byA != m_nearIsA)
+      {
+        FAIL(ILLEGAL_ARGUMENT);
+      }
+    }
+
+    /**
+       Log why the socket is unusable, and close it.
+     */
+    void Shutdown(const char * why) ;
+
+    // Not copyable
+    SocketChannel(const SocketChannel &) ;
+    SocketChannel & operator=(const SocketChannel &) ;
+  };
+}
+
+#endif /* SOCKETCHANNEL_H */
@@ -0,0 +1,179 @@
+#include "CpuPlacement.h"
+#include "Logger.h"
+
+#include <pthread.h>         /* For pthread_setaffinity_np */
+#include <sched.h>           /* For sched_getaffinity, cpu_set_t */
+#include <stdio.h>           /* For fopen, fgets, snprintf */
+#include <stdlib.h>          /* For strtoul */
+#include <unistd.h>          /* For syscall, sysconf */
+#include <sys/syscall.h>     /* For SYS_mbind */
+#include <linux/mempolicy.h> /* For MPOL_PREFERRED, MPOL_MF_MOVE */
+
+namespace MFM
+{
+  CpuPlacement::CpuPlacement()
+    : m_cpuCount(0)
+    , m_nodeCount(0)
+  { }
+
+  void CpuPlacement::Init()
+  {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed))
+    {
+      FAIL(ILLEGAL_STATE);
+    }
+
+    bool placed[MAX_CPUS];
+    for (u32 cpu = 0; cpu < MAX_CPUS; ++cpu)
+    {
+      placed[cpu] = false;
+    }
+
+    // Take each node's allowed CPUs in turn
+    m_cpuCount = 0;
+    m_nodeCount = 0;
+    for (u32 node = 0; node < MAX_NODES; ++node)
+    {
+      char path[100];
+      snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+      FILE * file = fopen(path, "r");
+      if (!file)
+      {
+        continue;
+      }
+
+      char list[4096];
+      bool flags[MAX_CPUS];
+      for (u32 cpu = 0; cpu < MAX_CPUS; ++cpu)
+      {
+        flags[cpu] = false;
+      }
+      bool ok = fgets(list, sizeof(list), file) && ParseCpuList(list, flags, MAX_CPUS);
+      fclose(file);
+      if (!ok)
+      {
+        LOG.Warning("Can't parse %s", path);
+        continue;
+      }
+
+      u32 before = m_cpuCount;
+      for (u32 cpu = 0; cpu < MAX_CPUS; ++cpu)
+      {
+        if (flags[cpu] && !placed[cpu] && CPU_ISSET(cpu, &allowed))
+        {
+          placed[cpu] = true;
+          m_cpus[m_cpuCount] = cpu;
+          m_nodes[m_cpuCount] = node;
+          ++m_cpuCount;
+        }
+      }
+      if (m_cpuCount > before)
+      {
+        ++m_nodeCount;
+      }
+    }
+
+    // Anything left (or everything, without sysfs) goes on node 0
+    u32 before = m_cpuCount;
+    for (u32 cpu = 0; cpu < MAX_CPUS; ++cpu)
+    {
+      if (!placed[cpu] && CPU_ISSET(cpu, &allowed))
+      {
+        m_cpus[m_cpuCount] = cpu;
+        m_nodes[m_cpuCount] = 0;
+        ++m_cpuCount;
+      }
+    }
+    if (m_nodeCount == 0 && m_cpuCount > before)
+    {
+      m_nodeCount = 1;
+    }
+
+    LOG.Message("%d CPUs on %d NUMA node%s available for tile threads",
+                m_cpuCount, m_nodeCount, m_nodeCount == 1 ? "" : "s");
+  }
+
+  bool CpuPlacement::ParseCpuList(const char * list, bool * flags, u32 size)
+  {
+    const char * p = list;
+    while (*p && *p != '\n')
+    {
+      char * end;
+      u32 lo = strtoul(p, &end, 10);
+      if (end == p)
+      {
+        return false;
+      }
+      u32 hi = lo;
+      p = end;
+      if (*p == '-')
+      {
+        ++p;
+        hi = strtoul(p, &end, 10);
+        if (end == p || hi < lo)
+        {
+          return false;
+        }
+        p = end;
+      }
+      for (u32 cpu = lo; cpu <= hi && cpu < size; ++cpu)
+      {
+        flags[cpu] = true;
+      }
+      if (*p == ',')
+      {
+        ++p;
+      }
+      else if (*p && *p != '\n')
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool CpuPlacement::PinThisThread(u32 cpu)
+  {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+  }
+
+  bool CpuPlacement::GetClaimedPages(uptr start, u64 bytes, u64 pageBytes,
+                                     uptr & first, uptr & last)
+  {
+    MFM_API_ASSERT_ARG(pageBytes > 0 && (pageBytes & (pageBytes - 1)) == 0);
+
+    // Pages whose middles lie in [start, start + bytes)
+    const uptr page = (uptr) pageBytes;
+    const uptr half = page / 2;
+    if (start < half)
+    {
+      return false;  // Not a mappable address anyway
+    }
+    first = (start - half + page - 1) & ~(page - 1);
+    last = (start + bytes - half + page - 1) & ~(page - 1);
+    return first < last;
+  }
+
+  bool CpuPlacement::MoveToNode(void * start, u64 bytes, u32 node, u64 pageBytes)
+  {
+    MFM_API_ASSERT_ARG(node < MAX_NODES);
+
+    uptr first, last;
+    if (!GetClaimedPages((uptr) start, bytes,
+                         pageBytes ? pageBytes : (u64) sysconf(_SC_PAGESIZE),
+                         first, last))
+    {
+      return true;  // No pages are ours to move
+    }
+
+    u64 mask = ((u64) 1) << node;
+    return syscall(SYS_mbind, first, last - first, MPOL_PREFERRED,
+                   &mask, MAX_NODES + 1, MPOL_MF_MOVE) == 0;
+  }
+
+}
@@ -1,10 +1,17 @@
 #include "GridTransceiver.h"
+#include "CpuPlacement.h"
 #include "Util.h"  // For MIN
 
+#include <stdlib.h>  /* For posix_memalign, free */
+#include <unistd.h>  /* For sysconf */
+
 namespace MFM
 {
   GridTransceiver::GridTransceiver()
     : m_enabled(false)
+    , m_bufferSize(DEFAULT_BUFFER_SIZE)
+    , m_buffers(0)
+    , m_buffersBytes(0)
     , m_bytesPerSecond(500000) // default ~500KBps == ~4Mbps
     , m_maxBytesInFlight(1)
     , m_excessNanoseconds(0)
@@ -14,6 +21,51 @@ namespace MFM
     m_lastAdvanced = now;
   }
 
+  void GridTransceiver::SetBufferSize(u32 bytes)
+  {
+    MFM_API_ASSERT_STATE(!m_enabled);
+    MFM_API_ASSERT_ARG(bytes >= MIN_BUFFER_SIZE && bytes <= MAX_BUFFER_SIZE);
+    MFM_API_ASSERT_ARG((bytes & (bytes - 1)) == 0);
+
+    if (bytes != m_bufferSize)
+    {
+      FreeBuffers();
+      m_bufferSize = bytes;
+    }
+  }
+
+  void GridTransceiver::AllocateBuffers()
+  {
+    if (!m_buffers)
+    {
+      const u32 page = (u32) sysconf(_SC_PAGESIZE);
+      const u32 bytes = (2 * m_bufferSize + page - 1) / page * page;
+      void * mem;
+      if (posix_memalign(&mem, page, bytes))
+      {
+        FAIL(OUT_OF_RESOURCES);
+      }
+      m_buffers = (u8 *) mem;
+      m_buffersBytes = bytes;
+      m_channelAtoB.SetBuffer(m_buffers, m_bufferSize);
+      m_channelBtoA.SetBuffer(m_buffers + m_bufferSize, m_bufferSize);
+    }
+  }
+
+  void GridTransceiver::FreeBuffers()
+  {
+    m_channelAtoB.SetBuffer(0, 0);
+    m_channelBtoA.SetBuffer(0, 0);
+    free(m_buffers);
+    m_buffers = 0;
+    m_buffersBytes = 0;
+  }
+
+  bool GridTransceiver::MoveToNode(u32 node)
+  {
+    return !m_buffers || CpuPlacement::MoveToNode(m_buffers, m_buffersBytes, node);
+  }
+
   bool GridTransceiver::AdvanceToTime(const timespec & now)
   {
     const u32 ONE_BILLION = 1000*1000*1000;
@@ -53,6 +105,13 @@ namespace MFM
     return rcvable > 0 || sndable > 0;
   }
 
+  void GridTransceiver::ByteChannel::SetBuffer(u8 * data, u32 size)
+  {
+    m_data = data;
+    m_mask = data ? size - 1 : 0;
+    m_writeIndex = m_xmitIndex = m_rcvIndex = m_readIndex = 0;
+  }
+
   u32 GridTransceiver::ByteChannel::Write(const u8 * data, u32 length)
   {
     const u32 count = MIN(CanWrite(), length);
@@ -0,0 +1,223 @@
+#include "HugePageBlock.h"
+#include "Logger.h"
+
+#include <errno.h>     /* For errno */
+#include <stdio.h>     /* For fopen, fgets, sscanf */
+#include <string.h>    /* For strerror, strncmp */
+#include <sys/mman.h>  /* For mmap, munmap, madvise */
+#include <unistd.h>    /* For sysconf */
+
+namespace MFM
+{
+  HugePageBlock::HugePageBlock()
+    : m_start(0)
+    , m_bytes(0)
+    , m_mapBytes(0)
+    , m_pageBytes(0)
+    , m_backing(BACKING_NONE)
+  { }
+
+  /**
+     The Hugepagesize in /proc/meminfo, in bytes, or 0 if it can't
+     be read.
+   */
+  static u64 ReadMeminfoHugePageBytes()
+  {
+    FILE * meminfo = fopen("/proc/meminfo", "r");
+    if (!meminfo)
+    {
+      return 0;
+    }
+    u64 bytes = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), meminfo))
+    {
+      unsigned long kb;
+      if (sscanf(line, "Hugepagesize: %lu kB", &kb) == 1)
+      {
+        bytes = ((u64) kb) * 1024;
+        break;
+      }
+    }
+    fclose(meminfo);
+    return bytes;
+  }
+
+  /**
+     \c bytes if it is a usable huge page size -- a power of two
+     bigger than an ordinary page -- else 0.
+   */
+  static u64 SaneHugePageBytes(u64 bytes)
+  {
+    const u64 page = (u64) sysconf(_SC_PAGESIZE);
+    return (bytes > page && (bytes & (bytes - 1)) == 0) ? bytes : 0;
+  }
+
+  u64 HugePageBlock::GetHugePageBytes()
+  {
+    static u64 bytes = 0;
+    if (!bytes)
+    {
+      FILE * fp = fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r");
+      if (fp)
+      {
+        unsigned long size;
+        if (fscanf(fp, "%lu", &size) == 1)
+        {
+          bytes = SaneHugePageBytes(size);
+        }
+        fclose(fp);
+      }
+      if (!bytes)
+      {
+        bytes = SaneHugePageBytes(ReadMeminfoHugePageBytes());
+      }
+      if (!bytes)
+      {
+        bytes = DEFAULT_HUGE_PAGE_BYTES;
+      }
+    }
+    return bytes;
+  }
+
+  u64 HugePageBlock::GetHugeTlbPageBytes()
+  {
+    static u64 bytes = 0;
+    if (!bytes)
+    {
+      bytes = SaneHugePageBytes(ReadMeminfoHugePageBytes());
+      if (!bytes)
+      {
+        bytes = GetHugePageBytes();
+      }
+    }
+    return bytes;
+  }
+
+  void * HugePageBlock::Allocate(u64 bytes)
+  {
+    MFM_API_ASSERT_STATE(!m_start);
+
+    const u64 huge = GetHugePageBytes();
+    const u64 tlbHuge = GetHugeTlbPageBytes();
+    const u64 rounded = (bytes + huge - 1) / huge * huge;
+    const int prot = PROT_READ | PROT_WRITE;
+    const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+    if (bytes >= huge)
+    {
+      // Reserved huge pages, if the administrator set aside enough
+      const u64 tlbRounded = (bytes + tlbHuge - 1) / tlbHuge * tlbHuge;
+      void * start = mmap(0, tlbRounded, prot, flags | MAP_HUGETLB, -1, 0);
+      if (start != MAP_FAILED)
+      {
+        m_start = start;
+        m_mapBytes = tlbRounded;
+        m_pageBytes = tlbHuge;
+        m_backing = BACKING_HUGETLB;
+      }
+      else
+      {
+        // Else over-map to find a huge page boundary, trim, and advise
+        u8 * raw = (u8 *) mmap(0, rounded + huge, prot, flags, -1, 0);
+        if (raw != MAP_FAILED)
+        {
+          u8 * aligned = (u8 *) ((((uptr) raw) + huge - 1) & ~(uptr) (huge - 1));
+          if (aligned > raw)
+          {
+            munmap(raw, aligned - raw);
+          }
+          munmap(aligned + rounded, (raw + rounded + huge) - (aligned + rounded));
+
+          m_start = aligned;
+          m_mapBytes = rounded;
+          m_backing = madvise(aligned, rounded, MADV_HUGEPAGE) ? BACKING_NORMAL : BACKING_THP;
+          m_pageBytes = m_backing == BACKING_THP ? huge : (u64) sysconf(_SC_PAGESIZE);
+        }
+      }
+    }
+
+    if (!m_start)
+    {
+      void * start = mmap(0, bytes, prot, flags, -1, 0);
+      if (start == MAP_FAILED)
+      {
+        LOG.Error("Can't map %ld bytes: %s", (long) bytes, strerror(errno));
+        FAIL(OUT_OF_RESOURCES);
+      }
+      m_start = start;
+      m_mapBytes = bytes;
+      m_pageBytes = (u64) sysconf(_SC_PAGESIZE);
+      m_backing = BACKING_NORMAL;
+    }
+
+    m_bytes = bytes;
+    return m_start;
+  }
+
+  void HugePageBlock::Free()
+  {
+    if (m_start)
+    {
+      munmap(m_start, m_mapBytes);
+      m_start = 0;
+      m_bytes = 0;
+      m_mapBytes = 0;
+      m_pageBytes = 0;
+      m_backing = BACKING_NONE;
+    }
+  }
+
+  const char * HugePageBlock::GetBackingName(Backing backing)
+  {
+    switch (backing)
+    {
+    case BACKING_NONE: return "none";
+    case BACKING_HUGETLB: return "hugetlb";
+    case BACKING_THP: return "thp";
+    case BACKING_NORMAL: return "normal";
+    default: FAIL(ILLEGAL_ARGUMENT);
+    }
+  }
+
+  u64 HugePageBlock::GetHugeBytes() const
+  {
+    if (m_backing == BACKING_HUGETLB)
+    {
+      return m_mapBytes;
+    }
+    if (m_backing != BACKING_THP)
+    {
+      return 0;
+    }
+
+    FILE * smaps = fopen("/proc/self/smaps", "r");
+    if (!smaps)
+    {
+      return 0;
+    }
+
+    // Sum AnonHugePages over the mappings within our block, which
+    // the kernel may have split
+    const uptr lo = (uptr) m_start;
+    const uptr hi = lo + m_mapBytes;
+    bool ours = false;
+    u64 hugeKB = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), smaps))
+    {
+      unsigned long start, end, kb;
+      if (sscanf(line, "%lx-%lx ", &start, &end) == 2)
+      {
+        ours = start >= lo && end <= hi;
+      }
+      else if (ours && sscanf(line, "AnonHugePages: %lu kB", &kb) == 1)
+      {
+        hugeKB += kb;
+      }
+    }
+    fclose(smaps);
+    return hugeKB * 1024;
+  }
+
+}
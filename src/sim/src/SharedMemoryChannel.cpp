@@ -0,0 +1,136 @@
+#include "SharedMemoryChannel.h"
+#include "Logger.h"
+#include "Util.h"  // For MIN
+
+#include <errno.h>         /* For errno */
+#include <string.h>        /* For memcpy, strerror */
+#include <time.h>          /* For struct timespec */
+#include <unistd.h>        /* For close, ftruncate, syscall */
+#include <sys/mman.h>      /* For mmap, munmap, memfd_create */
+#include <sys/syscall.h>   /* For SYS_futex */
+#include <linux/futex.h>   /* For FUTEX_WAIT, FUTEX_WAKE */
+
+namespace MFM
+{
+  SharedMemoryChannel::SharedMemoryChannel()
+    : m_mapping(0)
+    , m_mappingBytes(0)
+    , m_ringSize(0)
+  { }
+
+  SharedMemoryChannel::~SharedMemoryChannel()
+  {
+    if (m_mapping)
+    {
+      munmap(m_mapping, m_mappingBytes);
+    }
+  }
+
+  void SharedMemoryChannel::Create(u32 capacity)
+  {
+    MFM_API_ASSERT_STATE(!m_mapping);
+    MFM_API_ASSERT_ARG(capacity >= MIN_CAPACITY && capacity <= MAX_CAPACITY);
+
+    const u32 ringSize = capacity + 1;
+    const u32 bytes = 2 * sizeof(Ring) + 2 * ringSize;
+
+    // A memfd can be mapped by others too, but a fork suffices
+    void * mapping = MAP_FAILED;
+    s32 fd = memfd_create("MFM SharedMemoryChannel", MFD_CLOEXEC);
+    if (fd >= 0)
+    {
+      if (ftruncate(fd, bytes) == 0)
+      {
+        mapping = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      }
+      close(fd);
+    }
+    if (mapping == MAP_FAILED)
+    {
+      mapping = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    }
+    if (mapping == MAP_FAILED)
+    {
+      LOG.Error("Can't map %d bytes of shared memory: %s", bytes, strerror(errno));
+      FAIL(OUT_OF_RESOURCES);
+    }
+
+    // Fresh mappings are zeroed, so both rings start empty
+    m_mapping = (u8 *) mapping;
+    m_mappingBytes = bytes;
+    m_ringSize = ringSize;
+  }
+
+  u32 SharedMemoryChannel::Write(bool byA, const u8 * data, u32 length)
+  {
+    Ring & ring = GetRing(byA);
+    u8 * ringData = GetData(byA);
+
+    // Don't overwrite anything until the reader is done with it
+    const u32 readable = Readable(ring);
+    __sync_synchronize();
+
+    const u32 count = MIN(m_ringSize - 1 - readable, length);
+    const u32 write = ring.m_writeIndex;
+    const u32 first = MIN(count, m_ringSize - write);
+    memcpy(ringData + write, data, first);
+    memcpy(ringData, data + first, count - first);
+
+    // Publish the bytes, then see if the reader must be woken
+    __sync_synchronize();
+    ring.m_writeIndex = (write + count) % m_ringSize;
+    __sync_synchronize();
+    if (count > 0 && ring.m_readerAsleep)
+    {
+      syscall(SYS_futex, &ring.m_writeIndex, FUTEX_WAKE, 1, 0, 0, 0);
+    }
+    return count;
+  }
+
+  u32 SharedMemoryChannel::Read(bool byA, u8 * data, u32 length)
+  {
+    Ring & ring = GetRing(!byA);
+    const u8 * ringData = GetData(!byA);
+
+    // Don't read anything until the writer is done with it
+    const u32 readable = Readable(ring);
+    __sync_synchronize();
+
+    const u32 count = MIN(readable, length);
+    const u32 read = ring.m_readIndex;
+    const u32 first = MIN(count, m_ringSize - read);
+    memcpy(data, ringData + read, first);
+    memcpy(data + first, ringData, count - first);
+
+    __sync_synchronize();
+    ring.m_readIndex = (read + count) % m_ringSize;
+    return count;
+  }
+
+  bool SharedMemoryChannel::WaitToRead(bool byA, u32 timeoutUsec)
+  {
+    Ring & ring = GetRing(!byA);
+
+    const u32 seen = ring.m_writeIndex;
+    if (seen != ring.m_readIndex)
+    {
+      return true;
+    }
+
+    // Say we're asleep before looking again, so that either we see
+    // the writer's bytes or the writer sees us
+    ring.m_readerAsleep = 1;
+    __sync_synchronize();
+    if (ring.m_writeIndex == seen)
+    {
+      struct timespec timeout;
+      timeout.tv_sec = timeoutUsec / 1000000;
+      timeout.tv_nsec = (timeoutUsec % 1000000) * 1000;
+      syscall(SYS_futex, &ring.m_writeIndex, FUTEX_WAIT, seen, &timeout, 0, 0);
+    }
+    ring.m_readerAsleep = 0;
+
+    return ring.m_writeIndex != ring.m_readIndex;
+  }
+
+}
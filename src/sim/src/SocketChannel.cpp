@@ -0,0 +1,188 @@
+#include "SocketChannel.h"
+#include "Logger.h"
+#include "Util.h"  // For MIN
+
+#include <errno.h>       /* For errno */
+#include <fcntl.h>       /* For fcntl */
+#include <string.h>      /* For strerror */
+#include <unistd.h>      /* For close */
+#include <sys/socket.h>  /* For sendmsg, recvmsg */
+#include <sys/uio.h>     /* For struct iovec */
+
+namespace MFM
+{
+  SocketChannel::SocketChannel()
+    : m_fd(-1)
+    , m_nearIsA(true)
+    , m_bytesSent(0)
+    , m_bytesReceived(0)
+    , m_transfers(0)
+  { }
+
+  SocketChannel::~SocketChannel()
+  {
+    if (m_fd >= 0)
+    {
+      close(m_fd);
+    }
+  }
+
+  void SocketChannel::Open(s32 fd, bool nearIsA)
+  {
+    MFM_API_ASSERT_STATE(m_fd < 0);
+    MFM_API_ASSERT_ARG(fd >= 0);
+
+    s32 flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+      FAIL(IO_ERROR);
+    }
+
+    m_fd = fd;
+    m_nearIsA = nearIsA;
+  }
+
+  void SocketChannel::Shutdown(const char * why)
+  {
+    LOG.Warning("SocketChannel fd %d %s: %s; closing", m_fd, why,
+                errno ? strerror(errno) : "peer closed");
+    close(m_fd);
+    m_fd = -1;
+  }
+
+  bool SocketChannel::Advance()
+  {
+    if (m_fd < 0)
+    {
+      return false;
+    }
+
+    bool didWork = false;
+    struct iovec iov[2];
+    u8 * starts[2];
+    u32 lengths[2];
+
+    // Ship everything queued, in one call
+    u32 spans = m_out.GetReadableSpans(starts, lengths);
+    if (spans > 0)
+    {
+      struct msghdr msg;
+      memset(&msg, 0, sizeof(msg));
+      for (u32 i = 0; i < spans; ++i)
+      {
+        iov[i].iov_base = starts[i];
+        iov[i].iov_len = lengths[i];
+      }
+      msg.msg_iov = iov;
+      msg.msg_iovlen = spans;
+
+      ssize_t sent = sendmsg(m_fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+      if (sent > 0)
+      {
+        m_out.m_readIndex = (m_out.m_readIndex + (u32) sent) % BUFFER_SIZE;
+        m_bytesSent += sent;
+        ++m_transfers;
+        didWork = true;
+      }
+      else if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+      {
+        Shutdown("send failed");
+        return didWork;
+      }
+    }
+
+    // Take in everything there's room for, in one call
+    spans = m_in.GetWritableSpans(starts, lengths);
+    if (spans > 0)
+    {
+      struct msghdr msg;
+      memset(&msg, 0, sizeof(msg));
+      for (u32 i = 0; i < spans; ++i)
+      {
+        iov[i].iov_base = starts[i];
+        iov[i].iov_len = lengths[i];
+      }
+      msg.msg_iov = iov;
+      msg.msg_iovlen = spans;
+
+      errno = 0;
+      ssize_t got = recvmsg(m_fd, &msg, MSG_DONTWAIT);
+      if (got > 0)
+      {
+        m_in.m_writeIndex = (m_in.m_writeIndex + (u32) got) % BUFFER_SIZE;
+        m_bytesReceived += got;
+        ++m_transfers;
+        didWork = true;
+      }
+      else if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+      {
+        Shutdown("receive failed");
+      }
+    }
+
+    return didWork;
+  }
+
+  u32 SocketChannel::Ring::Write(const u8 * data, u32 length)
+  {
+    const u32 count = MIN(CanWrite(), length);
+    for (u32 i = 0; i < count; ++i)
+    {
+      m_data[m_writeIndex] = data[i];
+      m_writeIndex = (m_writeIndex + 1) % BUFFER_SIZE;
+    }
+    return count;
+  }
+
+  u32 SocketChannel::Ring::Read(u8 * data, u32 length)
+  {
+    const u32 count = MIN(CanRead(), length);
+    for (u32 i = 0; i < count; ++i)
+    {
+      data[i] = m_data[m_readIndex];
+      m_readIndex = (m_readIndex + 1) % BUFFER_SIZE;
+    }
+    return count;
+  }
+
+  u32 SocketChannel::Ring::GetReadableSpans(u8 * (starts[2]), u32 lengths[2])
+  {
+    const u32 readable = CanRead();
+    if (readable == 0)
+    {
+      return 0;
+    }
+
+    const u32 first = MIN(readable, (u32) BUFFER_SIZE - m_readIndex);
+    starts[0] = &m_data[m_readIndex];
+    lengths[0] = first;
+    if (first == readable)
+    {
+      return 1;
+    }
+    starts[1] = &m_data[0];
+    lengths[1] = readable - first;
+    return 2;
+  }
+
+  u32 SocketChannel::Ring::GetWritableSpans(u8 * (starts[2]), u32 lengths[2])
+  {
+    const u32 writable = CanWrite();
+    if (writable == 0)
+    {
+      return 0;
+    }
+
+    const u32 first = MIN(writable, (u32) BUFFER_SIZE - m_writeIndex);
+    starts[0] = &m_data[m_writeIndex];
+    lengths[0] = first;
+    if (first == writable)
+    {
+      return 1;
+    }
+    starts[1] = &m_data[0];
+    lengths[1] = writable - first;
+    return 2;
+  }
+
+}
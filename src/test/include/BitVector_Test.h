@@ -31,6 +31,10 @@ namespace MFM {
 
     static void Test_bitVectorLong();
 
+    static void Test_bitVectorConstantSpans();
+
+    static void Test_bitVector64BitUnits();
+
   };
 } /* namespace MFM */
 #endif /*BITVECTOR_TEST_H*/
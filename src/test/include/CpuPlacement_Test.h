@@ -0,0 +1,19 @@
+#ifndef CPUPLACEMENT_TEST_H      /* -*- C++ -*- */
+#define CPUPLACEMENT_TEST_H
+
+#include "CpuPlacement.h"
+
+namespace MFM {
+
+  class CpuPlacement_Test
+  {
+  public:
+    static void Test_ParseCpuList();
+    static void Test_GetClaimedPages();
+    static void Test_Init();
+
+    static void Test_RunTests();
+
+  };
+} /* namespace MFM */
+#endif /*CPUPLACEMENT_TEST_H*/
@@ -14,6 +14,8 @@ public:
 
   static void Test_EventWindowNoLockOpen();
 
+  static void Test_EventWindowInertCenter();
+
   static void Test_EventWindowWrite();
 
   static void Test_RunTests();
@@ -15,6 +15,8 @@ namespace MFM {
   {
   public:
     static void Test_gridPlaceAtom();
+    static void Test_gridRuntimeTileSide();
+    static void Test_gridPublishedAtomCounts();
   };
 } /* namespace MFM */
 #endif /*GRID_TEST_H*/
@@ -0,0 +1,18 @@
+#ifndef HUGEPAGEBLOCK_TEST_H      /* -*- C++ -*- */
+#define HUGEPAGEBLOCK_TEST_H
+
+#include "HugePageBlock.h"
+
+namespace MFM {
+
+  class HugePageBlock_Test
+  {
+  public:
+    static void Test_Small();
+    static void Test_Huge();
+
+    static void Test_RunTests();
+
+  };
+} /* namespace MFM */
+#endif /*HUGEPAGEBLOCK_TEST_H*/
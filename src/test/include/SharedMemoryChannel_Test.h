@@ -0,0 +1,19 @@
+#ifndef SHAREDMEMORYCHANNEL_TEST_H      /* -*- C++ -*- */
+#define SHAREDMEMORYCHANNEL_TEST_H
+
+#include "SharedMemoryChannel.h"
+
+namespace MFM {
+
+  class SharedMemoryChannel_Test
+  {
+  public:
+    static void Test_Basic();
+    static void Test_Wraparound();
+    static void Test_AcrossFork();
+
+    static void Test_RunTests();
+
+  };
+} /* namespace MFM */
+#endif /*SHAREDMEMORYCHANNEL_TEST_H*/
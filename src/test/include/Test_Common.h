@@ -23,6 +23,13 @@ namespace MFM {
   typedef Grid<TestGridConfig> TestGrid;
   typedef TestGrid::GridTile TestTile;
 
+  typedef GridConfig<TestEventConfig,0> TestRuntimeGridConfig;
+  typedef Grid<TestRuntimeGridConfig> TestRuntimeGrid;
+
+  typedef Site<P3AtomConfig, SITE_LEAN> TestLeanSite;
+  typedef EventConfig<TestLeanSite, 4> TestLeanEventConfig;
+  typedef SizedTile<TestLeanEventConfig, 40> TestLeanTile;
+
   typedef ElementTable<TestEventConfig> TestElementTable;
   typedef EventWindow<TestEventConfig> TestEventWindow;
 
@@ -6,6 +6,9 @@
 
 #include "UlamElement_Test.h"
 #include "GridTransceiver_Test.h"
+#include "SharedMemoryChannel_Test.h"
+#include "CpuPlacement_Test.h"
+#include "HugePageBlock_Test.h"
 #include "ElementRegistry_Test.h"
 #include "ByteSource_Test.h"
 #include "LineTailByteSink_Test.h"
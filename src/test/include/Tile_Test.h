@@ -13,7 +13,31 @@ namespace MFM {
   public:
     static void Test_RunTests();
 
+    static void Test_tileBehaviorFunction();
+
+    static void Test_tileCacheDigest();
+
+    static void Test_tileCachePipeline();
+
+    static void Test_tileChangeGenerations();
+
+    static void Test_tileCounters();
+
+    static void Test_tileDirectCaches();
+
+    static void Test_tileElementData();
+
+    static void Test_tileElementProfile();
+
+    static void Test_tileLeanSites();
+
+    static void Test_tilePhaseHistograms();
+
     static void Test_tilePlaceAtom();
+
+    static void Test_tileRemoteLock();
+
+    static void Test_tileSnapshot();
     static void Test_tileSquareDistances();
   };
 } /* namespace MFM */
@@ -1,6 +1,7 @@
 #include "assert.h"
 #include "BitVector_Test.h"
 #include "itype.h"
+#include "P3Atom.h"
 
 namespace MFM {
 
@@ -35,6 +36,8 @@ namespace MFM {
     Test_bitVectorSplitWrites();
     Test_bitVectorSetAndClearBits();
     Test_bitVectorStoreBits();
+    Test_bitVectorConstantSpans();
+    Test_bitVector64BitUnits();
   }
 
   static BitVector<256> bits;
@@ -299,4 +302,85 @@ namespace MFM {
     assert(bits->ReadLong(192, 64) == (u64) -1L);
   }
 
+  void BitVector_Test::Test_bitVectorConstantSpans()
+  {
+    BitVector<256>* bits = setup();
+
+    // Single unit, split across units, and empty spans all agree
+    // with the runtime versions
+    assert((bits->Read<0, 32>()) == bits->Read(0, 32));
+    assert((bits->Read<16, 32>()) == 0x13571112);
+    assert((bits->Read<56, 16>()) == 0x00001412);
+    assert((bits->Read<100, 4>()) == bits->Read(100, 4));
+    assert((bits->Read<255, 1>()) == 1);
+    assert((bits->Read<40, 0>()) == 0);
+
+    bits->Write<16, 32>(0xa0a0b0b0);
+    assert(bits->Read(0, 32) == 0x2468a0a0);
+    assert(bits->Read(32, 32) == 0xb0b01314);
+
+    bits->Write<100, 8>(0x5a);
+    assert(bits->Read(96, 32) == 0x95acdef0);
+
+    bits->Write<40, 0>(0xffffffff);   // Ignored
+    assert(bits->Read(32, 32) == 0xb0b01314);
+
+    bits = setup();
+    assert((bits->ReadLong<16, 64>()) == HexU64(0x13571112,0x13141234));
+    assert((bits->ReadLong<160, 36>()) == HexU64(0x8,0x76543214));
+
+    bits->WriteLong<24, 16>(0x5711L);
+    assert((bits->ReadLong<16, 64>()) == HexU64(0x13571112,0x13141234));
+
+    bits->WriteLong<192, 64>((u64) -1L);
+    assert(bits->ReadLong(192, 64) == (u64) -1L);
+
+    // And through P3Atom's fixed-position state fields
+    P3Atom atom(7);
+    atom.SetStateField<3, 9>(0x155);
+    assert(atom.GetStateField(3, 9) == 0x155);
+    assert((atom.GetStateField<3, 9>()) == 0x155);
+    assert((atom.GetStateField<2, 1>()) == 0);
+    assert(atom.GetType() == 7);
+  }
+
+  void BitVector_Test::Test_bitVector64BitUnits()
+  {
+    BitVector<256> narrow(vals);
+    BitVector<256,u64> wide(vals);
+
+    assert(sizeof(wide) == sizeof(narrow));
+    assert(sizeof(BitVector<96,u64>) == 16);
+
+    // Same bits in the same places regardless of unit size
+    for (u32 i = 0; i < 256; i += 4)
+      assert(wide.Read(i, 4) == narrow.Read(i, 4));
+
+    assert(wide.Read(16, 32) == 0x13571112);
+    assert((wide.Read<48, 32>()) == narrow.Read(48, 32));
+    assert((wide.Read<60, 8>()) == narrow.Read(60, 8));
+
+    wide.Write(60, 8, 0xa5);
+    wide.Write<124, 8>(0x5a);
+    narrow.Write(60, 8, 0xa5);
+    narrow.Write<124, 8>(0x5a);
+
+    u32 wideArray[BitVector<256,u64>::U32_LENGTH];
+    u32 narrowArray[BitVector<256>::U32_LENGTH];
+    wide.ToArray(wideArray);
+    narrow.ToArray(narrowArray);
+    for (u32 i = 0; i < 8; ++i)
+      assert(wideArray[i] == narrowArray[i]);
+
+    wide.ClearBits(16, 32*7);
+    narrow.ClearBits(16, 32*7);
+    wide.SetBits(100, 48);
+    narrow.SetBits(100, 48);
+    for (u32 i = 0; i < 256; i += 32)
+      assert(wide.Read(i, 32) == narrow.Read(i, 32));
+
+    assert(wide.ToggleBit(3) == narrow.ToggleBit(3));
+    assert(wide.ReadBit(3) == narrow.ReadBit(3));
+  }
+
 } /* namespace MFM */
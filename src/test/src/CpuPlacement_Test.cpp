@@ -0,0 +1,88 @@
+#include "assert.h"
+#include "CpuPlacement_Test.h"
+#include "itype.h"
+
+namespace MFM {
+
+  static u32 CountFlags(const bool * flags, u32 size)
+  {
+    u32 count = 0;
+    for (u32 i = 0; i < size; ++i)
+    {
+      if (flags[i]) ++count;
+    }
+    return count;
+  }
+
+  static void ClearFlags(bool * flags, u32 size)
+  {
+    for (u32 i = 0; i < size; ++i)
+    {
+      flags[i] = false;
+    }
+  }
+
+  void CpuPlacement_Test::Test_ParseCpuList() {
+    const u32 SIZE = 16;
+    bool flags[SIZE];
+
+    ClearFlags(flags, SIZE);
+    assert(CpuPlacement::ParseCpuList("0-3,8,10-11\n", flags, SIZE));
+    assert(CountFlags(flags, SIZE) == 7);
+    assert(flags[0] && flags[3] && !flags[4] && flags[8] && !flags[9] && flags[11]);
+
+    // Empty lists are fine; CPUs past size are ignored
+    ClearFlags(flags, SIZE);
+    assert(CpuPlacement::ParseCpuList("\n", flags, SIZE));
+    assert(CountFlags(flags, SIZE) == 0);
+    assert(CpuPlacement::ParseCpuList("14-40", flags, SIZE));
+    assert(CountFlags(flags, SIZE) == 2);
+
+    // Junk and backwards ranges are not
+    assert(!CpuPlacement::ParseCpuList("0-3;5", flags, SIZE));
+    assert(!CpuPlacement::ParseCpuList("5-2", flags, SIZE));
+    assert(!CpuPlacement::ParseCpuList("x", flags, SIZE));
+  }
+
+  void CpuPlacement_Test::Test_Init() {
+    CpuPlacement cpus;
+    cpus.Init();
+    assert(cpus.GetCpuCount() > 0);
+    assert(cpus.GetNodeCount() > 0);
+
+    // Nodes come in order, each in one run
+    for (u32 slot = 1; slot < cpus.GetCpuCount(); ++slot)
+    {
+      assert(cpus.GetNode(slot) >= cpus.GetNode(slot - 1));
+    }
+  }
+
+  void CpuPlacement_Test::Test_GetClaimedPages() {
+    const u64 PAGE = 2 * 1024 * 1024;
+    const uptr base = 64 * PAGE;
+    uptr first, last;
+
+    // A range claims the pages whose middles it holds
+    assert(CpuPlacement::GetClaimedPages(base, 3 * PAGE, PAGE, first, last));
+    assert(first == base && last == base + 3 * PAGE);
+    assert(CpuPlacement::GetClaimedPages(base + PAGE / 4, PAGE, PAGE, first, last));
+    assert(first == base && last == base + PAGE);
+
+    // so ranges splitting a page don't both claim it
+    assert(CpuPlacement::GetClaimedPages(base + PAGE / 2, PAGE / 4, PAGE, first, last));
+    assert(first == base && last == base + PAGE);
+    assert(CpuPlacement::GetClaimedPages(base + 3 * PAGE / 4, PAGE, PAGE, first, last));
+    assert(first == base + PAGE && last == base + 2 * PAGE);
+
+    // and a range missing every middle claims none
+    assert(!CpuPlacement::GetClaimedPages(base, PAGE / 4, PAGE, first, last));
+    assert(!CpuPlacement::GetClaimedPages(base + 3 * PAGE / 4, PAGE / 2, PAGE, first, last));
+  }
+
+  void CpuPlacement_Test::Test_RunTests() {
+    Test_ParseCpuList();
+    Test_GetClaimedPages();
+    Test_Init();
+  }
+
+} /* namespace MFM */
@@ -13,6 +13,7 @@ namespace MFM {
   {
     Test_EventWindowConstruction();
     Test_EventWindowNoLockOpen();
+    Test_EventWindowInertCenter();
     Test_EventWindowWrite();
   }
 
@@ -40,6 +41,14 @@ namespace MFM {
     bool success = ew.TryEventAt(center);
     assert(success);
 
+    // Wall is inert, so that event was counted without opening the
+    // window.  Open it directly to check the load.
+    assert(tile.GetAtom(center)->GetType() == WALL_TYPE);
+    assert(ew.IsFree());
+
+    success = ew.InitForEvent(center);
+    assert(success);
+
     TestAtom catom = ew.GetCenterAtomDirect();
 
     assert(catom.GetType() == WALL_TYPE);
@@ -50,6 +59,50 @@ namespace MFM {
 
   }
 
+  void EventWindow_Test::Test_EventWindowInertCenter()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Wall<TestEventConfig>::THE_INSTANCE.AllocateType(etnm);
+    tile.RegisterElement(Element_Wall<TestEventConfig>::THE_INSTANCE);
+    const u32 WALL_TYPE = Element_Wall<TestEventConfig>::THE_INSTANCE.GetType();
+    const u32 EMPTY_TYPE = Element_Empty<TestEventConfig>::THE_INSTANCE.GetType();
+
+    SPoint hidden(15, 20);
+    SPoint shared(5, 20);
+    SPoint east(1, 0);
+    assert(tile.IsInHidden(hidden));
+    assert(tile.IsInShared(shared));
+
+    tile.PlaceAtom(TestAtom(WALL_TYPE,0,0,0), hidden);
+    tile.PlaceAtom(TestAtom(WALL_TYPE,0,0,0), hidden + east);
+    tile.PlaceAtom(TestAtom(WALL_TYPE,0,0,0), shared);
+    tile.SetElementProfiling(true);
+    const ElementProfile * wallProfile = tile.GetElementTable().GetProfile(WALL_TYPE);
+
+    TestEventWindow ew(tile);
+
+    // A hidden inert center is counted, but nothing is run or stored
+    const u32 generation = tile.GetChangeGeneration();
+    bool success = ew.TryEventAt(hidden);
+    assert(success);
+    assert(ew.GetEventWindowsExecuted() == 1);
+    assert(ew.IsFree());
+    assert(wallProfile->m_calls == 0);
+    assert(tile.GetChangeGeneration() == generation);
+    assert(tile.GetAtom(hidden)->GetType() == WALL_TYPE);
+    assert(tile.GetAtom(hidden + east)->GetType() == WALL_TYPE);
+    assert(tile.GetAtom(hidden - east)->GetType() == EMPTY_TYPE);
+
+    // but other threads may write a shared center, so it gets a
+    // full, locked event
+    success = ew.TryEventAt(shared);
+    assert(success);
+    assert(ew.GetEventWindowsExecuted() == 2);
+    assert(wallProfile->m_calls == 1);
+    assert(tile.GetAtom(shared)->GetType() == WALL_TYPE);
+  }
+
   void EventWindow_Test::Test_EventWindowWrite()
   {
     TestTile tile;
@@ -82,7 +135,9 @@ namespace MFM {
 
     TestEventWindow ew(tile);
 
-    bool res = ew.TryEventAt(center);
+    // An event on Empty is counted without loading the window, so
+    // open it directly.
+    bool res = ew.InitForEvent(center);
     assert(res);
 
     ew.SetRelativeAtomDirect(zero, TestAtom(DREG_TYPE,0,0,0));
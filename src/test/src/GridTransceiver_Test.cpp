@@ -1,6 +1,7 @@
 #include "assert.h"
 #include "GridTransceiver_Test.h"
 #include "itype.h"
+#include "Fail.h"
 #include <string.h> // For strlen
 #include <stdio.h> // For fprintf
 
@@ -13,8 +14,9 @@ namespace MFM {
     assert(pt.CanRead(true) == 0);
     assert(pt.CanRead(false) == 0);
 
-    assert(pt.CanWrite(true) == GridTransceiver::BUFFER_SIZE - 1);
-    assert(pt.CanWrite(false) == GridTransceiver::BUFFER_SIZE - 1);
+    assert(pt.GetBufferSize() == GridTransceiver::DEFAULT_BUFFER_SIZE);
+    assert(pt.CanWrite(true) == GridTransceiver::DEFAULT_BUFFER_SIZE - 1);
+    assert(pt.CanWrite(false) == GridTransceiver::DEFAULT_BUFFER_SIZE - 1);
 
     assert(pt.CanXmit(true) == 0);
     assert(pt.CanXmit(false) == 0);
@@ -222,9 +224,64 @@ namespace MFM {
     assert(pt.CanRead(false) == 13 + 11);
   }
 
+  void GridTransceiver_Test::Test_BufferSize() {
+    GridTransceiver pt;
+
+    pt.SetBufferSize(GridTransceiver::MIN_BUFFER_SIZE);
+    assert(pt.GetBufferSize() == GridTransceiver::MIN_BUFFER_SIZE);
+
+    // Not a power of two
+    bool failed = false;
+    unwind_protect({ failed = true; },{ pt.SetBufferSize(300); });
+    assert(failed);
+
+    // Too small
+    failed = false;
+    unwind_protect({ failed = true; },{ pt.SetBufferSize(128); });
+    assert(failed);
+
+    pt.SetEnabled(true);
+    pt.SetMaxInFlight(0);
+    const u32 size = GridTransceiver::MIN_BUFFER_SIZE;
+    assert(pt.CanWrite(true) == size - 1);
+
+    // Not while enabled
+    failed = false;
+    unwind_protect({ failed = true; },{ pt.SetBufferSize(512); });
+    assert(failed);
+
+    // Push several buffers' worth through, wrapping repeatedly
+    u8 out[100], in[100];
+    u32 next = 0, expect = 0;
+    for (u32 round = 0; round < 40; ++round)
+    {
+      for (u32 i = 0; i < sizeof(out); ++i)
+      {
+        out[i] = (u8) (next + i);
+      }
+      next += pt.Write(true, out, sizeof(out));
+      pt.Advance(1000000000);
+      u32 got = pt.Read(false, in, sizeof(in));
+      for (u32 i = 0; i < got; ++i)
+      {
+        assert(in[i] == (u8) (expect + i));
+      }
+      expect += got;
+    }
+    assert(expect > 10 * size);
+
+    // Disabled, the size may change again, and the rings start empty
+    pt.SetEnabled(false);
+    pt.SetBufferSize(512);
+    pt.SetEnabled(true);
+    assert(pt.CanWrite(true) == 511);
+    assert(pt.CanRead(false) == 0);
+  }
+
   void GridTransceiver_Test::Test_RunTests() {
     Test_Basic();
     Test_DataRates();
+    Test_BufferSize();
   }
 
 } /* namespace MFM */
@@ -2,6 +2,7 @@
 #include "Grid.h"
 #include "Grid_Test.h"
 #include "Element_Res.h"
+#include "Fail.h"
 
 namespace MFM {
 
@@ -27,4 +28,92 @@ namespace MFM {
     assert(out->GetType() == atom.GetType());
 
   }
+
+  void Grid_Test::Test_gridRuntimeTileSide()
+  {
+    ElementRegistry<TestEventConfig> ereg;
+
+    // A compile-time side must be given as itself
+    bool failed = false;
+    unwind_protect({ failed = true; },{ TestGrid wrong(ereg,1,1,48); });
+    assert(failed);
+
+    // A runtime side must be even and in range
+    failed = false;
+    unwind_protect({ failed = true; },{ TestRuntimeGrid odd(ereg,1,1,41); });
+    assert(failed);
+
+    failed = false;
+    unwind_protect({ failed = true; },{
+        TestRuntimeGrid tiny(ereg,1,1,TestRuntimeGrid::MIN_TILE_SIDE - 2);
+      });
+    assert(failed);
+
+    const u32 SIDE = 50;  // No SizedTile of this side anywhere
+    const u32 OWNED = SIDE - 2 * TestEventConfig::EVENT_WINDOW_RADIUS;
+    TestRuntimeGrid grid(ereg,3,2,SIDE);
+
+    assert(grid.GetTileSide() == SIDE);
+    assert(grid.GetOwnedSide() == OWNED);
+    assert(grid.GetWidthSites() == 3 * OWNED);
+    assert(grid.GetHeightSites() == 2 * OWNED);
+    assert(grid.GetTile(SPoint(2,1)).GetTileSide() == SIDE);
+
+    grid.SetSeed(1);
+    grid.Init();
+
+    grid.Needed(Element_Res<TestEventConfig>::THE_INSTANCE);
+
+    TestAtom atom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+
+    // Every tile's sites are its own, out to the far corner
+    for (u32 x = 0; x < grid.GetWidthSites(); x += OWNED - 1)
+    {
+      for (u32 y = 0; y < grid.GetHeightSites(); y += OWNED - 1)
+      {
+        grid.PlaceAtom(atom, SPoint(x, y));
+      }
+    }
+
+    for (u32 x = 0; x < grid.GetWidthSites(); ++x)
+    {
+      for (u32 y = 0; y < grid.GetHeightSites(); ++y)
+      {
+        SPoint gloc(x, y);
+        const TestAtom * out = grid.GetAtom(gloc);
+        const bool placed = x % (OWNED - 1) == 0 && y % (OWNED - 1) == 0;
+        assert((out->GetType() == atom.GetType()) == placed);
+      }
+    }
+  }
+
+  void Grid_Test::Test_gridPublishedAtomCounts()
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,2,2);
+
+    grid.SetSeed(1);
+    grid.Init();
+
+    grid.Needed(Element_Res<TestEventConfig>::THE_INSTANCE);
+
+    TestAtom atom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    const u32 type = atom.GetType();
+    Tile<TestEventConfig> & tile = grid.GetTile(SPoint(0, 0));
+
+    // Nothing published until a count
+    grid.PlaceAtom(atom, SPoint(5, 10));
+    assert(tile.GetPublishedAtomCount(type) == 0);
+
+    // A paused grid recounts, and publishes what it counted
+    assert(grid.GetAtomCount(type) == 1);
+    assert(tile.GetPublishedAtomCount(type) == 1);
+
+    // Readers of published counts never trigger a recount
+    grid.PlaceAtom(atom, SPoint(6, 10));
+    assert(tile.GetPublishedAtomCount(type) == 1);
+    tile.PublishAtomCounts();
+    assert(tile.GetPublishedAtomCount(type) == 2);
+    assert(grid.GetAtomCount(type) == 2);
+  }
 } /* namespace MFM */
@@ -0,0 +1,56 @@
+#include "assert.h"
+#include "HugePageBlock_Test.h"
+#include "itype.h"
+
+namespace MFM {
+
+  void HugePageBlock_Test::Test_Small() {
+    HugePageBlock block;
+    assert(block.GetBacking() == HugePageBlock::BACKING_NONE);
+
+    // Less than a huge page gets ordinary pages
+    u8 * mem = (u8 *) block.Allocate(10000);
+    assert(mem);
+    assert(block.GetBacking() == HugePageBlock::BACKING_NORMAL);
+    assert(block.GetBytes() == 10000);
+    assert(block.GetHugeBytes() == 0);
+    assert(block.GetPageBytes() > 0 && block.GetPageBytes() < HugePageBlock::GetHugePageBytes());
+    assert(mem[0] == 0 && mem[9999] == 0);
+    mem[9999] = 1;
+
+    block.Free();
+    assert(block.GetBacking() == HugePageBlock::BACKING_NONE);
+  }
+
+  void HugePageBlock_Test::Test_Huge() {
+    HugePageBlock block;
+    // Whatever the system's huge page size, it's a power of two
+    const u64 huge = HugePageBlock::GetHugePageBytes();
+    assert(huge >= 4096 && (huge & (huge - 1)) == 0);
+
+    const u64 bytes = 3 * huge + 12345;
+    u8 * mem = (u8 *) block.Allocate(bytes);
+    assert(block.GetBacking() != HugePageBlock::BACKING_NONE);
+
+    // Huge pages, if we got them, start on a huge page boundary
+    if (block.GetBacking() != HugePageBlock::BACKING_NORMAL)
+    {
+      assert(((uptr) mem) % block.GetPageBytes() == 0);
+    }
+
+    // All of it is zeroed and writable
+    for (u64 i = 0; i < bytes; i += 4096)
+    {
+      assert(mem[i] == 0);
+      mem[i] = 1;
+    }
+    assert(mem[bytes - 1] == 0);
+    assert(block.GetHugeBytes() <= 4 * block.GetPageBytes());
+  }
+
+  void HugePageBlock_Test::Test_RunTests() {
+    Test_Small();
+    Test_Huge();
+  }
+
+} /* namespace MFM */
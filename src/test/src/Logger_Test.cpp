@@ -1,7 +1,11 @@
 #include "assert.h"
 #include "Logger_Test.h"
 #include "CharBufferByteSink.h"
+#include "LogRing.h"
+#include "TraceBuffer.h"
 #include <stdlib.h>        /* For strtol */
+#include <pthread.h>
+#include <stdio.h>         /* For sscanf */
 
 namespace MFM {
   typedef CharBufferByteSink<1024> CBS1K;
@@ -79,9 +83,187 @@ namespace MFM {
     }
   }
 
+  static void Test_LogRing() {
+    LogRing<4,8> ring;
+    char buf[8];
+    u32 tag;
+
+    assert(ring.Pop(tag, buf) < 0);
+
+    assert(ring.Push(1, "one", 3));
+    assert(ring.Push(2, "two", 3));
+    assert(ring.Push(3, "three", 5));
+    assert(ring.Push(4, "fourteen", 8));  // truncated to 7
+    assert(!ring.Push(5, "five", 4));     // full
+
+    assert(ring.Pop(tag, buf) == 3 && tag == 1 && !strcmp(buf, "one"));
+    assert(ring.Push(5, "five", 4));      // room again
+
+    assert(ring.Pop(tag, buf) == 3 && tag == 2 && !strcmp(buf, "two"));
+    assert(ring.Pop(tag, buf) == 5 && tag == 3 && !strcmp(buf, "three"));
+    assert(ring.Pop(tag, buf) == 7 && tag == 4 && !strcmp(buf, "fourtee"));
+    assert(ring.Pop(tag, buf) == 4 && tag == 5 && !strcmp(buf, "five"));
+    assert(ring.Pop(tag, buf) < 0);
+  }
+
+  static void Test_Async() {
+    {
+      tbuf.Reset();
+      Logger log(tbuf,Logger::MESSAGE);
+      log.SetTimeStamper(&NullSerializable);
+      log.StartAsync();
+      assert(log.IsAsync());
+      log.Debug("%d captains: %s vs %s", 2, "Scarlet", "Kirk");
+      log.Message("This is %s", "Captain Black");
+      log.Warning("We know that you can %s us, %s","hear","Earthman");
+      log.StopAsync();
+      assert(!log.IsAsync());
+      log.Error("Must sterilize");
+      assert(!strcmp("MSG: This is Captain Black\n"
+                     "WRN: We know that you can hear us, Earthman\n"
+                     "ERR: Must sterilize\n",
+                     tbuf.GetZString()));
+      assert(log.GetDroppedRecords() == 0);
+    }
+  }
+
+  /* Prints whatever phase the test is in when a message is stamped */
+  class PhaseStamper : public ByteSerializable {
+  public:
+    const char * m_phase;
+    PhaseStamper() : m_phase("") { }
+    virtual Result ReadFrom(ByteSource & byteSource, s32 argument = 0) {
+      return UNSUPPORTED;
+    }
+    virtual Result PrintTo(ByteSink & byteSink, s32 argument = 0) {
+      byteSink.Print(m_phase);
+      return SUCCESS;
+    }
+  };
+
+  static void Test_AsyncStampedWhenLogged() {
+    tbuf.Reset();
+    PhaseStamper stamper;
+    Logger log(tbuf,Logger::MESSAGE);
+    log.SetTimeStamper(&stamper);
+    log.StartAsync();
+    stamper.m_phase = "[1]";
+    log.Message("first");
+    stamper.m_phase = "[2]";
+    log.Message("second");
+    stamper.m_phase = "[late]";
+    log.StopAsync();
+    assert(!strcmp("[1]MSG: first\n"
+                   "[2]MSG: second\n",
+                   tbuf.GetZString()));
+  }
+
+  static const u32 RACE_THREADS = 4;
+  static const u32 RACE_MESSAGES = 500;
+
+  struct RaceArgs {
+    Logger * m_log;
+    u32 m_id;
+    volatile bool m_done;
+  };
+
+  static void * RaceLogger(void * arg) {
+    RaceArgs & ra = *(RaceArgs *) arg;
+    for (u32 i = 0; i < RACE_MESSAGES; ++i)
+    {
+      ra.m_log->Message("T%d %d", ra.m_id, i);
+    }
+    ra.m_done = true;
+    return 0;
+  }
+
+  static void Test_AsyncStopRace() {
+    static CharBufferByteSink<RACE_THREADS * RACE_MESSAGES * 32> rbuf;
+    rbuf.Reset();
+    Logger log(rbuf,Logger::MESSAGE);
+    log.SetTimeStamper(&NullSerializable);
+
+    RaceArgs args[RACE_THREADS];
+    pthread_t threads[RACE_THREADS];
+    for (u32 t = 0; t < RACE_THREADS; ++t)
+    {
+      args[t].m_log = &log;
+      args[t].m_id = t;
+      args[t].m_done = false;
+      assert(!pthread_create(&threads[t], NULL, RaceLogger, &args[t]));
+    }
+
+    // Flip modes under the loggers until they are all through
+    bool running = true;
+    while (running)
+    {
+      log.StartAsync();
+      log.StopAsync();
+      running = false;
+      for (u32 t = 0; t < RACE_THREADS; ++t)
+      {
+        running = running || !args[t].m_done;
+      }
+    }
+    for (u32 t = 0; t < RACE_THREADS; ++t)
+    {
+      pthread_join(threads[t], NULL);
+    }
+
+    // Every message is either written, in per-thread order, or counted dropped
+    u32 next[RACE_THREADS] = { 0 };
+    u32 written = 0;
+    const char * p = rbuf.GetZString();
+    while (*p)
+    {
+      u32 id, seq;
+      if (sscanf(p, "MSG: T%u %u", &id, &seq) == 2)
+      {
+        assert(id < RACE_THREADS && seq >= next[id]);
+        next[id] = seq + 1;
+        ++written;
+      }
+      p = strchr(p, '\n');
+      assert(p);
+      ++p;
+    }
+    assert(written + log.GetDroppedRecords() == RACE_THREADS * RACE_MESSAGES);
+  }
+
+  static void Test_TraceBuffer() {
+    CBS1K traceOut;
+    TraceBuffer tb;
+    assert(!tb.IsRecording(6));
+
+    tb.Start(3, traceOut, 6);
+    assert(tb.IsRecording(6));
+    assert(!tb.IsRecording(7));
+    tb.Record(6, TRACE_EW_TRY_EVENT, 17, 5, 9, 0);
+    tb.Record(6, TRACE_EW_LOCKS_SHORT, 18, 1, 3, 0);
+    assert(traceOut.GetLength() == 0);  // Buffered until Stop
+    tb.Stop();
+    assert(!tb.IsRecording(6));
+    assert(traceOut.GetLength() == 2 * sizeof(TraceRecord));
+
+    TraceRecord recs[2];
+    memcpy(recs, traceOut.GetZString(), sizeof(recs));
+    assert(recs[0].m_tileId == 3 && recs[0].m_eventId == 17);
+    assert(recs[0].m_code == TRACE_EW_TRY_EVENT && recs[0].m_level == 6);
+    assert(recs[0].m_args[0] == 5 && recs[0].m_args[1] == 9);
+    assert(recs[1].m_code == TRACE_EW_LOCKS_SHORT && recs[1].m_args[1] == 3);
+    assert(recs[0].m_timestamp <= recs[1].m_timestamp);
+
+    assert(!strcmp("EW_LOCKS_SHORT", TraceBuffer::GetCodeName(TRACE_EW_LOCKS_SHORT)));
+  }
+
   void Logger_Test::Test_RunTests() {
     Test_Basic();
     Test_IfLog();
+    Test_LogRing();
+    Test_Async();
+    Test_AsyncStampedWhenLogged();
+    Test_AsyncStopRace();
+    Test_TraceBuffer();
   }
 
 } /* namespace MFM */
@@ -0,0 +1,117 @@
+#include "assert.h"
+#include "SharedMemoryChannel_Test.h"
+#include "itype.h"
+#include <string.h>    // For strlen, memcmp
+#include <unistd.h>    // For fork, _exit
+#include <sys/wait.h>  // For waitpid
+
+namespace MFM {
+
+  void SharedMemoryChannel_Test::Test_Basic() {
+    SharedMemoryChannel smc;
+    assert(!smc.IsCreated());
+    smc.Create(SharedMemoryChannel::MIN_CAPACITY);
+    assert(smc.IsCreated());
+    assert(smc.GetCapacity() == SharedMemoryChannel::MIN_CAPACITY);
+
+    assert(smc.CanRead(true) == 0);
+    assert(smc.CanRead(false) == 0);
+    assert(smc.CanWrite(true) == SharedMemoryChannel::MIN_CAPACITY);
+    assert(smc.CanWrite(false) == SharedMemoryChannel::MIN_CAPACITY);
+
+    // 'foo' from a to b, 'barf' from b to a, each readable at once
+    const char * aWrite = "foo";
+    const char * bWrite = "barf";
+    assert(smc.Write(true, (const u8 *) aWrite, 3) == 3);
+    assert(smc.Write(false, (const u8 *) bWrite, 4) == 4);
+    assert(smc.CanRead(false) == 3);
+    assert(smc.CanRead(true) == 4);
+    assert(smc.CanWrite(true) == SharedMemoryChannel::MIN_CAPACITY - 3);
+
+    u8 buf[SharedMemoryChannel::MIN_CAPACITY + 10];
+    assert(smc.Read(false, buf, sizeof(buf)) == 3);
+    assert(!memcmp(buf, aWrite, 3));
+    assert(smc.Read(true, buf, 2) == 2);
+    assert(!memcmp(buf, "ba", 2));
+    assert(smc.CanRead(true) == 2);
+
+    // Nothing to wait for on a, so no sleep; nothing at all on b
+    assert(smc.WaitToRead(true, 1000000));
+    assert(!smc.WaitToRead(false, 10));
+
+    // Writes stop at capacity
+    u8 fill[SharedMemoryChannel::MIN_CAPACITY + 10];
+    memset(fill, 'x', sizeof(fill));
+    assert(smc.Write(true, fill, sizeof(fill)) == SharedMemoryChannel::MIN_CAPACITY);
+    assert(smc.CanWrite(true) == 0);
+    assert(smc.Write(true, fill, 1) == 0);
+  }
+
+  void SharedMemoryChannel_Test::Test_Wraparound() {
+    SharedMemoryChannel smc;
+    smc.Create(SharedMemoryChannel::MIN_CAPACITY);
+
+    // Stream more than the capacity through, in odd-sized pieces
+    u8 out[13];
+    u8 in[13];
+    u32 next = 0;
+    u32 expected = 0;
+    for (u32 round = 0; round < 50; ++round)
+    {
+      for (u32 i = 0; i < sizeof(out); ++i)
+      {
+        out[i] = (u8) next++;
+      }
+      assert(smc.Write(false, out, sizeof(out)) == sizeof(out));
+      assert(smc.Read(true, in, sizeof(in)) == sizeof(in));
+      for (u32 i = 0; i < sizeof(in); ++i)
+      {
+        assert(in[i] == (u8) expected++);
+      }
+    }
+    assert(smc.CanRead(true) == 0);
+  }
+
+  void SharedMemoryChannel_Test::Test_AcrossFork() {
+    SharedMemoryChannel smc;
+    smc.Create(1024);
+
+    const char * msg = "hello from side A";
+    const u32 len = strlen(msg);
+
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0)
+    {
+      // Child: wait for the parent's go-ahead, then answer on side A
+      u8 go;
+      while (!smc.WaitToRead(true, 100000))
+      { }
+      assert(smc.Read(true, &go, 1) == 1);
+      _exit(smc.Write(true, (const u8 *) msg, len) == len ? 0 : 1);
+    }
+
+    const u8 go = 'g';
+    assert(smc.Write(false, &go, 1) == 1);
+
+    u8 buf[64];
+    u32 got = 0;
+    while (got < len)
+    {
+      smc.WaitToRead(false, 100000);
+      got += smc.Read(false, buf + got, len - got);
+    }
+    assert(!memcmp(buf, msg, len));
+
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+
+  void SharedMemoryChannel_Test::Test_RunTests() {
+    Test_Basic();
+    Test_Wraparound();
+    Test_AcrossFork();
+  }
+
+} /* namespace MFM */
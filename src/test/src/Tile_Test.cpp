@@ -3,12 +3,29 @@
 #include "Point.h"
 #include "Tile_Test.h"
 #include "Element_Res.h"
+#include "GridTransceiver.h"
+#include "LonglivedLock.h"
+#include "SocketChannel.h"
+
+#include <sys/socket.h>  /* For socketpair */
 
 namespace MFM {
 
   void Tile_Test::Test_RunTests() {
     Test_tileSquareDistances();
     Test_tilePlaceAtom();
+    Test_tileSnapshot();
+    Test_tileChangeGenerations();
+    Test_tileCounters();
+    Test_tilePhaseHistograms();
+    Test_tileElementProfile();
+    Test_tileBehaviorFunction();
+    Test_tileElementData();
+    Test_tileCachePipeline();
+    Test_tileCacheDigest();
+    Test_tileDirectCaches();
+    Test_tileRemoteLock();
+    Test_tileLeanSites();
   }
 
   void Tile_Test::Test_tileSquareDistances()
@@ -56,4 +73,668 @@ namespace MFM {
 
     assert(other.GetType() == atom.GetType());
   }
+
+  void Tile_Test::Test_tileSnapshot()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateType(etnm);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+
+    const u32 W = tile.TILE_SIDE;
+    SPoint loc(10, 10);
+    TestAtom atom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+
+    // Nothing to acquire until enabled and published
+    tile.PublishSnapshot();
+    assert(tile.AcquireSnapshot() == 0);
+
+    tile.InitSnapshots();
+    assert(tile.AcquireSnapshot() == 0);
+
+    tile.PublishSnapshot();
+    const TestEventConfig::SITE * snap = tile.AcquireSnapshot();
+    assert(snap != 0);
+    assert(snap[loc.GetY() * W + loc.GetX()].GetAtom().GetType() != atom.GetType());
+
+    // The acquired snapshot is unchanged by later edits and publishes
+    tile.PlaceAtom(atom, loc);
+    assert(snap[loc.GetY() * W + loc.GetX()].GetAtom().GetType() != atom.GetType());
+    tile.PublishSnapshot();
+    tile.PublishSnapshot();
+    assert(snap[loc.GetY() * W + loc.GetX()].GetAtom().GetType() != atom.GetType());
+
+    // until the next acquire, which sees the latest publish
+    const TestEventConfig::SITE * newSnap = tile.AcquireSnapshot();
+    assert(newSnap != snap);
+    assert(newSnap[loc.GetY() * W + loc.GetX()].GetAtom().GetType() == atom.GetType());
+    assert(tile.AcquireSnapshot() == newSnap);
+
+    // and a publish with nothing changed since makes no new copy
+    tile.PublishSnapshot();
+    assert(tile.AcquireSnapshot() == newSnap);
+
+    // Block generations are those published with the snapshot
+    const u32 B = TestTile::CHANGE_BLOCK_SIDE;
+    const u32 bx = loc.GetX() / B, by = loc.GetY() / B;
+    const u32 published = tile.GetSnapshotBlockChangeGeneration(bx, by);
+    assert(published == tile.GetBlockChangeGeneration(bx, by));
+    tile.ClearAtoms();
+    assert(tile.GetBlockChangeGeneration(bx, by) != published);
+    assert(tile.GetSnapshotBlockChangeGeneration(bx, by) == published);
+  }
+
+  void Tile_Test::Test_tileChangeGenerations()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateType(etnm);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+
+    const u32 B = TestTile::CHANGE_BLOCK_SIDE;
+    SPoint loc(10, 10);
+    TestAtom atom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+
+    const u32 before = tile.GetChangeGeneration();
+    const u32 otherBlock = tile.GetBlockChangeGeneration(0, 0);
+
+    // A change stamps its own block and no other
+    tile.PlaceAtom(atom, loc);
+    const u32 after = tile.GetChangeGeneration();
+    assert(after != before);
+    assert(tile.GetBlockChangeGeneration(loc.GetX() / B, loc.GetY() / B) == after);
+    assert(tile.GetBlockChangeGeneration(0, 0) == otherBlock);
+
+    // Storing the same atom again changes nothing
+    tile.PlaceAtom(atom, loc);
+    assert(tile.GetChangeGeneration() == after);
+
+    // Clearing stamps every block
+    tile.ClearAtoms();
+    const u32 cleared = tile.GetChangeGeneration();
+    assert(cleared != after);
+    const u32 blocks = tile.GetChangeBlocksPerSide();
+    for (u32 by = 0; by < blocks; ++by)
+    {
+      for (u32 bx = 0; bx < blocks; ++bx)
+      {
+        assert(tile.GetBlockChangeGeneration(bx, by) == cleared);
+      }
+    }
+  }
+
+  void Tile_Test::Test_tileCounters()
+  {
+    TestTile tile;
+    TileCounters counters;
+    tile.AddCounters(counters);
+    assert(counters.m_eventsAttempted == 0);
+    assert(counters.m_idleAdvances == 0);
+
+    // An unconnected tile needs no locks and ships no packets, so
+    // only events rejected on recency leave an Advance idle
+    const u32 EVENTS = 1000;
+    tile.RequestStateActive();
+    for (u32 i = 0; i < EVENTS; ++i)
+    {
+      tile.Advance();
+    }
+
+    tile.AddCounters(counters);
+    assert(counters.m_eventsAttempted == EVENTS);
+    assert(counters.m_eventsExecuted + counters.m_recencyRejections == EVENTS);
+    assert(counters.m_eventsExecuted > 0);
+    assert(counters.m_lockFailures == 0);
+    assert(counters.m_packetsShipped == 0);
+    assert(counters.m_idleAdvances == counters.m_recencyRejections);
+
+    TileCounters total;
+    total.Add(counters);
+    total.Add(counters);
+    assert(total.m_eventsAttempted == 2 * EVENTS);
+    total.Clear();
+    assert(total.m_eventsAttempted == 0);
+
+    // The CSV header and rows must have the same columns
+    OString512 header, row;
+    TileCounters::PrintCSVHeader(header);
+    counters.PrintCSV(row);
+    u32 headerCommas = 0, rowCommas = 0;
+    for (const char * p = header.GetZString(); *p; ++p) headerCommas += *p == ',';
+    for (const char * p = row.GetZString(); *p; ++p) rowCommas += *p == ',';
+    assert(headerCommas == rowCommas);
+  }
+
+  void Tile_Test::Test_tilePhaseHistograms()
+  {
+    assert(LatencyHistogram::GetBucket(0) == 0);
+    assert(LatencyHistogram::GetBucket(1) == 0);
+    assert(LatencyHistogram::GetBucket(2) == 1);
+    assert(LatencyHistogram::GetBucket(3) == 1);
+    assert(LatencyHistogram::GetBucket(1024) == 10);
+    assert(LatencyHistogram::GetBucket(U64_MAX) == LatencyHistogram::BUCKET_COUNT - 1);
+
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateType(etnm);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+
+    // Res everywhere, so events get as far as their locks
+    const u32 W = tile.TILE_SIDE;
+    TestAtom atom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    for (u32 x = 0; x < W; ++x)
+    {
+      for (u32 y = 0; y < W; ++y)
+      {
+        tile.PlaceAtom(atom, SPoint(x, y));
+      }
+    }
+
+    // Nothing is timed until asked for
+    tile.RequestStateActive();
+    for (u32 i = 0; i < 500; ++i)
+    {
+      tile.Advance();
+    }
+    const PhaseHistograms & ph = tile.GetPhaseHistograms();
+    assert(ph.m_phases[PhaseHistograms::LOCK].GetSamples() == 0);
+
+    // Every event that tries for its locks is timed through every
+    // event window phase, and an unconnected tile never ships
+    tile.SetPhaseSampleOdds(1);
+    for (u32 i = 0; i < 500; ++i)
+    {
+      tile.Advance();
+    }
+    const u64 samples = ph.m_phases[PhaseHistograms::LOCK].GetSamples();
+    assert(samples > 0);
+    assert(ph.m_phases[PhaseHistograms::LOAD].GetSamples() == samples);
+    assert(ph.m_phases[PhaseHistograms::BEHAVIOR].GetSamples() == samples);
+    assert(ph.m_phases[PhaseHistograms::STORE].GetSamples() == samples);
+    assert(ph.m_phases[PhaseHistograms::SHIP].GetSamples() == 0);
+    assert(ph.m_phases[PhaseHistograms::BLOCK].GetSamples() == 0);
+
+    // Sums of histograms are histograms
+    PhaseHistograms total;
+    total.Add(ph);
+    total.Add(ph);
+    assert(total.m_phases[PhaseHistograms::LOAD].GetSamples() == 2 * samples);
+
+    // Timing 1 in 10 events times fewer of them
+    PhaseHistograms before;
+    before.Add(ph);
+    tile.SetPhaseSampleOdds(10);
+    for (u32 i = 0; i < 500; ++i)
+    {
+      tile.Advance();
+    }
+    const u64 more = ph.m_phases[PhaseHistograms::LOCK].GetSamples() -
+      before.m_phases[PhaseHistograms::LOCK].GetSamples();
+    assert(more > 0 && more < samples);
+  }
+
+  void Tile_Test::Test_tileElementProfile()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateType(etnm);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+    const u32 RES_TYPE = Element_Res<TestEventConfig>::THE_INSTANCE.GetType();
+
+    const u32 W = tile.TILE_SIDE;
+    TestAtom atom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    for (u32 x = 0; x < W; x += 2)
+    {
+      for (u32 y = 0; y < W; y += 2)
+      {
+        tile.PlaceAtom(atom, SPoint(x, y));
+      }
+    }
+
+    const ElementProfile * profile = tile.GetElementTable().GetProfile(RES_TYPE);
+    assert(profile != 0);
+    assert(tile.GetElementTable().GetProfile(RES_TYPE + 1) == 0);
+
+    // Nothing is recorded until asked for
+    tile.RequestStateActive();
+    for (u32 i = 0; i < 500; ++i)
+    {
+      tile.Advance();
+    }
+    assert(profile->m_calls == 0);
+
+    // Diffusing Res write sites as they go
+    tile.SetElementProfiling(true);
+    for (u32 i = 0; i < 500; ++i)
+    {
+      tile.Advance();
+    }
+    assert(profile->m_calls > 0);
+    assert(profile->m_maxCycles <= profile->m_cycles);
+    assert(profile->m_sitesWritten > 0);
+
+    ElementProfile total;
+    total.Add(*profile);
+    total.Add(*profile);
+    assert(total.m_calls == 2 * profile->m_calls);
+    assert(total.m_maxCycles == profile->m_maxCycles);
+  }
+
+  /* Counts whether ElementTable runs it directly or virtually */
+  class CountingElement : public Element<TestEventConfig>
+  {
+    typedef TestEventConfig EC;  // For MFM_UUID_FOR
+
+  public:
+    mutable u32 m_directCalls;
+    mutable u32 m_virtualCalls;
+
+    CountingElement(const char * label, bool direct)
+      : Element<TestEventConfig>(MFM_UUID_FOR(label, 1))
+      , m_directCalls(0)
+      , m_virtualCalls(0)
+    {
+      SetAtomicSymbol("Ct");
+      SetName(label);
+      if (direct)
+      {
+        SetBehaviorFunction(&CountDirect);
+      }
+    }
+
+    static void CountDirect(const Element<TestEventConfig> & elt, TestEventWindow & window)
+    {
+      ++static_cast<const CountingElement &>(elt).m_directCalls;
+    }
+
+    virtual void Behavior(TestEventWindow & window) const
+    {
+      ++m_virtualCalls;
+    }
+
+    virtual u32 DefaultPhysicsColor() const
+    {
+      return 0xffffffff;
+    }
+  };
+
+  static void RunCountingElement(CountingElement & elt)
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    elt.AllocateType(etnm);
+    tile.RegisterElement(elt);
+
+    const u32 W = tile.TILE_SIDE;
+    for (u32 x = 0; x < W; ++x)
+    {
+      for (u32 y = 0; y < W; ++y)
+      {
+        tile.PlaceAtom(elt.GetDefaultAtom(), SPoint(x, y));
+      }
+    }
+
+    tile.RequestStateActive();
+    for (u32 i = 0; i < 500; ++i)
+    {
+      tile.Advance();
+    }
+  }
+
+  void Tile_Test::Test_tileBehaviorFunction()
+  {
+    // An installed behavior function replaces the virtual call
+    CountingElement direct("CountDirect", true);
+    RunCountingElement(direct);
+    assert(direct.m_directCalls > 0);
+    assert(direct.m_virtualCalls == 0);
+
+    // and without one, Behavior runs
+    CountingElement virt("CountVirtual", false);
+    RunCountingElement(virt);
+    assert(virt.m_directCalls == 0);
+    assert(virt.m_virtualCalls > 0);
+  }
+
+  void Tile_Test::Test_tileElementData()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateType(etnm);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+    const u32 RES_TYPE = Element_Res<TestEventConfig>::THE_INSTANCE.GetType();
+    ElementTable<TestEventConfig> & et = tile.GetElementTable();
+
+    // Nothing until registered, and only for registered elements
+    assert(et.GetDataIfRegistered(RES_TYPE, 2) == 0);
+    assert(!et.AllocateElementDataSlotsFromType(RES_TYPE + 1, 2));
+
+    u64 * datap = et.GetDataAndRegister(RES_TYPE, 2);
+    assert(datap != 0);
+    assert(datap[0] == 0 && datap[1] == 0);
+    ++datap[1];
+
+    // Same slots again, but only at the same size
+    assert(et.GetDataAndRegister(RES_TYPE, 2) == datap);
+    assert(et.GetDataIfRegistered(RES_TYPE, 2) == datap);
+    assert(et.GetDataIfRegistered(RES_TYPE, 3) == 0);
+    assert(datap[1] == 1);
+
+    // Reinit frees the slots
+    et.Reinit();
+    assert(et.GetDataIfRegistered(RES_TYPE, 2) == 0);
+  }
+
+  static void DeliverAll(GridTransceiver & gt, CacheProcessor<TestEventConfig> & a,
+                         CacheProcessor<TestEventConfig> & b)
+  {
+    for (u32 i = 0; i < 10; ++i)
+    {
+      gt.Advance(1000000);
+      a.Advance();
+      b.Advance();
+    }
+  }
+
+  void Tile_Test::Test_tileCachePipeline()
+  {
+    TestTile west;
+    TestTile east;
+    GridTransceiver gt;
+    LonglivedLock lock;
+    west.Connect(gt, lock, Dirs::EAST);
+    east.Connect(gt, lock, Dirs::WEST);
+    gt.SetEnabled(true);
+    gt.SetDataRate(100000000);
+
+    CacheProcessor<TestEventConfig> & cp = west.GetCacheProcessor(Dirs::EAST);
+    CacheProcessor<TestEventConfig> & peer = east.GetCacheProcessor(Dirs::WEST);
+    assert(cp.GetPipelineDepth() == 1);
+
+    const u32 W = west.TILE_SIDE;
+    const SPoint first(W - 6, 10);
+    const SPoint overlapping(W - 6, 14);
+    const SPoint distant(W - 6, 30);
+
+    // Classic protocol: nothing more until the reply comes back
+    assert(cp.TryLock(Dirs::EAST));
+    cp.Activate();
+    cp.StartLoading(first);
+    cp.StartShipping(false);
+    cp.Advance();
+    assert(cp.GetOutstandingUpdates() == 1);
+    assert(!cp.CanPipelineEvent(Dirs::EAST, distant));
+    DeliverAll(gt, cp, peer);
+    assert(cp.IsIdle() && peer.IsIdle());
+    assert(cp.GetOutstandingUpdates() == 0);
+
+    // Pipelined: a second, non-overlapping update before any reply
+    west.SetCachePipelineDepth(2);
+    east.SetCachePipelineDepth(2);
+    assert(cp.TryLock(Dirs::EAST));
+    cp.Activate();
+    cp.StartLoading(first);
+    cp.StartShipping(false);
+    cp.Advance();
+    assert(!cp.CanPipelineEvent(Dirs::EAST, overlapping));
+    assert(!cp.CanPipelineEvent(Dirs::NORTHEAST, distant));
+    assert(cp.CanPipelineEvent(Dirs::EAST, distant));
+    cp.Activate();
+    cp.StartLoading(distant);
+    cp.StartShipping(false);
+    cp.Advance();
+    assert(cp.GetOutstandingUpdates() == 2);
+
+    // Tenure is full at the pipeline depth
+    assert(!cp.CanPipelineEvent(Dirs::EAST, SPoint(W - 6, 20)));
+
+    // Both replies drain in order, and the lock is released
+    DeliverAll(gt, cp, peer);
+    assert(cp.IsIdle() && peer.IsIdle());
+    assert(cp.GetOutstandingUpdates() == 0);
+
+    TileCounters counters;
+    west.AddCounters(counters);
+    assert(counters.m_consistencyFailures == 0);
+    assert(counters.m_packetsShipped == 2 + 4);  // Begins and ends only
+  }
+
+  static void ShipEmptyUpdate(GridTransceiver & gt, CacheProcessor<TestEventConfig> & cp,
+                              CacheProcessor<TestEventConfig> & peer, const SPoint & center,
+                              Dir dir)
+  {
+    assert(cp.TryLock(dir));
+    cp.Activate();
+    cp.StartLoading(center);
+    cp.StartShipping(false);
+    DeliverAll(gt, cp, peer);
+    assert(cp.IsIdle() && peer.IsIdle());
+  }
+
+  void Tile_Test::Test_tileCacheDigest()
+  {
+    TestTile west;
+    TestTile east;
+    GridTransceiver gt;
+    LonglivedLock lock;
+    west.Connect(gt, lock, Dirs::EAST);
+    east.Connect(gt, lock, Dirs::WEST);
+    gt.SetEnabled(true);
+    gt.SetDataRate(100000000);
+
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateType(etnm);
+    west.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+    east.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+    TestAtom res(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    const u32 emptyType = Element_Empty<TestEventConfig>::THE_INSTANCE.GetType();
+
+    west.SetCacheDigestPeriod(1);
+    east.SetCacheDigestPeriod(1);
+    CacheProcessor<TestEventConfig> & cp = west.GetCacheProcessor(Dirs::EAST);
+    CacheProcessor<TestEventConfig> & peer = east.GetCacheProcessor(Dirs::WEST);
+
+    const u32 W = west.TILE_SIDE;
+    const u32 R = TestEventConfig::EVENT_WINDOW_RADIUS;
+    const SPoint center(W - R - 2, W / 2);
+    const SPoint eastCenter(R + 2, W / 2);
+    const u32 halfStrip = R * (W - 4 * R);
+    TileCounters counters;
+
+    // Matching strips: a digest, and nothing more
+    ShipEmptyUpdate(gt, cp, peer, center, Dirs::EAST);
+    west.AddCounters(counters);
+    assert(counters.m_digestsShipped == 1);
+    assert(counters.m_digestMismatches == 0);
+
+    // Damage the east tile's copy of a west-owned strip site
+    const SPoint damaged(1, W / 2);
+    east.PlaceAtom(res, damaged);
+    ShipEmptyUpdate(gt, cp, peer, center, Dirs::EAST);
+    counters.Clear();
+    west.AddCounters(counters);
+    assert(counters.m_digestMismatches == 1);
+    assert(counters.m_resyncPacketsShipped == 0);
+
+    // The next update resends the half west owns, repairing it
+    ShipEmptyUpdate(gt, cp, peer, center, Dirs::EAST);
+    counters.Clear();
+    west.AddCounters(counters);
+    assert(counters.m_resyncPacketsShipped == halfStrip);
+    assert(counters.m_digestMismatches == 1);
+    assert(east.GetAtom(damaged)->GetType() == emptyType);
+
+    // Damage the west tile's own cache copy of an east-owned strip site
+    const SPoint stale(W - 1, W / 2);
+    SPoint owner = cp.LocalToRemote(stale);
+    assert(east.IsOwnedSite(owner));
+    west.PlaceAtom(res, stale);
+    ShipEmptyUpdate(gt, cp, peer, center, Dirs::EAST);
+    ShipEmptyUpdate(gt, cp, peer, center, Dirs::EAST);
+    counters.Clear();
+    west.AddCounters(counters);
+    assert(counters.m_digestMismatches == 3);  // Until east resyncs
+    assert(counters.m_resyncPacketsShipped == 2 * halfStrip);
+
+    // West's resyncs never overwrite the east-owned original
+    assert(east.GetAtom(owner)->GetType() == emptyType);
+    assert(west.GetAtom(stale)->GetType() != emptyType);
+
+    // East resyncs its own half, repairing west's cache
+    ShipEmptyUpdate(gt, peer, cp, eastCenter, Dirs::WEST);
+    counters.Clear();
+    east.AddCounters(counters);
+    assert(counters.m_resyncPacketsShipped == halfStrip);
+    assert(west.GetAtom(stale)->GetType() == emptyType);
+    assert(east.GetAtom(owner)->GetType() == emptyType);
+  }
+
+  void Tile_Test::Test_tileDirectCaches()
+  {
+    TestTile west;
+    TestTile east;
+    GridTransceiver gt;
+    LonglivedLock lock;
+    west.Connect(gt, lock, Dirs::EAST);
+    east.Connect(gt, lock, Dirs::WEST);
+
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateType(etnm);
+    west.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+    east.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+    TestAtom res(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+
+    CacheProcessor<TestEventConfig> & cp = west.GetCacheProcessor(Dirs::EAST);
+    CacheProcessor<TestEventConfig> & peer = east.GetCacheProcessor(Dirs::WEST);
+    cp.SetDirectPeer(peer);
+    peer.SetDirectPeer(cp);
+    assert(cp.IsDirect() && peer.IsDirect());
+
+    const u32 W = west.TILE_SIDE;
+    const u32 R = TestEventConfig::EVENT_WINDOW_RADIUS;
+    const SPoint center(W - R - 2, W / 2);
+    const SPoint remote = cp.LocalToRemote(center);
+    const u32 generation = east.GetChangeGeneration();
+
+    // A changed atom lands in the peer's cache with no packets, and
+    // the lock is free again as soon as the event is stored
+    assert(cp.TryLock(Dirs::EAST));
+    cp.Activate();
+    cp.StartLoading(center);
+    west.PlaceAtom(res, center);
+    cp.MaybeSendAtom(res, true, 0);
+    cp.MaybeSendAtom(res, false, 1);
+    cp.StartShipping(false);
+    assert(cp.IsIdle() && peer.IsIdle());
+    assert(east.GetAtom(remote)->GetType() == res.GetType());
+    assert(east.GetChangeGeneration() != generation);
+
+    TileCounters counters;
+    west.AddCounters(counters);
+    assert(counters.m_directUpdates == 1);
+    assert(counters.m_packetsShipped == 0);
+
+    // And the peer can take it right back
+    assert(peer.TryLock(Dirs::WEST));
+    peer.Unlock();
+  }
+
+  static void AdvanceSockets(SocketChannel & a, SocketChannel & b,
+                             CacheProcessor<TestEventConfig> & cpa,
+                             CacheProcessor<TestEventConfig> & cpb)
+  {
+    for (u32 i = 0; i < 10; ++i)
+    {
+      cpa.Advance();
+      a.Advance();
+      b.Advance();
+      cpb.Advance();
+    }
+  }
+
+  void Tile_Test::Test_tileRemoteLock()
+  {
+    // Two 'processes', each with its own stand-in for the shared lock
+    TestTile west;
+    TestTile east;
+    s32 fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    SocketChannel westSocket;
+    SocketChannel eastSocket;
+    westSocket.Open(fds[0], true);
+    eastSocket.Open(fds[1], false);
+    LonglivedLock westLock;
+    LonglivedLock eastLock;
+    west.Connect(westSocket, westLock, Dirs::EAST);
+    east.Connect(eastSocket, eastLock, Dirs::WEST);
+
+    CacheProcessor<TestEventConfig> & cp = west.GetCacheProcessor(Dirs::EAST);
+    CacheProcessor<TestEventConfig> & peer = east.GetCacheProcessor(Dirs::WEST);
+    cp.SetRemoteLock(true, cp);
+    peer.SetRemoteLock(false, peer);
+    assert(cp.IsRemoteLock() && peer.IsRemoteLock());
+    assert(cp.HoldsRemoteLockToken() && !peer.HoldsRemoteLockToken());
+
+    // The token holder locks as usual
+    assert(cp.TryLock(Dirs::EAST));
+    cp.Unlock();
+
+    // The other side's failed TryLock asks for the token
+    assert(!peer.TryLock(Dirs::WEST));
+    AdvanceSockets(westSocket, eastSocket, cp, peer);
+    assert(!cp.HoldsRemoteLockToken() && peer.HoldsRemoteLockToken());
+    assert(!cp.TryLock(Dirs::EAST));
+    assert(peer.TryLock(Dirs::WEST));
+
+    // It isn't handed back while in use
+    AdvanceSockets(westSocket, eastSocket, cp, peer);
+    assert(peer.HoldsRemoteLockToken());
+    peer.Unlock();
+    AdvanceSockets(westSocket, eastSocket, cp, peer);
+    assert(cp.HoldsRemoteLockToken() && !peer.HoldsRemoteLockToken());
+    assert(cp.TryLock(Dirs::EAST));
+    cp.Unlock();
+
+    TileCounters counters;
+    west.AddCounters(counters);
+    east.AddCounters(counters);
+    assert(counters.m_lockGrants == 2);
+  }
+
+  void Tile_Test::Test_tileLeanSites()
+  {
+    // Leaving out the Base and history leaves little but the atom
+    assert(sizeof(TestLeanSite) < sizeof(TestSite) / 2);
+    assert(sizeof(TestLeanTile) < sizeof(TestTile));
+
+    TestLeanSite site;
+    Base<P3AtomConfig> base;
+    base.PutBaseAtom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    site.StoreBase(base);
+    site.LoadBase(base);
+    assert(base.GetBaseAtom() == Base<P3AtomConfig>().GetBaseAtom());
+    site.SetLastChangedEventNumber(10);
+    assert(site.GetLastChangedEventNumber() == 0);
+    site.Sense(TOUCH_TYPE_LIGHT);
+    assert(!site.HasRecentLightTouch());
+
+    // A lean Tile still runs events
+    TestLeanTile tile;
+    ElementTypeNumberMap<TestLeanEventConfig> etnm;
+    Element_Res<TestLeanEventConfig>::THE_INSTANCE.AllocateType(etnm);
+    tile.RegisterElement(Element_Res<TestLeanEventConfig>::THE_INSTANCE);
+    const u32 W = tile.TILE_SIDE;
+    tile.PlaceAtom(Element_Res<TestLeanEventConfig>::THE_INSTANCE.GetDefaultAtom(),
+                   SPoint(W / 2, W / 2));
+
+    tile.RequestStateActive();
+    for (u32 i = 0; i < 1000; ++i)
+    {
+      tile.Advance();
+    }
+
+    TileCounters counters;
+    tile.AddCounters(counters);
+    assert(counters.m_eventsExecuted > 0);
+  }
 } /* namespace MFM */